@@ -26,6 +26,7 @@
 
 #include <unistd.h>
 #include <stdint.h>
+#include <sys/uio.h>
 
 enum LIBCURVE_ERROR {
     // success
@@ -116,4 +117,17 @@ typedef struct CurveAioContext {
     void*               buf;
 } CurveAioContext;
 
+/**
+ * A request of the batch submitted by AioSubmit, or of AioReadv/AioWritev
+ */
+typedef struct CurveAioRequest {
+    CurveAioContext*    ctx;
+    // buffers of a vectored read or write, ctx->buf is used if iov is NULL,
+    // otherwise ctx->length must be the total length of the buffers.
+    // the array is copied before the call returns, the buffers must stay
+    // valid until the callback of ctx is called
+    const struct iovec* iov;
+    int                 iovcnt;
+} CurveAioRequest;
+
 #endif  // INCLUDE_CLIENT_LIBCURVE_DEFINE_H_
@@ -32,23 +32,25 @@ void ChunkClosure::Run() {
      * 析构函数漏调
      */
     std::unique_ptr<ChunkClosure> selfGuard(this);
-    /**
-     * 确保done能够被调用，目的是保证rpc一定会返回
-     */
-    brpc::ClosureGuard doneGuard(request_->Closure());
-    /**
-     * 尽管在request propose给copyset的之前已经
-     * 对leader身份进行了确认，但是在copyset处理
-     * request的时候，当前copyset的身份还是有可能
-     * 变成非leader，所以需要判断ChunkClosure被调
-     * 用的时候，request的status，如果 ok，说明是
-     * 正常的apply处理，否则将请求转发
-     */
-    if (status().ok()) {
-        return;
+    {
+        /**
+         * 确保done能够被调用，目的是保证rpc一定会返回
+         */
+        brpc::ClosureGuard doneGuard(request_->Closure());
+        /**
+         * 尽管在request propose给copyset的之前已经
+         * 对leader身份进行了确认，但是在copyset处理
+         * request的时候，当前copyset的身份还是有可能
+         * 变成非leader，所以需要判断ChunkClosure被调
+         * 用的时候，request的status，如果 ok，说明是
+         * 正常的apply处理，否则将请求转发
+         */
+        if (!status().ok()) {
+            request_->RedirectChunkRequest();
+        }
     }
-
-    request_->RedirectChunkRequest();
+    // rpc返回之后再统计，trace包含返回的耗时
+    request_->FinishTrace();
 }
 
 void ScanChunkClosure::Run() {
@@ -24,6 +24,7 @@
 #include <memory>
 
 #include "src/chunkserver/chunkserver_metrics.h"
+#include "src/common/background_io_scheduler.h"
 
 namespace curve {
 namespace chunkserver {
@@ -111,6 +112,8 @@ void ChunkServiceClosure::OnResonse() {
                                request_->size(),
                                latencyUs,
                                hasError);
+            common::BackgroundIOScheduler::GetInstance().OnForegroundIO(
+                latencyUs);
             break;
         }
         case CHUNK_OP_TYPE::CHUNK_OP_WRITE: {
@@ -122,6 +125,8 @@ void ChunkServiceClosure::OnResonse() {
                                request_->size(),
                                latencyUs,
                                hasError);
+            common::BackgroundIOScheduler::GetInstance().OnForegroundIO(
+                latencyUs);
             break;
         }
         case CHUNK_OP_TYPE::CHUNK_OP_RECOVER: {
@@ -37,21 +37,31 @@
 #include "src/chunkserver/chunkserver_metrics.h"
 #include "src/chunkserver/chunkserver_service.h"
 #include "src/chunkserver/copyset_service.h"
+#include "src/chunkserver/io_tracer.h"
 #include "src/chunkserver/raftlog/curve_segment_log_storage.h"
+#include "src/chunkserver/raftlog/merged_log_storage.h"
 #include "src/chunkserver/raftsnapshot/curve_file_service.h"
 #include "src/chunkserver/raftsnapshot/curve_snapshot_attachment.h"
 #include "src/chunkserver/raftsnapshot/curve_snapshot_storage.h"
+#include "src/common/background_io_scheduler.h"
 #include "src/common/bytes_convert.h"
 #include "src/common/concurrent/task_thread_pool.h"
 #include "src/common/curve_version.h"
 #include "src/common/uri_parser.h"
 
+namespace braft {
+DECLARE_int32(raft_max_byte_count_per_rpc);
+}  // namespace braft
+
 using ::curve::fs::LocalFileSystem;
 using ::curve::fs::LocalFileSystemOption;
 using ::curve::fs::LocalFsFactory;
 using ::curve::fs::FileSystemType;
 using ::curve::chunkserver::concurrent::ConcurrentApplyModule;
 using ::curve::common::UriParser;
+using ::curve::common::BackgroundIOScheduler;
+using ::curve::common::BackgroundIOSchedulerOptions;
+using ::curve::common::BackgroundIOType;
 
 DEFINE_string(conf, "ChunkServer.conf", "Path of configuration file");
 DEFINE_string(chunkServerIp, "127.0.0.1", "chunkserver ip");
@@ -122,6 +132,21 @@ int ChunkServer::Run(int argc, char** argv) {
     LOG_IF(FATAL, metric->Init(metricOptions) != 0)
         << "Failed to init chunkserver metric.";
 
+    // 初始化写请求各阶段时延的采样统计
+    IOTracerOptions ioTracerOptions;
+    InitIOTracerOptions(&conf, &ioTracerOptions);
+    LOG_IF(FATAL, IOTracer::GetInstance().Init(ioTracerOptions,
+        "chunkserver_" + metricOptions.ip + "_" +
+        std::to_string(metricOptions.port) + "_io_trace") != 0)
+        << "Failed to init io tracer.";
+
+    // 初始化后台IO调度模块，需要在文件池开始格式化之前初始化
+    BackgroundIOSchedulerOptions backgroundIOOptions;
+    InitBackgroundIOSchedulerOptions(&conf, &backgroundIOOptions);
+    LOG_IF(FATAL, BackgroundIOScheduler::GetInstance().Init(
+        backgroundIOOptions) != 0)
+        << "Failed to init background io scheduler.";
+
     // 初始化并发持久模块
     ConcurrentApplyModule concurrentapply;
     ConcurrentApplyOption concurrentApplyOptions;
@@ -130,11 +155,20 @@ int ChunkServer::Run(int argc, char** argv) {
         << "Failed to initialize concurrentapply module!";
 
     // 初始化本地文件系统
+    bool enableIoUring = false;
+    LOG_IF(WARNING, !conf.GetBoolValue("fs.enable_io_uring", &enableIoUring))
+        << "config no fs.enable_io_uring info, using default value "
+        << enableIoUring;
     std::shared_ptr<LocalFileSystem> fs(
-        LocalFsFactory::CreateFs(FileSystemType::EXT4, ""));
+        LocalFsFactory::CreateFs(enableIoUring ? FileSystemType::EXT4_IO_URING
+                                               : FileSystemType::EXT4, ""));
     LocalFileSystemOption lfsOption;
     LOG_IF(FATAL, !conf.GetBoolValue(
         "fs.enable_renameat2", &lfsOption.enableRenameat2));
+    LOG_IF(WARNING, !conf.GetUInt32Value("fs.io_uring_queue_depth",
+                                         &lfsOption.ioUringQueueDepth))
+        << "config no fs.io_uring_queue_depth info, using default value "
+        << lfsOption.ioUringQueueDepth;
     LOG_IF(FATAL, 0 != fs->Init(lfsOption))
         << "Failed to initialize local filesystem module!";
 
@@ -154,7 +188,8 @@ int ChunkServer::Run(int argc, char** argv) {
     std::shared_ptr<FilePool> walFilePool = nullptr;
     bool useChunkFilePoolAsWalPool = true;
     uint32_t useChunkFilePoolAsWalPoolReserve = 15;
-    if (raftLogProtocol == kProtocalCurve) {
+    bool useMergedLog = raftLogProtocol == kMergedLogStorageProtocol;
+    if (raftLogProtocol == kProtocalCurve || useMergedLog) {
         LOG_IF(FATAL, !conf.GetBoolValue(
             "walfilepool.use_chunk_file_pool",
             &useChunkFilePoolAsWalPool));
@@ -167,6 +202,15 @@ int ChunkServer::Run(int argc, char** argv) {
                 << "Failed to init wal file pool";
             LOG(INFO) << "initialize walpool success.";
         } else {
+            // raft日志放在单独的盘上时，需要在该盘上使用独立的walpool
+            std::string raftLogDir;
+            UriParser::ParseUri(raftLogUri, &raftLogDir);
+            LOG_IF(FATAL, !IsOnSameDevice(fs, raftLogDir,
+                                          chunkFilePoolOptions.filePoolDir))
+                << "raft log dir " << raftLogDir << " is not on the same"
+                << " device as chunk file pool, set"
+                << " walfilepool.use_chunk_file_pool=false and put"
+                << " walfilepool.file_pool_dir on the raft log device";
             walFilePool = chunkfilePool;
             LOG_IF(FATAL, !conf.GetUInt32Value(
             "walfilepool.use_chunk_file_pool_reserve",
@@ -175,6 +219,18 @@ int ChunkServer::Run(int argc, char** argv) {
         }
     }
 
+    // 所有copyset的raft日志写入共享文件
+    if (useMergedLog) {
+        MergedLogOptions mergedLogOptions;
+        InitMergedLogOptions(&conf, &mergedLogOptions);
+        UriParser::ParseUri(raftLogUri, &mergedLogOptions.logRootDir);
+        mergedLogOptions.walFilePool = walFilePool;
+        mergedLogManager_ = std::make_shared<MergedLogManager>();
+        LOG_IF(FATAL, mergedLogManager_->Init(mergedLogOptions) != 0)
+            << "Failed to init merged log manager";
+        RegisterMergedLogStorageOrDie(mergedLogManager_);
+    }
+
     // 远端拷贝管理模块选项
     CopyerOptions copyerOptions;
     InitCopyerOptions(&conf, &copyerOptions);
@@ -260,6 +316,18 @@ int ChunkServer::Run(int argc, char** argv) {
             copysetNodeOptions.blockSize = poolOpt.blockSize;
         }
     }
+    if (copysetNodeOptions.blockCacheBytes > 0) {
+        BlockCacheOptions blockCacheOptions;
+        blockCacheOptions.capacity = copysetNodeOptions.blockCacheBytes;
+        blockCacheOptions.blockSize = copysetNodeOptions.blockCacheBlockSize;
+        LOG_IF(FATAL, blockCacheOptions.blockSize == 0)
+            << "copyset.block_cache_block_size should be greater than 0";
+        copysetNodeOptions.blockCache =
+            std::make_shared<CSBlockCache>(blockCacheOptions);
+        LOG(INFO) << "Block cache enabled, cache bytes: "
+                  << blockCacheOptions.capacity
+                  << ", block size: " << blockCacheOptions.blockSize;
+    }
 
     // install snapshot的带宽限制
     int snapshotThroughputBytes;
@@ -280,6 +348,20 @@ int ChunkServer::Run(int argc, char** argv) {
         = new ThroughputSnapshotThrottle(snapshotThroughputBytes, checkCycles);
     snapshotThrottle_ = snapshotThrottle;
     copysetNodeOptions.snapshotThrottle = &snapshotThrottle_;
+    // install snapshot时同时下载的文件数和每次rpc读取的数据量，
+    // 总带宽仍由上面的snapshot throttle限制
+    int snapshotCopyConcurrency = 1;
+    LOG_IF(WARNING, !conf.GetIntValue("chunkserver.snapshot_copy_concurrency",
+        &snapshotCopyConcurrency))
+        << "config no chunkserver.snapshot_copy_concurrency info, "
+        << "using default value " << snapshotCopyConcurrency;
+    CurveSnapshotStorage::set_copy_concurrency(snapshotCopyConcurrency);
+    int snapshotCopyBlockSize = braft::FLAGS_raft_max_byte_count_per_rpc;
+    LOG_IF(WARNING, !conf.GetIntValue("chunkserver.snapshot_copy_block_size",
+        &snapshotCopyBlockSize))
+        << "config no chunkserver.snapshot_copy_block_size info, "
+        << "using default value " << snapshotCopyBlockSize;
+    braft::FLAGS_raft_max_byte_count_per_rpc = snapshotCopyBlockSize;
 
     butil::ip_t ip;
     if (butil::str2ip(copysetNodeOptions.ip.c_str(), &ip) < 0) {
@@ -290,6 +372,13 @@ int ChunkServer::Run(int argc, char** argv) {
     // 注册curve snapshot storage
     RegisterCurveSnapshotStorageOrDie();
     CurveSnapshotStorage::set_server_addr(endPoint);
+    bool enableIncrementalSnapshot = false;
+    LOG_IF(WARNING, !conf.GetBoolValue("copyset.enable_incremental_snapshot",
+        &enableIncrementalSnapshot))
+        << "config no copyset.enable_incremental_snapshot info, "
+        << "using default value " << enableIncrementalSnapshot;
+    CurveSnapshotStorage::set_enable_incremental_snapshot(
+        enableIncrementalSnapshot);
     copysetNodeManager_ = &CopysetNodeManager::GetInstance();
     LOG_IF(FATAL, copysetNodeManager_->Init(copysetNodeOptions) != 0)
         << "Failed to initialize CopysetNodeManager.";
@@ -316,7 +405,8 @@ int ChunkServer::Run(int argc, char** argv) {
     // 监控部分模块的metric指标
     metric->MonitorTrash(trash_.get());
     metric->MonitorChunkFilePool(chunkfilePool.get());
-    if (raftLogProtocol == kProtocalCurve && !useChunkFilePoolAsWalPool) {
+    if ((raftLogProtocol == kProtocalCurve || useMergedLog) &&
+        !useChunkFilePoolAsWalPool) {
         metric->MonitorWalFilePool(walFilePool.get());
     }
     metric->ExposeConfigMetric(&conf);
@@ -474,6 +564,7 @@ int ChunkServer::Run(int argc, char** argv) {
         << "Failed to shutdown trash.";
     LOG_IF(ERROR, !chunkfilePool->StopCleaning())
         << "Failed to shutdown file pool clean worker.";
+    BackgroundIOScheduler::GetInstance().Stop();
     concurrentapply.Stop();
 
     google::ShutdownGoogleLogging();
@@ -586,6 +677,36 @@ void ChunkServer::InitConcurrentApplyOptions(common::Configuration *conf,
         "rconcurrentapply.queuedepth", &concurrentApplyOptions->rqueuedepth));
     LOG_IF(FATAL, !conf->GetIntValue(
         "wconcurrentapply.queuedepth", &concurrentApplyOptions->wqueuedepth));
+    LOG_IF(WARNING, !conf->GetIntValue(
+        "rconcurrentapply.queuenum", &concurrentApplyOptions->rqueuenum))
+        << "config no rconcurrentapply.queuenum info, using default value "
+        << concurrentApplyOptions->rqueuenum;
+    LOG_IF(WARNING, !conf->GetIntValue(
+        "wconcurrentapply.queuenum", &concurrentApplyOptions->wqueuenum))
+        << "config no wconcurrentapply.queuenum info, using default value "
+        << concurrentApplyOptions->wqueuenum;
+}
+
+bool ChunkServer::IsOnSameDevice(const std::shared_ptr<LocalFileSystem> &fs,
+    const std::string &path1, const std::string &path2) {
+    struct stat info[2];
+    const std::string *paths[2] = {&path1, &path2};
+    for (int i = 0; i < 2; ++i) {
+        int fd = fs->Open(*paths[i], O_RDONLY);
+        if (fd < 0) {
+            LOG(INFO) << "Failed to open " << *paths[i]
+                      << ", skip device check";
+            return true;
+        }
+        int ret = fs->Fstat(fd, &info[i]);
+        fs->Close(fd);
+        if (ret != 0) {
+            LOG(INFO) << "Failed to stat " << *paths[i]
+                      << ", skip device check";
+            return true;
+        }
+    }
+    return info[0].st_dev == info[1].st_dev;
 }
 
 void ChunkServer::InitWalFilePoolOptions(
@@ -600,28 +721,27 @@ void ChunkServer::InitWalFilePoolOptions(
         "walfilepool.enable_get_segment_from_pool",
         &walPoolOptions->getFileFromPool));
 
-    if (walPoolOptions->getFileFromPool == false) {
-        std::string filePoolUri;
-        LOG_IF(FATAL, !conf->GetStringValue(
-            "walfilepool.file_pool_dir", &filePoolUri));
-        ::memcpy(walPoolOptions->filePoolDir,
-                 filePoolUri.c_str(),
-                 filePoolUri.size());
-    } else {
+    // walpool目录可以和chunkfilepool不在同一块盘上，例如单独的SSD/NVMe
+    std::string filePoolUri;
+    LOG_IF(FATAL, !conf->GetStringValue(
+        "walfilepool.file_pool_dir", &filePoolUri));
+    ::memcpy(walPoolOptions->filePoolDir,
+             filePoolUri.c_str(),
+             filePoolUri.size());
+
+    if (walPoolOptions->getFileFromPool) {
         std::string metaUri;
         LOG_IF(FATAL, !conf->GetStringValue(
             "walfilepool.meta_path", &metaUri));
 
         std::string pool_size;
-        LOG_IF(FATAL, !conf->GetStringValue("walfilepool.chunk_file_pool_size",
+        LOG_IF(FATAL, !conf->GetStringValue("walfilepool.wal_file_pool_size",
                                             &pool_size));
         LOG_IF(FATAL, !curve::common::ToNumbericByte(
                           pool_size, &walPoolOptions->filePoolSize));
-        LOG_IF(FATAL, !conf->GetUInt64Value("walfilepool.wal_file_pool_size",
-                                            &walPoolOptions->filePoolSize));
         LOG_IF(FATAL, !conf->GetBoolValue("walfilepool.allocated_by_percent",
                                           &walPoolOptions->allocatedByPercent));
-        LOG_IF(FATAL, !conf->GetUInt32Value("walfilepool.allocated_percent",
+        LOG_IF(FATAL, !conf->GetUInt32Value("walfilepool.allocate_percent",
                                             &walPoolOptions->allocatedPercent));
         LOG_IF(FATAL, !conf->GetUInt32Value("walfilepool.thread_num",
                                             &walPoolOptions->formatThreadNum));
@@ -646,6 +766,18 @@ void ChunkServer::InitWalFilePoolOptions(
     }
 }
 
+void ChunkServer::InitMergedLogOptions(
+    common::Configuration *conf, MergedLogOptions *mergedLogOptions) {
+    LOG_IF(WARNING, !conf->GetStringValue("mergedlog.dir",
+                                          &mergedLogOptions->path))
+        << "config no mergedlog.dir info, using default value "
+        << mergedLogOptions->path;
+    LOG_IF(WARNING, !conf->GetBoolValue("mergedlog.enable_sync",
+                                        &mergedLogOptions->enableSync))
+        << "config no mergedlog.enable_sync info, using default value "
+        << mergedLogOptions->enableSync;
+}
+
 void ChunkServer::InitCopysetNodeOptions(
     common::Configuration *conf, CopysetNodeOptions *copysetNodeOptions) {
     LOG_IF(FATAL, !conf->GetStringValue("global.ip", &copysetNodeOptions->ip));
@@ -687,6 +819,10 @@ void ChunkServer::InitCopysetNodeOptions(
         &copysetNodeOptions->locationLimit));
     LOG_IF(FATAL, !conf->GetUInt32Value("copyset.load_concurrency",
         &copysetNodeOptions->loadConcurrency));
+    LOG_IF(WARNING, !conf->GetUInt32Value("copyset.chunk_load_concurrency",
+        &copysetNodeOptions->chunkLoadConcurrency))
+        << "config no copyset.chunk_load_concurrency info, "
+        << "using default value " << copysetNodeOptions->chunkLoadConcurrency;
     LOG_IF(FATAL, !conf->GetUInt32Value("copyset.check_retrytimes",
         &copysetNodeOptions->checkRetryTimes));
     LOG_IF(FATAL, !conf->GetUInt32Value("copyset.finishload_margin",
@@ -699,13 +835,44 @@ void ChunkServer::InitCopysetNodeOptions(
     LOG_IF(FATAL, !conf->GetBoolValue(
         "copyset.enable_odsync_when_open_chunkfile",
         &copysetNodeOptions->enableOdsyncWhenOpenChunkFile));
+    ret = conf->GetBoolValue("copyset.enable_odirect_read",
+        &copysetNodeOptions->enableODirectRead);
+    LOG_IF(WARNING, ret == false)
+        << "config no copyset.enable_odirect_read info, using default value "
+        << copysetNodeOptions->enableODirectRead;
+    LOG_IF(WARNING, !conf->GetUInt32Value("copyset.odirect_read_max_fds",
+        &copysetNodeOptions->maxODirectReadFds))
+        << "config no copyset.odirect_read_max_fds info, "
+        << "using default value " << copysetNodeOptions->maxODirectReadFds;
+    LOG_IF(WARNING, !conf->GetUInt32Value("copyset.paste_metapage_batch",
+        &copysetNodeOptions->pasteMetaPageBatch))
+        << "config no copyset.paste_metapage_batch info, "
+        << "using default value " << copysetNodeOptions->pasteMetaPageBatch;
+    LOG_IF(WARNING, !conf->GetUInt64Value("copyset.block_cache_bytes",
+        &copysetNodeOptions->blockCacheBytes))
+        << "config no copyset.block_cache_bytes info, "
+        << "using default value " << copysetNodeOptions->blockCacheBytes;
+    LOG_IF(WARNING, !conf->GetUInt32Value("copyset.block_cache_block_size",
+        &copysetNodeOptions->blockCacheBlockSize))
+        << "config no copyset.block_cache_block_size info, "
+        << "using default value " << copysetNodeOptions->blockCacheBlockSize;
+    LOG_IF(WARNING, !conf->GetBoolValue("copyset.enable_write_coalesce",
+        &copysetNodeOptions->enableWriteCoalesce))
+        << "config no copyset.enable_write_coalesce info, using default value "
+        << copysetNodeOptions->enableWriteCoalesce;
+    LOG_IF(WARNING, !conf->GetUInt32Value("copyset.write_coalesce_max_bytes",
+        &copysetNodeOptions->writeCoalesceMaxBytes))
+        << "config no copyset.write_coalesce_max_bytes info, "
+        << "using default value " << copysetNodeOptions->writeCoalesceMaxBytes;
+    LOG_IF(WARNING, !conf->GetUInt32Value("copyset.write_coalesce_wait_us",
+        &copysetNodeOptions->writeCoalesceWaitUs))
+        << "config no copyset.write_coalesce_wait_us info, "
+        << "using default value " << copysetNodeOptions->writeCoalesceWaitUs;
     if (!copysetNodeOptions->enableOdsyncWhenOpenChunkFile) {
         LOG_IF(FATAL, !conf->GetUInt64Value("copyset.sync_chunk_limits",
             &copysetNodeOptions->syncChunkLimit));
         LOG_IF(FATAL, !conf->GetUInt64Value("copyset.sync_threshold",
             &copysetNodeOptions->syncThreshold));
-        LOG_IF(FATAL, !conf->GetUInt32Value("copyset.check_syncing_interval_ms",
-            &copysetNodeOptions->checkSyncingIntervalMs));
         LOG_IF(FATAL, !conf->GetUInt32Value("copyset.sync_trigger_seconds",
                 &copysetNodeOptions->syncTriggerSeconds));
     }
@@ -729,6 +896,20 @@ void ChunkServer::InitCopyerOptions(
         &disableS3Adapter));
     LOG_IF(FATAL, !conf->GetUInt64Value("curve.curve_file_timeout_s",
         &copyerOptions->curveFileTimeoutSec));
+    LOG_IF(FATAL, !conf->GetUInt32Value("global.chunk_size",
+        &copyerOptions->chunkSize));
+    LOG_IF(WARNING, !conf->GetUInt64Value("clone.source_cache_bytes",
+        &copyerOptions->sourceCacheBytes))
+        << "config no clone.source_cache_bytes info, using default value "
+        << copyerOptions->sourceCacheBytes;
+    LOG_IF(WARNING, !conf->GetUInt32Value("clone.source_cache_block_size",
+        &copyerOptions->sourceCacheBlockSize))
+        << "config no clone.source_cache_block_size info, using default value "
+        << copyerOptions->sourceCacheBlockSize;
+    LOG_IF(WARNING, !conf->GetUInt32Value("clone.source_prefetch_blocks",
+        &copyerOptions->sourcePrefetchBlocks))
+        << "config no clone.source_prefetch_blocks info, using default value "
+        << copyerOptions->sourcePrefetchBlocks;
 
     if (disableCurveClient) {
         copyerOptions->curveClient = nullptr;
@@ -757,6 +938,10 @@ void ChunkServer::InitScanOptions(
         &scanOptions->intervalSec));
     LOG_IF(FATAL, !conf->GetUInt64Value("copyset.scan_size_byte",
         &scanOptions->scanSize));
+    LOG_IF(WARNING, !conf->GetUInt32Value("copyset.scan_block_size_byte",
+        &scanOptions->scanBlockSize))
+        << "config no copyset.scan_block_size_byte info, using default value "
+        << scanOptions->scanBlockSize;
     LOG_IF(FATAL, !conf->GetUInt32Value("global.meta_page_size",
         &scanOptions->chunkMetaPageSize));
     LOG_IF(FATAL, !conf->GetUInt64Value("copyset.scan_rpc_timeout_ms",
@@ -780,6 +965,15 @@ void ChunkServer::InitHeartbeatOptions(
         &heartbeatOptions->intervalSec));
     LOG_IF(FATAL, !conf->GetUInt32Value("mds.heartbeat_timeout",
         &heartbeatOptions->timeout));
+    HeartbeatDeltaOptions *deltaOptions = &heartbeatOptions->deltaOptions;
+    LOG_IF(WARNING, !conf->GetBoolValue("mds.heartbeat_delta_report",
+        &deltaOptions->enable))
+        << "config no mds.heartbeat_delta_report info, "
+        << "using default value " << deltaOptions->enable;
+    LOG_IF(WARNING, !conf->GetUInt32Value("mds.heartbeat_full_report_interval",
+        &deltaOptions->fullReportInterval))
+        << "config no mds.heartbeat_full_report_interval info, "
+        << "using default value " << deltaOptions->fullReportInterval;
 }
 
 void ChunkServer::InitRegisterOptions(
@@ -826,6 +1020,55 @@ void ChunkServer::InitMetricOptions(
         "metric.onoff", &metricOptions->collectMetric));
 }
 
+void ChunkServer::InitIOTracerOptions(
+    common::Configuration *conf, IOTracerOptions *ioTracerOptions) {
+    LOG_IF(WARNING, !conf->GetUInt32Value("metric.io_trace_sample_rate",
+        &ioTracerOptions->sampleRate))
+        << "config no metric.io_trace_sample_rate info, "
+        << "using default value " << ioTracerOptions->sampleRate;
+    LOG_IF(WARNING, !conf->GetUInt32Value("metric.io_trace_slowest_num",
+        &ioTracerOptions->slowestNum))
+        << "config no metric.io_trace_slowest_num info, "
+        << "using default value " << ioTracerOptions->slowestNum;
+    LOG_IF(WARNING, !conf->GetUInt32Value("metric.io_trace_window_s",
+        &ioTracerOptions->windowS))
+        << "config no metric.io_trace_window_s info, "
+        << "using default value " << ioTracerOptions->windowS;
+}
+
+void ChunkServer::InitBackgroundIOSchedulerOptions(
+    common::Configuration *conf, BackgroundIOSchedulerOptions *options) {
+    uint64_t bpsLimitMB = options->bpsLimit / common::kMiB;
+    LOG_IF(WARNING, !conf->GetUInt64Value("background_io.bps_limit_mb",
+        &bpsLimitMB))
+        << "config no background_io.bps_limit_mb info, using default value "
+        << bpsLimitMB;
+    options->bpsLimit = bpsLimitMB * common::kMiB;
+    LOG_IF(WARNING, !conf->GetUInt64Value("background_io.iops_limit",
+        &options->iopsLimit))
+        << "config no background_io.iops_limit info, using default value "
+        << options->iopsLimit;
+    for (int i = 0; i < common::kBackgroundIOTypeNum; ++i) {
+        std::string key = std::string("background_io.weight.") +
+            BackgroundIOTypeName(static_cast<BackgroundIOType>(i));
+        LOG_IF(WARNING, !conf->GetUInt32Value(key, &options->weights[i]))
+            << "config no " << key << " info, using default value "
+            << options->weights[i];
+    }
+    LOG_IF(WARNING, !conf->GetUInt64Value("background_io.latency_threshold_us",
+        &options->latencyThresholdUs))
+        << "config no background_io.latency_threshold_us info, "
+        << "using default value " << options->latencyThresholdUs;
+    LOG_IF(WARNING, !conf->GetUInt32Value("background_io.min_ratio_percent",
+        &options->minRatioPercent))
+        << "config no background_io.min_ratio_percent info, "
+        << "using default value " << options->minRatioPercent;
+    LOG_IF(WARNING, !conf->GetUInt32Value("background_io.adjust_interval_ms",
+        &options->adjustIntervalMs))
+        << "config no background_io.adjust_interval_ms info, "
+        << "using default value " << options->adjustIntervalMs;
+}
+
 void ChunkServer::LoadConfigFromCmdline(common::Configuration *conf) {
     // 如果命令行有设置, 命令行覆盖配置文件中的字段
     google::CommandLineFlagInfo info;
@@ -34,7 +34,10 @@
 #include "src/chunkserver/trash.h"
 #include "src/chunkserver/chunkserver_metrics.h"
 #include "src/chunkserver/concurrent_apply/concurrent_apply.h"
+#include "src/chunkserver/io_tracer.h"
 #include "src/chunkserver/scan_service.h"
+#include "src/chunkserver/raftlog/merged_log_manager.h"
+#include "src/common/background_io_scheduler.h"
 
 using ::curve::chunkserver::concurrent::ConcurrentApplyOption;
 
@@ -64,6 +67,9 @@ class ChunkServer {
     void InitWalFilePoolOptions(common::Configuration *conf,
         FilePoolOptions *walPoolOption);
 
+    void InitMergedLogOptions(common::Configuration *conf,
+        MergedLogOptions *mergedLogOptions);
+
     void InitConcurrentApplyOptions(common::Configuration *conf,
         ConcurrentApplyOption *concurrentApplyOption);
 
@@ -91,6 +97,12 @@ class ChunkServer {
     void InitMetricOptions(common::Configuration *conf,
         ChunkServerMetricOptions *metricOptions);
 
+    void InitIOTracerOptions(common::Configuration *conf,
+        IOTracerOptions *ioTracerOptions);
+
+    void InitBackgroundIOSchedulerOptions(common::Configuration *conf,
+        common::BackgroundIOSchedulerOptions *options);
+
     void LoadConfigFromCmdline(common::Configuration *conf);
 
     int GetChunkServerMetaFromLocal(const std::string &storeUri,
@@ -101,6 +113,13 @@ class ChunkServer {
     int ReadChunkServerMeta(const std::shared_ptr<LocalFileSystem> &fs,
         const std::string &metaUri, ChunkServerMetadata *metadata);
 
+    /**
+     * 判断两个路径是否在同一个设备上，文件池通过rename分配和回收文件，
+     * 不能跨设备使用；路径不存在时无法判断，视为同一设备
+     */
+    bool IsOnSameDevice(const std::shared_ptr<LocalFileSystem> &fs,
+        const std::string &path1, const std::string &path2);
+
  private:
     // copysetNodeManager_ 管理chunkserver上所有copysetNode
     CopysetNodeManager* copysetNodeManager_;
@@ -117,6 +136,9 @@ class ChunkServer {
     // trash_ 定期回收垃圾站中的物理空间
     std::shared_ptr<Trash> trash_;
 
+    // raft_log_uri为curve_merged协议时，所有copyset共享的raft日志
+    std::shared_ptr<MergedLogManager> mergedLogManager_;
+
     // install snapshot流控
     scoped_refptr<SnapshotThrottle> snapshotThrottle_;
 };
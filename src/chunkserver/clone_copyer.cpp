@@ -21,6 +21,11 @@
  */
 
 #include "src/chunkserver/clone_copyer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
 #include "src/chunkserver/clone_core.h"
 #include "src/common/timeutility.h"
 
@@ -40,6 +45,44 @@ struct CurveAioCombineContext {
     CurveAioContext curveCtx;
 };
 
+struct OriginCopyer::CachedReadRequest {
+    OriginType type;
+    string path;
+    off_t offset;
+    size_t size;
+    char* buf;
+    DownloadClosure* done;
+    // 还未完成的块的个数
+    std::atomic<uint64_t> pending;
+    // 是否有块下载失败
+    std::atomic<bool> failed;
+};
+
+class OriginCopyer::BlockDownloadClosure : public DownloadClosure {
+ public:
+    BlockDownloadClosure(OriginCopyer* copyer,
+                         const std::string& key,
+                         uint32_t blockSize)
+        : DownloadClosure(nullptr, nullptr, nullptr, nullptr)
+        , copyer_(copyer)
+        , key_(key)
+        , block_(std::make_shared<std::string>(blockSize, '\0')) {}
+
+    char* Buffer() {
+        return &(*block_)[0];
+    }
+
+    void Run() override {
+        std::unique_ptr<BlockDownloadClosure> selfGuard(this);
+        copyer_->OnBlockFetched(key_, block_, isFailed_);
+    }
+
+ private:
+    OriginCopyer* copyer_;
+    std::string key_;
+    std::shared_ptr<std::string> block_;
+};
+
 void CurveAioCallback(struct CurveAioContext* context) {
     auto curveCombineCtx = reinterpret_cast<CurveAioCombineContext *>(
         reinterpret_cast<char *>(context) -
@@ -84,9 +127,21 @@ void OriginCopyer::DeleteExpiredCurveCache(void* arg) {
 
 OriginCopyer::OriginCopyer()
     : curveClient_(nullptr)
-    , s3Client_(nullptr) {}
+    , s3Client_(nullptr)
+    , blockCache_(nullptr)
+    , blockSize_(0)
+    , prefetchBlocks_(0)
+    , chunkSize_(0) {}
 
 int OriginCopyer::Init(const CopyerOptions& options) {
+    if (options.sourceCacheBytes > 0 &&
+        (options.sourceCacheBlockSize == 0 ||
+         options.sourceCacheBytes < options.sourceCacheBlockSize)) {
+        LOG(ERROR) << "Invalid source cache options"
+                   << ", cache bytes: " << options.sourceCacheBytes
+                   << ", block size: " << options.sourceCacheBlockSize;
+        return -1;
+    }
     curveFileTimeoutSec_ = options.curveFileTimeoutSec;
     curveClient_ = options.curveClient;
     s3Client_ = options.s3Client;
@@ -115,6 +170,19 @@ int OriginCopyer::Init(const CopyerOptions& options) {
         LOG(FATAL) << "init curveFile timer thread failed, " << berror(rc);
     }
     timerId_ = bthread::TimerThread::INVALID_TASK_ID;
+
+    if (options.sourceCacheBytes > 0) {
+        blockSize_ = options.sourceCacheBlockSize;
+        prefetchBlocks_ = options.sourcePrefetchBlocks;
+        chunkSize_ = options.chunkSize;
+        blockCache_ = std::make_shared<SourceBlockCache>(
+            options.sourceCacheBytes / blockSize_,
+            std::make_shared<CacheMetrics>("chunkserver_clone_source"));
+        LOG(INFO) << "Source cache enabled, cache bytes: "
+                  << options.sourceCacheBytes
+                  << ", block size: " << blockSize_
+                  << ", prefetch blocks: " << prefetchBlocks_;
+    }
     return 0;
 }
 
@@ -143,31 +211,199 @@ void OriginCopyer::DownloadAsync(DownloadClosure* done) {
     std::string originPath;
     OriginType type =
         LocationOperator::ParseLocation(context->location, &originPath);
+    // 源端数据的路径和请求在其中的绝对偏移
+    std::string path;
+    off_t offset;
     if (type == OriginType::CurveOrigin) {
         off_t chunkOffset;
-        std::string fileName;
         bool parseSuccess = LocationOperator::ParseCurveChunkPath(
-            originPath, &fileName, &chunkOffset);
+            originPath, &path, &chunkOffset);
         if (!parseSuccess) {
             LOG(ERROR) << "Parse curve chunk path failed."
                        << "originPath: " << originPath;
             done->SetFailed();
             return;
         }
-        DownloadFromCurve(fileName, chunkOffset + context->offset,
-                          context->size, context->buf,
-                          done);
-        doneGuard.release();
+        offset = chunkOffset + context->offset;
     } else if (type == OriginType::S3Origin) {
-        DownloadFromS3(originPath, context->offset,
-                       context->size, context->buf,
-                       done);
-        doneGuard.release();
+        path = originPath;
+        offset = context->offset;
     } else {
         LOG(ERROR) << "Unknown origin location."
                    << "location: " << context->location;
         done->SetFailed();
+        return;
+    }
+
+    if (blockCache_ != nullptr) {
+        off_t chunkEnd = chunkSize_ > 0
+                             ? offset - context->offset + chunkSize_
+                             : offset + context->size;
+        DownloadThroughCache(type, path, offset, context->size, context->buf,
+                             chunkEnd, done);
+    } else {
+        DownloadFromOrigin(type, path, offset, context->size, context->buf,
+                           done);
+    }
+    doneGuard.release();
+}
+
+void OriginCopyer::DownloadFromOrigin(OriginType type,
+                                      const string& path,
+                                      off_t off,
+                                      size_t size,
+                                      char* buf,
+                                      DownloadClosure* done) {
+    if (type == OriginType::CurveOrigin) {
+        DownloadFromCurve(path, off, size, buf, done);
+    } else {
+        DownloadFromS3(path, off, size, buf, done);
+    }
+}
+
+std::string OriginCopyer::BlockKey(OriginType type,
+                                   const string& path,
+                                   uint64_t blockIndex) {
+    return std::to_string(static_cast<int>(type)) + ":" + path + ":" +
+           std::to_string(blockIndex);
+}
+
+void OriginCopyer::DownloadThroughCache(OriginType type,
+                                        const string& path,
+                                        off_t off,
+                                        size_t size,
+                                        char* buf,
+                                        off_t chunkEnd,
+                                        DownloadClosure* done) {
+    if (size == 0) {
+        DownloadFromOrigin(type, path, off, size, buf, done);
+        return;
+    }
+
+    uint64_t firstBlock = off / blockSize_;
+    uint64_t lastBlock = (off + size - 1) / blockSize_;
+    // 预取不超出请求所在的chunk
+    uint64_t chunkLastBlock =
+        std::max<uint64_t>((chunkEnd - 1) / blockSize_, lastBlock);
+    uint64_t prefetchEnd =
+        std::min<uint64_t>(lastBlock + prefetchBlocks_, chunkLastBlock);
+
+    CachedReadRequest* request = new CachedReadRequest();
+    request->type = type;
+    request->path = path;
+    request->offset = off;
+    request->size = size;
+    request->buf = buf;
+    request->done = done;
+    // 多计一次，避免在所有块登记完之前回调
+    request->pending.store(lastBlock - firstBlock + 2);
+    request->failed.store(false);
+
+    std::vector<std::pair<uint64_t, std::shared_ptr<std::string>>> hits;
+    std::vector<std::pair<uint64_t, std::string>> fetches;
+    {
+        std::lock_guard<std::mutex> lock(blockMtx_);
+        for (uint64_t index = firstBlock; index <= lastBlock; ++index) {
+            std::string key = BlockKey(type, path, index);
+            std::shared_ptr<std::string> block;
+            if (blockCache_->Get(key, &block)) {
+                hits.emplace_back(index, block);
+                continue;
+            }
+            auto iter = inflightBlocks_.find(key);
+            if (iter == inflightBlocks_.end()) {
+                iter = inflightBlocks_.emplace(
+                    key, std::vector<BlockWaiter>()).first;
+                fetches.emplace_back(index, key);
+            }
+            iter->second.push_back({request, index});
+        }
+        // 没有等待者的块只用于填充缓存
+        for (uint64_t index = lastBlock + 1; index <= prefetchEnd; ++index) {
+            std::string key = BlockKey(type, path, index);
+            std::shared_ptr<std::string> block;
+            if (inflightBlocks_.count(key) > 0 ||
+                blockCache_->Get(key, &block)) {
+                continue;
+            }
+            inflightBlocks_.emplace(key, std::vector<BlockWaiter>());
+            fetches.emplace_back(index, key);
+        }
+    }
+
+    for (auto& hit : hits) {
+        CopyFromBlock(request, hit.first, *hit.second);
+        FinishCachedRead(request);
+    }
+    for (auto& fetch : fetches) {
+        FetchBlock(type, path, fetch.first, fetch.second);
+    }
+    FinishCachedRead(request);
+}
+
+void OriginCopyer::FetchBlock(OriginType type,
+                              const string& path,
+                              uint64_t blockIndex,
+                              const std::string& key) {
+    BlockDownloadClosure* closure =
+        new BlockDownloadClosure(this, key, blockSize_);
+    DownloadFromOrigin(type, path, blockIndex * blockSize_, blockSize_,
+                       closure->Buffer(), closure);
+}
+
+void OriginCopyer::OnBlockFetched(const std::string& key,
+                                  std::shared_ptr<std::string> block,
+                                  bool failed) {
+    std::vector<BlockWaiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(blockMtx_);
+        auto iter = inflightBlocks_.find(key);
+        if (iter != inflightBlocks_.end()) {
+            waiters.swap(iter->second);
+            inflightBlocks_.erase(iter);
+        }
+        if (!failed) {
+            blockCache_->Put(key, block);
+        }
+    }
+
+    for (auto& waiter : waiters) {
+        if (failed) {
+            waiter.request->failed.store(true);
+        } else {
+            CopyFromBlock(waiter.request, waiter.blockIndex, *block);
+        }
+        FinishCachedRead(waiter.request);
+    }
+}
+
+void OriginCopyer::CopyFromBlock(const CachedReadRequest* request,
+                                 uint64_t blockIndex,
+                                 const std::string& block) {
+    uint64_t blockStart = blockIndex * blockSize_;
+    uint64_t start = std::max<uint64_t>(blockStart, request->offset);
+    uint64_t end = std::min<uint64_t>(blockStart + block.size(),
+                                      request->offset + request->size);
+    if (start >= end) {
+        return;
+    }
+    memcpy(request->buf + (start - request->offset),
+           block.data() + (start - blockStart), end - start);
+}
+
+void OriginCopyer::FinishCachedRead(CachedReadRequest* request) {
+    if (request->pending.fetch_sub(1) != 1) {
+        return;
+    }
+
+    std::unique_ptr<CachedReadRequest> requestGuard(request);
+    if (request->failed.load()) {
+        // 源端的数据可能不足一个块，按请求的区域直接下载
+        DownloadFromOrigin(request->type, request->path, request->offset,
+                           request->size, request->buf, request->done);
+        return;
     }
+    brpc::ClosureGuard doneGuard(request->done);
 }
 
 void OriginCopyer::DownloadFromS3(const string& objectName,
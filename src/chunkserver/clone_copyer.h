@@ -28,6 +28,7 @@
 #include <unordered_map>
 #include <string>
 #include <list>
+#include <vector>
 
 #include "include/chunkserver/chunkserver_common.h"
 #include "src/common/location_operator.h"
@@ -36,6 +37,7 @@
 #include "src/client/client_common.h"
 #include "include/client/libcurve.h"
 #include "src/common/s3_adapter.h"
+#include "src/common/lru_cache.h"
 
 namespace curve {
 namespace chunkserver {
@@ -47,6 +49,8 @@ using curve::common::LocationOperator;
 using curve::common::OriginType;
 using curve::common::GetObjectAsyncCallBack;
 using curve::common::GetObjectAsyncContext;
+using curve::common::LRUCache;
+using curve::common::CacheMetrics;
 using std::string;
 
 class DownloadClosure;
@@ -64,6 +68,14 @@ struct CopyerOptions {
     std::shared_ptr<S3Adapter> s3Client;
     // curve file's time to live
     uint64_t curveFileTimeoutSec;
+    // chunk的大小，预取不会超出请求所在的chunk
+    uint32_t chunkSize = 0;
+    // 源端数据缓存的总字节数，为0表示不缓存
+    uint64_t sourceCacheBytes = 0;
+    // 源端数据按块缓存，每个块的大小，需要能整除chunk大小
+    uint32_t sourceCacheBlockSize = 1024 * 1024;
+    // 读源端数据时，预取请求之后的块的个数
+    uint32_t sourcePrefetchBlocks = 0;
 };
 
 struct AsyncDownloadContext {
@@ -92,6 +104,16 @@ struct CurveOpenTimestamp {
 
 std::ostream& operator<<(std::ostream& out, const AsyncDownloadContext& rhs);
 
+struct SourceBlockTraits {
+    static uint64_t CountBytes(const std::shared_ptr<std::string>& block) {
+        return block->size();
+    }
+};
+
+using SourceBlockCache = LRUCache<std::string, std::shared_ptr<std::string>,
+                                  curve::common::CacheTraits<std::string>,
+                                  SourceBlockTraits>;
+
 class OriginCopyer {
  public:
     OriginCopyer();
@@ -118,6 +140,47 @@ class OriginCopyer {
     virtual void DownloadAsync(DownloadClosure* done);
 
  private:
+    // 一次通过缓存读取源端数据的请求
+    struct CachedReadRequest;
+    // 等待某个正在下载的块的请求
+    struct BlockWaiter {
+        CachedReadRequest* request;
+        uint64_t blockIndex;
+    };
+    class BlockDownloadClosure;
+
+    void DownloadFromOrigin(OriginType type,
+                            const string& path,
+                            off_t off,
+                            size_t size,
+                            char* buf,
+                            DownloadClosure* done);
+    /**
+     * 按块通过缓存读取源端数据，命中的块直接拷贝，正在下载的块等待下载完成，
+     * 其余的块发起下载；任何一个块下载失败时，退化为直接下载请求的区域
+     */
+    void DownloadThroughCache(OriginType type,
+                              const string& path,
+                              off_t off,
+                              size_t size,
+                              char* buf,
+                              off_t chunkEnd,
+                              DownloadClosure* done);
+    // 发起一个块的下载，调用前需要已经在inflightBlocks_中登记
+    void FetchBlock(OriginType type, const string& path,
+                    uint64_t blockIndex, const std::string& key);
+    // 块下载完成后加入缓存，并将数据拷贝给等待的请求
+    void OnBlockFetched(const std::string& key,
+                        std::shared_ptr<std::string> block,
+                        bool failed);
+    // 请求的一个块完成，所有块完成后回调
+    void FinishCachedRead(CachedReadRequest* request);
+    static std::string BlockKey(OriginType type, const string& path,
+                                uint64_t blockIndex);
+    void CopyFromBlock(const CachedReadRequest* request,
+                       uint64_t blockIndex,
+                       const std::string& block);
+
     void DownloadFromS3(const string& objectName,
                        off_t off,
                        size_t size,
@@ -151,6 +214,15 @@ class OriginCopyer {
     bthread::TimerThread timer_;
     // timer's task id
     bthread::TimerThread::TaskId timerId_;
+    // 源端数据的块缓存，未开启时为nullptr
+    std::shared_ptr<SourceBlockCache> blockCache_;
+    uint32_t blockSize_;
+    uint32_t prefetchBlocks_;
+    uint32_t chunkSize_;
+    // 保护inflightBlocks_，并保证查询缓存和登记下载的原子性
+    std::mutex blockMtx_;
+    // 正在下载的块 -> 等待该块的请求，同一个块只下载一次
+    std::unordered_map<std::string, std::vector<BlockWaiter>> inflightBlocks_;
 };
 
 }  // namespace chunkserver
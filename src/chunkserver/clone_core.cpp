@@ -30,10 +30,15 @@
 #include "src/chunkserver/chunk_service_closure.h"
 #include "src/chunkserver/datastore/chunkserver_datastore.h"
 #include "src/common/timeutility.h"
+#include "src/common/aligned_buffer_pool.h"
+#include "src/common/background_io_scheduler.h"
 
 namespace curve {
 namespace chunkserver {
 
+using curve::common::AlignedBufferPool;
+using curve::common::BackgroundIOScheduler;
+using curve::common::BackgroundIOType;
 using curve::common::Bitmap;
 using curve::common::TimeUtility;
 
@@ -225,6 +230,12 @@ int CloneCore::HandleReadRequest(
     brpc::ClosureGuard doneGuard(done);
     const ChunkRequest* request = readRequest->request_;
 
+    // 用户的读请求属于前台IO，只限制恢复clone chunk的请求
+    if (request->optype() == CHUNK_OP_TYPE::CHUNK_OP_RECOVER) {
+        BackgroundIOScheduler::GetInstance().Acquire(BackgroundIOType::CLONE,
+                                                     request->size());
+    }
+
     // 获取chunk信息
     CSChunkInfo chunkInfo;
     ChunkID id = readRequest->ChunkId();
@@ -329,10 +340,12 @@ int CloneCore::SetReadChunkResponse(
     butil::IOBuf responseData;
     // 如果chunk存在，则要从chunk中读取已经写过的区域合并后返回
     if (errorCode == CSErrorCode::Success) {
-        char* chunkData = new (std::nothrow) char[length];
+        AlignedBufferPool& bufferPool = AlignedBufferPool::GetInstance();
+        char* chunkData = bufferPool.Alloc(length);
         int ret = ReadThenMerge(
             readRequest, chunkInfo, cloneData, chunkData);
-        responseData.append_user_data(chunkData, length, ReadBufferDeleter);
+        responseData.append_user_data(chunkData, length,
+                                      bufferPool.GetDeleter(length));
         if (ret < 0) {
             SetResponse(readRequest,
                         CHUNK_OP_STATUS::CHUNK_OP_STATUS_FAILURE_UNKNOWN);
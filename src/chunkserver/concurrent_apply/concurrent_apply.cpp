@@ -31,6 +31,11 @@ using ::curve::common::CountDownEvent;
 namespace curve {
 namespace chunkserver {
 namespace concurrent {
+
+const int ConcurrentApplyModule::kDefaultQueueFactor;
+const int ConcurrentApplyModule::kMaxBatchSize;
+std::atomic<uint32_t> ConcurrentApplyModule::instanceCount_(0);
+
 bool ConcurrentApplyModule::Init(const ConcurrentApplyOption &opt) {
     if (start_) {
         LOG(WARNING) << "concurrent module already start!";
@@ -43,8 +48,12 @@ bool ConcurrentApplyModule::Init(const ConcurrentApplyOption &opt) {
 
     start_ = true;
     cond_.Reset(opt.rconcurrentsize + opt.wconcurrentsize);
-    InitThreadPool(ApplyTaskType::READ, rconcurrentsize_, rqueuedepth_);
-    InitThreadPool(ApplyTaskType::WRITE, wconcurrentsize_, wqueuedepth_);
+    std::string metricPrefix = "concurrent_apply_" +
+        std::to_string(instanceCount_.fetch_add(1));
+    InitThreadPool(ApplyTaskType::READ, rconcurrentsize_,
+                   rqueuenum_, rqueuedepth_, metricPrefix);
+    InitThreadPool(ApplyTaskType::WRITE, wconcurrentsize_,
+                   wqueuenum_, wqueuedepth_, metricPrefix);
 
     if (!cond_.WaitFor(5000)) {
         LOG(ERROR) << "init concurrent module's threads fail";
@@ -71,79 +80,142 @@ bool ConcurrentApplyModule::checkOptAndInit(
     wqueuedepth_ = opt.wqueuedepth;
     rconcurrentsize_ = opt.rconcurrentsize;
     rqueuedepth_ = opt.rqueuedepth;
+    // fewer queues than threads would leave threads idle
+    wqueuenum_ = opt.wqueuenum > 0 ?
+        std::max(opt.wqueuenum, wconcurrentsize_) :
+        wconcurrentsize_ * kDefaultQueueFactor;
+    rqueuenum_ = opt.rqueuenum > 0 ?
+        std::max(opt.rqueuenum, rconcurrentsize_) :
+        rconcurrentsize_ * kDefaultQueueFactor;
 
     return true;
 }
 
 
 void ConcurrentApplyModule::InitThreadPool(
-    ApplyTaskType type, int concurrent, int depth) {
-    for (int i = 0; i < concurrent; i++) {
-        auto asyncth = new (std::nothrow) TaskThread(depth);
-        CHECK(asyncth != nullptr) << "allocate failed!";
+    ApplyTaskType type, int concurrent, int queueNum, int depth,
+    const std::string& metricPrefix) {
+    ApplyPool* pool = GetPool(type);
+    std::string prefix = metricPrefix +
+        (type == ApplyTaskType::READ ? "_read" : "_write");
+    pool->waitLatency.expose(prefix, "wait");
+    for (int i = 0; i < queueNum; i++) {
+        auto queue = new (std::nothrow) ApplyQueue(depth);
+        CHECK(queue != nullptr) << "allocate failed!";
+        std::string queuePrefix = prefix + "_queue_" + std::to_string(i);
+        queue->depth.reset(new bvar::PassiveStatus<uint32_t>(
+            queuePrefix, "depth",
+            &ConcurrentApplyModule::GetQueueDepth, queue));
+        queue->waitLatency.reset(
+            new bvar::LatencyRecorder(queuePrefix, "wait"));
+        pool->queues.push_back(queue);
+    }
 
-        switch (type) {
-        case ApplyTaskType::READ:
-            rapplyMap_.insert(std::make_pair(i, asyncth));
-            break;
+    for (int i = 0; i < concurrent; i++) {
+        pool->threads.emplace_back(&ConcurrentApplyModule::Run, this, pool);
+    }
+}
 
-        case ApplyTaskType::WRITE:
-            wapplyMap_.insert(std::make_pair(i, asyncth));
-            break;
+void ConcurrentApplyModule::PushTask(ApplyPool* pool, ApplyQueue* queue,
+                                     Task task) {
+    bool schedule = false;
+    {
+        std::unique_lock<bthread::Mutex> lk(queue->mtx);
+        while (queue->tasks.size() >= queue->capacity) {
+            queue->notFull.wait(lk);
+        }
+        queue->tasks.push_back({std::move(task),
+                                TimeUtility::GetTimeofDayUs()});
+        if (!queue->scheduled) {
+            queue->scheduled = true;
+            schedule = true;
         }
     }
 
-    for (int i = 0; i < concurrent; i++) {
-        switch (type) {
-        case ApplyTaskType::READ:
-            rapplyMap_[i]->th =
-                    std::thread(&ConcurrentApplyModule::Run, this, type, i);
-            break;
-
-        case ApplyTaskType::WRITE:
-            wapplyMap_[i]->th =
-                    std::thread(&ConcurrentApplyModule::Run, this, type, i);
-            break;
+    if (schedule) {
+        {
+            std::lock_guard<bthread::Mutex> lk(pool->readyMtx);
+            pool->ready.push_back(queue);
         }
+        pool->readyCond.notify_one();
     }
 }
 
-void ConcurrentApplyModule::Run(ApplyTaskType type, int index) {
+void ConcurrentApplyModule::Run(ApplyPool* pool) {
     cond_.Signal();
-    while (start_) {
-        switch (type) {
-        case ApplyTaskType::READ:
-            rapplyMap_[index]->tq.Pop()();
-            break;
-
-        case ApplyTaskType::WRITE:
-            wapplyMap_[index]->tq.Pop()();
-            break;
+    while (true) {
+        ApplyQueue* queue = nullptr;
+        {
+            std::unique_lock<bthread::Mutex> lk(pool->readyMtx);
+            while (pool->ready.empty() && start_) {
+                pool->readyCond.wait(lk);
+            }
+            // exit after all the pushed tasks are executed
+            if (pool->ready.empty()) {
+                break;
+            }
+            queue = pool->ready.front();
+            pool->ready.pop_front();
         }
+        RunQueue(pool, queue);
     }
 }
 
-void ConcurrentApplyModule::Stop() {
-    if (!start_.exchange(false)) {
-        return;
+void ConcurrentApplyModule::RunQueue(ApplyPool* pool, ApplyQueue* queue) {
+    for (int i = 0; i < kMaxBatchSize; i++) {
+        ApplyQueue::QueuedTask task;
+        {
+            std::lock_guard<bthread::Mutex> lk(queue->mtx);
+            if (queue->tasks.empty()) {
+                queue->scheduled = false;
+                return;
+            }
+            task = std::move(queue->tasks.front());
+            queue->tasks.pop_front();
+        }
+        queue->notFull.notify_one();
+        uint64_t waitUs = TimeUtility::GetTimeofDayUs() - task.pushUs;
+        pool->waitLatency << waitUs;
+        *queue->waitLatency << waitUs;
+        task.task();
     }
 
-    LOG(INFO) << "stop ConcurrentApplyModule...";
-    auto wakeup = []() {};
-    for (auto iter : rapplyMap_) {
-        iter.second->tq.Push(wakeup);
-        iter.second->th.join();
-        delete iter.second;
+    // the queue may still have tasks, put it to the tail of the ready list
+    // so that the other queues get executed
+    std::lock_guard<bthread::Mutex> lk(pool->readyMtx);
+    pool->ready.push_back(queue);
+}
+
+uint32_t ConcurrentApplyModule::GetQueueDepth(void* arg) {
+    ApplyQueue* queue = static_cast<ApplyQueue*>(arg);
+    std::lock_guard<bthread::Mutex> lk(queue->mtx);
+    return queue->tasks.size();
+}
+
+void ConcurrentApplyModule::StopThreadPool(ApplyPool* pool) {
+    {
+        std::lock_guard<bthread::Mutex> lk(pool->readyMtx);
+        pool->readyCond.notify_all();
+    }
+    for (auto& th : pool->threads) {
+        th.join();
     }
-    rapplyMap_.clear();
+    pool->threads.clear();
 
-    for (auto iter : wapplyMap_) {
-        iter.second->tq.Push(wakeup);
-        iter.second->th.join();
-        delete iter.second;
+    for (auto queue : pool->queues) {
+        delete queue;
     }
-    wapplyMap_.clear();
+    pool->queues.clear();
+}
 
+void ConcurrentApplyModule::Stop() {
+    if (!start_.exchange(false)) {
+        return;
+    }
+
+    LOG(INFO) << "stop ConcurrentApplyModule...";
+    StopThreadPool(&rpool_);
+    StopThreadPool(&wpool_);
     LOG(INFO) << "stop ConcurrentApplyModule ok.";
 }
 
@@ -152,11 +224,11 @@ void ConcurrentApplyModule::Flush() {
         return;
     }
 
-    CountDownEvent event(wconcurrentsize_);
+    CountDownEvent event(wpool_.queues.size());
     auto flushtask = [&event]() { event.Signal(); };
 
-    for (int i = 0; i < wconcurrentsize_; i++) {
-        wapplyMap_[i]->tq.Push(flushtask);
+    for (auto queue : wpool_.queues) {
+        PushTask(&wpool_, queue, flushtask);
     }
 
     event.Wait();
@@ -167,15 +239,15 @@ void ConcurrentApplyModule::FlushAll() {
         return;
     }
 
-    CountDownEvent event(wconcurrentsize_ + rconcurrentsize_);
+    CountDownEvent event(wpool_.queues.size() + rpool_.queues.size());
     auto flushtask = [&event]() { event.Signal(); };
 
-    for (int i = 0; i < wconcurrentsize_; i++) {
-        wapplyMap_[i]->tq.Push(flushtask);
+    for (auto queue : wpool_.queues) {
+        PushTask(&wpool_, queue, flushtask);
     }
 
-    for (int i = 0; i < rconcurrentsize_; i++) {
-        rapplyMap_[i]->tq.Push(flushtask);
+    for (auto queue : rpool_.queues) {
+        PushTask(&rpool_, queue, flushtask);
     }
 
     event.Wait();
@@ -25,19 +25,24 @@
 
 #include <bthread/condition_variable.h>
 #include <bthread/mutex.h>
+#include <bvar/bvar.h>
 #include <glog/logging.h>
 
 #include <atomic>
 #include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>               // NOLINT
+#include <string>
 #include <thread>              // NOLINT
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "include/curve_compiler_specific.h"
 #include "proto/chunk.pb.h"
 #include "src/common/concurrent/count_down_event.h"
-#include "src/common/concurrent/task_queue.h"
+#include "src/common/timeutility.h"
 
 using curve::common::CountDownEvent;
 using curve::chunkserver::CHUNK_OP_TYPE;
@@ -46,31 +51,55 @@ namespace curve {
 namespace chunkserver {
 namespace concurrent {
 
-using ::curve::common::GenericTaskQueue;
+using ::curve::common::TimeUtility;
 
 struct ConcurrentApplyOption {
     int wconcurrentsize;
     int wqueuedepth;
     int rconcurrentsize;
     int rqueuedepth;
+    // num of write/read queues, tasks are hashed to queues and the queues
+    // are shared by the threads, <= 0 means kDefaultQueueFactor * threads
+    int wqueuenum;
+    int rqueuenum;
 
     ConcurrentApplyOption(int wconcurrentsize = 0, int wqueuedepth = 0,
-                          int rconcurrentsize = 0, int rqueuedepth = 0)
+                          int rconcurrentsize = 0, int rqueuedepth = 0,
+                          int wqueuenum = 0, int rqueuenum = 0)
         : wconcurrentsize(wconcurrentsize), wqueuedepth(wqueuedepth),
-          rconcurrentsize(rconcurrentsize), rqueuedepth(rqueuedepth) {}
+          rconcurrentsize(rconcurrentsize), rqueuedepth(rqueuedepth),
+          wqueuenum(wqueuenum), rqueuenum(rqueuenum) {}
 };
 
 enum class ApplyTaskType {READ, WRITE};
 
+/**
+ * Tasks are hashed by key to queues, tasks in the same queue are executed
+ * in order and a queue is processed by at most one thread at a time.
+ * The queues are not bound to threads: a queue with pending tasks is put
+ * on the ready list of its pool and any idle thread of the pool takes it,
+ * so a slow task only blocks the tasks hashed to its own queue.
+ */
 class CURVE_CACHELINE_ALIGNMENT ConcurrentApplyModule {
  public:
+    // default num of queues for each thread
+    static const int kDefaultQueueFactor = 4;
+    // max num of tasks executed each time a thread takes a queue
+    static const int kMaxBatchSize = 16;
+
     ConcurrentApplyModule(): start_(false),
                              rconcurrentsize_(0),
                              rqueuedepth_(0),
+                             rqueuenum_(0),
                              wconcurrentsize_(0),
                              wqueuedepth_(0),
+                             wqueuenum_(0),
                              cond_(0) {}
 
+    ~ConcurrentApplyModule() {
+        Stop();
+    }
+
     /**
      * Init: initialize ConcurrentApplyModule
      * @param[in] wconcurrentsize: num of write threads
@@ -89,17 +118,10 @@ class CURVE_CACHELINE_ALIGNMENT ConcurrentApplyModule {
      */
     template <class F, class... Args>
     bool Push(uint64_t key, ApplyTaskType optype, F&& f, Args&&... args) {
-        switch (optype) {
-            case ApplyTaskType::READ:
-                rapplyMap_[Hash(key, rconcurrentsize_)]->tq.Push(
-                        std::forward<F>(f), std::forward<Args>(args)...);
-                break;
-            case ApplyTaskType::WRITE:
-                wapplyMap_[Hash(key, wconcurrentsize_)]->tq.Push(
-                        std::forward<F>(f), std::forward<Args>(args)...);
-                break;
-        }
-
+        ApplyPool* pool = GetPool(optype);
+        ApplyQueue* queue = pool->queues[Hash(key, pool->queues.size())];
+        PushTask(pool, queue, std::bind(std::forward<F>(f),
+                                        std::forward<Args>(args)...));
         return true;
     }
 
@@ -112,31 +134,80 @@ class CURVE_CACHELINE_ALIGNMENT ConcurrentApplyModule {
     void Stop();
 
  private:
+    using Task = std::function<void()>;
+
+    struct ApplyQueue {
+        struct QueuedTask {
+            Task task;
+            // time the task is pushed, to measure the wait time
+            uint64_t pushUs;
+        };
+
+        bthread::Mutex mtx;
+        bthread::ConditionVariable notFull;
+        std::deque<QueuedTask> tasks;
+        size_t capacity;
+        // true if the queue is on the ready list or being processed
+        bool scheduled;
+        std::unique_ptr<bvar::PassiveStatus<uint32_t>> depth;
+        // time tasks wait in this queue before executed
+        std::unique_ptr<bvar::LatencyRecorder> waitLatency;
+
+        explicit ApplyQueue(size_t cap) : capacity(cap), scheduled(false) {}
+    };
+
+    // threads of one task type and the queues processed by them
+    struct ApplyPool {
+        std::vector<ApplyQueue*> queues;
+        std::vector<std::thread> threads;
+        bthread::Mutex readyMtx;
+        bthread::ConditionVariable readyCond;
+        // queues with pending tasks and not being processed
+        std::deque<ApplyQueue*> ready;
+        // time tasks wait in all the queues of the pool before executed
+        bvar::LatencyRecorder waitLatency;
+    };
+
     bool checkOptAndInit(const ConcurrentApplyOption &option);
 
-    void Run(ApplyTaskType type, int index);
+    void Run(ApplyPool* pool);
 
-    void InitThreadPool(ApplyTaskType type, int concorrent, int depth);
+    // execute at most kMaxBatchSize tasks of the queue
+    void RunQueue(ApplyPool* pool, ApplyQueue* queue);
+
+    void PushTask(ApplyPool* pool, ApplyQueue* queue, Task task);
+
+    void InitThreadPool(ApplyTaskType type, int concorrent,
+                        int queueNum, int depth,
+                        const std::string& metricPrefix);
+
+    void StopThreadPool(ApplyPool* pool);
+
+    ApplyPool* GetPool(ApplyTaskType type) {
+        return type == ApplyTaskType::READ ? &rpool_ : &wpool_;
+    }
+
+    static uint32_t GetQueueDepth(void* arg);
 
     static int Hash(uint64_t key, int concurrent) {
         return key % concurrent;
     }
 
- private:
-    struct TaskThread {
-        std::thread th;
-        GenericTaskQueue<bthread::Mutex, bthread::ConditionVariable> tq;
-        explicit TaskThread(size_t capacity) : tq(capacity) {}
-    };
+    // metrics of different modules in the same process are exposed with
+    // different prefixes
+    static std::atomic<uint32_t> instanceCount_;
 
+ private:
     std::atomic<bool> start_;
     int rconcurrentsize_;
     int rqueuedepth_;
+    int rqueuenum_;
     int wconcurrentsize_;
     int wqueuedepth_;
+    int wqueuenum_;
     CountDownEvent cond_;
-    CURVE_CACHELINE_ALIGNMENT std::unordered_map<int, TaskThread*> wapplyMap_;
-    CURVE_CACHELINE_ALIGNMENT std::unordered_map<int, TaskThread*> rapplyMap_;
+    CURVE_CACHELINE_ALIGNMENT ApplyPool wpool_;
+    CURVE_CACHELINE_ALIGNMENT ApplyPool rpool_;
 };
 }   // namespace concurrent
 }   // namespace chunkserver
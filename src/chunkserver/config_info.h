@@ -27,6 +27,7 @@
 #include <memory>
 
 #include "src/fs/local_filesystem.h"
+#include "src/chunkserver/datastore/block_cache.h"
 #include "src/chunkserver/trash.h"
 #include "src/chunkserver/inflight_throttle.h"
 #include "src/chunkserver/concurrent_apply/concurrent_apply.h"
@@ -118,6 +119,8 @@ struct CopysetNodeOptions {
 
     // 限制chunkserver启动时copyset并发恢复加载的数量,为0表示不限制
     uint32_t loadConcurrency = 0;
+    // 每个copyset启动时并发加载chunk文件的线程数，不大于1表示串行加载
+    uint32_t chunkLoadConcurrency = 1;
     // chunkserver sync_thread_pool number of threads.
     uint32_t syncConcurrency = 20;
     // copyset trigger sync timeout
@@ -134,12 +137,30 @@ struct CopysetNodeOptions {
 
     // enable O_DSYNC when open chunkfile
     bool enableOdsyncWhenOpenChunkFile = false;
+    // read aligned chunk data with O_DIRECT
+    bool enableODirectRead = false;
+    // 所有chunk文件以O_DIRECT打开的fd总数上限，超过后按buffered io读，
+    // 为0表示不限制
+    uint32_t maxODirectReadFds = 16384;
+    // clone chunk连续多少次paste更新一次metapage，为1表示每次paste都更新
+    uint32_t pasteMetaPageBatch = 1;
+    // chunk数据块缓存的总字节数，为0表示不缓存
+    uint64_t blockCacheBytes = 0;
+    // chunk数据按块缓存，每个块的大小，需要能整除chunk大小
+    uint32_t blockCacheBlockSize = 64 * 1024;
+    // 所有copyset共享的chunk数据块缓存，未开启时为nullptr
+    std::shared_ptr<CSBlockCache> blockCache;
     // syncChunkLimit default limit
     uint64_t syncChunkLimit = 2 * 1024 * 1024;
     // syncHighChunkLimit default limit = 64k
     uint64_t syncThreshold = 64 * 1024;
-    // check syncing interval
-    uint32_t checkSyncingIntervalMs = 500u;
+
+    // 是否合并同一个chunk上相邻的顺序小写
+    bool enableWriteCoalesce = false;
+    // 合并后一次写入的最大字节数
+    uint32_t writeCoalesceMaxBytes = 128 * 1024;
+    // 合并前等待后续请求到达的时间，为0表示只合并已经积压的请求
+    uint32_t writeCoalesceWaitUs = 0;
 
     CopysetNodeOptions();
 };
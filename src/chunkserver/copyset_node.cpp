@@ -28,13 +28,12 @@
 #include <braft/closure_helper.h>
 #include <braft/snapshot.h>
 #include <braft/protobuf_file.h>
+#include <braft/local_file_meta.pb.h>
 #include <utility>
 #include <memory>
 #include <algorithm>
 #include <cassert>
 #include <future>
-#include <deque>
-#include <set>
 #include <chrono>
 #include <condition_variable>
 
@@ -46,6 +45,7 @@
 #include "src/chunkserver/copyset_node_manager.h"
 #include "src/chunkserver/datastore/define.h"
 #include "src/chunkserver/datastore/datastore_file_helper.h"
+#include "src/chunkserver/datastore/filename_operator.h"
 #include "src/common/uri_parser.h"
 #include "src/common/crc32.h"
 #include "src/common/fs_util.h"
@@ -61,9 +61,8 @@ using curve::fs::FileSystemInfo;
 
 const char *kCurveConfEpochFilename = "conf.epoch";
 
-uint32_t CopysetNode::syncTriggerSeconds_ = 25;
-std::shared_ptr<common::TaskThreadPool<>>
-    CopysetNode::copysetSyncPool_ = nullptr;
+std::shared_ptr<GroupSyncer>
+    CopysetNode::groupSyncer_ = std::make_shared<GroupSyncer>();
 
 CopysetNode::CopysetNode(const LogicPoolID &logicPoolId,
                          const CopysetID &copysetId,
@@ -84,8 +83,8 @@ CopysetNode::CopysetNode(const LogicPoolID &logicPoolId,
     scaning_(false),
     lastScanSec_(0),
     enableOdsyncWhenOpenChunkFile_(false),
-    isSyncing_(false),
-    checkSyncingIntervalMs_(500) {
+    chunkModifiedBase_(0),
+    snapshotModifiedBase_(0) {
 }
 
 CopysetNode::~CopysetNode() {
@@ -135,6 +134,11 @@ int CopysetNode::Init(const CopysetNodeOptions &options) {
     dsOptions.locationLimit = options.locationLimit;
     dsOptions.enableOdsyncWhenOpenChunkFile =
         options.enableOdsyncWhenOpenChunkFile;
+    dsOptions.enableODirectRead = options.enableODirectRead;
+    dsOptions.maxODirectReadFds = options.maxODirectReadFds;
+    dsOptions.loadConcurrency = options.chunkLoadConcurrency;
+    dsOptions.pasteMetaPageBatch = options.pasteMetaPageBatch;
+    dsOptions.blockCache = options.blockCache;
     dataStore_ = std::make_shared<CSDataStore>(options.localFileSystem,
                                                options.chunkFilePool,
                                                dsOptions);
@@ -147,11 +151,10 @@ int CopysetNode::Init(const CopysetNodeOptions &options) {
     }
     enableOdsyncWhenOpenChunkFile_ = options.enableOdsyncWhenOpenChunkFile;
     if (!enableOdsyncWhenOpenChunkFile_) {
-        syncThread_.Init(this);
-        dataStore_->SetCacheCondPtr(syncThread_.cond_);
+        dataStore_->SetCacheCondPtr(groupSyncer_->GetCond());
         dataStore_->SetCacheLimits(options.syncChunkLimit,
             options.syncThreshold);
-        LOG(INFO) << "init sync thread success limit = "
+        LOG(INFO) << "init sync limits success limit = "
                   << options.syncChunkLimit <<
                   "syncthreshold = " << options.syncThreshold;
     }
@@ -177,6 +180,12 @@ int CopysetNode::Init(const CopysetNodeOptions &options) {
     peerId_ = PeerId(addr, 0);
     raftNode_ = std::make_shared<RaftNode>(groupId, peerId_);
     concurrentapply_ = options.concurrentapply;
+    if (options.enableWriteCoalesce) {
+        WriteCoalescerOptions coalescerOptions;
+        coalescerOptions.maxBytes = options.writeCoalesceMaxBytes;
+        coalescerOptions.waitUs = options.writeCoalesceWaitUs;
+        writeCoalescer_.reset(new WriteCoalescer(coalescerOptions));
+    }
 
 
     /*
@@ -207,8 +216,6 @@ int CopysetNode::Init(const CopysetNodeOptions &options) {
     // without using global variables.
     StoreOptForCurveSegmentLogStorage(lsOptions);
 
-    checkSyncingIntervalMs_ = options.checkSyncingIntervalMs;
-
     return 0;
 }
 
@@ -220,20 +227,12 @@ int CopysetNode::Run() {
         return -1;
     }
 
-    if (!enableOdsyncWhenOpenChunkFile_) {
-        syncThread_.Run();
-    }
-
     LOG(INFO) << "Run copyset success."
               << "Copyset: " << GroupIdString();
     return 0;
 }
 
 void CopysetNode::Fini() {
-    if (!enableOdsyncWhenOpenChunkFile_) {
-        syncThread_.Stop();
-    }
-
     WaitSnapshotDone();
 
     if (nullptr != raftNode_) {
@@ -303,6 +302,9 @@ void CopysetNode::on_apply(::braft::Iterator &iter) {
             CHECK(nullptr != chunkClosure)
                 << "ChunkClosure dynamic cast failed";
             std::shared_ptr<ChunkOpRequest>& opRequest = chunkClosure->request_;
+            opRequest->MarkTrace(IOTraceStage::COMMIT);
+            RecordChunkModified(opRequest->ChunkId(), opRequest->OpType(),
+                                iter.index());
             concurrentapply_->Push(opRequest->ChunkId(), ChunkOpRequest::Schedule(opRequest->OpType()),  // NOLINT
                                    &ChunkOpRequest::OnApply, opRequest,
                                    iter.index(), doneGuard.release());
@@ -320,6 +322,7 @@ void CopysetNode::on_apply(::braft::Iterator &iter) {
             auto opReq = ChunkOpRequest::Decode(log, &request, &data,
                                                 iter.index(), GetLeaderId());
             auto chunkId = request.chunkid();
+            RecordChunkModified(chunkId, request.optype(), iter.index());
             concurrentapply_->Push(chunkId, ChunkOpRequest::Schedule(request.optype()),  // NOLINT
                                    &ChunkOpRequest::OnApplyFromLog, opReq,
                                    dataStore_, std::move(request), data);
@@ -327,12 +330,29 @@ void CopysetNode::on_apply(::braft::Iterator &iter) {
     }
 }
 
+void CopysetNode::RecordChunkModified(ChunkID chunkId,
+                                      CHUNK_OP_TYPE opType,
+                                      int64_t index) {
+    switch (opType) {
+    case CHUNK_OP_TYPE::CHUNK_OP_READ:
+    case CHUNK_OP_TYPE::CHUNK_OP_READ_SNAP:
+    case CHUNK_OP_TYPE::CHUNK_OP_SCAN:
+        return;
+    default:
+        chunkModifiedIndex_[chunkId] = index;
+    }
+}
+
 void CopysetNode::on_shutdown() {
     LOG(INFO) << GroupIdString() << " is shutdown";
 }
 
 void CopysetNode::on_snapshot_save(::braft::SnapshotWriter *writer,
                                    ::braft::Closure *done) {
+    // on_snapshot_save在状态机线程中调用，此时所有小于等于快照index的op
+    // 都已经记录，拷贝一份给后台保存快照的线程使用
+    snapshotModifiedIndex_ = chunkModifiedIndex_;
+    snapshotModifiedBase_ = chunkModifiedBase_;
     snapshotFuture_ =
         std::async(std::launch::async,
             &CopysetNode::save_snapshot_background, this, writer, done);
@@ -390,7 +410,22 @@ void CopysetNode::save_snapshot_background(::braft::SnapshotWriter *writer,
             chunkApath.append("/").append(fileName);
             std::string filePath = curve::common::CalcRelativePath(
                                     writer->get_path(), chunkApath);
-            writer->add_file(filePath);
+            // chunk文件在meta的user_meta中记录其最后一次被修改的日志index，
+            // follower安装快照时，本地已经apply过该index的chunk可以直接复用
+            FileNameOperator::FileInfo info =
+                FileNameOperator::ParseFileName(fileName);
+            if (info.type != FileNameOperator::FileType::CHUNK) {
+                writer->add_file(filePath);
+                continue;
+            }
+            int64_t modifiedIndex = snapshotModifiedBase_;
+            auto iter = snapshotModifiedIndex_.find(info.id);
+            if (iter != snapshotModifiedIndex_.end()) {
+                modifiedIndex = iter->second;
+            }
+            braft::LocalFileMeta fileMeta;
+            fileMeta.set_user_meta(std::to_string(modifiedIndex));
+            writer->add_file(filePath, &fileMeta);
         }
     } else {
         done->status().set_error(errno, "invalid: %s", strerror(errno));
@@ -505,6 +540,10 @@ int CopysetNode::on_snapshot_load(::braft::SnapshotReader *reader) {
     LOG(INFO) << "update lastSnapshotIndex_ from " << lastSnapshotIndex_;
     lastSnapshotIndex_ = meta.last_included_index();
     LOG(INFO) << "to lastSnapshotIndex_: " << lastSnapshotIndex_;
+
+    // 快照之前的修改记录已经无法获知，快照中的chunk都按快照index处理
+    chunkModifiedIndex_.clear();
+    chunkModifiedBase_ = lastSnapshotIndex_;
     return 0;
 }
 
@@ -880,6 +919,10 @@ ConcurrentApplyModule *CopysetNode::GetConcurrentApplyModule() const {
     return concurrentapply_;
 }
 
+WriteCoalescer *CopysetNode::GetWriteCoalescer() const {
+    return writeCoalescer_.get();
+}
+
 void CopysetNode::Propose(const braft::Task &task) {
     raftNode_->apply(task);
 }
@@ -1046,73 +1089,10 @@ bool CopysetNode::GetLeaderStatus(NodeStatus *leaderStaus) {
     return true;
 }
 
-void CopysetNode::HandleSyncTimerOut() {
-    if (isSyncing_.exchange(true)) {
-        return;
-    }
-    SyncAllChunks();
-    isSyncing_ = false;
-}
-
 void CopysetNode::ForceSyncAllChunks() {
-    while (isSyncing_.exchange(true)) {
-        std::this_thread::sleep_for(
-            std::chrono::milliseconds(checkSyncingIntervalMs_));
-    }
-    SyncAllChunks();
-    isSyncing_ = false;
-}
-
-void CopysetNode::SyncAllChunks() {
-    std::deque<ChunkID> temp;
-    {
-        curve::common::LockGuard lg(chunkIdsLock_);
-        temp.swap(chunkIdsToSync_);
-    }
-    std::set<ChunkID> chunkIds;
-    for (auto chunkId : temp) {
-        chunkIds.insert(chunkId);
-    }
-    for (ChunkID chunk : chunkIds) {
-        copysetSyncPool_->Enqueue([=]() {
-            CSErrorCode r = dataStore_->SyncChunk(chunk);
-            if (r != CSErrorCode::Success) {
-                LOG(FATAL) << "Sync Chunk failed in Copyset: "
-                       << GroupIdString()
-                       << ", chunkid: " << chunk
-                       << " data store return: " << r;
-            }
-        });
-    }
-}
-
-void SyncChunkThread::Init(CopysetNode* node) {
-    running_ = true;
-    node_ = node;
-    cond_ = std::make_shared<std::condition_variable>();
-}
-
-void SyncChunkThread::Run() {
-    syncThread_ = std::thread([this](){
-        while (running_) {
-            std::unique_lock<std::mutex> lock(mtx_);
-            cond_->wait_for(lock,
-                std::chrono::seconds(CopysetNode::syncTriggerSeconds_));
-            node_->SyncAllChunks();
-        }
-    });
-}
-
-void SyncChunkThread::Stop() {
-    running_ = false;
-    if (syncThread_.joinable()) {
-        cond_->notify_one();
-        syncThread_.join();
-    }
-}
-
-SyncChunkThread::~SyncChunkThread() {
-    Stop();
+    // the chunks shipped before may be in the batch being synced now, flush
+    // waits for that batch and then syncs the remaining chunks of this copyset
+    groupSyncer_->Flush(dataStore_);
 }
 
 }  // namespace chunkserver
@@ -32,10 +32,11 @@
 #include <vector>
 #include <climits>
 #include <memory>
-#include <deque>
+#include <unordered_map>
 
 #include "src/chunkserver/concurrent_apply/concurrent_apply.h"
 #include "src/chunkserver/datastore/chunkserver_datastore.h"
+#include "src/chunkserver/datastore/group_syncer.h"
 #include "src/chunkserver/conf_epoch_file.h"
 #include "src/chunkserver/config_info.h"
 #include "src/chunkserver/chunkserver_metrics.h"
@@ -45,6 +46,7 @@
 #include "src/common/string_util.h"
 #include "src/common/concurrent/task_thread_pool.h"
 #include "src/chunkserver/raft_node.h"
+#include "src/chunkserver/write_coalescer.h"
 #include "proto/heartbeat.pb.h"
 #include "proto/chunk.pb.h"
 #include "proto/common.pb.h"
@@ -106,24 +108,6 @@ class ConfigurationChangeDone : public braft::Closure {
     ConfigurationChange expectedCfgChange;
 };
 
-class CopysetNode;
-
-class SyncChunkThread : public curve::common::Uncopyable {
- public:
-    friend class CopysetNode;
-    SyncChunkThread() = default;
-    ~SyncChunkThread();
-    void Run();
-    void Init(CopysetNode* node);
-    void Stop();
- private:
-    bool running_;
-    std::mutex mtx_;
-    std::shared_ptr<std::condition_variable> cond_;
-    std::thread syncThread_;
-    CopysetNode* node_;
-};
-
 /**
  * 一个Copyset Node就是一个复制组的副本
  */
@@ -315,6 +299,11 @@ class CopysetNode : public braft::StateMachine,
      */
     virtual ConcurrentApplyModule* GetConcurrentApplyModule() const;
 
+    /**
+     * 返回写合并模块，未开启写合并时返回nullptr
+     */
+    virtual WriteCoalescer* GetWriteCoalescer() const;
+
     /**
      * 向copyset node propose一个op request
      * @param task
@@ -430,10 +419,8 @@ class CopysetNode : public braft::StateMachine,
      * better for test
      */
  public:
-    // sync trigger seconds
-    static uint32_t syncTriggerSeconds_;
-    // shared to sync pool
-    static std::shared_ptr<TaskThreadPool<>> copysetSyncPool_;
+    // shared by all copysets to sync chunk files in batch
+    static std::shared_ptr<GroupSyncer> groupSyncer_;
     /**
      * 从文件中解析copyset配置版本信息
      * @param filePath:文件路径
@@ -457,14 +444,9 @@ class CopysetNode : public braft::StateMachine,
             return;
         }
 
-        curve::common::LockGuard lg(chunkIdsLock_);
-        chunkIdsToSync_.push_back(chunkId);
+        groupSyncer_->Add(dataStore_, chunkId);
     }
 
-    void HandleSyncTimerOut();
-
-    void SyncAllChunks();
-
     void ForceSyncAllChunks();
 
     void WaitSnapshotDone();
@@ -478,6 +460,15 @@ class CopysetNode : public braft::StateMachine,
         return ToGroupIdString(logicPoolId_, copysetId_);
     }
 
+    /**
+     * 记录chunk最后一次被修改时对应的日志index，只在状态机线程中调用
+     * @param chunkId: op操作的chunk id
+     * @param opType: op类型，读类型的op不会修改chunk
+     * @param index: op对应的日志index
+     */
+    void RecordChunkModified(ChunkID chunkId, CHUNK_OP_TYPE opType,
+                             int64_t index);
+
  private:
     // 逻辑池 id
     LogicPoolID logicPoolId_;
@@ -509,6 +500,8 @@ class CopysetNode : public braft::StateMachine,
     CurveSegmentLogStorage* logStorage_;
     // 并发模块
     ConcurrentApplyModule *concurrentapply_ = nullptr;
+    // 写合并模块，未开启时为nullptr
+    std::unique_ptr<WriteCoalescer> writeCoalescer_;
     // 配置版本持久化工具接口
     std::unique_ptr<ConfEpochFile> epochFile_;
     // 复制组的apply index
@@ -533,18 +526,17 @@ class CopysetNode : public braft::StateMachine,
 
     // enable O_DSYNC when open file
     bool enableOdsyncWhenOpenChunkFile_;
-    // sync chunk thread
-    SyncChunkThread syncThread_;
-    // chunkIds need to sync
-    std::deque<ChunkID> chunkIdsToSync_;
-    // lock for chunkIdsToSync_
-    mutable curve::common::Mutex chunkIdsLock_;
-    // is syncing
-    std::atomic<bool> isSyncing_;
-    // do snapshot check syncing interval
-    uint32_t checkSyncingIntervalMs_;
     // async snapshot future object
     std::future<void> snapshotFuture_;
+
+    // chunk最后一次被修改的日志index，只在状态机线程中访问
+    std::unordered_map<ChunkID, int64_t> chunkModifiedIndex_;
+    // 没有记录的chunk，其最后一次修改的日志index不会超过该值
+    int64_t chunkModifiedBase_;
+    // 打快照时chunkModifiedIndex_和chunkModifiedBase_的拷贝，
+    // 由后台保存快照的线程使用
+    std::unordered_map<ChunkID, int64_t> snapshotModifiedIndex_;
+    int64_t snapshotModifiedBase_;
 };
 
 }  // namespace chunkserver
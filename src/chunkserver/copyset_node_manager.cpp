@@ -53,9 +53,11 @@ std::once_flag addServiceFlag;
 
 int CopysetNodeManager::Init(const CopysetNodeOptions &copysetNodeOptions) {
     copysetNodeOptions_ = copysetNodeOptions;
-    CopysetNode::syncTriggerSeconds_ = copysetNodeOptions.syncTriggerSeconds;
-    CopysetNode::copysetSyncPool_ =
-        std::make_shared<common::TaskThreadPool<>>();
+    GroupSyncerOptions syncerOptions;
+    syncerOptions.flushIntervalMs =
+        copysetNodeOptions.syncTriggerSeconds * 1000;
+    syncerOptions.syncConcurrency = copysetNodeOptions.syncConcurrency;
+    CopysetNode::groupSyncer_->Init(syncerOptions);
     if (copysetNodeOptions_.loadConcurrency > 0) {
         copysetLoader_ = std::make_shared<TaskThreadPool<>>();
     } else {
@@ -68,9 +70,13 @@ int CopysetNodeManager::Run() {
     if (running_.exchange(true, std::memory_order_acq_rel)) {
         return 0;
     }
-    CopysetNode::copysetSyncPool_->Start(copysetNodeOptions_.syncConcurrency);
     assert(copysetNodeOptions_.syncConcurrency > 0);
-    int ret = 0;
+    int ret = CopysetNode::groupSyncer_->Run();
+    if (ret < 0) {
+        LOG(ERROR) << "Group syncer start error. ThreadNum: "
+                   << copysetNodeOptions_.syncConcurrency;
+        return -1;
+    }
     // 启动线程池
     if (copysetLoader_ != nullptr) {
         ret = copysetLoader_->Start(
@@ -96,7 +102,7 @@ int CopysetNodeManager::Fini() {
         return 0;
     }
     loadFinished_.exchange(false, std::memory_order_acq_rel);
-    CopysetNode::copysetSyncPool_->Stop();
+    CopysetNode::groupSyncer_->Fini();
     if (copysetLoader_ != nullptr) {
         copysetLoader_->Stop();
         copysetLoader_ = nullptr;
@@ -486,7 +492,9 @@ bool CopysetNodeManager::PurgeCopysetNodeData(const LogicPoolID &logicPoolId,
                           << ToGroupIdString(logicPoolId, copysetId)
                           << "to trash success.";
                 copysetNodeMap_.erase(it);
-                ret = true;
+                // 数据已经放入回收站后才回收单独存放的raft日志，
+                // 避免copyset删除失败时丢失日志
+                ret = RecycleSeparateRaftLog(groupId);
             }
         }
     }
@@ -516,6 +524,26 @@ bool CopysetNodeManager::DeleteBrokenCopyset(const LogicPoolID& poolId,
         return false;
     }
 
+    return RecycleSeparateRaftLog(groupId);
+}
+
+bool CopysetNodeManager::RecycleSeparateRaftLog(const GroupId &groupId) {
+    std::string copysetsDir;
+    std::string logDir;
+    curve::common::UriParser::ParseUri(copysetNodeOptions_.chunkDataUri,
+                                       &copysetsDir);
+    curve::common::UriParser::ParseUri(copysetNodeOptions_.logUri, &logDir);
+    // 日志和数据在同一目录下，随copyset目录一起放入回收站
+    if (logDir.empty() || logDir == copysetsDir) {
+        return true;
+    }
+
+    logDir.append("/").append(groupId);
+    if (0 != copysetNodeOptions_.trash->RecycleRaftLog(logDir)) {
+        LOG(ERROR) << "Failed to recycle raft log of copyset " << groupId
+                   << ", log dir: " << logDir;
+        return false;
+    }
     return true;
 }
 
@@ -212,6 +212,15 @@ class CopysetNodeManager : public curve::common::Uncopyable {
         const CopysetID &copysetId,
         const Configuration &conf);
 
+    /**
+     * raft日志单独存放(copyset.raft_log_uri和copyset.chunk_data_uri不同，
+     * 例如日志放在单独的高速盘上)时，回收copyset的raft日志目录，
+     * 日志中的wal会被归还到文件池，所以需要在copyset目录成功放入回收站后调用
+     * @param groupId: 复制组id
+     * @return 成功或者日志和数据在同一目录时返回true，失败返回false
+     */
+    bool RecycleSeparateRaftLog(const GroupId &groupId);
+
  private:
     using CopysetNodeMap = std::unordered_map<GroupId,
                                               std::shared_ptr<CopysetNode>>;
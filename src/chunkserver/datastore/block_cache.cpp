@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/chunkserver/datastore/block_cache.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace curve {
+namespace chunkserver {
+
+CSBlockCache::CSBlockCache(const BlockCacheOptions& options)
+    : blockSize_(options.blockSize),
+      nextGeneration_(0),
+      nextNamespace_(0) {
+    CHECK(blockSize_ > 0) << "Invalid block size of block cache";
+    // ARCCache keeps half of max_count resident, the rest are ghost keys
+    uint64_t blockNum = std::max<uint64_t>(options.capacity / blockSize_, 1);
+    cache_.reset(new BlockARCCache(2 * blockNum,
+        std::make_shared<curve::common::CacheMetrics>(
+            options.metricPrefix)));
+}
+
+uint64_t CSBlockCache::NewNamespace() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    uint64_t ns = ++nextNamespace_;
+    generations_[ns];
+    return ns;
+}
+
+void CSBlockCache::DropNamespace(uint64_t ns) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    generations_.erase(ns);
+}
+
+bool CSBlockCache::Get(uint64_t ns, ChunkID id, uint64_t blockIndex,
+                       CachedBlockPtr* block) {
+    return cache_->Get(BlockKey(ns, id, blockIndex), block);
+}
+
+uint64_t CSBlockCache::BeginFill(uint64_t ns, ChunkID id) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto iter = generations_.find(ns);
+    if (iter == generations_.end()) {
+        return 0;
+    }
+    auto result = iter->second.emplace(id, 0);
+    if (result.second) {
+        result.first->second = ++nextGeneration_;
+    }
+    return result.first->second;
+}
+
+void CSBlockCache::Fill(uint64_t ns, ChunkID id, uint64_t generation,
+                        uint64_t blockIndex, CachedBlockPtr block) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto iter = generations_.find(ns);
+    if (iter == generations_.end()) {
+        return;
+    }
+    auto chunkIter = iter->second.find(id);
+    if (chunkIter == iter->second.end() ||
+        chunkIter->second != generation) {
+        return;
+    }
+    cache_->Put(BlockKey(ns, id, blockIndex), block);
+}
+
+void CSBlockCache::Invalidate(uint64_t ns, ChunkID id,
+                              off_t offset, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto iter = generations_.find(ns);
+    if (iter == generations_.end()) {
+        return;
+    }
+    auto chunkIter = iter->second.find(id);
+    // the blocks are only filled after the chunk gets a generation
+    if (chunkIter == iter->second.end()) {
+        return;
+    }
+    chunkIter->second = ++nextGeneration_;
+    RemoveBlocks(ns, id, offset / blockSize_,
+                 (offset + length - 1) / blockSize_);
+}
+
+void CSBlockCache::InvalidateChunk(uint64_t ns, ChunkID id,
+                                   size_t chunkSize) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto iter = generations_.find(ns);
+    if (iter == generations_.end()) {
+        return;
+    }
+    if (iter->second.erase(id) == 0 || chunkSize == 0) {
+        return;
+    }
+    RemoveBlocks(ns, id, 0, (chunkSize - 1) / blockSize_);
+}
+
+std::string CSBlockCache::BlockKey(uint64_t ns, ChunkID id,
+                                   uint64_t blockIndex) {
+    return std::to_string(ns) + "_" + std::to_string(id) + "_" +
+           std::to_string(blockIndex);
+}
+
+void CSBlockCache::RemoveBlocks(uint64_t ns, ChunkID id,
+                                uint64_t beginIndex, uint64_t endIndex) {
+    for (uint64_t index = beginIndex; index <= endIndex; ++index) {
+        cache_->Remove(BlockKey(ns, id, index));
+    }
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,144 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_CHUNKSERVER_DATASTORE_BLOCK_CACHE_H_
+#define SRC_CHUNKSERVER_DATASTORE_BLOCK_CACHE_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+
+#include "include/chunkserver/chunkserver_common.h"
+#include "src/common/lru_cache.h"
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace chunkserver {
+
+struct BlockCacheOptions {
+    // total bytes of the cached blocks
+    uint64_t capacity = 0;
+    // size of a cached block, must divide the chunk size
+    uint32_t blockSize = 64 * 1024;
+    // prefix of the hit/miss/bytes metrics
+    std::string metricPrefix = "chunkserver_datastore_block";
+};
+
+using CachedBlockPtr = std::shared_ptr<std::string>;
+
+struct CachedBlockTraits {
+    static uint64_t CountBytes(const CachedBlockPtr& block) {
+        return block->size();
+    }
+};
+
+/**
+ * Cache of chunk data blocks shared by all datastores of the chunkserver.
+ * Each datastore reads and invalidates blocks in its own namespace, so the
+ * same chunk id in different copysets never shares a block.
+ *
+ * A read that misses takes the generation of the chunk with BeginFill
+ * before reading the file, and the blocks are only inserted by Fill if the
+ * chunk has not been modified since. A modification bumps the generation
+ * after the data is written to the file, so a block read before the write
+ * can not be put back into the cache after the write has invalidated it.
+ */
+class CSBlockCache : public curve::common::Uncopyable {
+ public:
+    explicit CSBlockCache(const BlockCacheOptions& options);
+    ~CSBlockCache() = default;
+
+    uint32_t BlockSize() const { return blockSize_; }
+
+    /**
+     * Allocate a namespace for a datastore
+     */
+    uint64_t NewNamespace();
+
+    /**
+     * Drop all the blocks of the namespace, they are left in the cache
+     * until evicted but never returned again
+     */
+    void DropNamespace(uint64_t ns);
+
+    /**
+     * Get a cached block
+     * @return: true if the block is cached
+     */
+    bool Get(uint64_t ns, ChunkID id, uint64_t blockIndex,
+             CachedBlockPtr* block);
+
+    /**
+     * Get the generation of the chunk before reading it from the file
+     * @return: the generation passed to Fill
+     */
+    uint64_t BeginFill(uint64_t ns, ChunkID id);
+
+    /**
+     * Insert a block read from the file, the block is dropped if the chunk
+     * has been modified after BeginFill
+     */
+    void Fill(uint64_t ns, ChunkID id, uint64_t generation,
+              uint64_t blockIndex, CachedBlockPtr block);
+
+    /**
+     * Invalidate the blocks overlapping with the range after the range is
+     * modified
+     */
+    void Invalidate(uint64_t ns, ChunkID id, off_t offset, size_t length);
+
+    /**
+     * Invalidate all the blocks of the chunk after it is deleted
+     * @param chunkSize: the size of the chunk
+     */
+    void InvalidateChunk(uint64_t ns, ChunkID id, size_t chunkSize);
+
+ private:
+    // ARC keeps blocks read more than once from being flushed by scans
+    using BlockARCCache = curve::common::ARCCache<std::string,
+        CachedBlockPtr, curve::common::CacheTraits<std::string>,
+        CachedBlockTraits>;
+
+    static std::string BlockKey(uint64_t ns, ChunkID id,
+                                uint64_t blockIndex);
+    // remove the blocks in [beginIndex, endIndex], called with mtx_ held
+    void RemoveBlocks(uint64_t ns, ChunkID id,
+                      uint64_t beginIndex, uint64_t endIndex);
+
+ private:
+    const uint32_t blockSize_;
+    std::unique_ptr<BlockARCCache> cache_;
+    // protect the generations, and make the generation check and the
+    // block insertion atomic with respect to invalidation
+    std::mutex mtx_;
+    // the generations are unique over the whole cache, so a chunk that is
+    // deleted and read again never gets a generation of a stale read
+    uint64_t nextGeneration_;
+    uint64_t nextNamespace_;
+    // namespace -> chunk id -> generation, only the chunks read through
+    // the cache have a generation
+    std::unordered_map<uint64_t,
+        std::unordered_map<ChunkID, uint64_t>> generations_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_DATASTORE_BLOCK_CACHE_H_
@@ -20,17 +20,21 @@
  * Author: yangyaokai
  */
 #include <fcntl.h>
+#include <bthread/bthread.h>
 #include <algorithm>
 #include <memory>
 
 #include "src/chunkserver/datastore/chunkserver_datastore.h"
 #include "src/chunkserver/datastore/chunkserver_chunkfile.h"
+#include "src/common/aligned_buffer_pool.h"
 #include "src/common/crc32.h"
 #include "src/common/curve_define.h"
 
 namespace curve {
 namespace chunkserver {
 
+using curve::common::AlignedBufferPool;
+
 ChunkFileMetaPage::ChunkFileMetaPage(const ChunkFileMetaPage& metaPage) {
     version = metaPage.version;
     sn = metaPage.sn;
@@ -132,6 +136,8 @@ CSErrorCode ChunkFileMetaPage::decode(const char* buf) {
 uint64_t CSChunkFile::syncChunkLimits_ = 2 * 1024 * 1024;
 uint64_t CSChunkFile::syncThreshold_ = 64 * 1024;
 
+std::atomic<uint32_t> CSChunkFile::directFdCount_(0);
+
 CSChunkFile::CSChunkFile(std::shared_ptr<LocalFileSystem> lfs,
                          std::shared_ptr<FilePool> chunkFilePool,
                          const ChunkOptions& options)
@@ -144,11 +150,18 @@ CSChunkFile::CSChunkFile(std::shared_ptr<LocalFileSystem> lfs,
       chunkId_(options.id),
       baseDir_(options.baseDir),
       isCloneChunk_(false),
+      metaPageDirty_(false),
+      pendingPastes_(0),
+      pasteMetaPageBatch_(std::max<uint32_t>(options.pasteMetaPageBatch, 1)),
+      inflightAio_(0),
       snapshot_(nullptr),
       chunkFilePool_(chunkFilePool),
       lfs_(lfs),
       metric_(options.metric),
-      enableOdsyncWhenOpenChunkFile_(options.enableOdsyncWhenOpenChunkFile) {
+      enableOdsyncWhenOpenChunkFile_(options.enableOdsyncWhenOpenChunkFile),
+      enableODirectRead_(options.enableODirectRead),
+      directFd_(-1),
+      maxDirectFds_(options.maxODirectReadFds) {
     CHECK(!baseDir_.empty()) << "Create chunk file failed";
     CHECK(lfs_ != nullptr) << "Create chunk file failed";
     metaPage_.sn = options.sn;
@@ -171,9 +184,7 @@ CSChunkFile::~CSChunkFile() {
         snapshot_ = nullptr;
     }
 
-    if (fd_ >= 0) {
-        lfs_->Close(fd_);
-    }
+    closeFds();
 
     if (metric_ != nullptr) {
         metric_->chunkFileCount << -1;
@@ -185,6 +196,8 @@ CSChunkFile::~CSChunkFile() {
 
 CSErrorCode CSChunkFile::Open(bool createFile) {
     WriteLockGuard writeGuard(rwLock_);
+    // the asynchronous reads submitted before must not be torn
+    waitInflightAio();
     string chunkFilePath = path();
     // Create a new file, if the chunk file already exists, no need to create
     // The existence of chunk files may be caused by two situations:
@@ -291,6 +304,8 @@ CSErrorCode CSChunkFile::Write(SequenceNum sn,
                                uint32_t* cost) {
     (void)cost;
     WriteLockGuard writeGuard(rwLock_);
+    // the asynchronous reads submitted before must not be torn
+    waitInflightAio();
     if (!CheckOffsetAndLength(offset, length)) {
         LOG(ERROR) << "Write chunk failed, invalid offset or length."
                    << "ChunkID: " << chunkId_
@@ -427,7 +442,9 @@ CSErrorCode CSChunkFile::Write(SequenceNum sn,
 }
 
 CSErrorCode CSChunkFile::Sync() {
-    WriteLockGuard writeGuard(rwLock_);
+    // only need to keep fd_ from being closed, flushing does not
+    // conflict with readers
+    ReadLockGuard readGuard(rwLock_);
     int rc = SyncData();
     if (rc < 0) {
         LOG(ERROR) << "Sync data failed, "
@@ -437,8 +454,21 @@ CSErrorCode CSChunkFile::Sync() {
     return CSErrorCode::Success;
 }
 
+CSErrorCode CSChunkFile::WriteBack() {
+    ReadLockGuard readGuard(rwLock_);
+    int rc = lfs_->SyncFileRange(fd_, 0, 0, SYNC_FILE_RANGE_WRITE);
+    if (rc < 0) {
+        LOG(ERROR) << "Write back data failed, "
+                   << "ChunkID:" << chunkId_;
+        return CSErrorCode::InternalError;
+    }
+    return CSErrorCode::Success;
+}
+
 CSErrorCode CSChunkFile::Paste(const char * buf, off_t offset, size_t length) {
     WriteLockGuard writeGuard(rwLock_);
+    // the asynchronous reads submitted before must not be torn
+    waitInflightAio();
     if (!CheckOffsetAndLength(offset, length)) {
         LOG(ERROR) << "Paste chunk failed, invalid offset or length."
                    << "ChunkID: " << chunkId_
@@ -482,8 +512,13 @@ CSErrorCode CSChunkFile::Paste(const char * buf, off_t offset, size_t length) {
         }
     }
 
+    // All pages have been written before, nothing to update
+    if (uncopiedRange.empty()) {
+        return CSErrorCode::Success;
+    }
+
     // Update bitmap
-    CSErrorCode errorCode = flush();
+    CSErrorCode errorCode = flushPaste();
     if (errorCode != CSErrorCode::Success) {
         LOG(ERROR) << "Paste data to chunk failed."
                     << "ChunkID: " << chunkId_
@@ -496,6 +531,91 @@ CSErrorCode CSChunkFile::Paste(const char * buf, off_t offset, size_t length) {
 
 CSErrorCode CSChunkFile::Read(char * buf, off_t offset, size_t length) {
     ReadLockGuard readGuard(rwLock_);
+    CSErrorCode errorCode = checkReadRange(offset, length);
+    if (errorCode != CSErrorCode::Success) {
+        return errorCode;
+    }
+
+    int rc = readData(buf, offset, length);
+    if (rc < 0) {
+        LOG(ERROR) << "Read chunk file failed."
+                   << "ChunkID: " << chunkId_
+                   << ",chunk sn: " << metaPage_.sn;
+        return CSErrorCode::InternalError;
+    }
+    return CSErrorCode::Success;
+}
+
+namespace {
+
+struct AioDoneArg {
+    CSAioCallback done;
+    CSErrorCode errorCode;
+};
+
+void* RunAioDone(void* arg) {
+    std::unique_ptr<AioDoneArg> doneArg(static_cast<AioDoneArg*>(arg));
+    doneArg->done(doneArg->errorCode);
+    return nullptr;
+}
+
+// The completion thread of the filesystem is shared by all the chunks,
+// so the callback of an asynchronous request runs in a bthread
+void ScheduleAioDone(const CSAioCallback& done, CSErrorCode errorCode) {
+    AioDoneArg* arg = new AioDoneArg{done, errorCode};
+    bthread_t tid;
+    if (bthread_start_background(&tid, nullptr, RunAioDone, arg) != 0) {
+        LOG(ERROR) << "Start bthread for aio callback failed";
+        RunAioDone(arg);
+    }
+}
+
+}  // namespace
+
+void CSChunkFile::ReadAsync(char * buf, off_t offset, size_t length,
+                            CSAioCallback done) {
+    CSErrorCode errorCode;
+    {
+        ReadLockGuard readGuard(rwLock_);
+        errorCode = checkReadRange(offset, length);
+        if (errorCode == CSErrorCode::Success) {
+            {
+                std::lock_guard<std::mutex> lk(aioMtx_);
+                ++inflightAio_;
+            }
+            int rc = readDataAsync(buf, offset, length,
+                [this, offset, length, done](int ret) {
+                    if (ret < 0) {
+                        LOG(ERROR) << "Read chunk file failed."
+                                   << "ChunkID: " << chunkId_
+                                   << ", offset: " << offset
+                                   << ", length: " << length;
+                    }
+                    // writers of the chunk wait for the data to land
+                    {
+                        std::lock_guard<std::mutex> lk(aioMtx_);
+                        --inflightAio_;
+                        aioCond_.notify_all();
+                    }
+                    ScheduleAioDone(done, ret < 0 ? CSErrorCode::InternalError
+                                                  : CSErrorCode::Success);
+                });
+            if (rc == 0) {
+                return;
+            }
+            LOG(ERROR) << "Submit read chunk file failed."
+                       << "ChunkID: " << chunkId_
+                       << ",chunk sn: " << metaPage_.sn;
+            std::lock_guard<std::mutex> lk(aioMtx_);
+            --inflightAio_;
+            aioCond_.notify_all();
+            errorCode = CSErrorCode::InternalError;
+        }
+    }
+    done(errorCode);
+}
+
+CSErrorCode CSChunkFile::checkReadRange(off_t offset, size_t length) {
     if (!CheckOffsetAndLength(offset, length)) {
         LOG(ERROR) << "Read chunk failed, invalid offset or length."
                    << "ChunkID: " << chunkId_
@@ -525,14 +645,62 @@ CSErrorCode CSChunkFile::Read(char * buf, off_t offset, size_t length) {
         }
     }
 
-    int rc = readData(buf, offset, length);
+    return CSErrorCode::Success;
+}
+
+void CSChunkFile::waitInflightAio() {
+    std::unique_lock<std::mutex> lk(aioMtx_);
+    aioCond_.wait(lk, [this] { return inflightAio_ == 0; });
+}
+
+int CSChunkFile::readFd(const char* buf, off_t offset, size_t length) {
+    if (!enableODirectRead_.load(std::memory_order_relaxed) ||
+        !common::is_aligned(reinterpret_cast<uintptr_t>(buf),
+                            kDirectIOAlignment) ||
+        !common::is_aligned(offset + metaPageSize_, kDirectIOAlignment) ||
+        !common::is_aligned(length, kDirectIOAlignment)) {
+        return fd_;
+    }
+
+    int fd = directFd_.load(std::memory_order_acquire);
+    if (fd >= 0) {
+        return fd;
+    }
+    std::lock_guard<std::mutex> lk(directFdMtx_);
+    fd = directFd_.load(std::memory_order_relaxed);
+    if (fd >= 0) {
+        return fd;
+    }
+    // the chunk is read with buffered IO until other chunk files close
+    // their O_DIRECT fds
+    if (directFdCount_.fetch_add(1) >= maxDirectFds_ && maxDirectFds_ > 0) {
+        directFdCount_.fetch_sub(1);
+        return fd_;
+    }
+    int rc = lfs_->Open(path(), O_RDONLY|O_NOATIME|O_DIRECT);
     if (rc < 0) {
-        LOG(ERROR) << "Read chunk file failed."
-                   << "ChunkID: " << chunkId_
-                   << ",chunk sn: " << metaPage_.sn;
-        return CSErrorCode::InternalError;
+        directFdCount_.fetch_sub(1);
+        LOG(WARNING) << "Open chunk file with O_DIRECT failed, "
+                     << "fallback to buffered read."
+                     << "ChunkID: " << chunkId_
+                     << ", error: " << strerror(-rc);
+        enableODirectRead_.store(false, std::memory_order_relaxed);
+        return fd_;
+    }
+    directFd_.store(rc, std::memory_order_release);
+    return rc;
+}
+
+void CSChunkFile::closeFds() {
+    if (fd_ >= 0) {
+        lfs_->Close(fd_);
+        fd_ = -1;
+    }
+    int directFd = directFd_.exchange(-1);
+    if (directFd >= 0) {
+        lfs_->Close(directFd);
+        directFdCount_.fetch_sub(1);
     }
-    return CSErrorCode::Success;
 }
 
 CSErrorCode CSChunkFile::ReadMetaPage(char * buf) {
@@ -664,10 +832,9 @@ CSErrorCode CSChunkFile::Delete(SequenceNum sn)  {
         snapshot_ = nullptr;
     }
 
-    if (fd_ >= 0) {
-        lfs_->Close(fd_);
-        fd_ = -1;
-    }
+    // Asynchronous reads may still be in progress on fd_
+    waitInflightAio();
+    closeFds();
     int ret = chunkFilePool_->RecycleFile(path());
     if (ret < 0)
         return CSErrorCode::InternalError;
@@ -681,6 +848,8 @@ CSErrorCode CSChunkFile::Delete(SequenceNum sn)  {
 
 CSErrorCode CSChunkFile::DeleteSnapshotOrCorrectSn(SequenceNum correctedSn)  {
     WriteLockGuard writeGuard(rwLock_);
+    // the asynchronous reads submitted before must not be torn
+    waitInflightAio();
 
     // If it is a clone chunk, theoretically this interface should not be called
     if (isCloneChunk_) {
@@ -788,24 +957,28 @@ CSErrorCode CSChunkFile::GetHash(off_t offset,
     ReadLockGuard readGuard(rwLock_);
     uint32_t crc32c = 0;
 
-    char *buf = new(std::nothrow) char[length];
+    // 分段读取并计算crc，避免一次性申请整个范围的内存
+    const size_t bufSize = std::min(length, AlignedBufferPool::kMaxPooledSize);
+    char *buf = AlignedBufferPool::GetInstance().Alloc(bufSize);
     if (nullptr == buf) {
         return CSErrorCode::InternalError;
     }
 
-    int rc = lfs_->Read(fd_, buf, offset, length);
-    if (rc < 0) {
-        LOG(ERROR) << "Read chunk file failed."
-                   << "ChunkID: " << chunkId_
-                   << ",chunk sn: " << metaPage_.sn;
-        delete[] buf;
-        return CSErrorCode::InternalError;
+    for (size_t pos = 0; pos < length; pos += bufSize) {
+        size_t len = std::min(bufSize, length - pos);
+        int rc = lfs_->Read(fd_, buf, offset + pos, len);
+        if (rc < 0) {
+            LOG(ERROR) << "Read chunk file failed."
+                       << "ChunkID: " << chunkId_
+                       << ",chunk sn: " << metaPage_.sn;
+            AlignedBufferPool::GetInstance().Free(buf, bufSize);
+            return CSErrorCode::InternalError;
+        }
+        crc32c = curve::common::CRC32(crc32c, buf, len);
     }
-
-    crc32c = curve::common::CRC32(crc32c, buf, length);
     *hash = std::to_string(crc32c);
 
-    delete[] buf;
+    AlignedBufferPool::GetInstance().Free(buf, bufSize);
 
     return CSErrorCode::Success;
 }
@@ -963,11 +1136,17 @@ CSErrorCode CSChunkFile::copy2Snapshot(off_t offset, size_t length) {
 }
 
 CSErrorCode CSChunkFile::flush() {
+    bool needUpdateMeta = !dirtyPages_.empty() || metaPageDirty_;
+    // Avoid copying the bitmap if nothing has changed
+    if (!needUpdateMeta && (!isCloneChunk_ ||
+        metaPage_.bitmap->NextClearBit(0) != Bitmap::NO_POS)) {
+        return CSErrorCode::Success;
+    }
+
     ChunkFileMetaPage tempMeta = metaPage_;
-    bool needUpdateMeta = dirtyPages_.size() > 0;
     bool clearClone = false;
-    for (auto pageIndex : dirtyPages_) {
-        tempMeta.bitmap->Set(pageIndex);
+    for (auto& range : dirtyPages_) {
+        tempMeta.bitmap->Set(range.beginIndex, range.endIndex);
     }
     if (isCloneChunk_) {
         // If all pages have been written, mark the Chunk as a non-clone chunk
@@ -989,6 +1168,8 @@ CSErrorCode CSChunkFile::flush() {
         metaPage_.bitmap = tempMeta.bitmap;
         metaPage_.location = tempMeta.location;
         dirtyPages_.clear();
+        metaPageDirty_ = false;
+        pendingPastes_ = 0;
         if (clearClone) {
             if (metric_ != nullptr) {
                 metric_->cloneChunkCount << -1;
@@ -999,5 +1180,23 @@ CSErrorCode CSChunkFile::flush() {
     return CSErrorCode::Success;
 }
 
+CSErrorCode CSChunkFile::flushPaste() {
+    if (++pendingPastes_ >= pasteMetaPageBatch_) {
+        return flush();
+    }
+
+    // Only update the bitmap in memory, reads see the pasted pages at once
+    for (auto& range : dirtyPages_) {
+        metaPage_.bitmap->Set(range.beginIndex, range.endIndex);
+    }
+    dirtyPages_.clear();
+    metaPageDirty_ = true;
+    // The chunk becoming a normal chunk has to be persisted at once
+    if (metaPage_.bitmap->NextClearBit(0) == Bitmap::NO_POS) {
+        return flush();
+    }
+    return CSErrorCode::Success;
+}
+
 }  // namespace chunkserver
 }  // namespace curve
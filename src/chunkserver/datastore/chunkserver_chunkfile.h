@@ -31,6 +31,7 @@
 #include <functional>
 #include <memory>
 #include <condition_variable>
+#include <mutex>
 
 #include "include/curve_compiler_specific.h"
 #include "include/chunkserver/chunkserver_common.h"
@@ -48,6 +49,7 @@ namespace curve {
 namespace chunkserver {
 
 using curve::fs::LocalFileSystem;
+using curve::fs::AioCallback;
 using curve::common::RWLock;
 using curve::common::WriteLockGuard;
 using curve::common::ReadLockGuard;
@@ -112,6 +114,14 @@ struct ChunkOptions {
     PageSizeType    metaPageSize;
     // enable O_DSYNC When Open ChunkFile
     bool enableOdsyncWhenOpenChunkFile;
+    // read aligned requests with O_DIRECT
+    bool enableODirectRead;
+    // max number of fds opened with O_DIRECT by all the chunk files of the
+    // process, 0 means no limit
+    uint32_t maxODirectReadFds;
+    // number of consecutive pastes on a clone chunk whose bitmap changes are
+    // persisted by one metapage update, 1 persists every paste
+    uint32_t pasteMetaPageBatch;
     // datastore internal statistical metric
     std::shared_ptr<DataStoreMetric> metric;
 
@@ -123,6 +133,9 @@ struct ChunkOptions {
                    , chunkSize(0)
                    , blockSize(0)
                    , metaPageSize(0)
+                   , enableODirectRead(false)
+                   , maxODirectReadFds(0)
+                   , pasteMetaPageBatch(1)
                    , metric(nullptr) {}
 };
 
@@ -175,6 +188,13 @@ class CSChunkFile {
 
     CSErrorCode Sync();
 
+    /**
+     * Start writeback of the dirty pages of the chunk file without waiting
+     * for it, used to issue the IO of a batch of files before Sync them
+     * @return: return error code
+     */
+    CSErrorCode WriteBack();
+
     /**
      * Write the copied data into Chunk
      * Only write areas that have not been written, and will not overwrite
@@ -196,6 +216,21 @@ class CSChunkFile {
      */
     CSErrorCode Read(char * buf, off_t offset, size_t length);
 
+    /**
+     * Read chunk files asynchronously
+     * The read lock is only held while the request is checked and
+     * submitted, the operations that take the write lock wait until all
+     * submitted requests are completed, so the range read is not modified
+     * and the chunk file is not closed while the data lands.
+     * done is called in a bthread
+     * @param buf: the data read, must be valid until done is called
+     * @param offset: the starting offset of the data requested to be read
+     * @param length: The length of the data requested to be read
+     * @param done: called with the error code when the read is finished
+     */
+    void ReadAsync(char * buf, off_t offset, size_t length,
+                   CSAioCallback done);
+
     /**
      * Read chunk meta data
      * There may be concurrency, add read lock
@@ -245,6 +280,14 @@ class CSChunkFile {
      * @param[out]: the chunk info getted
      */
     void GetInfo(CSChunkInfo* info);
+    /**
+     * Whether the chunk is a clone chunk, reading a clone chunk fails if
+     * the range has pages never written
+     */
+    bool IsCloneChunk() {
+        ReadLockGuard readGuard(rwLock_);
+        return isCloneChunk_;
+    }
     /**
      * Get the hash value of the chunk, this interface is used for test
      * @param[out]: chunk hash value
@@ -316,6 +359,35 @@ class CSChunkFile {
      * to a normal chunk
      */
     CSErrorCode flush();
+    /**
+     * Update the bitmap after a paste, the metapage is only persisted once
+     * every pasteMetaPageBatch_ pastes, or by the next write.
+     * Pasted pages only hold data copied from the clone source, if their bits
+     * are lost on crash they are read from the source and pasted again
+     */
+    CSErrorCode flushPaste();
+    /**
+     * Check whether the specified area can be read
+     * @param offset: the starting offset of the data requested to be read
+     * @param length: The length of the data requested to be read
+     * @return: return error code
+     */
+    CSErrorCode checkReadRange(off_t offset, size_t length);
+    /**
+     * Wait for all asynchronous requests submitted on fd_ to complete
+     */
+    void waitInflightAio();
+    /**
+     * Choose the fd to read the specified area. If O_DIRECT read is enabled
+     * and buf, offset and length are all aligned, the O_DIRECT fd is used
+     * unless the limit of O_DIRECT fds is reached,
+     * which is opened on first use. Otherwise fd_ is used.
+     */
+    int readFd(const char* buf, off_t offset, size_t length);
+    /**
+     * Close fd_ and the O_DIRECT fd
+     */
+    void closeFds();
 
     inline string path() {
         return baseDir_ + "/" +
@@ -330,12 +402,19 @@ class CSChunkFile {
         return lfs_->Read(fd_, buf, 0, metaPageSize_);
     }
 
+    inline int readDataAsync(char* buf, off_t offset, size_t length,
+                             AioCallback cb) {
+        return lfs_->ReadAsync(readFd(buf, offset, length), buf,
+                               offset + metaPageSize_, length, cb);
+    }
+
     inline int writeMetaPage(const char* buf) {
         return lfs_->Write(fd_, buf, 0, metaPageSize_);
     }
 
     inline int readData(char* buf, off_t offset, size_t length) {
-        return lfs_->Read(fd_, buf, offset + metaPageSize_, length);
+        return lfs_->Read(readFd(buf, offset, length), buf,
+                          offset + metaPageSize_, length);
     }
 
     inline int writeData(const char* buf, off_t offset, size_t length) {
@@ -346,14 +425,7 @@ class CSChunkFile {
         // If it is a clone chunk, you need to determine whether you need to
         // change the bitmap and update the metapage
         if (isCloneChunk_) {
-            uint32_t beginIndex = offset / blockSize_;
-            uint32_t endIndex = (offset + length - 1) / blockSize_;
-            for (uint32_t i = beginIndex; i <= endIndex; ++i) {
-                // record dirty page
-                if (!metaPage_.bitmap->Test(i)) {
-                    dirtyPages_.insert(i);
-                }
-            }
+            markDirtyPages(offset, length);
         }
         return rc;
     }
@@ -365,20 +437,22 @@ class CSChunkFile {
         }
         // If it is a clone chunk, you need to determine whether you need to
         // change the bitmap and update the metapage
-        // page size to alignment
         if (isCloneChunk_) {
-            uint32_t beginIndex = offset / blockSize_;
-            uint32_t endIndex = (offset + length - 1) / blockSize_;
-            for (uint32_t i = beginIndex; i <= endIndex; ++i) {
-                // record dirty page
-                if (!metaPage_.bitmap->Test(i)) {
-                    dirtyPages_.insert(i);
-                }
-            }
+            markDirtyPages(offset, length);
         }
         return rc;
     }
 
+    // record the unwritten pages in the range as dirty pages
+    inline void markDirtyPages(off_t offset, size_t length) {
+        uint32_t beginIndex = offset / blockSize_;
+        uint32_t endIndex = (offset + length - 1) / blockSize_;
+        std::vector<BitRange> clearRanges;
+        metaPage_.bitmap->Divide(beginIndex, endIndex, &clearRanges, nullptr);
+        dirtyPages_.insert(dirtyPages_.end(), clearRanges.begin(),
+                           clearRanges.end());
+    }
+
     inline int SyncData() {
         return lfs_->Sync(fd_);
     }
@@ -420,10 +494,20 @@ class CSChunkFile {
     // chunk metapage
     ChunkFileMetaPage metaPage_;
     // has been written but has not yet been updated to the
-    // page index in the metapage
-    std::set<uint32_t> dirtyPages_;
+    // page ranges in the metapage
+    std::vector<BitRange> dirtyPages_;
+    // the bitmap in memory has pasted pages that are not yet persisted
+    bool metaPageDirty_;
+    // pastes since the metapage was last persisted
+    uint32_t pendingPastes_;
+    // see ChunkOptions::pasteMetaPageBatch
+    uint32_t pasteMetaPageBatch_;
     // read-write lock
     RWLock rwLock_;
+    // number of asynchronous requests submitted but not completed
+    uint32_t inflightAio_;
+    std::mutex aioMtx_;
+    std::condition_variable aioCond_;
     // Snapshot file pointer
     CSSnapshot* snapshot_;
     // Rely on FilePool to create and delete files
@@ -434,6 +518,18 @@ class CSChunkFile {
     std::shared_ptr<DataStoreMetric> metric_;
     // enable O_DSYNC When Open ChunkFile
     bool enableOdsyncWhenOpenChunkFile_;
+    // read aligned requests with O_DIRECT, disabled if the O_DIRECT fd
+    // can not be opened
+    std::atomic<bool> enableODirectRead_;
+    // file descriptor opened with O_DIRECT, only used to read
+    std::atomic<int> directFd_;
+    std::mutex directFdMtx_;
+    // see ChunkOptions::maxODirectReadFds
+    uint32_t maxDirectFds_;
+    // number of fds opened with O_DIRECT by all the chunk files, every
+    // chunk file keeps one until it is closed, so they are limited not to
+    // double the fds of the process
+    static std::atomic<uint32_t> directFdCount_;
 };
 }  // namespace chunkserver
 }  // namespace curve
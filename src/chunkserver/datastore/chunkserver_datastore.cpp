@@ -24,16 +24,22 @@
 #include <fcntl.h>
 #include <cstring>
 #include <iostream>
+#include <algorithm>
 #include <list>
 #include <memory>
+#include <thread>
+#include <unordered_set>
 
 #include "src/chunkserver/datastore/chunkserver_datastore.h"
 #include "src/chunkserver/datastore/filename_operator.h"
+#include "src/common/aligned_buffer_pool.h"
 #include "src/common/location_operator.h"
 
 namespace curve {
 namespace chunkserver {
 
+using curve::common::AlignedBufferPool;
+
 CSDataStore::CSDataStore(std::shared_ptr<LocalFileSystem> lfs,
                          std::shared_ptr<FilePool> chunkFilePool,
                          const DataStoreOptions& options)
@@ -44,16 +50,42 @@ CSDataStore::CSDataStore(std::shared_ptr<LocalFileSystem> lfs,
       baseDir_(options.baseDir),
       chunkFilePool_(chunkFilePool),
       lfs_(lfs),
-      enableOdsyncWhenOpenChunkFile_(options.enableOdsyncWhenOpenChunkFile) {
+      enableOdsyncWhenOpenChunkFile_(options.enableOdsyncWhenOpenChunkFile),
+      enableODirectRead_(options.enableODirectRead),
+      maxODirectReadFds_(options.maxODirectReadFds),
+      loadConcurrency_(options.loadConcurrency),
+      pasteMetaPageBatch_(options.pasteMetaPageBatch),
+      blockCache_(options.blockCache) {
     CHECK(!baseDir_.empty()) << "Create datastore failed";
     CHECK(lfs_ != nullptr) << "Create datastore failed";
     CHECK(chunkFilePool_ != nullptr) << "Create datastore failed";
+    // the cached blocks are read from the chunk file as a whole, so they
+    // must not cross the chunk and must be aligned for O_DIRECT reads
+    if (blockCache_ != nullptr &&
+        (blockSize_ == 0 || chunkSize_ % blockCache_->BlockSize() != 0 ||
+         blockCache_->BlockSize() % blockSize_ != 0)) {
+        LOG(WARNING) << "Block cache disabled for " << baseDir_
+                     << ", cache block size " << blockCache_->BlockSize()
+                     << " mismatch chunk size " << chunkSize_
+                     << " or block size " << blockSize_;
+        blockCache_ = nullptr;
+    }
 }
 
 CSDataStore::~CSDataStore() {
+    if (blockCache_ != nullptr) {
+        blockCache_->DropNamespace(blockCacheNs_.load());
+    }
 }
 
 bool CSDataStore::Initialize() {
+    // The chunk files may be replaced when reloaded, e.g. after installing
+    // a raft snapshot, so the blocks cached before are all dropped
+    if (blockCache_ != nullptr) {
+        blockCache_->DropNamespace(blockCacheNs_.load());
+        blockCacheNs_.store(blockCache_->NewNamespace());
+    }
+
     // Make sure the baseDir directory exists
     if (!lfs_->DirExists(baseDir_.c_str())) {
         int rc = lfs_->Mkdir(baseDir_.c_str());
@@ -73,15 +105,17 @@ bool CSDataStore::Initialize() {
     // If loaded before, reload here
     metaCache_.Clear();
     metric_ = std::make_shared<DataStoreMetric>();
+    // Collect the chunks and snapshots first, the chunk files are loaded
+    // concurrently, and then the snapshots are loaded into their chunks
+    vector<ChunkID> chunkIds;
+    std::unordered_set<ChunkID> chunkIdSet;
+    vector<FileNameOperator::FileInfo> snapshots;
     for (size_t i = 0; i < files.size(); ++i) {
         FileNameOperator::FileInfo info =
             FileNameOperator::ParseFileName(files[i]);
         if (info.type == FileNameOperator::FileType::CHUNK) {
-            // If the chunk file has not been loaded yet, load it to metaCache
-            CSErrorCode errorCode = loadChunkFile(info.id);
-            if (errorCode != CSErrorCode::Success) {
-                LOG(ERROR) << "Load chunk file failed: " << files[i];
-                return false;
+            if (chunkIdSet.insert(info.id).second) {
+                chunkIds.push_back(info.id);
             }
         } else if (info.type == FileNameOperator::FileType::SNAPSHOT) {
             string chunkFilePath = baseDir_ + "/" +
@@ -93,27 +127,68 @@ bool CSDataStore::Initialize() {
                              << files[i] << "' chunk.";
                 continue;
             }
-            // If the chunk file exists, load the chunk file to metaCache first
-            CSErrorCode errorCode = loadChunkFile(info.id);
-            if (errorCode != CSErrorCode::Success) {
-                LOG(ERROR) << "Load chunk file failed.";
-                return false;
-            }
-
-            // Load snapshot to memory
-            errorCode = metaCache_.Get(info.id)->LoadSnapshot(info.sn);
-            if (errorCode != CSErrorCode::Success) {
-                LOG(ERROR) << "Load snapshot failed.";
-                return false;
+            // The chunk file must be loaded before the snapshot
+            if (chunkIdSet.insert(info.id).second) {
+                chunkIds.push_back(info.id);
             }
+            snapshots.push_back(info);
         } else {
             LOG(WARNING) << "Unknown file: " << files[i];
         }
     }
-    LOG(INFO) << "Initialize data store success.";
+
+    if (!loadChunkFiles(chunkIds)) {
+        return false;
+    }
+
+    for (auto& info : snapshots) {
+        // Load snapshot to memory
+        CSErrorCode errorCode =
+            metaCache_.Get(info.id)->LoadSnapshot(info.sn);
+        if (errorCode != CSErrorCode::Success) {
+            LOG(ERROR) << "Load snapshot failed.";
+            return false;
+        }
+    }
+    LOG(INFO) << "Initialize data store success, "
+              << "chunk count: " << chunkIds.size()
+              << ", snapshot count: " << snapshots.size();
     return true;
 }
 
+bool CSDataStore::loadChunkFiles(const vector<ChunkID>& ids) {
+    auto loadChunks = [this, &ids](size_t start, size_t step,
+                                   std::atomic<bool>* failed) {
+        for (size_t i = start; i < ids.size() && !failed->load(); i += step) {
+            // If the chunk file has not been loaded yet, load it to metaCache
+            CSErrorCode errorCode = loadChunkFile(ids[i]);
+            if (errorCode != CSErrorCode::Success) {
+                LOG(ERROR) << "Load chunk file failed, ChunkID = " << ids[i];
+                failed->store(true);
+            }
+        }
+    };
+
+    std::atomic<bool> failed(false);
+    size_t concurrency = std::min<size_t>(loadConcurrency_, ids.size());
+    if (concurrency <= 1) {
+        loadChunks(0, 1, &failed);
+        return !failed.load();
+    }
+
+    // The metapage reads of different chunk files are independent,
+    // spread them over the loader threads
+    vector<std::thread> loaders;
+    loaders.reserve(concurrency);
+    for (size_t i = 0; i < concurrency; ++i) {
+        loaders.emplace_back(loadChunks, i, concurrency, &failed);
+    }
+    for (auto& loader : loaders) {
+        loader.join();
+    }
+    return !failed.load();
+}
+
 CSErrorCode CSDataStore::DeleteChunk(ChunkID id, SequenceNum sn) {
     auto chunkFile = metaCache_.Get(id);
     if (chunkFile != nullptr) {
@@ -124,6 +199,9 @@ CSErrorCode CSDataStore::DeleteChunk(ChunkID id, SequenceNum sn) {
             return errorCode;
         }
         metaCache_.Remove(id);
+        if (blockCache_ != nullptr) {
+            blockCache_->InvalidateChunk(blockCacheNs_.load(), id, chunkSize_);
+        }
     }
     return CSErrorCode::Success;
 }
@@ -154,6 +232,43 @@ CSErrorCode CSDataStore::ReadChunk(ChunkID id,
         return CSErrorCode::ChunkNotExistError;
     }
 
+    if (useBlockCache(chunkFile, offset, length)) {
+        if (readCachedBlocks(id, buf, offset, length)) {
+            return CSErrorCode::Success;
+        }
+        // read the whole blocks covering the range and cache them
+        uint32_t cacheBlockSize = blockCache_->BlockSize();
+        off_t alignedOffset = offset / cacheBlockSize * cacheBlockSize;
+        size_t alignedLength = (offset + length + cacheBlockSize - 1) /
+                               cacheBlockSize * cacheBlockSize - alignedOffset;
+        bool aligned = alignedOffset == offset && alignedLength == length;
+        char* data = aligned
+            ? buf : AlignedBufferPool::GetInstance().Alloc(alignedLength);
+        if (data != nullptr) {
+            uint64_t generation =
+                blockCache_->BeginFill(blockCacheNs_.load(), id);
+            CSErrorCode errorCode =
+                chunkFile->Read(data, alignedOffset, alignedLength);
+            if (errorCode == CSErrorCode::Success) {
+                fillCachedBlocks(id, generation, data,
+                                 alignedOffset, alignedLength);
+                if (!aligned) {
+                    memcpy(buf, data + (offset - alignedOffset), length);
+                }
+            }
+            if (!aligned) {
+                AlignedBufferPool::GetInstance().Free(data, alignedLength);
+            }
+            if (errorCode != CSErrorCode::Success) {
+                LOG(WARNING) << "Read chunk file failed."
+                             << "ChunkID = " << id;
+                return errorCode;
+            }
+            return CSErrorCode::Success;
+        }
+        // read the range directly if no memory for the blocks
+    }
+
     CSErrorCode errorCode = chunkFile->Read(buf, offset, length);
     if (errorCode != CSErrorCode::Success) {
         LOG(WARNING) << "Read chunk file failed."
@@ -163,6 +278,72 @@ CSErrorCode CSDataStore::ReadChunk(ChunkID id,
     return CSErrorCode::Success;
 }
 
+void CSDataStore::ReadChunkAsync(ChunkID id,
+                                 SequenceNum sn,
+                                 char * buf,
+                                 off_t offset,
+                                 size_t length,
+                                 CSAioCallback done) {
+    (void)sn;
+    auto chunkFile = metaCache_.Get(id);
+    if (chunkFile == nullptr) {
+        done(CSErrorCode::ChunkNotExistError);
+        return;
+    }
+
+    if (useBlockCache(chunkFile, offset, length)) {
+        if (readCachedBlocks(id, buf, offset, length)) {
+            done(CSErrorCode::Success);
+            return;
+        }
+        // read the whole blocks covering the range and cache them
+        uint32_t cacheBlockSize = blockCache_->BlockSize();
+        off_t alignedOffset = offset / cacheBlockSize * cacheBlockSize;
+        size_t alignedLength = (offset + length + cacheBlockSize - 1) /
+                               cacheBlockSize * cacheBlockSize - alignedOffset;
+        bool aligned = alignedOffset == offset && alignedLength == length;
+        char* data = aligned
+            ? buf : AlignedBufferPool::GetInstance().Alloc(alignedLength);
+        if (data != nullptr) {
+            uint64_t generation =
+                blockCache_->BeginFill(blockCacheNs_.load(), id);
+            chunkFile->ReadAsync(data, alignedOffset, alignedLength,
+                [this, chunkFile, id, generation, buf, offset, length, data,
+                 alignedOffset, alignedLength, aligned, done](
+                    CSErrorCode errorCode) {
+                    if (errorCode == CSErrorCode::Success) {
+                        fillCachedBlocks(id, generation, data,
+                                         alignedOffset, alignedLength);
+                        if (!aligned) {
+                            memcpy(buf, data + (offset - alignedOffset),
+                                   length);
+                        }
+                    } else {
+                        LOG(WARNING) << "Read chunk file failed."
+                                     << "ChunkID = " << id;
+                    }
+                    if (!aligned) {
+                        AlignedBufferPool::GetInstance().Free(data,
+                                                              alignedLength);
+                    }
+                    done(errorCode);
+                });
+            return;
+        }
+        // read the range directly if no memory for the blocks
+    }
+
+    // chunkFile is captured to keep it alive until the read is finished
+    chunkFile->ReadAsync(buf, offset, length,
+        [chunkFile, id, done](CSErrorCode errorCode) {
+            if (errorCode != CSErrorCode::Success) {
+                LOG(WARNING) << "Read chunk file failed."
+                             << "ChunkID = " << id;
+            }
+            done(errorCode);
+        });
+}
+
 CSErrorCode CSDataStore::ReadChunkMetaPage(ChunkID id, SequenceNum sn,
                                            char * buf) {
     (void)sn;
@@ -255,6 +436,9 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
         options.metaPageSize = metaPageSize_;
         options.metric = metric_;
         options.enableOdsyncWhenOpenChunkFile = enableOdsyncWhenOpenChunkFile_;
+        options.enableODirectRead = enableODirectRead_;
+        options.maxODirectReadFds = maxODirectReadFds_;
+        options.pasteMetaPageBatch = pasteMetaPageBatch_;
         CSErrorCode errorCode = CreateChunkFile(options, &chunkFile);
         if (errorCode != CSErrorCode::Success) {
             return errorCode;
@@ -266,6 +450,10 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
                                              offset,
                                              length,
                                              cost);
+    if (blockCache_ != nullptr) {
+        // a failed write may have modified part of the range
+        blockCache_->Invalidate(blockCacheNs_.load(), id, offset, length);
+    }
     if (errorCode != CSErrorCode::Success) {
         LOG(WARNING) << "Write chunk file failed."
                      << "ChunkID = " << id;
@@ -289,6 +477,20 @@ CSErrorCode CSDataStore::SyncChunk(ChunkID id) {
     return CSErrorCode::Success;
 }
 
+CSErrorCode CSDataStore::WriteBackChunk(ChunkID id) {
+    auto chunkFile = metaCache_.Get(id);
+    if (chunkFile == nullptr) {
+        return CSErrorCode::Success;
+    }
+    CSErrorCode errorCode = chunkFile->WriteBack();
+    if (errorCode != CSErrorCode::Success) {
+        LOG(WARNING) << "Write back chunk file failed."
+                     << "ChunkID = " << id;
+        return errorCode;
+    }
+    return CSErrorCode::Success;
+}
+
 CSErrorCode CSDataStore::CreateCloneChunk(ChunkID id,
                                           SequenceNum sn,
                                           SequenceNum correctedSn,
@@ -319,6 +521,9 @@ CSErrorCode CSDataStore::CreateCloneChunk(ChunkID id,
         options.blockSize = blockSize_;
         options.metaPageSize = metaPageSize_;
         options.metric = metric_;
+        options.enableODirectRead = enableODirectRead_;
+        options.maxODirectReadFds = maxODirectReadFds_;
+        options.pasteMetaPageBatch = pasteMetaPageBatch_;
         CSErrorCode errorCode = CreateChunkFile(options, &chunkFile);
         if (errorCode != CSErrorCode::Success) {
             return errorCode;
@@ -360,6 +565,9 @@ CSErrorCode CSDataStore::PasteChunk(ChunkID id,
         return CSErrorCode::ChunkNotExistError;
     }
     CSErrorCode errcode = chunkFile->Paste(buf, offset, length);
+    if (blockCache_ != nullptr) {
+        blockCache_->Invalidate(blockCacheNs_.load(), id, offset, length);
+    }
     if (errcode != CSErrorCode::Success) {
         LOG(WARNING) << "Paste Chunk failed, Chunk not exists."
                      << "ChunkID = " << id;
@@ -412,6 +620,9 @@ CSErrorCode CSDataStore::loadChunkFile(ChunkID id) {
         options.blockSize = blockSize_;
         options.metaPageSize = metaPageSize_;
         options.metric = metric_;
+        options.enableODirectRead = enableODirectRead_;
+        options.maxODirectReadFds = maxODirectReadFds_;
+        options.pasteMetaPageBatch = pasteMetaPageBatch_;
         CSChunkFilePtr chunkFilePtr =
             std::make_shared<CSChunkFile>(lfs_,
                                           chunkFilePool_,
@@ -424,7 +635,55 @@ CSErrorCode CSDataStore::loadChunkFile(ChunkID id) {
     return CSErrorCode::Success;
 }
 
-ChunkMap CSDataStore::GetChunkMap() {
+bool CSDataStore::useBlockCache(const CSChunkFilePtr& chunkFile,
+                                off_t offset, size_t length) {
+    if (blockCache_ == nullptr) {
+        return false;
+    }
+    // invalid requests are left to the chunk file to reject
+    if (length == 0 || offset % blockSize_ != 0 || length % blockSize_ != 0 ||
+        offset + length > chunkSize_) {
+        return false;
+    }
+    // the unwritten pages of a clone chunk can not be read, so the range
+    // can not be extended to the whole blocks
+    return !chunkFile->IsCloneChunk();
+}
+
+bool CSDataStore::readCachedBlocks(ChunkID id, char* buf,
+                                   off_t offset, size_t length) {
+    uint64_t ns = blockCacheNs_.load();
+    uint32_t cacheBlockSize = blockCache_->BlockSize();
+    uint64_t beginIndex = offset / cacheBlockSize;
+    uint64_t endIndex = (offset + length - 1) / cacheBlockSize;
+    for (uint64_t index = beginIndex; index <= endIndex; ++index) {
+        CachedBlockPtr block;
+        if (!blockCache_->Get(ns, id, index, &block)) {
+            return false;
+        }
+        off_t blockOffset = index * cacheBlockSize;
+        off_t begin = std::max<off_t>(offset, blockOffset);
+        off_t end = std::min<off_t>(offset + length,
+                                    blockOffset + cacheBlockSize);
+        memcpy(buf + (begin - offset), block->data() + (begin - blockOffset),
+               end - begin);
+    }
+    return true;
+}
+
+void CSDataStore::fillCachedBlocks(ChunkID id, uint64_t generation,
+                                   const char* data, off_t alignedOffset,
+                                   size_t alignedLength) {
+    uint64_t ns = blockCacheNs_.load();
+    uint32_t cacheBlockSize = blockCache_->BlockSize();
+    for (size_t pos = 0; pos < alignedLength; pos += cacheBlockSize) {
+        blockCache_->Fill(ns, id, generation,
+            (alignedOffset + pos) / cacheBlockSize,
+            std::make_shared<std::string>(data + pos, cacheBlockSize));
+    }
+}
+
+ChunkMapPtr CSDataStore::GetChunkMap() {
     return metaCache_.GetMap();
 }
 
@@ -30,6 +30,7 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <atomic>
 #include <condition_variable>
 
 #include "include/curve_compiler_specific.h"
@@ -37,6 +38,7 @@
 #include "src/common/concurrent/rw_lock.h"
 #include "src/common/concurrent/concurrent.h"
 #include "src/chunkserver/datastore/define.h"
+#include "src/chunkserver/datastore/block_cache.h"
 #include "src/chunkserver/datastore/chunkserver_chunkfile.h"
 #include "src/chunkserver/datastore/file_pool.h"
 #include "src/fs/local_filesystem.h"
@@ -63,6 +65,19 @@ struct DataStoreOptions {
     PageSizeType                        metaPageSize;
     uint32_t                            locationLimit;
     bool                                enableOdsyncWhenOpenChunkFile;
+    bool                                enableODirectRead = false;
+    // max number of fds opened with O_DIRECT by all the chunk files of the
+    // process, 0 means no limit
+    uint32_t                            maxODirectReadFds = 0;
+    // number of threads loading chunk files in Initialize,
+    // load in the calling thread if not greater than 1
+    uint32_t                            loadConcurrency = 1;
+    // number of consecutive pastes on a clone chunk persisted by one
+    // metapage update, 1 persists every paste
+    uint32_t                            pasteMetaPageBatch = 1;
+    // cache of chunk data blocks shared by all datastores, nullptr means
+    // reading from the chunk files directly
+    std::shared_ptr<CSBlockCache>       blockCache;
 };
 
 /**
@@ -94,48 +109,90 @@ struct DataStoreMetric {
 using DataStoreMetricPtr = std::shared_ptr<DataStoreMetric>;
 
 using ChunkMap = std::unordered_map<ChunkID, CSChunkFilePtr>;
-// For the mapping from chunkid to chunkfile,
-// use read-write lock to protect the map operation
+using ChunkMapPtr = std::shared_ptr<const ChunkMap>;
+// For the mapping from chunkid to chunkfile.
+// The map is split into shards by chunkid, each shard is protected by its
+// own read-write lock, so that the apply threads operating on different
+// chunks don't contend on the same lock.
 class CSMetaCache {
  public:
+    static const uint32_t kShardNum = 32;
+
     CSMetaCache() : cvar_(nullptr),
-        sumChunkRate_(std::make_shared<std::atomic<uint64_t>>()) {}
+        sumChunkRate_(std::make_shared<std::atomic<uint64_t>>()),
+        version_(0),
+        snapshotVersion_(0),
+        snapshot_(nullptr) {}
     virtual ~CSMetaCache() {}
 
-    ChunkMap GetMap() {
-        ReadLockGuard readGuard(rwLock_);
-        return chunkMap_;
+    /**
+     * Get a read-only snapshot of all the chunks in the cache.
+     * The snapshot is shared by callers and only rebuilt after the cache
+     * is modified, it is built shard by shard without blocking the whole
+     * cache. A chunk set or removed concurrently with the build may or may
+     * not be included in the snapshot.
+     */
+    ChunkMapPtr GetMap() {
+        uint64_t version = version_.load(std::memory_order_acquire);
+        {
+            curve::common::LockGuard lg(snapshotMtx_);
+            if (snapshot_ != nullptr && snapshotVersion_ == version) {
+                return snapshot_;
+            }
+        }
+        auto chunkMap = std::make_shared<ChunkMap>();
+        for (uint32_t i = 0; i < kShardNum; ++i) {
+            ReadLockGuard readGuard(shards_[i].rwLock);
+            chunkMap->insert(shards_[i].chunkMap.begin(),
+                             shards_[i].chunkMap.end());
+        }
+        curve::common::LockGuard lg(snapshotMtx_);
+        if (snapshot_ == nullptr || snapshotVersion_ <= version) {
+            snapshot_ = chunkMap;
+            snapshotVersion_ = version;
+        }
+        return chunkMap;
     }
 
     CSChunkFilePtr Get(ChunkID id) {
-        ReadLockGuard readGuard(rwLock_);
-        if (chunkMap_.find(id) == chunkMap_.end()) {
+        Shard& shard = GetShard(id);
+        ReadLockGuard readGuard(shard.rwLock);
+        auto iter = shard.chunkMap.find(id);
+        if (iter == shard.chunkMap.end()) {
             return nullptr;
         }
-        return chunkMap_[id];
+        return iter->second;
     }
 
     CSChunkFilePtr Set(ChunkID id, CSChunkFilePtr chunkFile) {
-        WriteLockGuard writeGuard(rwLock_);
+        Shard& shard = GetShard(id);
+        WriteLockGuard writeGuard(shard.rwLock);
        // When two write requests are concurrently created to create a chunk
        // file, return the first set chunkFile
-        if (chunkMap_.find(id) == chunkMap_.end()) {
+        auto ret = shard.chunkMap.emplace(id, chunkFile);
+        if (ret.second) {
             chunkFile->SetSyncInfo(sumChunkRate_, cvar_);
-            chunkMap_[id] = chunkFile;
+            version_.fetch_add(1, std::memory_order_release);
         }
-        return chunkMap_[id];
+        return ret.first->second;
     }
 
     void Remove(ChunkID id) {
-        WriteLockGuard writeGuard(rwLock_);
-        if (chunkMap_.find(id) != chunkMap_.end()) {
-            chunkMap_.erase(id);
+        Shard& shard = GetShard(id);
+        WriteLockGuard writeGuard(shard.rwLock);
+        if (shard.chunkMap.erase(id) > 0) {
+            version_.fetch_add(1, std::memory_order_release);
         }
     }
 
     void Clear() {
-        WriteLockGuard writeGuard(rwLock_);
-        chunkMap_.clear();
+        for (uint32_t i = 0; i < kShardNum; ++i) {
+            WriteLockGuard writeGuard(shards_[i].rwLock);
+            shards_[i].chunkMap.clear();
+        }
+        version_.fetch_add(1, std::memory_order_release);
+        curve::common::LockGuard lg(snapshotMtx_);
+        snapshot_ = nullptr;
     }
 
     void SetCondPtr(std::shared_ptr<std::condition_variable> cond) {
@@ -147,12 +204,27 @@ class CSMetaCache {
         CSChunkFile::syncThreshold_ = threshold;
     }
 
+ private:
+    struct Shard {
+        RWLock      rwLock;
+        ChunkMap    chunkMap;
+    };
+
+    Shard& GetShard(ChunkID id) {
+        return shards_[id % kShardNum];
+    }
+
  private:
     std::shared_ptr<std::condition_variable> cvar_;
     // sum of all chunks rate
     std::shared_ptr<std::atomic<uint64_t>> sumChunkRate_;
-    RWLock      rwLock_;
-    ChunkMap    chunkMap_;
+    Shard       shards_[kShardNum];
+    // increased every time a chunk is set or removed
+    std::atomic<uint64_t> version_;
+    // the snapshot returned by GetMap and the version it was built at
+    curve::common::Mutex snapshotMtx_;
+    uint64_t    snapshotVersion_;
+    ChunkMapPtr snapshot_;
 };
 
 class CSDataStore {
@@ -206,6 +278,25 @@ class CSDataStore {
                                   off_t offset,
                                   size_t length);
 
+    /**
+     * Read the contents of the current chunk asynchronously
+     * @param id: the chunk id to be read
+     * @param sn: used to record trace, not used in actual logic processing,
+     *             indicating the sequence number of the current user file
+     * @param buf: the content of the data read, must be valid until done
+     *             is called
+     * @param offset: the logical offset of the data requested to be read in the chunk
+     * @param length: the length of the data requested to be read
+     * @param done: called exactly once with the error code, may be called
+     *              in the current thread or the io completion thread
+     */
+    virtual void ReadChunkAsync(ChunkID id,
+                                SequenceNum sn,
+                                char * buf,
+                                off_t offset,
+                                size_t length,
+                                CSAioCallback done);
+
     /**
      * Read the metadata of the current chunk
      * @param id: the chunk id to be read
@@ -257,6 +348,14 @@ class CSDataStore {
 
     virtual CSErrorCode SyncChunk(ChunkID id);
 
+    /**
+     * Start writeback of the chunk's dirty pages without waiting for it,
+     * SyncChunk is still needed to make the data durable
+     * @param id: the chunk id
+     * @return: return error code
+     */
+    virtual CSErrorCode WriteBackChunk(ChunkID id);
+
 
     // Deprecated, only use for unit & integration test
     virtual CSErrorCode WriteChunk(
@@ -326,7 +425,7 @@ class CSDataStore {
      */
     virtual DataStoreStatus GetStatus();
 
-    virtual ChunkMap GetChunkMap();
+    virtual ChunkMapPtr GetChunkMap();
 
     void SetCacheCondPtr(std::shared_ptr<std::condition_variable> cond) {
         metaCache_.SetCondPtr(cond);
@@ -338,8 +437,19 @@ class CSDataStore {
 
  private:
     CSErrorCode loadChunkFile(ChunkID id);
+    // load the chunk files concurrently by loadConcurrency_ threads
+    bool loadChunkFiles(const std::vector<ChunkID>& ids);
     CSErrorCode CreateChunkFile(const ChunkOptions & ops,
                                 CSChunkFilePtr* chunkFile);
+    // whether the read of the range goes through the block cache
+    bool useBlockCache(const CSChunkFilePtr& chunkFile,
+                       off_t offset, size_t length);
+    // copy the range from the cached blocks
+    // return false if any block of the range is not cached
+    bool readCachedBlocks(ChunkID id, char* buf, off_t offset, size_t length);
+    // insert the blocks of the aligned range read from the chunk file
+    void fillCachedBlocks(ChunkID id, uint64_t generation, const char* data,
+                          off_t alignedOffset, size_t alignedLength);
 
  private:
     // The size of each chunk
@@ -362,6 +472,19 @@ class CSDataStore {
     DataStoreMetricPtr metric_;
     // enable O_DSYNC When Open ChunkFile
     bool enableOdsyncWhenOpenChunkFile_;
+    // read aligned requests with O_DIRECT
+    bool enableODirectRead_;
+    // max number of fds opened with O_DIRECT
+    uint32_t maxODirectReadFds_;
+    // number of threads loading chunk files in Initialize
+    uint32_t loadConcurrency_;
+    // number of pastes persisted by one metapage update
+    uint32_t pasteMetaPageBatch_;
+    // cache of chunk data blocks, nullptr if disabled
+    std::shared_ptr<CSBlockCache> blockCache_;
+    // namespace of this datastore in the block cache, renewed when the
+    // chunk files are reloaded
+    std::atomic<uint64_t> blockCacheNs_{0};
 };
 
 }  // namespace chunkserver
@@ -23,6 +23,7 @@
 #ifndef SRC_CHUNKSERVER_DATASTORE_DEFINE_H_
 #define SRC_CHUNKSERVER_DATASTORE_DEFINE_H_
 
+#include <functional>
 #include <string>
 #include <memory>
 
@@ -39,6 +40,8 @@ using curve::common::Bitmap;
 const uint8_t FORMAT_VERSION = 1;
 const uint8_t FORMAT_VERSION_V2 = 2;
 const SequenceNum kInvalidSeq = 0;
+// Alignment of buffer, offset and length required by O_DIRECT
+const uint32_t kDirectIOAlignment = 4096;
 
 // define error code
 enum CSErrorCode {
@@ -75,6 +78,9 @@ enum CSErrorCode {
     PageNerverWrittenError = 13,
 };
 
+// Callback of the asynchronous interfaces, called once with the error code
+using CSAioCallback = std::function<void(CSErrorCode)>;
+
 // Chunk details
 struct CSChunkInfo {
     // the id of the chunk
@@ -39,6 +39,8 @@
 #include <vector>
 
 #include "absl/utility/utility.h"
+#include "src/common/aligned_buffer_pool.h"
+#include "src/common/background_io_scheduler.h"
 #include "src/common/configuration.h"
 #include "src/common/crc32.h"
 #include "src/common/curve_define.h"
@@ -46,6 +48,9 @@
 #include "src/common/throttle.h"
 
 using curve::common::kFilePoolMagic;
+using curve::common::AlignedBufferPool;
+using curve::common::BackgroundIOScheduler;
+using curve::common::BackgroundIOType;
 DEFINE_int64(formatInterval, 100, "Sets a interval between formatting.");
 DEFINE_validator(formatInterval, brpc::PositiveInteger);
 
@@ -325,6 +330,9 @@ bool FilePool::CleanChunk(uint64_t chunkid, bool onlyMarked) {
         char *buffer = writeBuffer_.get();
 
         while (nwrite < ntotal) {
+            BackgroundIOScheduler::GetInstance().Acquire(
+                BackgroundIOType::CLEAN,
+                std::min(ntotal - nwrite, (uint64_t)bytesPerWrite));
             nbytes = fsptr_->Write(
                 fd, buffer, nwrite,
                 std::min(ntotal - nwrite, (uint64_t)bytesPerWrite));
@@ -352,41 +360,19 @@ bool FilePool::CleanChunk(uint64_t chunkid, bool onlyMarked) {
 }
 
 bool FilePool::CleaningChunk() {
-    auto popBack = [this](std::vector<uint64_t> *chunks,
-                          uint64_t *chunksLeft) -> uint64_t {
-        std::unique_lock<std::mutex> lk(mtx_);
-        if (chunks->empty()) {
-            return 0;
-        }
-
-        uint64_t chunkid = chunks->back();
-        chunks->pop_back();
-        (*chunksLeft)--;
-        currentState_.preallocatedChunksLeft--;
-        return chunkid;
-    };
-
-    auto pushBack = [this](std::vector<uint64_t> *chunks, uint64_t chunkid,
-                           uint64_t *chunksLeft) {
-        std::unique_lock<std::mutex> lk(mtx_);
-        chunks->push_back(chunkid);
-        (*chunksLeft)++;
-        currentState_.preallocatedChunksLeft++;
-    };
-
-    uint64_t chunkid = popBack(&dirtyChunks_, &currentState_.dirtyChunksLeft);
-    if (0 == chunkid) {
+    uint64_t chunkid = 0;
+    if (!dirtyChunks_.Pop(&chunkid)) {
         return false;
     }
 
     // Fill zero to specify chunk
     if (!CleanChunk(chunkid, false)) {
-        pushBack(&dirtyChunks_, chunkid, &currentState_.dirtyChunksLeft);
+        dirtyChunks_.Push(chunkid);
         return false;
     }
 
     LOG(INFO) << "Clean chunk success, chunkid: " << chunkid;
-    pushBack(&cleanChunks_, chunkid, &currentState_.cleanChunksLeft);
+    cleanChunks_.Push(chunkid);
     return true;
 }
 
@@ -482,15 +468,17 @@ int FilePool::FormatTask(uint64_t indexOffset,
             LOG(ERROR) << "Format ERROR!";
             break;
         }
+        cleanChunks_.Push(chunkIndex + indexOffset);
         this->mtx_.lock();
-        cleanChunks_.push_back(chunkIndex + indexOffset);
-        this->currentState_.cleanChunksLeft++;
-        this->currentState_.preallocatedChunksLeft++;
         this->currentState_.chunkNum++;
         this->formatStat_.allocateChunkNum++;
         this->mtx_.unlock();
         this->cond_.notify_all();
     }
+    // Wake up GetChunk waiting for formatting if formatting failed or stopped
+    this->mtx_.lock();
+    this->mtx_.unlock();
+    this->cond_.notify_all();
     LOG(INFO) << "format thread has done!";
     return 0;
 }
@@ -544,48 +532,47 @@ bool FilePool::StopCleaning() {
     return true;
 }
 
-bool FilePool::GetChunk(bool needClean, uint64_t *chunkid, bool *isCleaned) {
-    auto pop = [&](std::vector<uint64_t>* chunks, uint64_t* chunksLeft,
-                   bool isCleanChunks) -> bool {
-        if (chunks->empty()) {
-            return false;
-        }
-
-        *chunkid = chunks->back();
-        chunks->pop_back();
-        (*chunksLeft)--;
-        currentState_.preallocatedChunksLeft--;
-        *isCleaned = isCleanChunks;
+bool FilePool::PopChunk(bool needClean, uint64_t *chunkid, bool *isCleaned) {
+    FreeChunkList* first = needClean ? &cleanChunks_ : &dirtyChunks_;
+    FreeChunkList* second = needClean ? &dirtyChunks_ : &cleanChunks_;
+    if (first->Pop(chunkid)) {
+        *isCleaned = needClean;
         return true;
-    };
+    }
+    if (second->Pop(chunkid)) {
+        *isCleaned = !needClean;
+        return true;
+    }
+    return false;
+}
 
-    auto wake_up = [&]() {
-        return (formatStat_.allocateChunkNum.load() ==
-                formatStat_.preAllocateNum)  // NOLINT
-               || !(dirtyChunks_.empty() && cleanChunks_.empty());
-    };
+bool FilePool::FormatFinished() const {
+    return formatStat_.allocateChunkNum.load() == formatStat_.preAllocateNum ||
+           formatStat_.isWrong.load() || !formatAlived_.load();
+}
 
-    bool ret = true;
-    {
+bool FilePool::GetChunk(bool needClean, uint64_t *chunkid, bool *isCleaned) {
+    // The free lists are checked without the pool lock, only wait for the
+    // format workers when the pool is empty during formatting
+    bool ret = PopChunk(needClean, chunkid, isCleaned);
+    if (!ret && !FormatFinished()) {
         std::unique_lock<std::mutex> lk(mtx_);
-        if (formatStat_.allocateChunkNum.load() != formatStat_.preAllocateNum) {
-            cond_.wait(lk, wake_up);
-        }
-        if (!needClean) {
-            return pop(&dirtyChunks_, &currentState_.dirtyChunksLeft, false) ||
-                   pop(&cleanChunks_, &currentState_.cleanChunksLeft, true);
-        }
-
-        // Need clean chunk
-        *isCleaned = false;
-        ret = pop(&cleanChunks_, &currentState_.cleanChunksLeft, true) ||
-              pop(&dirtyChunks_, &currentState_.dirtyChunksLeft, false);
+        cond_.wait(lk, [&]() {
+            ret = PopChunk(needClean, chunkid, isCleaned);
+            return ret || FormatFinished();
+        });
     }
-    if (true == ret && false == *isCleaned && CleanChunk(*chunkid, true)) {
-        *isCleaned = true;
+    if (!ret || !needClean || *isCleaned) {
+        return ret;
     }
 
-    return *isCleaned;
+    // Need clean chunk, but only dirty chunk left
+    if (!CleanChunk(*chunkid, true)) {
+        dirtyChunks_.Push(*chunkid);
+        return false;
+    }
+    *isCleaned = true;
+    return true;
 }
 
 int FilePool::GetFile(const std::string &targetpath, const char *metapage,
@@ -639,7 +626,7 @@ int FilePool::GetFile(const std::string &targetpath, const char *metapage,
             } else {
                 LOG(INFO) << "get file " << targetpath
                           << " success! now pool size = "
-                          << currentState_.preallocatedChunksLeft;
+                          << Size();
                 break;
             }
         } else {
@@ -667,17 +654,31 @@ int FilePool::AllocateChunk(const std::string &chunkpath) {
         return -1;
     }
 
-    char *data = new (std::nothrow) char[chunklen];
-    memset(data, 0, chunklen);
-
-    ret = fsptr_->Write(fd, data, 0, chunklen);
-    if (ret < 0) {
+    // 使用池中的buffer分段写零，格式化时不再为每个文件申请chunklen大小的内存
+    AlignedBufferPool& bufferPool = AlignedBufferPool::GetInstance();
+    uint64_t bufSize = std::min<uint64_t>(chunklen,
+                                          AlignedBufferPool::kMaxPooledSize);
+    char *data = bufferPool.Alloc(bufSize);
+    if (data == nullptr) {
         fsptr_->Close(fd);
-        delete[] data;
-        LOG(ERROR) << "write failed, " << chunkpath.c_str();
+        LOG(ERROR) << "alloc format buffer failed, " << chunkpath.c_str();
         return -1;
     }
-    delete[] data;
+    memset(data, 0, bufSize);
+
+    for (uint64_t offset = 0; offset < chunklen; offset += bufSize) {
+        int length = std::min<uint64_t>(bufSize, chunklen - offset);
+        BackgroundIOScheduler::GetInstance().Acquire(BackgroundIOType::FORMAT,
+                                                     length);
+        ret = fsptr_->Write(fd, data, offset, length);
+        if (ret < 0) {
+            fsptr_->Close(fd);
+            bufferPool.Free(data, bufSize);
+            LOG(ERROR) << "write failed, " << chunkpath.c_str();
+            return -1;
+        }
+    }
+    bufferPool.Free(data, bufSize);
 
     ret = fsptr_->Fsync(fd);
     if (ret < 0) {
@@ -763,17 +764,20 @@ int FilePool::RecycleFile(const std::string &chunkpath) {
             return fsptr_->Delete(chunkpath.c_str());
         }
 
+        // The file may still be referenced by a hard link, e.g. a chunk reused
+        // by an incremental raft snapshot; reusing its inode would overwrite
+        // the other reference, so just unlink it
+        if (info.st_nlink > 1) {
+            LOG(INFO) << "file " << chunkpath.c_str() << " has "
+                      << info.st_nlink << " links, delete it directly";
+            fsptr_->Close(fd);
+            return fsptr_->Delete(chunkpath.c_str());
+        }
+
         fsptr_->Close(fd);
 
-        uint64_t newfilenum = 0;
-        std::string newfilename;
-        {
-            std::unique_lock<std::mutex> lk(mtx_);
-            currentmaxfilenum_.fetch_add(1);
-            newfilenum = currentmaxfilenum_.load();
-            newfilename = std::to_string(newfilenum);
-        }
-        std::string targetpath = currentdir_ + "/" + newfilename;
+        uint64_t newfilenum = currentmaxfilenum_.fetch_add(1) + 1;
+        std::string targetpath = currentdir_ + "/" + std::to_string(newfilenum);
 
         ret = fsptr_->Rename(chunkpath.c_str(), targetpath.c_str());
         if (ret < 0) {
@@ -782,12 +786,9 @@ int FilePool::RecycleFile(const std::string &chunkpath) {
         } else {
             LOG(INFO) << "Recycle " << chunkpath.c_str() << ", success!"
                       << ", now chunkpool size = "
-                      << currentState_.dirtyChunksLeft + 1;
+                      << Size() + 1;
         }
-        std::unique_lock<std::mutex> lk(mtx_);
-        dirtyChunks_.push_back(newfilenum);
-        currentState_.dirtyChunksLeft++;
-        currentState_.preallocatedChunksLeft++;
+        dirtyChunks_.Push(newfilenum);
     }
     return 0;
 }
@@ -795,9 +796,8 @@ int FilePool::RecycleFile(const std::string &chunkpath) {
 void FilePool::UnInitialize() {
     currentdir_ = "";
     StopFormatting();
-    std::unique_lock<std::mutex> lk(mtx_);
-    dirtyChunks_.clear();
-    cleanChunks_.clear();
+    dirtyChunks_.Clear();
+    cleanChunks_.Clear();
 }
 
 bool FilePool::ScanInternal() {
@@ -823,6 +823,8 @@ bool FilePool::ScanInternal() {
 
     size_t suffixLen = kCleanChunkSuffix_.size();
     uint64_t chunklen = poolOpt_.fileSize + poolOpt_.metaPageSize;
+    std::vector<uint64_t> dirtyChunks;
+    std::vector<uint64_t> cleanChunks;
     for (auto &iter : tmpvec) {
         bool isCleaned = false;
         std::string chunkNum = iter;
@@ -864,9 +866,9 @@ bool FilePool::ScanInternal() {
         uint64_t filenum = atoll(chunkNum.c_str());
         if (filenum != 0) {
             if (isCleaned) {
-                cleanChunks_.push_back(filenum);
+                cleanChunks.push_back(filenum);
             } else {
-                dirtyChunks_.push_back(filenum);
+                dirtyChunks.push_back(filenum);
             }
             if (filenum > maxnum) {
                 maxnum = filenum;
@@ -878,15 +880,11 @@ bool FilePool::ScanInternal() {
     currentState_.chunkNum += CountAllocatedNum(poolOpt_.copysetDir);
     currentState_.chunkNum += CountAllocatedNum(poolOpt_.recycleDir);
 
-    std::unique_lock<std::mutex> lk(mtx_);
     currentmaxfilenum_.store(maxnum + 1);
-    currentState_.dirtyChunksLeft = dirtyChunks_.size();
-    currentState_.cleanChunksLeft = cleanChunks_.size();
-    currentState_.preallocatedChunksLeft =
-        currentState_.dirtyChunksLeft + currentState_.cleanChunksLeft;
+    dirtyChunks_.PushBatch(dirtyChunks);
+    cleanChunks_.PushBatch(cleanChunks);
 
-    LOG(INFO) << "scan done, pool size = "
-              << currentState_.preallocatedChunksLeft;
+    LOG(INFO) << "scan done, pool size = " << Size();
     return true;
 }
 
@@ -915,12 +913,16 @@ uint64_t FilePool::CountAllocatedNum(const std::string& path) {
 }
 
 size_t FilePool::Size() {
-    std::unique_lock<std::mutex> lk(mtx_);
-    return currentState_.preallocatedChunksLeft;
+    return dirtyChunks_.Size() + cleanChunks_.Size();
 }
 
 FilePoolState FilePool::GetState() const {
-    return currentState_;
+    FilePoolState state = currentState_;
+    state.dirtyChunksLeft = dirtyChunks_.Size();
+    state.cleanChunksLeft = cleanChunks_.Size();
+    state.preallocatedChunksLeft =
+        state.dirtyChunksLeft + state.cleanChunksLeft;
+    return state;
 }
 
 const ChunkFormatStat& FilePool::GetChunkFormatStat() const {
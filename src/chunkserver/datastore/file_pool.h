@@ -35,6 +35,7 @@
 #include <vector>
 
 #include "include/curve_compiler_specific.h"
+#include "src/chunkserver/datastore/free_chunk_list.h"
 #include "src/common/concurrent/concurrent.h"
 #include "src/common/interruptible_sleeper.h"
 #include "src/common/throttle.h"
@@ -308,6 +309,17 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
      */
     bool GetChunk(bool needClean, uint64_t* chunkid, bool* isCleaned);
 
+    /**
+     * @brief: Take a chunk from the free lists without blocking
+     * @return: Return false if both lists are empty
+     */
+    bool PopChunk(bool needClean, uint64_t* chunkid, bool* isCleaned);
+
+    /**
+     * @brief: Whether the format workers will not add chunks any more
+     */
+    bool FormatFinished() const;
+
     /**
      * @brief: Zeroing specify chunk file
      * @param chunkid: The chunk id
@@ -352,7 +364,8 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
     // Sets a pause between cleaning when clean chunk fail
     static const std::chrono::milliseconds kFailSleepMsec_;
 
-    // Protect dirtyChunks_, cleanChunks_
+    // Protect the format state, GetChunk waits on it only when the pool is
+    // empty while formatting is still in progress
     std::mutex mtx_;
 
     // Wait for GetChunk
@@ -366,10 +379,10 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
     std::shared_ptr<LocalFileSystem> fsptr_;
 
     // The numeric format of the file name for all dirty chunk
-    std::vector<uint64_t> dirtyChunks_;
+    FreeChunkList dirtyChunks_;
 
     // The numeric format of the file name for all clean chunk
-    std::vector<uint64_t> cleanChunks_;
+    FreeChunkList cleanChunks_;
 
     // The current largest file name number format
     std::atomic<uint64_t> currentmaxfilenum_;
@@ -377,7 +390,8 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
     // FilePool configuration options
     FilePoolOptions poolOpt_;
 
-    // FilePool allocation status
+    // FilePool allocation status, the number of files left is taken from
+    // dirtyChunks_ and cleanChunks_
     FilePoolState currentState_;
 
     // Whether the clean thread is alive
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/chunkserver/datastore/free_chunk_list.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>  // NOLINT
+
+namespace curve {
+namespace chunkserver {
+
+FreeChunkList::FreeChunkList(uint32_t shardNum) : size_(0) {
+    if (shardNum == 0) {
+        shardNum = 1;
+    }
+    for (uint32_t i = 0; i < shardNum; ++i) {
+        shards_.emplace_back(new Shard());
+    }
+}
+
+uint32_t FreeChunkList::LocalShardIndex() const {
+    static thread_local size_t hash =
+        std::hash<std::thread::id>()(std::this_thread::get_id());
+    return hash % shards_.size();
+}
+
+void FreeChunkList::Push(uint64_t chunkid) {
+    Shard* shard = shards_[LocalShardIndex()].get();
+    std::lock_guard<std::mutex> lk(shard->mtx);
+    shard->chunks.push_back(chunkid);
+    // Updated under the shard lock so that a concurrent Pop never sees
+    // the file before it is counted
+    size_.fetch_add(1, std::memory_order_release);
+}
+
+void FreeChunkList::PushBatch(const std::vector<uint64_t>& chunkids) {
+    // Split the files into contiguous blocks, one for each shard. The last
+    // block goes to the local shard, so a following Pop in this thread gets
+    // the last file as if the list were a single stack
+    size_t shardNum = shards_.size();
+    size_t blockSize = (chunkids.size() + shardNum - 1) / shardNum;
+    uint32_t local = LocalShardIndex();
+    for (size_t i = 0; i < shardNum; ++i) {
+        size_t begin = std::min(i * blockSize, chunkids.size());
+        size_t end = std::min(begin + blockSize, chunkids.size());
+        if (begin == end) {
+            continue;
+        }
+        Shard* shard = shards_[(local + 1 + i) % shardNum].get();
+        std::lock_guard<std::mutex> lk(shard->mtx);
+        shard->chunks.insert(shard->chunks.end(),
+                             chunkids.begin() + begin, chunkids.begin() + end);
+        size_.fetch_add(end - begin, std::memory_order_release);
+    }
+}
+
+bool FreeChunkList::Pop(uint64_t* chunkid) {
+    if (Empty()) {
+        return false;
+    }
+
+    // Start from the local shard, steal from the others if it is empty
+    size_t shardNum = shards_.size();
+    uint32_t start = LocalShardIndex();
+    for (size_t i = 0; i < shardNum; ++i) {
+        Shard* shard = shards_[(start + i) % shardNum].get();
+        std::lock_guard<std::mutex> lk(shard->mtx);
+        if (!shard->chunks.empty()) {
+            *chunkid = shard->chunks.back();
+            shard->chunks.pop_back();
+            size_.fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+void FreeChunkList::Clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lk(shard->mtx);
+        size_.fetch_sub(shard->chunks.size(), std::memory_order_release);
+        shard->chunks.clear();
+    }
+}
+
+}  // namespace chunkserver
+}  // namespace curve
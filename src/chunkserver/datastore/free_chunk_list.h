@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_CHUNKSERVER_DATASTORE_FREE_CHUNK_LIST_H_
+#define SRC_CHUNKSERVER_DATASTORE_FREE_CHUNK_LIST_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace chunkserver {
+
+/**
+ * The free list of pre-allocated files in FilePool.
+ * Files are spread over several shards, each protected by its own mutex.
+ * A thread pushes and pops on the shard picked by its thread id and only
+ * steals from other shards when its own shard is empty, so concurrent
+ * GetFile/RecycleFile calls and the clean/format workers rarely contend.
+ * The total size is kept in an atomic, checking for an empty list does
+ * not take any lock.
+ */
+class FreeChunkList : public curve::common::Uncopyable {
+ public:
+    static const uint32_t kDefaultShardNum = 8;
+
+    explicit FreeChunkList(uint32_t shardNum = kDefaultShardNum);
+    ~FreeChunkList() = default;
+
+    /**
+     * Put a file into the list
+     * @param chunkid: the file number in the pool directory
+     */
+    void Push(uint64_t chunkid);
+
+    /**
+     * Put a batch of files into the list, the files are spread evenly
+     * over all shards, the last ones are taken first by this thread
+     */
+    void PushBatch(const std::vector<uint64_t>& chunkids);
+
+    /**
+     * Take a file from the list
+     * @param[out] chunkid: the file number taken
+     * @return false if the list is empty
+     */
+    bool Pop(uint64_t* chunkid);
+
+    uint64_t Size() const {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const {
+        return Size() == 0;
+    }
+
+    void Clear();
+
+ private:
+    struct Shard {
+        std::mutex mtx;
+        std::vector<uint64_t> chunks;
+    };
+
+    uint32_t LocalShardIndex() const;
+
+ private:
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> size_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_DATASTORE_FREE_CHUNK_LIST_H_
@@ -0,0 +1,189 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/chunkserver/datastore/group_syncer.h"
+
+#include <glog/logging.h>
+
+#include <chrono>
+#include <utility>
+
+#include "src/common/concurrent/count_down_event.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::common::CountDownEvent;
+
+GroupSyncer::GroupSyncer()
+    : running_(false),
+      cond_(std::make_shared<std::condition_variable>()),
+      syncPool_(std::make_shared<TaskThreadPool<>>()) {}
+
+GroupSyncer::~GroupSyncer() {
+    Fini();
+}
+
+int GroupSyncer::Init(const GroupSyncerOptions& options) {
+    options_ = options;
+    return 0;
+}
+
+int GroupSyncer::Run() {
+    if (running_.exchange(true)) {
+        return 0;
+    }
+    int ret = syncPool_->Start(options_.syncConcurrency);
+    if (ret < 0) {
+        LOG(ERROR) << "Start group syncer pool failed, concurrency: "
+                   << options_.syncConcurrency;
+        running_ = false;
+        return -1;
+    }
+    syncThread_ = std::thread(&GroupSyncer::SyncLoop, this);
+    LOG(INFO) << "Group syncer started, flush interval ms: "
+              << options_.flushIntervalMs
+              << ", sync concurrency: " << options_.syncConcurrency;
+    return 0;
+}
+
+int GroupSyncer::Fini() {
+    {
+        std::lock_guard<std::mutex> lk(condMtx_);
+        if (!running_.exchange(false)) {
+            return 0;
+        }
+        cond_->notify_all();
+    }
+    if (syncThread_.joinable()) {
+        syncThread_.join();
+    }
+    std::lock_guard<std::mutex> flushLock(flushMtx_);
+    FlushPending();
+    syncPool_->Stop();
+    LOG(INFO) << "Group syncer stopped.";
+    return 0;
+}
+
+void GroupSyncer::Add(const std::shared_ptr<CSDataStore>& dataStore,
+                      ChunkID id) {
+    std::lock_guard<std::mutex> lk(pendingMtx_);
+    DirtyChunks& dirty = pending_[dataStore.get()];
+    if (dirty.dataStore == nullptr) {
+        dirty.dataStore = dataStore;
+    }
+    dirty.chunkIds.insert(id);
+}
+
+void GroupSyncer::Flush() {
+    std::lock_guard<std::mutex> flushLock(flushMtx_);
+    FlushPending();
+}
+
+void GroupSyncer::Flush(const std::shared_ptr<CSDataStore>& dataStore) {
+    // 等待正在进行的一轮刷盘，其中可能包含该datastore的chunk
+    std::lock_guard<std::mutex> flushLock(flushMtx_);
+    DirtyMap dirtyMap;
+    {
+        std::lock_guard<std::mutex> lk(pendingMtx_);
+        auto iter = pending_.find(dataStore.get());
+        if (iter == pending_.end()) {
+            return;
+        }
+        dirtyMap.emplace(iter->first, std::move(iter->second));
+        pending_.erase(iter);
+    }
+    SyncDirty(dirtyMap);
+}
+
+size_t GroupSyncer::PendingCount() {
+    std::lock_guard<std::mutex> lk(pendingMtx_);
+    size_t count = 0;
+    for (auto& item : pending_) {
+        count += item.second.chunkIds.size();
+    }
+    return count;
+}
+
+void GroupSyncer::SyncLoop() {
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lk(condMtx_);
+            if (!running_) {
+                break;
+            }
+            cond_->wait_for(lk,
+                std::chrono::milliseconds(options_.flushIntervalMs));
+        }
+        std::lock_guard<std::mutex> flushLock(flushMtx_);
+        FlushPending();
+    }
+}
+
+void GroupSyncer::FlushPending() {
+    DirtyMap dirtyMap;
+    {
+        std::lock_guard<std::mutex> lk(pendingMtx_);
+        dirtyMap.swap(pending_);
+    }
+    SyncDirty(dirtyMap);
+}
+
+void GroupSyncer::SyncDirty(const DirtyMap& dirtyMap) {
+    if (dirtyMap.empty()) {
+        return;
+    }
+
+    // 先对本轮所有chunk发起回写，不等待完成
+    int count = 0;
+    for (auto& item : dirtyMap) {
+        CSDataStore* dataStore = item.first;
+        for (ChunkID id : item.second.chunkIds) {
+            CSErrorCode errorCode = dataStore->WriteBackChunk(id);
+            if (errorCode != CSErrorCode::Success) {
+                LOG(WARNING) << "Write back chunk failed, chunkid: " << id
+                             << ", data store return: " << errorCode;
+            }
+            ++count;
+        }
+    }
+
+    // 再并发等待所有chunk刷盘完成
+    CountDownEvent syncDone(count);
+    bool usePool = running_.load();
+    for (auto& item : dirtyMap) {
+        CSDataStore* dataStore = item.first;
+        for (ChunkID id : item.second.chunkIds) {
+            auto task = [dataStore, id, &syncDone]() {
+                CSErrorCode errorCode = dataStore->SyncChunk(id);
+                if (errorCode != CSErrorCode::Success) {
+                    LOG(FATAL) << "Sync chunk failed, chunkid: " << id
+                               << ", data store return: " << errorCode;
+                }
+                syncDone.Signal();
+            };
+            if (usePool) {
+                syncPool_->Enqueue(task);
+            } else {
+                task();
+            }
+        }
+    }
+    syncDone.Wait();
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,133 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_CHUNKSERVER_DATASTORE_GROUP_SYNCER_H_
+#define SRC_CHUNKSERVER_DATASTORE_GROUP_SYNCER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "include/chunkserver/chunkserver_common.h"
+#include "src/chunkserver/datastore/chunkserver_datastore.h"
+#include "src/common/concurrent/task_thread_pool.h"
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::common::TaskThreadPool;
+
+struct GroupSyncerOptions {
+    // 两轮批量刷盘之间的最大间隔
+    uint32_t flushIntervalMs = 25000;
+    // 并发执行fdatasync的线程数
+    uint32_t syncConcurrency = 20;
+};
+
+/**
+ * chunkserver上所有copyset共享的批量刷盘模块
+ * 各copyset写过的chunk登记到待刷盘集合中，同一个chunk在一轮中只会刷一次盘，
+ * 刷盘线程在每个刷盘周期或者被datastore的写入量唤醒时取出所有待刷盘的chunk，
+ * 先对所有文件发起回写，使各个文件的IO同时下发到磁盘，再并发的等待各文件
+ * fdatasync完成，从而把一个周期内大量小写的刷盘开销合并到一轮中
+ */
+class GroupSyncer : public curve::common::Uncopyable {
+ public:
+    GroupSyncer();
+    virtual ~GroupSyncer();
+
+    int Init(const GroupSyncerOptions& options);
+
+    /**
+     * 启动刷盘线程和刷盘线程池
+     * @return 成功返回0，失败返回-1
+     */
+    int Run();
+
+    /**
+     * 停止刷盘线程，停止前会把已登记的chunk刷盘
+     * @return 成功返回0
+     */
+    int Fini();
+
+    /**
+     * 登记需要刷盘的chunk，在下一轮批量刷盘时统一刷盘
+     * @param dataStore: chunk所在的datastore
+     * @param id: chunk id
+     */
+    void Add(const std::shared_ptr<CSDataStore>& dataStore, ChunkID id);
+
+    /**
+     * 立即执行一轮刷盘，返回时所有在调用前登记的chunk都已经刷盘，
+     * 包括正在进行中的一轮刷盘
+     */
+    void Flush();
+
+    /**
+     * 只对指定datastore登记的chunk立即刷盘，其他datastore的chunk留到下一轮，
+     * 返回时该datastore在调用前登记的chunk都已经刷盘
+     * @param dataStore: 需要刷盘的datastore
+     */
+    void Flush(const std::shared_ptr<CSDataStore>& dataStore);
+
+    /**
+     * datastore写入量达到阈值时通过该条件变量提前唤醒刷盘线程
+     */
+    std::shared_ptr<std::condition_variable> GetCond() const {
+        return cond_;
+    }
+
+    // 当前待刷盘的chunk数量
+    size_t PendingCount();
+
+ private:
+    void SyncLoop();
+
+    // 对取出的所有待刷盘chunk执行一轮刷盘，调用方需持有flushMtx_
+    void FlushPending();
+
+ private:
+    struct DirtyChunks {
+        std::shared_ptr<CSDataStore> dataStore;
+        std::unordered_set<ChunkID> chunkIds;
+    };
+    using DirtyMap = std::unordered_map<CSDataStore*, DirtyChunks>;
+
+    // 对给定的chunk执行回写和刷盘，调用方需持有flushMtx_
+    void SyncDirty(const DirtyMap& dirtyMap);
+
+    GroupSyncerOptions options_;
+    // 待刷盘的chunk，按datastore分组
+    DirtyMap pending_;
+    std::mutex pendingMtx_;
+    // 保证同一时刻只有一轮刷盘在进行
+    std::mutex flushMtx_;
+    std::atomic<bool> running_;
+    std::mutex condMtx_;
+    std::shared_ptr<std::condition_variable> cond_;
+    std::thread syncThread_;
+    std::shared_ptr<TaskThreadPool<>> syncPool_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_DATASTORE_GROUP_SYNCER_H_
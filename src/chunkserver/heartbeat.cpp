@@ -96,6 +96,8 @@ int Heartbeat::Init(const HeartbeatOptions &options) {
 
     // init scanManager
     scanMan_ = options.scanManager;
+
+    deltaTracker_.Init(options_.deltaOptions);
     return 0;
 }
 
@@ -326,7 +328,11 @@ void Heartbeat::DumpHeartbeatRequest(const HeartbeatRequest& request) {
              << request.chunkserverid()
              << ", IP: " << request.ip() << ", port: " << request.port()
              << ", copyset count: " << request.copysetcount()
-             << ", leader count: " << request.leadercount();
+             << ", leader count: " << request.leadercount()
+             << ", delta: " << request.deltareport()
+             << ", reported copyset count: " << request.copysetinfos_size()
+             << ", removed copyset count: "
+             << request.removedcopysets_size();
     for (int i = 0; i < request.copysetinfos_size(); i ++) {
         const curve::mds::heartbeat::CopySetInfo& info =
             request.copysetinfos(i);
@@ -599,14 +605,18 @@ void Heartbeat::HeartbeatWorker() {
             ::sleep(errorIntervalSec);
             continue;
         }
+        deltaTracker_.Filter(&req);
 
         LOG(INFO) << "sending heartbeat info";
         ret = SendHeartbeat(req, &resp);
         if (ret != 0) {
             LOG(WARNING) << "Failed to send heartbeat to MDS";
+            // 可能已经切换了mds，下次全量上报并重新确认是否支持增量心跳
+            deltaTracker_.Reset();
             ::sleep(errorIntervalSec);
             continue;
         }
+        deltaTracker_.OnResponse(resp);
 
         LOG(INFO) << "executing heartbeat info";
         ret = ExecTask(resp);
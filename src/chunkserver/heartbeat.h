@@ -39,6 +39,7 @@
 #include "src/common/wait_interval.h"
 #include "src/common/concurrent/concurrent.h"
 #include "src/chunkserver/scan_manager.h"
+#include "src/chunkserver/heartbeat_delta_tracker.h"
 #include "proto/heartbeat.pb.h"
 #include "proto/scan.pb.h"
 
@@ -69,6 +70,7 @@ struct HeartbeatOptions {
     uint32_t                timeout;
     CopysetNodeManager*     copysetNodeManager;
     ScanManager*            scanManager;
+    HeartbeatDeltaOptions   deltaOptions;
 
     std::shared_ptr<LocalFileSystem> fs;
     std::shared_ptr<FilePool> chunkFilePool;
@@ -187,6 +189,9 @@ class Heartbeat {
     uint64_t startUpTime_;
 
     ScanManager *scanMan_;
+
+    // 记录已上报的copyset信息，用于构建增量心跳
+    HeartbeatDeltaTracker deltaTracker_;
 };
 
 }  // namespace chunkserver
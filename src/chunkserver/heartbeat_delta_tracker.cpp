@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/chunkserver/heartbeat_delta_tracker.h"
+
+#include <glog/logging.h>
+
+namespace curve {
+namespace chunkserver {
+
+using curve::mds::heartbeat::CopySetInfo;
+using curve::mds::heartbeat::CopySetIdentity;
+using curve::mds::heartbeat::HeartbeatStatusCode;
+
+HeartbeatDeltaTracker::HeartbeatDeltaTracker()
+    : mdsAcceptDelta_(false),
+      needFullReport_(true),
+      deltaCount_(0),
+      pendingDelta_(false) {}
+
+void HeartbeatDeltaTracker::Init(const HeartbeatDeltaOptions& options) {
+    options_ = options;
+    Reset();
+}
+
+bool HeartbeatDeltaTracker::Filter(HeartbeatRequest* request) {
+    pending_.clear();
+    pendingDelta_ = false;
+    if (!options_.enable) {
+        return false;
+    }
+
+    for (const CopySetInfo& info : request->copysetinfos()) {
+        GroupNid id = ToGroupNid(info.logicalpoolid(), info.copysetid());
+        pending_[id] = info.SerializeAsString();
+    }
+
+    bool needFull = !mdsAcceptDelta_ || needFullReport_ ||
+        (options_.fullReportInterval > 0 &&
+         deltaCount_ >= options_.fullReportInterval);
+    if (needFull) {
+        return false;
+    }
+
+    google::protobuf::RepeatedPtrField<CopySetInfo> infos;
+    infos.Swap(request->mutable_copysetinfos());
+    for (CopySetInfo& info : infos) {
+        GroupNid id = ToGroupNid(info.logicalpoolid(), info.copysetid());
+        auto iter = reported_.find(id);
+        if (iter != reported_.end() && iter->second == pending_[id] &&
+            needReport_.count(id) == 0) {
+            continue;
+        }
+        request->add_copysetinfos()->Swap(&info);
+    }
+    for (const auto& item : reported_) {
+        if (pending_.count(item.first) != 0) {
+            continue;
+        }
+        CopySetIdentity* removed = request->add_removedcopysets();
+        removed->set_logicalpoolid(GetPoolID(item.first));
+        removed->set_copysetid(GetCopysetID(item.first));
+    }
+    request->set_deltareport(true);
+    pendingDelta_ = true;
+    return true;
+}
+
+void HeartbeatDeltaTracker::OnResponse(const HeartbeatResponse& response) {
+    if (!options_.enable) {
+        return;
+    }
+
+    mdsAcceptDelta_ = response.acceptdelta();
+    needReport_.clear();
+    for (const CopySetIdentity& id : response.needreportcopysets()) {
+        needReport_.insert(ToGroupNid(id.logicalpoolid(), id.copysetid()));
+    }
+
+    // 部分copyset没有被mds正确处理时，下次重新全量上报
+    bool ok = response.statuscode() == HeartbeatStatusCode::hbOK ||
+        response.statuscode() == HeartbeatStatusCode::hbRequestNoCopyset;
+    if (!ok || response.needfullreport()) {
+        LOG(INFO) << "Next heartbeat will report all copysets, status code: "
+                  << response.statuscode()
+                  << ", need full report: " << response.needfullreport();
+        reported_.clear();
+        needFullReport_ = true;
+        return;
+    }
+
+    // mds已经收到了所有相比reported_有变化的copyset，两者一致
+    reported_.swap(pending_);
+    pending_.clear();
+    if (pendingDelta_) {
+        ++deltaCount_;
+    } else {
+        deltaCount_ = 0;
+        needFullReport_ = false;
+    }
+}
+
+void HeartbeatDeltaTracker::Reset() {
+    mdsAcceptDelta_ = false;
+    needFullReport_ = true;
+    deltaCount_ = 0;
+    pendingDelta_ = false;
+    reported_.clear();
+    pending_.clear();
+    needReport_.clear();
+}
+
+}  // namespace chunkserver
+}  // namespace curve
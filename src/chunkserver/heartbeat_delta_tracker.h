@@ -0,0 +1,100 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_CHUNKSERVER_HEARTBEAT_DELTA_TRACKER_H_
+#define SRC_CHUNKSERVER_HEARTBEAT_DELTA_TRACKER_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "include/chunkserver/chunkserver_common.h"
+#include "proto/heartbeat.pb.h"
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace chunkserver {
+
+/**
+ * 增量心跳选项
+ */
+struct HeartbeatDeltaOptions {
+    // 是否开启增量心跳，关闭时每次心跳都全量上报copyset信息
+    bool enable = false;
+    // 每发送多少次增量心跳后发送一次全量心跳，为0时只在必要时全量上报
+    uint32_t fullReportInterval = 30;
+};
+
+/**
+ * 记录上次成功上报给mds的copyset信息，据此把心跳请求裁剪为增量心跳。
+ * 只有mds在回应中表明支持增量心跳(acceptDelta)后才会发送增量心跳，
+ * mds要求全量上报、心跳失败或切换mds后，下次心跳全量上报。
+ * 只在心跳线程中使用，不加锁。
+ */
+class HeartbeatDeltaTracker : public curve::common::Uncopyable {
+ public:
+    using HeartbeatRequest =
+        curve::mds::heartbeat::ChunkServerHeartbeatRequest;
+    using HeartbeatResponse =
+        curve::mds::heartbeat::ChunkServerHeartbeatResponse;
+
+    HeartbeatDeltaTracker();
+    ~HeartbeatDeltaTracker() = default;
+
+    void Init(const HeartbeatDeltaOptions& options);
+
+    /**
+     * @brief 去掉心跳请求中相比上次成功上报没有变化的copyset信息，
+     *        并填充已删除的copyset
+     * @param[in|out] request 包含全部copyset信息的心跳请求
+     * @return true: 本次为增量心跳，false: 本次为全量心跳
+     */
+    bool Filter(HeartbeatRequest* request);
+
+    /**
+     * @brief 心跳发送成功后，根据mds的回应更新已上报的copyset信息
+     * @param[in] response mds的回应
+     */
+    void OnResponse(const HeartbeatResponse& response);
+
+    /**
+     * @brief 心跳发送失败或者切换了mds，下次心跳全量上报
+     */
+    void Reset();
+
+ private:
+    HeartbeatDeltaOptions options_;
+    // mds是否支持增量心跳
+    bool mdsAcceptDelta_;
+    // 下次心跳是否需要全量上报
+    bool needFullReport_;
+    // 上次全量心跳之后已经发送的增量心跳个数
+    uint32_t deltaCount_;
+    // 最近一次构建的心跳是否为增量心跳
+    bool pendingDelta_;
+    // mds已经确认的copyset信息，复制组ID -> 序列化后的CopySetInfo
+    std::unordered_map<GroupNid, std::string> reported_;
+    // 最近一次构建的心跳对应的全部copyset信息，心跳成功后替换reported_
+    std::unordered_map<GroupNid, std::string> pending_;
+    // mds要求下次心跳必须上报的copyset
+    std::unordered_set<GroupNid> needReport_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_HEARTBEAT_DELTA_TRACKER_H_
@@ -0,0 +1,210 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/chunkserver/io_tracer.h"
+
+#include <butil/fast_rand.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "src/common/timeutility.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::common::TimeUtility;
+
+const char* IOTraceStageName(IOTraceStage stage) {
+    switch (stage) {
+        case IOTraceStage::RECEIVE:
+            return "receive";
+        case IOTraceStage::PROCESS:
+            return "process";
+        case IOTraceStage::PROPOSE:
+            return "propose";
+        case IOTraceStage::COMMIT:
+            return "commit";
+        case IOTraceStage::APPLY:
+            return "apply";
+        case IOTraceStage::DATASTORE:
+            return "datastore";
+        case IOTraceStage::RESPONSE:
+            return "response";
+    }
+    return "unknown";
+}
+
+void IOTrace::Mark(IOTraceStage stage) {
+    timeUs[static_cast<int>(stage)] = TimeUtility::GetTimeofDayUs();
+}
+
+uint64_t IOTrace::TotalUs() const {
+    uint64_t begin = timeUs[static_cast<int>(IOTraceStage::RECEIVE)];
+    uint64_t end = timeUs[static_cast<int>(IOTraceStage::RESPONSE)];
+    if (begin == 0 || end < begin) {
+        return 0;
+    }
+    return end - begin;
+}
+
+IOTracer::IOTracer() : sampleRate_(0), windowStartUs_(0) {}
+
+IOTracer& IOTracer::GetInstance() {
+    static IOTracer tracer;
+    return tracer;
+}
+
+int IOTracer::Init(const IOTracerOptions& options,
+                   const std::string& prefix) {
+    if (options.sampleRate == 0) {
+        LOG(INFO) << "io trace is disabled.";
+        return 0;
+    }
+    if (options.windowS == 0) {
+        LOG(ERROR) << "io trace window should be greater than 0.";
+        return -1;
+    }
+    options_ = options;
+    for (int i = 1; i < kIOTraceStageNum; ++i) {
+        stageLatency_[i].reset(new bvar::LatencyRecorder());
+        if (stageLatency_[i]->expose(prefix,
+                IOTraceStageName(static_cast<IOTraceStage>(i))) != 0) {
+            LOG(ERROR) << "expose io trace stage latency failed.";
+            return -1;
+        }
+    }
+    if (totalLatency_.expose(prefix, "total") != 0) {
+        LOG(ERROR) << "expose io trace total latency failed.";
+        return -1;
+    }
+    slowestStatus_.reset(new bvar::PassiveStatus<std::string>(
+        prefix, "slowest", PrintSlowest, this));
+    windowStartUs_ = TimeUtility::GetTimeofDayUs();
+    sampleRate_.store(options.sampleRate, std::memory_order_release);
+    LOG(INFO) << "io trace enabled, sample rate: " << options.sampleRate
+              << ", slowest num: " << options.slowestNum;
+    return 0;
+}
+
+std::unique_ptr<IOTrace> IOTracer::Sample(const ChunkRequest& request) {
+    uint32_t rate = sampleRate_.load(std::memory_order_acquire);
+    if (rate == 0 ||
+        request.optype() != CHUNK_OP_TYPE::CHUNK_OP_WRITE ||
+        butil::fast_rand_less_than(rate) != 0) {
+        return nullptr;
+    }
+    std::unique_ptr<IOTrace> trace(new IOTrace());
+    trace->logicPoolId = request.logicpoolid();
+    trace->copysetId = request.copysetid();
+    trace->chunkId = request.chunkid();
+    trace->offset = request.offset();
+    trace->size = request.size();
+    trace->Mark(IOTraceStage::RECEIVE);
+    return trace;
+}
+
+void IOTracer::Finish(const IOTrace& trace) {
+    if (sampleRate_.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    for (int i = 1; i < kIOTraceStageNum; ++i) {
+        if (trace.timeUs[i - 1] == 0 ||
+            trace.timeUs[i] < trace.timeUs[i - 1]) {
+            continue;
+        }
+        *stageLatency_[i] << trace.timeUs[i] - trace.timeUs[i - 1];
+    }
+    uint64_t totalUs = trace.TotalUs();
+    if (totalUs == 0) {
+        return;
+    }
+    totalLatency_ << totalUs;
+    if (options_.slowestNum == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    RollWindow(trace.timeUs[static_cast<int>(IOTraceStage::RESPONSE)]);
+    if (currentSlowest_.size() < options_.slowestNum) {
+        currentSlowest_.push_back(trace);
+        return;
+    }
+    auto fastest = std::min_element(currentSlowest_.begin(),
+        currentSlowest_.end(), [](const IOTrace& a, const IOTrace& b) {
+            return a.TotalUs() < b.TotalUs();
+        });
+    if (fastest->TotalUs() < totalUs) {
+        *fastest = trace;
+    }
+}
+
+void IOTracer::RollWindow(uint64_t nowUs) {
+    uint64_t windowUs = options_.windowS * 1000000ULL;
+    if (nowUs < windowStartUs_ + windowUs) {
+        return;
+    }
+    // 超过两个周期没有请求时，上一个周期的记录也已经过期
+    if (nowUs < windowStartUs_ + 2 * windowUs) {
+        lastSlowest_.swap(currentSlowest_);
+    } else {
+        lastSlowest_.clear();
+    }
+    currentSlowest_.clear();
+    windowStartUs_ = nowUs;
+}
+
+void IOTracer::DumpSlowest(std::ostream& os) {
+    std::vector<IOTrace> traces;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        RollWindow(TimeUtility::GetTimeofDayUs());
+        traces = lastSlowest_;
+        traces.insert(traces.end(),
+                      currentSlowest_.begin(), currentSlowest_.end());
+    }
+    std::sort(traces.begin(), traces.end(),
+              [](const IOTrace& a, const IOTrace& b) {
+                  return a.TotalUs() > b.TotalUs();
+              });
+    if (traces.size() > options_.slowestNum) {
+        traces.resize(options_.slowestNum);
+    }
+    for (const auto& trace : traces) {
+        os << "copyset " << trace.logicPoolId << "," << trace.copysetId
+           << " chunk " << trace.chunkId
+           << " offset " << trace.offset
+           << " size " << trace.size
+           << " total " << trace.TotalUs() << "us";
+        for (int i = 1; i < kIOTraceStageNum; ++i) {
+            os << " " << IOTraceStageName(static_cast<IOTraceStage>(i)) << " ";
+            if (trace.timeUs[i - 1] == 0 ||
+                trace.timeUs[i] < trace.timeUs[i - 1]) {
+                os << "-";
+            } else {
+                os << trace.timeUs[i] - trace.timeUs[i - 1] << "us";
+            }
+        }
+        os << "\n";
+    }
+}
+
+void IOTracer::PrintSlowest(std::ostream& os, void* arg) {
+    static_cast<IOTracer*>(arg)->DumpSlowest(os);
+}
+
+}  // namespace chunkserver
+}  // namespace curve
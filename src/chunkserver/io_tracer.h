@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_CHUNKSERVER_IO_TRACER_H_
+#define SRC_CHUNKSERVER_IO_TRACER_H_
+
+#include <bvar/bvar.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "include/chunkserver/chunkserver_common.h"
+#include "proto/chunk.pb.h"
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::common::Uncopyable;
+
+// 写请求在chunkserver内依次经过的阶段，trace中记录到达每个阶段的时间
+enum class IOTraceStage {
+    // chunk service收到rpc请求
+    RECEIVE = 0,
+    // ChunkOpRequest::Process开始处理
+    PROCESS = 1,
+    // 经过写合并后propose给raft
+    PROPOSE = 2,
+    // 日志写盘并复制到多数派后提交，状态机开始apply
+    COMMIT = 3,
+    // 从并发apply队列中取出，开始执行
+    APPLY = 4,
+    // CSDataStore::WriteChunk返回
+    DATASTORE = 5,
+    // rpc返回给client
+    RESPONSE = 6,
+};
+
+const int kIOTraceStageNum = 7;
+
+const char* IOTraceStageName(IOTraceStage stage);
+
+// 一个被采样的请求在各阶段的时间戳，未经过的阶段为0
+struct IOTrace {
+    LogicPoolID logicPoolId = 0;
+    CopysetID copysetId = 0;
+    ChunkID chunkId = 0;
+    uint64_t offset = 0;
+    uint32_t size = 0;
+    uint64_t timeUs[kIOTraceStageNum] = {0};
+
+    void Mark(IOTraceStage stage);
+
+    // 从收到请求到返回的总时延，请求没有完整经过两端时为0
+    uint64_t TotalUs() const;
+};
+
+struct IOTracerOptions {
+    // 平均每多少个写请求采样一个，为0表示关闭
+    uint32_t sampleRate = 0;
+    // 保留的最慢请求个数
+    uint32_t slowestNum = 32;
+    // 最慢请求的统计周期，导出当前和上一个周期内最慢的请求
+    uint32_t windowS = 60;
+};
+
+/**
+ * 写请求各阶段时延的采样统计
+ * 被采样的写请求在ChunkOpRequest中带一个IOTrace，经过各阶段时打点，
+ * 返回时调用Finish，把相邻两个阶段的时间差记到该阶段的LatencyRecorder，
+ * 例如<prefix>_commit是propose到提交的时延，包含日志写盘和复制。
+ * 最慢的若干个请求可以从<prefix>_slowest查看各阶段的耗时
+ */
+class IOTracer : public Uncopyable {
+ public:
+    IOTracer();
+    ~IOTracer() = default;
+
+    static IOTracer& GetInstance();
+
+    /**
+     * 初始化并暴露metric，未初始化或者sampleRate为0时不采样
+     * @param prefix: metric名字的前缀
+     * @return 成功返回0，失败返回-1
+     */
+    int Init(const IOTracerOptions& options, const std::string& prefix);
+
+    /**
+     * 决定是否采样该请求，只采样写请求
+     * @return 采样时返回已记录RECEIVE的trace，否则返回nullptr
+     */
+    std::unique_ptr<IOTrace> Sample(const ChunkRequest& request);
+
+    /**
+     * 请求返回后记录各阶段的时延
+     */
+    void Finish(const IOTrace& trace);
+
+    /**
+     * 按总时延从大到小输出最近的最慢请求
+     */
+    void DumpSlowest(std::ostream& os);
+
+ private:
+    static void PrintSlowest(std::ostream& os, void* arg);
+    void RollWindow(uint64_t nowUs);
+
+ private:
+    IOTracerOptions options_;
+    std::atomic<uint32_t> sampleRate_;
+
+    // 各阶段的时延，下标为到达的阶段，RECEIVE没有对应的时延
+    std::unique_ptr<bvar::LatencyRecorder> stageLatency_[kIOTraceStageNum];
+    bvar::LatencyRecorder totalLatency_;
+    std::unique_ptr<bvar::PassiveStatus<std::string>> slowestStatus_;
+
+    // 保护下面两个最慢请求列表
+    std::mutex mtx_;
+    uint64_t windowStartUs_;
+    std::vector<IOTrace> currentSlowest_;
+    std::vector<IOTrace> lastSlowest_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_IO_TRACER_H_
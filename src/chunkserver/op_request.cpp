@@ -30,15 +30,22 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "src/chunkserver/copyset_node.h"
 #include "src/chunkserver/chunk_closure.h"
 #include "src/chunkserver/clone_manager.h"
 #include "src/chunkserver/clone_task.h"
+#include "src/chunkserver/write_coalescer.h"
+#include "src/common/aligned_buffer_pool.h"
+#include "src/common/crc32.h"
 
 namespace curve {
 namespace chunkserver {
 
+using curve::common::AlignedBufferPool;
+
 ChunkOpRequest::ChunkOpRequest() :
     datastore_(nullptr),
     node_(nullptr),
@@ -58,11 +65,14 @@ ChunkOpRequest::ChunkOpRequest(std::shared_ptr<CopysetNode> nodePtr,
     cntl_(dynamic_cast<brpc::Controller *>(cntl)),
     request_(request),
     response_(response),
-    done_(done) {
+    done_(done),
+    trace_(request != nullptr ? IOTracer::GetInstance().Sample(*request)
+                              : nullptr) {
 }
 
 void ChunkOpRequest::Process() {
     brpc::ClosureGuard doneGuard(done_);
+    MarkTrace(IOTraceStage::PROCESS);
 
     // check if current node is leader
     if (!node_->IsLeaderTerm()) {
@@ -82,6 +92,17 @@ void ChunkOpRequest::Process() {
 
 int ChunkOpRequest::Propose(const ChunkRequest *request,
                             const butil::IOBuf *data) {
+    WriteCoalescer *coalescer = node_->GetWriteCoalescer();
+    if (nullptr != coalescer) {
+        // 所有请求都经过合并模块，保证propose的顺序和到达的顺序一致
+        coalescer->Submit(shared_from_this(), request, data);
+        return 0;
+    }
+    return ProposeToRaft(request, data);
+}
+
+int ChunkOpRequest::ProposeToRaft(const ChunkRequest *request,
+                                  const butil::IOBuf *data) {
     // 打包op request为task
     braft::Task task;
     butil::IOBuf log;
@@ -100,11 +121,20 @@ int ChunkOpRequest::Propose(const ChunkRequest *request,
      */
     task.expected_term = node_->LeaderTerm();
 
+    MarkTrace(IOTraceStage::PROPOSE);
     node_->Propose(task);
 
     return 0;
 }
 
+void ChunkOpRequest::FinishTrace() {
+    if (trace_ != nullptr) {
+        trace_->Mark(IOTraceStage::RESPONSE);
+        IOTracer::GetInstance().Finish(*trace_);
+        trace_.reset();
+    }
+}
+
 void ChunkOpRequest::RedirectChunkRequest() {
     // 编译时加上 --copt -DUSE_BTHREAD_MUTEX
     // 否则可能发生死锁: CLDCFS-1120
@@ -344,8 +374,10 @@ void ReadChunkRequest::OnApply(uint64_t index,
             return;
         }
         // 如果是ReadChunk请求还需要从本地读取数据
+        // 读取是异步的，读完成后在回调中返回
         if (request_->optype() == CHUNK_OP_TYPE::CHUNK_OP_READ) {
-            ReadChunk();
+            ReadChunk(index, done);
+            return;
         }
         // 如果是recover请求，说明请求区域已经被写过了，可以直接返回成功
         if (request_->optype() == CHUNK_OP_TYPE::CHUNK_OP_RECOVER) {
@@ -353,6 +385,11 @@ void ReadChunkRequest::OnApply(uint64_t index,
         }
     } while (false);
 
+    ApplyDone(index, done);
+}
+
+void ReadChunkRequest::ApplyDone(uint64_t index,
+                                 ::google::protobuf::Closure *done) {
     if (response_->status() == CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS) {
         node_->UpdateAppliedIndex(index);
     }
@@ -388,25 +425,34 @@ bool ReadChunkRequest::NeedClone(const CSChunkInfo& chunkInfo) {
     return false;
 }
 
-static void ReadBufferDeleter(void* ptr) {
-    delete[] static_cast<char*>(ptr);
-}
-
-void ReadChunkRequest::ReadChunk() {
-    char *readBuffer = nullptr;
+void ReadChunkRequest::ReadChunk(uint64_t index,
+                                 ::google::protobuf::Closure *done) {
+    // 从池中获取对齐的buffer，随response attachment释放时归还到池中
     size_t size = request_->size();
-
-    readBuffer = new(std::nothrow)char[size];
+    char *readBuffer = AlignedBufferPool::GetInstance().Alloc(size);
     CHECK(nullptr != readBuffer)
-        << "new readBuffer failed " << strerror(errno);
+        << "alloc readBuffer failed " << strerror(errno);
+
+    // 回调中持有请求本身，保证读完成前请求不会被释放
+    auto thisPtr =
+        std::dynamic_pointer_cast<ReadChunkRequest>(shared_from_this());
+    datastore_->ReadChunkAsync(request_->chunkid(),
+                               request_->sn(),
+                               readBuffer,
+                               request_->offset(),
+                               size,
+        [thisPtr, readBuffer, size, index, done](CSErrorCode ret) {
+            thisPtr->OnReadChunkDone(ret, readBuffer, size);
+            thisPtr->ApplyDone(index, done);
+        });
+}
 
-    auto ret = datastore_->ReadChunk(request_->chunkid(),
-                                     request_->sn(),
-                                     readBuffer,
-                                     request_->offset(),
-                                     size);
+void ReadChunkRequest::OnReadChunkDone(CSErrorCode ret,
+                                       char *readBuffer,
+                                       size_t size) {
     butil::IOBuf wrapper;
-    wrapper.append_user_data(readBuffer, size, ReadBufferDeleter);
+    wrapper.append_user_data(readBuffer, size,
+        AlignedBufferPool::GetInstance().GetDeleter(size));
     if (CSErrorCode::Success == ret) {
         cntl_->response_attachment().append(wrapper);
         response_->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
@@ -430,6 +476,7 @@ void WriteChunkRequest::OnApply(uint64_t index,
                                 ::google::protobuf::Closure *done) {
     brpc::ClosureGuard doneGuard(done);
     uint32_t cost;
+    MarkTrace(IOTraceStage::APPLY);
 
     std::string  cloneSourceLocation;
     if (existCloneInfo(request_)) {
@@ -440,11 +487,12 @@ void WriteChunkRequest::OnApply(uint64_t index,
 
     auto ret = datastore_->WriteChunk(request_->chunkid(),
                                       request_->sn(),
-                                      cntl_->request_attachment(),
+                                      WriteData(),
                                       request_->offset(),
                                       request_->size(),
                                       &cost,
                                       cloneSourceLocation);
+    MarkTrace(IOTraceStage::DATASTORE);
 
     if (CSErrorCode::Success == ret) {
         response_->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
@@ -518,13 +566,46 @@ void WriteChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
     }
 }
 
+MergedWriteChunkRequest::MergedWriteChunkRequest(
+    const ChunkRequest &request,
+    std::vector<std::shared_ptr<ChunkOpRequest>> ops,
+    butil::IOBuf *data) :
+    WriteChunkRequest(),
+    mergedRequest_(request),
+    ops_(std::move(ops)) {
+    CHECK(!ops_.empty()) << "merged write request without ops";
+    node_ = ops_.front()->node_;
+    datastore_ = ops_.front()->datastore_;
+    request_ = &mergedRequest_;
+    response_ = &mergedResponse_;
+    done_ = google::protobuf::NewCallback(
+        this, &MergedWriteChunkRequest::RunOriginalDone);
+    data_.swap(*data);
+    mergedRequest_.set_size(data_.size());
+}
+
+void MergedWriteChunkRequest::MarkTrace(IOTraceStage stage) {
+    for (auto &op : ops_) {
+        op->MarkTrace(stage);
+    }
+}
+
+void MergedWriteChunkRequest::RunOriginalDone() {
+    for (auto &op : ops_) {
+        {
+            brpc::ClosureGuard doneGuard(op->done_);
+            op->response_->CopyFrom(mergedResponse_);
+        }
+        op->FinishTrace();
+    }
+}
+
 void ReadSnapshotRequest::OnApply(uint64_t index,
                                   ::google::protobuf::Closure *done) {
     brpc::ClosureGuard doneGuard(done);
-    char *readBuffer = nullptr;
     uint32_t size = request_->size();
-    readBuffer = new(std::nothrow)char[size];
-    CHECK(nullptr != readBuffer) << "new readBuffer failed, "
+    char *readBuffer = AlignedBufferPool::GetInstance().Alloc(size);
+    CHECK(nullptr != readBuffer) << "alloc readBuffer failed, "
                                  << errno << ":" << strerror(errno);
     auto ret = datastore_->ReadSnapshotChunk(request_->chunkid(),
                                              request_->sn(),
@@ -532,7 +613,8 @@ void ReadSnapshotRequest::OnApply(uint64_t index,
                                              request_->offset(),
                                              request_->size());
     butil::IOBuf wrapper;
-    wrapper.append_user_data(readBuffer, size, ReadBufferDeleter);
+    wrapper.append_user_data(readBuffer, size,
+        AlignedBufferPool::GetInstance().GetDeleter(size));
 
     do {
         /**
@@ -766,41 +848,101 @@ void PasteChunkInternalRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> data
     }
 }
 
+namespace {
+/**
+ * 分段读取扫描范围内的数据并计算crc，每次最多读取kMaxPooledSize，
+ * 避免一次性申请整个扫描范围的内存。request指定了scanBlockSize时，
+ * 同时记录每个块的crc，用于在副本不一致时定位不一致的子区间
+ * @param datastore: chunk数据持久化层
+ * @param request: scan请求
+ * @param scanMap[out]: 填充crc、blockSize和blockCrc
+ * @return datastore的返回值
+ */
+CSErrorCode ScanChunkData(const std::shared_ptr<CSDataStore> &datastore,
+                          const ChunkRequest &request,
+                          ScanMap *scanMap) {
+    size_t size = request.size();
+    // scan chunk metapage
+    if (request.has_readmetapage() && request.readmetapage()) {
+        std::unique_ptr<char[]> readBuffer(new(std::nothrow)char[size]);
+        CHECK(nullptr != readBuffer)
+            << "new readBuffer failed " << strerror(errno);
+        CSErrorCode ret = datastore->ReadChunkMetaPage(request.chunkid(),
+                                                       request.sn(),
+                                                       readBuffer.get());
+        if (CSErrorCode::Success == ret) {
+            scanMap->set_crc(::curve::common::CRC32(readBuffer.get(), size));
+        }
+        return ret;
+    }
+
+    // scan user data
+    const size_t bufSize = std::min(size, AlignedBufferPool::kMaxPooledSize);
+    char *readBuffer = AlignedBufferPool::GetInstance().Alloc(bufSize);
+    CHECK(nullptr != readBuffer) << "alloc readBuffer failed, "
+                                 << errno << ":" << strerror(errno);
+    const uint64_t blockSize = request.scanblocksize();
+    if (blockSize > 0) {
+        scanMap->set_blocksize(blockSize);
+    }
+
+    CSErrorCode ret = CSErrorCode::Success;
+    uint32_t crc = 0;
+    uint32_t blockCrc = 0;
+    uint64_t blockLen = 0;
+    for (size_t off = 0; off < size; off += bufSize) {
+        size_t len = std::min(bufSize, size - off);
+        ret = datastore->ReadChunk(request.chunkid(),
+                                   request.sn(),
+                                   readBuffer,
+                                   request.offset() + off,
+                                   len);
+        if (CSErrorCode::Success != ret) {
+            break;
+        }
+        if (0 == blockSize) {
+            crc = ::curve::common::CRC32(crc, readBuffer, len);
+            continue;
+        }
+        // 每个块单独计算crc，再拼接出整个范围的crc，数据只需要计算一遍
+        for (size_t pos = 0; pos < len;) {
+            size_t n = std::min<uint64_t>(len - pos, blockSize - blockLen);
+            blockCrc = ::curve::common::CRC32(blockCrc, readBuffer + pos, n);
+            blockLen += n;
+            pos += n;
+            if (blockLen == blockSize || off + pos == size) {
+                scanMap->add_blockcrc(blockCrc);
+                crc = ::curve::common::CRC32Combine(crc, blockCrc, blockLen);
+                blockCrc = 0;
+                blockLen = 0;
+            }
+        }
+    }
+    AlignedBufferPool::GetInstance().Free(readBuffer, bufSize);
+
+    if (CSErrorCode::Success == ret) {
+        scanMap->set_crc(crc);
+    }
+    return ret;
+}
+}  // namespace
+
 void ScanChunkRequest::OnApply(uint64_t index,
                                ::google::protobuf::Closure *done) {
     brpc::ClosureGuard doneGuard(done);
 
     // read and calculate crc, build scanmap
-    uint32_t crc = 0;
-    size_t size = request_->size();
-    std::unique_ptr<char[]> readBuffer(new(std::nothrow)char[size]);
-    CHECK(nullptr != readBuffer)
-        << "new readBuffer failed " << strerror(errno);
-    // scan chunk metapage or user data
-    auto ret = 0;
-    if (request_->has_readmetapage() && request_->readmetapage()) {
-        ret = datastore_->ReadChunkMetaPage(request_->chunkid(),
-                                            request_->sn(),
-                                            readBuffer.get());
-    } else {
-        ret = datastore_->ReadChunk(request_->chunkid(),
-                                    request_->sn(),
-                                    readBuffer.get(),
-                                    request_->offset(),
-                                    size);
-    }
+    ScanMap scanMap;
+    auto ret = ScanChunkData(datastore_, *request_, &scanMap);
 
     if (CSErrorCode::Success == ret) {
-        crc = ::curve::common::CRC32(readBuffer.get(), size);
         // build scanmap
-        ScanMap scanMap;
         scanMap.set_logicalpoolid(request_->logicpoolid());
         scanMap.set_copysetid(request_->copysetid());
         scanMap.set_chunkid(request_->chunkid());
         scanMap.set_index(index);
-        scanMap.set_crc(crc);
         scanMap.set_offset(request_->offset());
-        scanMap.set_len(size);
+        scanMap.set_len(request_->size());
 
         ScanKey jobKey(request_->logicpoolid(), request_->copysetid());
         scanManager_->SetLocalScanMap(jobKey, scanMap);
@@ -823,29 +965,11 @@ void ScanChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,  /
                                                const ChunkRequest &request,
                                                const butil::IOBuf &data) {
     (void)data;
-    uint32_t crc = 0;
-    size_t size = request.size();
-    std::unique_ptr<char[]> readBuffer(new(std::nothrow)char[size]);
-    CHECK(nullptr != readBuffer)
-        << "new readBuffer failed " << strerror(errno);
-
-    // scan chunk metapage or user data
-    auto ret = 0;
-    if (request.has_readmetapage() && request.readmetapage()) {
-        ret = datastore->ReadChunkMetaPage(request.chunkid(),
-                                            request.sn(),
-                                            readBuffer.get());
-    } else {
-        ret = datastore->ReadChunk(request.chunkid(),
-                                    request.sn(),
-                                    readBuffer.get(),
-                                    request.offset(),
-                                    size);
-    }
+    std::unique_ptr<ScanMap> scanMap(new ScanMap());
+    auto ret = ScanChunkData(datastore, request, scanMap.get());
 
     if (CSErrorCode::Success == ret) {
-        crc = ::curve::common::CRC32(readBuffer.get(), size);
-        BuildAndSendScanMap(request, index_, crc);
+        BuildAndSendScanMap(request, index_, scanMap.release());
     } else if (CSErrorCode::ChunkNotExistError == ret) {
         LOG(ERROR) << "scan failed: chunk not exist, "
                    << " datastore return: " << ret
@@ -862,23 +986,22 @@ void ScanChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,  /
 }
 
 void ScanChunkRequest::BuildAndSendScanMap(const ChunkRequest &request,
-                                           uint64_t index, uint32_t crc) {
+                                           uint64_t index, ScanMap *scanMap) {
     // send rpc to leader
     brpc::Channel *channel = new brpc::Channel();
     if (channel->Init(peer_.addr, NULL) != 0) {
         LOG(ERROR) << "Fail to init channel to chunkserver for send scanmap: "
                    << peer_;
         delete channel;
+        delete scanMap;
         return;
     }
 
-    // build scanmap
-    ScanMap *scanMap = new ScanMap();
+    // build scanmap, crc has been set by the caller
     scanMap->set_logicalpoolid(request.logicpoolid());
     scanMap->set_copysetid(request.copysetid());
     scanMap->set_chunkid(request.chunkid());
     scanMap->set_index(index);
-    scanMap->set_crc(crc);
     scanMap->set_offset(request.offset());
     scanMap->set_len(request.size());
 
@@ -28,11 +28,13 @@
 #include <brpc/controller.h>
 
 #include <memory>
+#include <vector>
 
 #include "proto/chunk.pb.h"
 #include "include/chunkserver/chunkserver_common.h"
 #include "src/chunkserver/concurrent_apply/concurrent_apply.h"
 #include "src/chunkserver/datastore/define.h"
+#include "src/chunkserver/io_tracer.h"
 #include "src/chunkserver/scan_manager.h"
 
 using ::google::protobuf::RpcController;
@@ -61,6 +63,9 @@ inline bool existCloneInfo(const ChunkRequest *request) {
 }
 
 class ChunkOpRequest : public std::enable_shared_from_this<ChunkOpRequest> {
+    friend class WriteCoalescer;
+    friend class MergedWriteChunkRequest;
+
  public:
     ChunkOpRequest();
     ChunkOpRequest(std::shared_ptr<CopysetNode> nodePtr,
@@ -123,6 +128,20 @@ class ChunkOpRequest : public std::enable_shared_from_this<ChunkOpRequest> {
      */
     virtual void RedirectChunkRequest();
 
+    /**
+     * 被采样的请求记录到达某个阶段的时间，未采样时为空操作
+     */
+    virtual void MarkTrace(IOTraceStage stage) {
+        if (trace_ != nullptr) {
+            trace_->Mark(stage);
+        }
+    }
+
+    /**
+     * 请求返回后记录trace中各阶段的时延
+     */
+    void FinishTrace();
+
  public:
     /**
      * Op序列化工具函数
@@ -161,7 +180,8 @@ class ChunkOpRequest : public std::enable_shared_from_this<ChunkOpRequest> {
 
  protected:
     /**
-     * 打包request为braft::task，propose给相应的复制组
+     * 打包request为braft::task，propose给相应的复制组，
+     * 复制组开启了写合并时交给WriteCoalescer按顺序propose
      * @param request:Chunk Request
      * @param data:请求中包含的数据内容
      * @return 0成功，-1失败
@@ -169,6 +189,15 @@ class ChunkOpRequest : public std::enable_shared_from_this<ChunkOpRequest> {
     int Propose(const ChunkRequest *request,
                 const butil::IOBuf *data);
 
+    /**
+     * 直接打包request为braft::task，propose给相应的复制组
+     * @param request:Chunk Request
+     * @param data:请求中包含的数据内容
+     * @return 0成功，-1失败
+     */
+    int ProposeToRaft(const ChunkRequest *request,
+                      const butil::IOBuf *data);
+
  protected:
     // chunk持久化接口
     std::shared_ptr<CSDataStore> datastore_;
@@ -182,6 +211,8 @@ class ChunkOpRequest : public std::enable_shared_from_this<ChunkOpRequest> {
     ChunkResponse *response_;
     // rpc done closure
     ::google::protobuf::Closure *done_;
+    // 采样到的请求各阶段的时间戳，未采样时为nullptr
+    std::unique_ptr<IOTrace> trace_;
 };
 
 class DeleteChunkRequest : public ChunkOpRequest {
@@ -235,8 +266,12 @@ class ReadChunkRequest : public ChunkOpRequest {
  private:
     // 根据chunk信息判断是否需要拷贝数据
     bool NeedClone(const CSChunkInfo& chunkInfo);
-    // 从chunk文件中读数据
-    void ReadChunk();
+    // 从chunk文件中异步读数据，读完成后执行done
+    void ReadChunk(uint64_t index, ::google::protobuf::Closure *done);
+    // 根据读的结果设置response
+    void OnReadChunkDone(CSErrorCode ret, char *readBuffer, size_t size);
+    // 更新apply index并返回
+    void ApplyDone(uint64_t index, ::google::protobuf::Closure *done);
 
  private:
     CloneManager* cloneMgr_;
@@ -266,6 +301,51 @@ class WriteChunkRequest : public ChunkOpRequest {
     void OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
                         const ChunkRequest &request,
                         const butil::IOBuf &data) override;
+
+ protected:
+    /**
+     * 返回需要写入的数据
+     */
+    virtual const butil::IOBuf &WriteData() {
+        return cntl_->request_attachment();
+    }
+};
+
+/**
+ * 由WriteCoalescer将同一个chunk上多个相邻的顺序写合并而成的写请求，
+ * 按普通的写请求编码成一条raft日志，follower和日志回放不感知合并。
+ * apply完成或者出错后，将response复制给各个原始请求并调用它们的done
+ */
+class MergedWriteChunkRequest : public WriteChunkRequest {
+ public:
+    /**
+     * @param request: 第一个原始请求的Chunk Request
+     * @param ops: 按offset顺序排列的原始写请求
+     * @param data: 合并后的数据，构造后被清空
+     */
+    MergedWriteChunkRequest(const ChunkRequest &request,
+                            std::vector<std::shared_ptr<ChunkOpRequest>> ops,
+                            butil::IOBuf *data);
+    virtual ~MergedWriteChunkRequest() = default;
+
+    const ChunkRequest *GetChunkRequest() { return &mergedRequest_; }
+    const butil::IOBuf *GetWriteData() { return &data_; }
+
+    // 合并请求本身不采样，打点转发给各个原始请求
+    void MarkTrace(IOTraceStage stage) override;
+
+ protected:
+    const butil::IOBuf &WriteData() override { return data_; }
+
+ private:
+    // 合并请求的done，将结果分发给各个原始请求
+    void RunOriginalDone();
+
+ private:
+    ChunkRequest mergedRequest_;
+    ChunkResponse mergedResponse_;
+    butil::IOBuf data_;
+    std::vector<std::shared_ptr<ChunkOpRequest>> ops_;
 };
 
 class ReadSnapshotRequest : public ChunkOpRequest {
@@ -387,8 +467,9 @@ class ScanChunkRequest : public ChunkOpRequest {
                         const butil::IOBuf &data) override;
 
  private:
+    // 补全scanMap并发送给leader，scanMap的所有权转移给发送的rpc
     void BuildAndSendScanMap(const ChunkRequest &request, uint64_t index,
-                             uint32_t crc);
+                             ScanMap *scanMap);
     ScanManager* scanManager_;
     uint64_t index_;
     PeerId peer_;
@@ -45,6 +45,7 @@
 #include <braft/fsync.h>
 #include "src/chunkserver/raftlog/curve_segment.h"
 #include "src/chunkserver/raftlog/define.h"
+#include "src/common/aligned_buffer_pool.h"
 
 namespace curve {
 namespace chunkserver {
@@ -53,6 +54,33 @@ DEFINE_bool(raftSyncSegments, true, "call fsync when a segment is closed");
 DEFINE_bool(enableWalDirectWrite, true, "enable wal direct write or not");
 DEFINE_uint32(walAlignSize, 4096, "wal align size to write");
 
+using curve::common::AlignedBufferPool;
+
+namespace {
+
+// WAL写入和metapage更新使用的对齐buffer优先从AlignedBufferPool中获取，
+// walAlignSize超过池的对齐大小时单独分配
+char* AllocWalBuffer(size_t size) {
+    if (FLAGS_walAlignSize <= AlignedBufferPool::kAlignment) {
+        return AlignedBufferPool::GetInstance().Alloc(size);
+    }
+    void* buf = nullptr;
+    int ret = posix_memalign(&buf, FLAGS_walAlignSize, size);
+    LOG_IF(ERROR, ret != 0)
+        << "posix_memalign WAL buffer failed " << strerror(ret);
+    return ret == 0 ? static_cast<char*>(buf) : nullptr;
+}
+
+void FreeWalBuffer(char* buf, size_t size) {
+    if (FLAGS_walAlignSize <= AlignedBufferPool::kAlignment) {
+        AlignedBufferPool::GetInstance().Free(buf, size);
+    } else {
+        free(buf);
+    }
+}
+
+}  // namespace
+
 int CurveSegment::create() {
     if (!_is_open) {
         CHECK(false) << "Create on a closed segment at first_index="
@@ -380,16 +408,19 @@ int CurveSegment::append(const braft::LogEntry* entry) {
                   << " _first_index=" << _first_index;
         return ERANGE;
     }
-    butil::IOBuf data;
+    // 配置类日志需要先序列化，数据类日志直接使用entry中的数据
+    butil::IOBuf conf_data;
+    const butil::IOBuf* data = &conf_data;
     switch (entry->type) {
     case braft::ENTRY_TYPE_DATA:
-        data.append(entry->data);
+        data = &entry->data;
         break;
     case braft::ENTRY_TYPE_NO_OP:
         break;
     case braft::ENTRY_TYPE_CONFIGURATION:
         {
-            butil::Status status = serialize_configuration_meta(entry, data);
+            butil::Status status =
+                serialize_configuration_meta(entry, conf_data);
             if (!status.ok()) {
                 LOG(ERROR) << "Fail to serialize ConfigurationPBMeta, path: "
                            << _path;
@@ -402,41 +433,46 @@ int CurveSegment::append(const braft::LogEntry* entry) {
                    << ", path: " << _path;
         return -1;
     }
-    uint32_t data_check_sum = get_checksum(_checksum_type, data);
-    uint32_t real_length = data.length();
-    size_t to_write = kEntryHeaderSize + data.length();
+    uint32_t real_length = data->length();
+    size_t to_write = kEntryHeaderSize + real_length;
     uint32_t zero_bytes_num = 0;
     // 4KB alignment
     if (to_write % FLAGS_walAlignSize != 0) {
         zero_bytes_num = (to_write / FLAGS_walAlignSize + 1) *
                                         FLAGS_walAlignSize - to_write;
     }
-    data.resize(data.length() + zero_bytes_num);
-    to_write = kEntryHeaderSize + data.length();
-    CHECK_LE(data.length(), 1ul << 56ul);
-    char* write_buf = nullptr;
+    to_write += zero_bytes_num;
+    const uint32_t data_length = real_length + zero_bytes_num;
+    CHECK_LE(data_length, 1ul << 56ul);
+
+    char header_buf[kEntryHeaderSize];
+    char* write_buf = header_buf;
+    uint32_t data_check_sum = 0;
     if (FLAGS_enableWalDirectWrite) {
-        int ret = posix_memalign(reinterpret_cast<void **>(&write_buf),
-                                 FLAGS_walAlignSize, to_write);
-        LOG_IF(FATAL, ret < 0 || write_buf == nullptr)
-        << "posix_memalign WAL write buffer failed " << strerror(ret);
+        // 数据直接拷贝到对齐的buffer中计算校验和并写入，不再经过IOBuf中转
+        write_buf = AllocWalBuffer(to_write);
+        LOG_IF(FATAL, write_buf == nullptr)
+            << "Alloc WAL write buffer failed, size: " << to_write;
+        char* data_buf = write_buf + kEntryHeaderSize;
+        data->copy_to(data_buf, real_length);
+        memset(data_buf + real_length, 0, zero_bytes_num);
+        data_check_sum = get_checksum(_checksum_type, data_buf, real_length);
     } else {
-        write_buf = new char[kEntryHeaderSize];
+        data_check_sum = get_checksum(_checksum_type, *data);
     }
 
     const uint32_t meta_field = (entry->type << 24) | (_checksum_type << 16);
     butil::RawPacker packer(write_buf);
     packer.pack64(entry->id.term)
           .pack32(meta_field)
-          .pack32((uint32_t)data.length())
+          .pack32(data_length)
           .pack32(real_length)
           .pack32(data_check_sum);
     packer.pack32(get_checksum(
                   _checksum_type, write_buf, kEntryHeaderSize - 4));
     if (FLAGS_enableWalDirectWrite) {
-        data.copy_to(write_buf + kEntryHeaderSize, real_length);
         int ret = ::pwrite(_direct_fd, write_buf, to_write, _meta.bytes);
-        free(write_buf);
+        FreeWalBuffer(write_buf, to_write);
         if (ret != static_cast<int>(to_write)) {
             LOG(ERROR) << "Fail to write directly to fd=" << _direct_fd
                        << ", buf=" << static_cast<void*>(write_buf)
@@ -446,9 +482,10 @@ int CurveSegment::append(const braft::LogEntry* entry) {
         }
     } else {
         butil::IOBuf header;
-        header.append(write_buf, kEntryHeaderSize);
-        delete write_buf;
-        butil::IOBuf* pieces[2] = { &header, &data };
+        header.append(header_buf, kEntryHeaderSize);
+        butil::IOBuf body(*data);
+        body.resize(data_length);
+        butil::IOBuf* pieces[2] = { &header, &body };
         size_t start = 0;
         ssize_t written = 0;
         while (written < (ssize_t)to_write) {
@@ -474,19 +511,18 @@ int CurveSegment::append(const braft::LogEntry* entry) {
 }
 
 int CurveSegment::_update_meta_page() {
-    char* metaPage = nullptr;
-    int ret = posix_memalign(reinterpret_cast<void **>(&metaPage),
-                            FLAGS_walAlignSize, _meta_page_size);
-    LOG_IF(FATAL, ret < 0 || metaPage == nullptr)
-        << "posix_memalign WAL meta page failed " << strerror(ret);
+    char* metaPage = AllocWalBuffer(_meta_page_size);
+    LOG_IF(FATAL, metaPage == nullptr)
+        << "Alloc WAL meta page failed, size: " << _meta_page_size;
     memset(metaPage, 0, _meta_page_size);
     memcpy(metaPage, &_meta.bytes, sizeof(_meta.bytes));
+    int ret = 0;
     if (FLAGS_enableWalDirectWrite) {
         ret = ::pwrite(_direct_fd, metaPage, _meta_page_size, 0);
     } else {
         ret = ::pwrite(_fd, metaPage, _meta_page_size, 0);
     }
-    free(metaPage);
+    FreeWalBuffer(metaPage, _meta_page_size);
     if (ret != static_cast<int>(_meta_page_size)) {
         LOG(ERROR) << "Fail to write meta page into fd="
                    << (FLAGS_enableWalDirectWrite ? _direct_fd : _fd)
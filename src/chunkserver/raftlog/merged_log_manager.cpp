@@ -0,0 +1,662 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/chunkserver/raftlog/merged_log_manager.h"
+
+#include <braft/util.h>
+#include <butil/fast_rand.h>
+#include <butil/fd_utility.h>
+#include <butil/file_util.h>
+#include <butil/files/dir_reader_posix.h>
+#include <butil/raw_pack.h>
+#include <butil/strings/string_printf.h>
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace curve {
+namespace chunkserver {
+
+// 一个共享日志文件，metapage中记录文件的nonce和seq，文件中每条记录的header
+// 都带有相同的nonce，用于区分从walFilePool中复用的文件里残留的旧数据
+class MergedLogFile {
+ public:
+    MergedLogFile(uint64_t seq, uint64_t nonce, const std::string& path,
+                  int fd, uint64_t writeOffset)
+        : seq(seq), nonce(nonce), path(path), fd(fd),
+          writeOffset(writeOffset) {}
+
+    ~MergedLogFile() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    const uint64_t seq;
+    const uint64_t nonce;
+    const std::string path;
+    const int fd;
+    // 下一次写入的位置，只由合并写入的发起者修改
+    uint64_t writeOffset;
+    // 各复制组在本文件中写入的最大日志index，受MergedLogManager::mtx_保护
+    std::unordered_map<uint64_t, int64_t> maxIndex;
+};
+
+namespace {
+
+struct RecordHeader {
+    uint64_t nonce;
+    uint64_t groupId;
+    int64_t index;
+    int64_t term;
+    int type;
+    uint32_t dataLen;
+    uint32_t dataChecksum;
+};
+
+void PackHeader(const RecordHeader& header, char* buf) {
+    butil::RawPacker packer(buf);
+    packer.pack64(header.nonce)
+          .pack64(header.groupId)
+          .pack64(static_cast<uint64_t>(header.index))
+          .pack64(static_cast<uint64_t>(header.term))
+          .pack32(static_cast<uint32_t>(header.type) << 24)
+          .pack32(header.dataLen)
+          .pack32(header.dataChecksum);
+    packer.pack32(braft::crc32(buf, kMergedRecordHeaderSize - 4));
+}
+
+// header校验失败返回false，说明已经读到了文件中有效数据的末尾
+bool UnpackHeader(const char* buf, RecordHeader* header) {
+    uint32_t metaField = 0;
+    uint32_t headerChecksum = 0;
+    butil::RawUnpacker unpacker(buf);
+    unpacker.unpack64(header->nonce)
+            .unpack64(header->groupId)
+            .unpack64(reinterpret_cast<uint64_t&>(header->index))
+            .unpack64(reinterpret_cast<uint64_t&>(header->term))
+            .unpack32(metaField)
+            .unpack32(header->dataLen)
+            .unpack32(header->dataChecksum)
+            .unpack32(headerChecksum);
+    header->type = metaField >> 24;
+    return headerChecksum == braft::crc32(buf, kMergedRecordHeaderSize - 4);
+}
+
+bool IsMark(int type) {
+    return type == MERGED_RECORD_TRUNCATE_SUFFIX ||
+           type == MERGED_RECORD_RESET;
+}
+
+}  // namespace
+
+void MergedGroupIndex::TruncateSuffix(int64_t lastIndexKept) {
+    if (lastIndexKept < firstIndex) {
+        entries.clear();
+        firstIndex = lastIndexKept + 1;
+        return;
+    }
+    while (!entries.empty() && LastIndex() > lastIndexKept) {
+        entries.pop_back();
+    }
+}
+
+void MergedGroupIndex::TruncatePrefix(int64_t firstIndexKept) {
+    while (!entries.empty() && firstIndex < firstIndexKept) {
+        entries.pop_front();
+        ++firstIndex;
+    }
+    if (entries.empty()) {
+        firstIndex = std::max(firstIndex, firstIndexKept);
+    }
+}
+
+MergedLogManager::MergedLogManager()
+    : fileSize_(0),
+      metaPageSize_(0),
+      nextSeq_(1),
+      settledSeq_(1),
+      writing_(false) {}
+
+MergedLogManager::~MergedLogManager() {}
+
+int MergedLogManager::Init(const MergedLogOptions& options) {
+    options_ = options;
+    if (options_.walFilePool == nullptr) {
+        LOG(ERROR) << "wal file pool is null";
+        return -1;
+    }
+    FilePoolOptions poolOpt = options_.walFilePool->GetFilePoolOpt();
+    metaPageSize_ = poolOpt.metaPageSize;
+    fileSize_ = poolOpt.fileSize + poolOpt.metaPageSize;
+
+    butil::FilePath dirPath(options_.path);
+    butil::File::Error e;
+    if (!butil::CreateDirectoryAndGetError(dirPath, &e, true)) {
+        LOG(ERROR) << "Fail to create " << options_.path << " : " << e;
+        return -1;
+    }
+
+    butil::DirReaderPosix dirReader(options_.path.c_str());
+    if (!dirReader.IsValid()) {
+        LOG(ERROR) << "Fail to open dir " << options_.path;
+        return -1;
+    }
+    std::vector<uint64_t> seqs;
+    while (dirReader.Next()) {
+        uint64_t seq = 0;
+        if (sscanf(dirReader.name(), CURVE_MERGED_SEGMENT_PATTERN, &seq) == 1) {
+            seqs.push_back(seq);
+        }
+    }
+    std::sort(seqs.begin(), seqs.end());
+
+    // 按写入顺序重放所有共享文件，恢复各复制组的日志索引
+    for (uint64_t seq : seqs) {
+        if (LoadFile(seq) != 0) {
+            return -1;
+        }
+        nextSeq_ = seq + 1;
+    }
+    // 已有文件的末尾可能有未写完的数据，之后的写入总是从新文件开始
+    settledSeq_ = nextSeq_;
+    LOG(INFO) << "Merged log init success, path: " << options_.path
+              << ", file count: " << files_.size()
+              << ", recovered group count: " << recovered_.size();
+    return 0;
+}
+
+int MergedLogManager::LoadFile(uint64_t seq) {
+    std::string path(options_.path);
+    butil::string_appendf(&path, "/" CURVE_MERGED_SEGMENT_PATTERN, seq);
+    int fd = ::open(path.c_str(), O_RDWR | O_NOATIME);
+    if (fd < 0) {
+        LOG(ERROR) << "Fail to open " << path << ", " << berror();
+        return -1;
+    }
+    butil::make_close_on_exec(fd);
+
+    std::unique_ptr<char[]> buf(new char[fileSize_]);
+    ssize_t size = ::pread(fd, buf.get(), fileSize_, 0);
+    if (size < static_cast<ssize_t>(metaPageSize_)) {
+        LOG(ERROR) << "Fail to read " << path << ", " << berror();
+        ::close(fd);
+        return -1;
+    }
+
+    uint64_t nonce = 0;
+    uint64_t fileSeq = 0;
+    butil::RawUnpacker(buf.get()).unpack64(nonce).unpack64(fileSeq);
+    auto file = std::make_shared<MergedLogFile>(seq, nonce, path, fd, size);
+    if (fileSeq != seq) {
+        // 获取文件后写metapage前crash，文件中没有有效数据
+        LOG(WARNING) << "Merged log file " << path << " has seq " << fileSeq
+                     << " in meta page, skip it";
+        files_[seq] = file;
+        return 0;
+    }
+
+    uint64_t offset = metaPageSize_;
+    size_t count = 0;
+    while (offset + kMergedRecordHeaderSize <= static_cast<uint64_t>(size)) {
+        RecordHeader header;
+        if (!UnpackHeader(buf.get() + offset, &header) ||
+            header.nonce != nonce) {
+            break;
+        }
+        uint64_t length = kMergedRecordHeaderSize + header.dataLen;
+        if (offset + length > static_cast<uint64_t>(size)) {
+            break;
+        }
+        const char* data = buf.get() + offset + kMergedRecordHeaderSize;
+        if (header.dataChecksum != braft::crc32(data, header.dataLen)) {
+            LOG(WARNING) << "Found corrupted record in " << path
+                         << ", offset: " << offset;
+            break;
+        }
+
+        MergedGroupIndex& group = recovered_[header.groupId];
+        if (header.type == MERGED_RECORD_RESET) {
+            group.entries.clear();
+            group.firstIndex = header.index;
+        } else if (header.type == MERGED_RECORD_TRUNCATE_SUFFIX) {
+            group.TruncateSuffix(header.index);
+        } else {
+            MergedLogLocation location{seq, offset,
+                static_cast<uint32_t>(length), header.term, header.type};
+            ReplayRecord(header.groupId, header.index, location);
+            int64_t& maxIndex = file->maxIndex[header.groupId];
+            maxIndex = std::max(maxIndex, header.index);
+        }
+        offset += length;
+        ++count;
+    }
+    file->writeOffset = offset;
+    files_[seq] = file;
+    LOG(INFO) << "Load merged log file " << path << ", record count: "
+              << count << ", valid bytes: " << offset;
+    return 0;
+}
+
+void MergedLogManager::ReplayRecord(uint64_t groupId, int64_t index,
+                                    const MergedLogLocation& location) {
+    MergedGroupIndex& group = recovered_[groupId];
+    if (group.entries.empty()) {
+        group.firstIndex = index;
+    } else if (index > group.LastIndex() + 1 || index < group.firstIndex) {
+        LOG(WARNING) << "Merged log of group " << groupId << " has hole,"
+                     << " first index: " << group.firstIndex
+                     << ", last index: " << group.LastIndex()
+                     << ", record index: " << index;
+        group.entries.clear();
+        group.firstIndex = index;
+    } else if (index <= group.LastIndex()) {
+        // 被截断后重新写入的日志覆盖之前的日志
+        group.TruncateSuffix(index - 1);
+    }
+    group.entries.push_back(location);
+}
+
+void MergedLogManager::OpenGroup(uint64_t groupId, MergedGroupIndex* index) {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    auto it = recovered_.find(groupId);
+    if (it != recovered_.end()) {
+        *index = std::move(it->second);
+        recovered_.erase(it);
+    } else {
+        *index = MergedGroupIndex();
+    }
+    GroupState& state = groups_[groupId];
+    state.opened = true;
+}
+
+void MergedLogManager::CloseGroup(uint64_t groupId) {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    auto it = groups_.find(groupId);
+    if (it != groups_.end()) {
+        it->second.opened = false;
+    }
+}
+
+void MergedLogManager::UpdateFirstIndex(uint64_t groupId, int64_t firstIndex) {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    groups_[groupId].firstIndex = firstIndex;
+}
+
+int MergedLogManager::AppendEntries(
+    uint64_t groupId, const std::vector<braft::LogEntry*>& entries,
+    std::vector<MergedLogLocation>* locations) {
+    PendingWrite write;
+    write.groupId = groupId;
+    write.records.resize(entries.size());
+    // 序列化和计算校验和在各自的线程中完成，合并写入时只需要填写header
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const braft::LogEntry* entry = entries[i];
+        Record& record = write.records[i];
+        record.index = entry->id.index;
+        record.term = entry->id.term;
+        record.type = entry->type;
+        switch (entry->type) {
+        case braft::ENTRY_TYPE_DATA:
+            record.data.append(entry->data);
+            break;
+        case braft::ENTRY_TYPE_NO_OP:
+            break;
+        case braft::ENTRY_TYPE_CONFIGURATION:
+            {
+                butil::Status status =
+                    serialize_configuration_meta(entry, record.data);
+                if (!status.ok()) {
+                    LOG(ERROR) << "Fail to serialize ConfigurationPBMeta"
+                               << ", group: " << groupId;
+                    return -1;
+                }
+            }
+            break;
+        default:
+            LOG(FATAL) << "unknow entry type: " << entry->type
+                       << ", group: " << groupId;
+            return -1;
+        }
+        record.dataChecksum = braft::crc32(record.data);
+    }
+
+    int ret = Submit(&write);
+    if (ret == 0) {
+        locations->swap(write.locations);
+    }
+    return ret;
+}
+
+int MergedLogManager::AppendMark(uint64_t groupId, MergedRecordType type,
+                                 int64_t index) {
+    PendingWrite write;
+    write.groupId = groupId;
+    write.records.resize(1);
+    write.records[0].index = index;
+    write.records[0].term = 0;
+    write.records[0].type = type;
+    write.records[0].dataChecksum = braft::crc32(write.records[0].data);
+    return Submit(&write);
+}
+
+int MergedLogManager::Submit(PendingWrite* write) {
+    std::unique_lock<bthread::Mutex> lk(mtx_);
+    queue_.push_back(write);
+    // 没有正在进行的写入时，由队首的请求把当前排队的所有请求合并写入
+    while (!write->done && (writing_ || queue_.front() != write)) {
+        cond_.wait(lk);
+    }
+    if (write->done) {
+        return write->ret;
+    }
+
+    std::vector<PendingWrite*> batch(queue_.begin(), queue_.end());
+    queue_.clear();
+    writing_ = true;
+    lk.unlock();
+
+    WriteBatch(batch);
+
+    lk.lock();
+    for (PendingWrite* w : batch) {
+        for (size_t i = 0; w->ret == 0 && i < w->locations.size(); ++i) {
+            const MergedLogLocation& location = w->locations[i];
+            if (IsMark(location.type)) {
+                continue;
+            }
+            auto it = files_.find(location.fileSeq);
+            if (it == files_.end()) {
+                continue;
+            }
+            int64_t& maxIndex = it->second->maxIndex[w->groupId];
+            maxIndex = std::max(maxIndex, w->records[i].index);
+        }
+        w->done = true;
+    }
+    settledSeq_ = active_ != nullptr ? active_->seq : nextSeq_;
+    writing_ = false;
+    cond_.notify_all();
+    return write->ret;
+}
+
+void MergedLogManager::WriteBatch(const std::vector<PendingWrite*>& batch) {
+    const uint64_t capacity = fileSize_ - metaPageSize_;
+    butil::IOBuf buf;
+    uint64_t bufOffset = active_ != nullptr ? active_->writeOffset : 0;
+    bool failed = false;
+    size_t recordCount = 0;
+
+    for (PendingWrite* w : batch) {
+        w->locations.clear();
+        w->locations.reserve(w->records.size());
+        bool tooLarge = false;
+        for (const Record& record : w->records) {
+            if (kMergedRecordHeaderSize + record.data.size() > capacity) {
+                LOG(ERROR) << "Record of group " << w->groupId
+                           << " is too large, index: " << record.index
+                           << ", size: " << record.data.size();
+                tooLarge = true;
+                break;
+            }
+        }
+        if (tooLarge) {
+            w->ret = -1;
+            continue;
+        }
+
+        for (Record& record : w->records) {
+            uint64_t length = kMergedRecordHeaderSize + record.data.size();
+            if (active_ == nullptr ||
+                bufOffset + buf.size() + length > fileSize_) {
+                // 当前文件写满，先把已经打包的数据写入再切换到新文件
+                if (active_ != nullptr && !buf.empty() &&
+                    FlushToFile(active_, &buf, bufOffset) != 0) {
+                    failed = true;
+                    break;
+                }
+                std::shared_ptr<MergedLogFile> file = CreateFile();
+                if (file == nullptr) {
+                    failed = true;
+                    break;
+                }
+                std::lock_guard<bthread::Mutex> lk(mtx_);
+                active_ = file;
+                bufOffset = active_->writeOffset;
+            }
+
+            RecordHeader header;
+            header.nonce = active_->nonce;
+            header.groupId = w->groupId;
+            header.index = record.index;
+            header.term = record.term;
+            header.type = record.type;
+            header.dataLen = record.data.size();
+            header.dataChecksum = record.dataChecksum;
+            char headerBuf[kMergedRecordHeaderSize];
+            PackHeader(header, headerBuf);
+
+            w->locations.push_back(MergedLogLocation{active_->seq,
+                bufOffset + buf.size(), static_cast<uint32_t>(length),
+                record.term, record.type});
+            buf.append(headerBuf, kMergedRecordHeaderSize);
+            buf.append(record.data);
+            ++recordCount;
+        }
+        if (failed) {
+            break;
+        }
+        w->ret = 0;
+    }
+
+    if (!failed && !buf.empty() &&
+        FlushToFile(active_, &buf, bufOffset) != 0) {
+        failed = true;
+    }
+    if (failed) {
+        // 写失败后文件末尾的状态未知，不再往该文件中写入
+        for (PendingWrite* w : batch) {
+            w->ret = -1;
+        }
+        std::lock_guard<bthread::Mutex> lk(mtx_);
+        active_ = nullptr;
+        return;
+    }
+    VLOG(6) << "Merged log write " << batch.size() << " requests, "
+            << recordCount << " records";
+}
+
+int MergedLogManager::FlushToFile(const std::shared_ptr<MergedLogFile>& file,
+                                  butil::IOBuf* buf, uint64_t offset) {
+    size_t size = buf->size();
+    if (braft::file_pwrite(*buf, file->fd, offset) != 0) {
+        LOG(ERROR) << "Fail to write merged log " << file->path
+                   << ", offset: " << offset << ", size: " << size
+                   << ", " << berror();
+        return -1;
+    }
+    if (options_.enableSync && ::fdatasync(file->fd) != 0) {
+        LOG(ERROR) << "Fail to sync merged log " << file->path
+                   << ", " << berror();
+        return -1;
+    }
+    file->writeOffset = offset + size;
+    buf->clear();
+    return 0;
+}
+
+std::shared_ptr<MergedLogFile> MergedLogManager::CreateFile() {
+    uint64_t seq = 0;
+    {
+        std::lock_guard<bthread::Mutex> lk(mtx_);
+        seq = nextSeq_++;
+    }
+    uint64_t nonce = butil::fast_rand();
+    std::string path(options_.path);
+    butil::string_appendf(&path, "/" CURVE_MERGED_SEGMENT_PATTERN, seq);
+
+    std::unique_ptr<char[]> metaPage(new char[metaPageSize_]);
+    memset(metaPage.get(), 0, metaPageSize_);
+    butil::RawPacker(metaPage.get()).pack64(nonce).pack64(seq);
+    if (options_.walFilePool->GetFile(path, metaPage.get()) != 0) {
+        LOG(ERROR) << "Get merged log file from wal file pool fail, path: "
+                   << path;
+        return nullptr;
+    }
+    int fd = ::open(path.c_str(), O_RDWR | O_NOATIME);
+    if (fd < 0) {
+        LOG(ERROR) << "Fail to open " << path << ", " << berror();
+        return nullptr;
+    }
+    butil::make_close_on_exec(fd);
+
+    auto file = std::make_shared<MergedLogFile>(seq, nonce, path, fd,
+                                                metaPageSize_);
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    files_[seq] = file;
+    LOG(INFO) << "Created merged log file " << path;
+    return file;
+}
+
+braft::LogEntry* MergedLogManager::ReadEntry(
+    uint64_t groupId, int64_t index, const MergedLogLocation& location) {
+    std::shared_ptr<MergedLogFile> file;
+    {
+        std::lock_guard<bthread::Mutex> lk(mtx_);
+        auto it = files_.find(location.fileSeq);
+        if (it == files_.end()) {
+            LOG(WARNING) << "Merged log file " << location.fileSeq
+                         << " of group " << groupId << " not found, index: "
+                         << index;
+            return NULL;
+        }
+        file = it->second;
+    }
+
+    butil::IOPortal buf;
+    ssize_t n = braft::file_pread(&buf, file->fd, location.offset,
+                                  location.length);
+    if (n != static_cast<ssize_t>(location.length)) {
+        LOG(ERROR) << "Fail to read merged log " << file->path
+                   << ", offset: " << location.offset
+                   << ", length: " << location.length << ", " << berror();
+        return NULL;
+    }
+    char headerBuf[kMergedRecordHeaderSize];
+    buf.cutn(headerBuf, kMergedRecordHeaderSize);
+    RecordHeader header;
+    if (!UnpackHeader(headerBuf, &header) || header.nonce != file->nonce ||
+        header.groupId != groupId || header.index != index ||
+        header.term != location.term ||
+        header.dataChecksum != braft::crc32(buf)) {
+        LOG(ERROR) << "Merged log record mismatch, path: " << file->path
+                   << ", offset: " << location.offset << ", group: "
+                   << groupId << ", index: " << index;
+        return NULL;
+    }
+
+    braft::LogEntry* entry = new braft::LogEntry();
+    entry->AddRef();
+    switch (header.type) {
+    case braft::ENTRY_TYPE_DATA:
+        entry->data.swap(buf);
+        break;
+    case braft::ENTRY_TYPE_NO_OP:
+        break;
+    case braft::ENTRY_TYPE_CONFIGURATION:
+        {
+            butil::Status status = parse_configuration_meta(buf, entry);
+            if (!status.ok()) {
+                LOG(WARNING) << "Fail to parse ConfigurationPBMeta, path: "
+                             << file->path << ", offset: " << location.offset;
+                entry->Release();
+                return NULL;
+            }
+        }
+        break;
+    default:
+        LOG(ERROR) << "Unknown entry type " << header.type << ", path: "
+                   << file->path << ", offset: " << location.offset;
+        entry->Release();
+        return NULL;
+    }
+    entry->id.index = index;
+    entry->id.term = header.term;
+    entry->type = static_cast<braft::EntryType>(header.type);
+    return entry;
+}
+
+bool MergedLogManager::CanRecycle(
+    const std::shared_ptr<MergedLogFile>& file) {
+    for (const auto& item : file->maxIndex) {
+        auto it = groups_.find(item.first);
+        if (it != groups_.end() && it->second.opened) {
+            if (item.second >= it->second.firstIndex) {
+                return false;
+            }
+            continue;
+        }
+
+        // 未打开或已关闭的复制组，copyset目录被删除后其日志都可以回收
+        std::string groupDir =
+            options_.logRootDir + "/" + std::to_string(item.first);
+        struct stat info;
+        if (::stat(groupDir.c_str(), &info) == 0) {
+            if (it == groups_.end() || item.second >= it->second.firstIndex) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void MergedLogManager::Recycle() {
+    std::vector<std::shared_ptr<MergedLogFile>> recycled;
+    {
+        std::lock_guard<bthread::Mutex> lk(mtx_);
+        // 按创建顺序回收，保证截断标记总是在被它截断的日志之后回收
+        for (auto it = files_.begin(); it != files_.end();) {
+            if (it->first >= settledSeq_ || !CanRecycle(it->second)) {
+                break;
+            }
+            recycled.push_back(it->second);
+            it = files_.erase(it);
+        }
+    }
+
+    for (auto& file : recycled) {
+        std::string path = file->path;
+        file = nullptr;
+        if (options_.walFilePool->RecycleFile(path) != 0) {
+            LOG(ERROR) << "Fail to recycle merged log file " << path;
+        } else {
+            LOG(INFO) << "Recycled merged log file " << path;
+        }
+    }
+}
+
+size_t MergedLogManager::FileCount() {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    return files_.size();
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,226 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_CHUNKSERVER_RAFTLOG_MERGED_LOG_MANAGER_H_
+#define SRC_CHUNKSERVER_RAFTLOG_MERGED_LOG_MANAGER_H_
+
+#include <braft/log_entry.h>
+#include <bthread/condition_variable.h>
+#include <bthread/mutex.h>
+#include <butil/iobuf.h>
+#include <inttypes.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/chunkserver/datastore/file_pool.h"
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace chunkserver {
+
+#define CURVE_MERGED_SEGMENT_PATTERN "curve_merged_log_%020" PRIu64
+
+// Format of record header, all fields are in network order
+// | ----------------------- file nonce (64bits) -----------------------  |
+// | ------------------------ group id (64bits) ------------------------  |
+// | ------------------------- index (64bits) -------------------------  |
+// | -------------------------- term (64bits) -------------------------  |
+// | record type (8bits) | reserved (24bits) | data len (32bits)         |
+// | data checksum (32bits) | header checksum (32bits)                   |
+const size_t kMergedRecordHeaderSize = 48;
+
+// 除braft的entry类型外，共享日志中还会记录下面两种标记
+enum MergedRecordType {
+    // 截断index之后的日志，对应truncate_suffix
+    MERGED_RECORD_TRUNCATE_SUFFIX = 0xF0,
+    // 清空日志并从index开始写，对应reset
+    MERGED_RECORD_RESET = 0xF1,
+};
+
+// 一条日志在共享文件中的位置
+struct MergedLogLocation {
+    uint64_t fileSeq;
+    uint64_t offset;
+    uint32_t length;
+    int64_t term;
+    int type;
+};
+
+// 重启后从共享文件中恢复出的某个复制组的日志索引
+struct MergedGroupIndex {
+    // 第一条日志的index，entries为空时表示下一条日志的index
+    int64_t firstIndex = 1;
+    std::deque<MergedLogLocation> entries;
+
+    int64_t LastIndex() const {
+        return firstIndex + static_cast<int64_t>(entries.size()) - 1;
+    }
+    // 丢弃index之后的日志
+    void TruncateSuffix(int64_t lastIndexKept);
+    // 丢弃index之前的日志
+    void TruncatePrefix(int64_t firstIndexKept);
+};
+
+struct MergedLogOptions {
+    // 共享日志文件所在目录，需要和walFilePool在同一块盘上
+    std::string path = "./0/merged_log";
+    // copyset raft日志根目录，复制组的日志在logRootDir/groupId下，
+    // 用于判断已经关闭的复制组是否已被删除
+    std::string logRootDir;
+    std::shared_ptr<FilePool> walFilePool;
+    // 每次批量写入后是否fdatasync
+    bool enableSync = true;
+};
+
+class MergedLogFile;
+
+/**
+ * 多个copyset共享的raft日志
+ * 各个copyset的日志按写入顺序追加到同一组共享文件中，每个copyset只在内存中
+ * 维护自己的日志索引。并发提交的写请求由先到达的请求合并成一次顺序写和一次
+ * fdatasync，从而把大量copyset的小写合并成少量的大块顺序写。
+ * 共享文件从walFilePool中获取，当文件中所有复制组的日志都已经被
+ * truncate_prefix丢弃后按文件创建顺序回收到walFilePool中。
+ */
+class MergedLogManager : public curve::common::Uncopyable {
+ public:
+    MergedLogManager();
+    virtual ~MergedLogManager();
+
+    /**
+     * 加载目录下已有的共享文件，恢复各复制组的日志索引，
+     * 之后的写入总是在新文件中进行
+     * @return 成功返回0，失败返回-1
+     */
+    int Init(const MergedLogOptions& options);
+
+    /**
+     * 复制组打开日志时调用，取出重启时恢复的日志索引
+     * @param groupId: 复制组id
+     * @param index[out]: 恢复出的日志索引，没有则为空
+     */
+    void OpenGroup(uint64_t groupId, MergedGroupIndex* index);
+
+    /**
+     * 复制组关闭日志时调用，关闭后其日志仍然保留，
+     * 直到对应的copyset目录被删除
+     */
+    void CloseGroup(uint64_t groupId);
+
+    /**
+     * 更新复制组的第一条日志index，在此之前的日志可以被回收
+     */
+    void UpdateFirstIndex(uint64_t groupId, int64_t firstIndex);
+
+    /**
+     * 写入一个复制组的一批日志，和其他复制组并发的写入合并后一起落盘
+     * @param groupId: 复制组id
+     * @param entries: 需要写入的日志
+     * @param locations[out]: 每条日志在共享文件中的位置
+     * @return 成功返回0，失败返回-1
+     */
+    int AppendEntries(uint64_t groupId,
+                      const std::vector<braft::LogEntry*>& entries,
+                      std::vector<MergedLogLocation>* locations);
+
+    /**
+     * 写入truncate_suffix或reset标记
+     * @return 成功返回0，失败返回-1
+     */
+    int AppendMark(uint64_t groupId, MergedRecordType type, int64_t index);
+
+    /**
+     * 读取一条日志
+     * @return 成功返回日志，失败返回NULL
+     */
+    braft::LogEntry* ReadEntry(uint64_t groupId, int64_t index,
+                               const MergedLogLocation& location);
+
+    /**
+     * 按文件创建顺序回收所有日志都已经无用的共享文件
+     */
+    void Recycle();
+
+    // 当前共享文件的个数
+    size_t FileCount();
+
+ private:
+    struct Record {
+        int64_t index;
+        int64_t term;
+        int type;
+        butil::IOBuf data;
+        uint32_t dataChecksum;
+    };
+
+    struct PendingWrite {
+        uint64_t groupId;
+        std::vector<Record> records;
+        std::vector<MergedLogLocation> locations;
+        int ret = -1;
+        bool done = false;
+    };
+
+    // 复制组在共享日志中的状态
+    struct GroupState {
+        bool opened = false;
+        // 打开过的复制组在此之前的日志都可以回收
+        int64_t firstIndex = 0;
+    };
+
+    int Submit(PendingWrite* write);
+    // 由合并写入的发起者执行，调用期间writing_为true
+    void WriteBatch(const std::vector<PendingWrite*>& batch);
+    int FlushToFile(const std::shared_ptr<MergedLogFile>& file,
+                    butil::IOBuf* buf, uint64_t offset);
+    std::shared_ptr<MergedLogFile> CreateFile();
+    int LoadFile(uint64_t seq);
+    void ReplayRecord(uint64_t groupId, int64_t index,
+                      const MergedLogLocation& location);
+    bool CanRecycle(const std::shared_ptr<MergedLogFile>& file);
+
+ private:
+    MergedLogOptions options_;
+    // 共享文件的总大小，包括metapage
+    uint64_t fileSize_;
+    uint32_t metaPageSize_;
+    uint64_t nextSeq_;
+    // seq小于该值的文件不会再被写入，并且maxIndex已经更新完成
+    uint64_t settledSeq_;
+
+    bthread::Mutex mtx_;
+    bthread::ConditionVariable cond_;
+    std::deque<PendingWrite*> queue_;
+    bool writing_;
+
+    // 由合并写入的发起者独占访问
+    std::shared_ptr<MergedLogFile> active_;
+    // 所有共享文件，按创建顺序排列
+    std::map<uint64_t, std::shared_ptr<MergedLogFile>> files_;
+    std::unordered_map<uint64_t, GroupState> groups_;
+    // 重启后恢复出的尚未打开的复制组日志索引
+    std::unordered_map<uint64_t, MergedGroupIndex> recovered_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_RAFTLOG_MERGED_LOG_MANAGER_H_
@@ -0,0 +1,302 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/chunkserver/raftlog/merged_log_storage.h"
+
+#include <braft/local_storage.pb.h>
+#include <braft/protobuf_file.h>
+#include <butil/file_util.h>
+#include <glog/logging.h>
+
+#include <mutex>
+
+#include "src/chunkserver/raftlog/define.h"
+#include "src/common/string_util.h"
+
+namespace curve {
+namespace chunkserver {
+
+const char kMergedLogStorageProtocol[] = "curve_merged";
+
+void RegisterMergedLogStorageOrDie(
+    const std::shared_ptr<MergedLogManager>& manager) {
+    static MergedLogStorage logStorage(manager);
+    braft::log_storage_extension()->RegisterOrDie(
+                                    kMergedLogStorageProtocol, &logStorage);
+}
+
+MergedLogStorage::~MergedLogStorage() {
+    if (_opened) {
+        _manager->CloseGroup(_group_id);
+    }
+}
+
+int MergedLogStorage::init(braft::ConfigurationManager* configuration_manager) {
+    // 日志目录为${raft_log_uri}/${groupId}/log
+    butil::FilePath dir_path(_path);
+    std::string group = dir_path.DirName().BaseName().value();
+    if (!curve::common::StringToUll(group, &_group_id)) {
+        LOG(ERROR) << "Fail to parse group id from log path: " << _path;
+        return -1;
+    }
+    butil::File::Error e;
+    if (!butil::CreateDirectoryAndGetError(
+                dir_path, &e, braft::FLAGS_raft_create_parent_directories)) {
+        LOG(ERROR) << "Fail to create " << dir_path.value() << " : " << e;
+        return -1;
+    }
+
+    bool is_empty = false;
+    int ret = load_meta();
+    if (ret != 0 && errno == ENOENT) {
+        LOG(WARNING) << _path << " is empty";
+        is_empty = true;
+    } else if (ret != 0) {
+        return -1;
+    }
+
+    _manager->OpenGroup(_group_id, &_index);
+    _opened = true;
+    if (is_empty) {
+        // copyset被删除后重建时，共享文件中可能还残留着之前的日志
+        _index = MergedGroupIndex();
+        if (_manager->AppendMark(_group_id, MERGED_RECORD_RESET, 1) != 0 ||
+            save_meta(1) != 0) {
+            LOG(ERROR) << "Fail to reset log, path: " << _path;
+            return -1;
+        }
+        _first_log_index.store(1);
+        _last_log_index.store(0);
+        _manager->UpdateFirstIndex(_group_id, 1);
+        return 0;
+    }
+
+    const int64_t first_log_index = _first_log_index.load();
+    _index.TruncatePrefix(first_log_index);
+    if (_index.entries.empty()) {
+        _index.firstIndex = first_log_index;
+    } else if (_index.firstIndex > first_log_index) {
+        LOG(ERROR) << "log has hole, path: " << _path
+                   << " first_log_index: " << first_log_index
+                   << " first_index: " << _index.firstIndex;
+        return -1;
+    }
+    _last_log_index.store(_index.LastIndex());
+
+    // configuration entries should be added to configuration manager
+    for (size_t i = 0; i < _index.entries.size(); ++i) {
+        const MergedLogLocation& location = _index.entries[i];
+        if (location.type != braft::ENTRY_TYPE_CONFIGURATION) {
+            continue;
+        }
+        int64_t index = _index.firstIndex + i;
+        braft::LogEntry* entry =
+            _manager->ReadEntry(_group_id, index, location);
+        if (entry == NULL) {
+            LOG(ERROR) << "fail to load configuration entry, path: " << _path
+                       << " index: " << index;
+            return -1;
+        }
+        braft::ConfigurationEntry conf_entry(*entry);
+        configuration_manager->add(conf_entry);
+        entry->Release();
+    }
+
+    _manager->UpdateFirstIndex(_group_id, first_log_index);
+    LOG(INFO) << "Merged log storage init success, path: " << _path
+              << " first_log_index: " << first_log_index
+              << " last_log_index: " << last_log_index();
+    return 0;
+}
+
+int MergedLogStorage::load_meta() {
+    std::string meta_path(_path);
+    meta_path.append("/" BRAFT_SEGMENT_META_FILE);
+
+    braft::ProtoBufFile pb_file(meta_path);
+    braft::LogPBMeta meta;
+    if (0 != pb_file.load(&meta)) {
+        PLOG_IF(ERROR, errno != ENOENT)
+                << "Fail to load meta from " << meta_path;
+        return -1;
+    }
+
+    _first_log_index.store(meta.first_log_index());
+    return 0;
+}
+
+int MergedLogStorage::save_meta(const int64_t log_index) {
+    std::string meta_path(_path);
+    meta_path.append("/" BRAFT_SEGMENT_META_FILE);
+
+    braft::LogPBMeta meta;
+    meta.set_first_log_index(log_index);
+    braft::ProtoBufFile pb_file(meta_path);
+    int ret = pb_file.save(&meta, braft::raft_sync_meta());
+    PLOG_IF(ERROR, ret != 0) << "Fail to save meta to " << meta_path;
+    return ret;
+}
+
+int MergedLogStorage::get_location(const int64_t index,
+                                   MergedLogLocation* location) {
+    BAIDU_SCOPED_LOCK(_mutex);
+    int64_t first_index = first_log_index();
+    int64_t last_index = last_log_index();
+    if (index < first_index || index > last_index) {
+        LOG_IF(WARNING, index > last_index + 1) << "Attempted to access entry "
+            << index << " outside of log, "
+            << " first_log_index: " << first_index
+            << " last_log_index: " << last_index;
+        return -1;
+    }
+    *location = _index.entries[index - _index.firstIndex];
+    return 0;
+}
+
+braft::LogEntry* MergedLogStorage::get_entry(const int64_t index) {
+    MergedLogLocation location;
+    if (get_location(index, &location) != 0) {
+        return NULL;
+    }
+    return _manager->ReadEntry(_group_id, index, location);
+}
+
+int64_t MergedLogStorage::get_term(const int64_t index) {
+    MergedLogLocation location;
+    if (get_location(index, &location) != 0) {
+        return 0;
+    }
+    return location.term;
+}
+
+int MergedLogStorage::append_entry(const braft::LogEntry* entry) {
+    std::vector<braft::LogEntry*> entries;
+    entries.push_back(const_cast<braft::LogEntry*>(entry));
+    return append_entries(entries, NULL) == 1 ? 0 : EIO;
+}
+
+int MergedLogStorage::append_entries(
+                    const std::vector<braft::LogEntry*>& entries,
+                    braft::IOMetric* metric) {
+    (void)metric;
+    if (entries.empty()) {
+        return 0;
+    }
+    if (_last_log_index.load(butil::memory_order_relaxed) + 1
+            != entries.front()->id.index) {
+        LOG(FATAL) << "There's gap between appending entries and"
+                   << " _last_log_index path: " << _path;
+        return -1;
+    }
+
+    std::vector<MergedLogLocation> locations;
+    if (_manager->AppendEntries(_group_id, entries, &locations) != 0) {
+        LOG(ERROR) << "Fail to append entries, path: " << _path;
+        return 0;
+    }
+
+    BAIDU_SCOPED_LOCK(_mutex);
+    if (_index.entries.empty()) {
+        _index.firstIndex = entries.front()->id.index;
+    }
+    for (const MergedLogLocation& location : locations) {
+        _index.entries.push_back(location);
+    }
+    _last_log_index.fetch_add(entries.size(), butil::memory_order_release);
+    return entries.size();
+}
+
+int MergedLogStorage::truncate_prefix(const int64_t first_index_kept) {
+    if (_first_log_index.load(butil::memory_order_acquire) >=
+                                                    first_index_kept) {
+        return 0;
+    }
+    // NOTE: save meta first, see CurveSegmentLogStorage::truncate_prefix
+    if (save_meta(first_index_kept) != 0) {
+        PLOG(ERROR) << "Fail to save meta, path: " << _path;
+        return -1;
+    }
+    {
+        BAIDU_SCOPED_LOCK(_mutex);
+        _index.TruncatePrefix(first_index_kept);
+        _first_log_index.store(first_index_kept, butil::memory_order_release);
+        if (_last_log_index.load(butil::memory_order_relaxed) <
+                                                    first_index_kept) {
+            _last_log_index.store(first_index_kept - 1,
+                                  butil::memory_order_release);
+        }
+    }
+    _manager->UpdateFirstIndex(_group_id, first_index_kept);
+    _manager->Recycle();
+    return 0;
+}
+
+int MergedLogStorage::truncate_suffix(const int64_t last_index_kept) {
+    // 先持久化截断标记，重启后重放到标记时丢弃被截断的日志
+    if (_manager->AppendMark(_group_id, MERGED_RECORD_TRUNCATE_SUFFIX,
+                             last_index_kept) != 0) {
+        LOG(ERROR) << "Fail to truncate suffix, path: " << _path
+                   << " last_index_kept: " << last_index_kept;
+        return -1;
+    }
+    BAIDU_SCOPED_LOCK(_mutex);
+    _index.TruncateSuffix(last_index_kept);
+    _last_log_index.store(last_index_kept, butil::memory_order_release);
+    if (_index.entries.empty()) {
+        // all the logs have been cleared, the we move _first_log_index to the
+        // next index
+        _first_log_index.store(last_index_kept + 1,
+                               butil::memory_order_release);
+    }
+    return 0;
+}
+
+int MergedLogStorage::reset(const int64_t next_log_index) {
+    if (next_log_index <= 0) {
+        LOG(ERROR) << "Invalid next_log_index=" << next_log_index
+                   << " path: " << _path;
+        return EINVAL;
+    }
+    if (save_meta(next_log_index) != 0) {
+        PLOG(ERROR) << "Fail to save meta, path: " << _path;
+        return -1;
+    }
+    if (_manager->AppendMark(_group_id, MERGED_RECORD_RESET,
+                             next_log_index) != 0) {
+        LOG(ERROR) << "Fail to reset log, path: " << _path
+                   << " next_log_index: " << next_log_index;
+        return -1;
+    }
+    {
+        BAIDU_SCOPED_LOCK(_mutex);
+        _index.entries.clear();
+        _index.firstIndex = next_log_index;
+        _first_log_index.store(next_log_index, butil::memory_order_relaxed);
+        _last_log_index.store(next_log_index - 1, butil::memory_order_relaxed);
+    }
+    _manager->UpdateFirstIndex(_group_id, next_log_index);
+    _manager->Recycle();
+    return 0;
+}
+
+braft::LogStorage* MergedLogStorage::new_instance(
+    const std::string& uri) const {
+    CHECK(nullptr != _manager) << "merged log manager is null";
+    return new MergedLogStorage(uri, _manager);
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_CHUNKSERVER_RAFTLOG_MERGED_LOG_STORAGE_H_
+#define SRC_CHUNKSERVER_RAFTLOG_MERGED_LOG_STORAGE_H_
+
+#include <braft/log_entry.h>
+#include <braft/storage.h>
+#include <braft/util.h>
+#include <butil/atomicops.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/chunkserver/raftlog/merged_log_manager.h"
+
+namespace curve {
+namespace chunkserver {
+
+// raft_log_uri使用该协议时，所有copyset的日志写入MergedLogManager的共享文件
+extern const char kMergedLogStorageProtocol[];
+
+void RegisterMergedLogStorageOrDie(
+    const std::shared_ptr<MergedLogManager>& manager);
+
+// LogStorage backed by MergedLogManager. Entries of all copysets are appended
+// to shared segment files, each copyset only keeps the index of its own
+// entries in memory.
+//
+// Log dir layout (one per copyset):
+//      log_meta: record first_log_index
+class MergedLogStorage : public braft::LogStorage {
+ public:
+    MergedLogStorage(const std::string& path,
+                     std::shared_ptr<MergedLogManager> manager)
+        : _path(path), _group_id(0), _first_log_index(1),
+          _last_log_index(0), _manager(manager), _opened(false) {}
+
+    explicit MergedLogStorage(std::shared_ptr<MergedLogManager> manager)
+        : MergedLogStorage("", manager) {}
+
+    virtual ~MergedLogStorage();
+
+    // init logstorage, recover the index of this copyset from shared log
+    virtual int init(braft::ConfigurationManager* configuration_manager);
+
+    // first log index in log
+    virtual int64_t first_log_index() {
+        return _first_log_index.load(butil::memory_order_acquire);
+    }
+
+    // last log index in log
+    virtual int64_t last_log_index() {
+        return _last_log_index.load(butil::memory_order_acquire);
+    }
+
+    // get logentry by index
+    virtual braft::LogEntry* get_entry(const int64_t index);
+
+    // get logentry's term by index
+    virtual int64_t get_term(const int64_t index);
+
+    // append entry to log
+    virtual int append_entry(const braft::LogEntry* entry);
+
+    // append entries to log, return success append number
+    virtual int append_entries(const std::vector<braft::LogEntry*>& entries,
+                               braft::IOMetric* metric);
+
+    // delete logs from storage's head, [1, first_index_kept) will be discarded
+    virtual int truncate_prefix(const int64_t first_index_kept);
+
+    // delete uncommitted logs from storage's tail,
+    // (last_index_kept, infinity) will be discarded
+    virtual int truncate_suffix(const int64_t last_index_kept);
+
+    virtual int reset(const int64_t next_log_index);
+
+    virtual braft::LogStorage* new_instance(const std::string& uri) const;
+
+ private:
+    int save_meta(const int64_t log_index);
+    int load_meta();
+    int get_location(const int64_t index, MergedLogLocation* location);
+
+    std::string _path;
+    uint64_t _group_id;
+    butil::atomic<int64_t> _first_log_index;
+    butil::atomic<int64_t> _last_log_index;
+    braft::raft_mutex_t _mutex;
+    // 本复制组日志在共享文件中的位置，受_mutex保护
+    MergedGroupIndex _index;
+    std::shared_ptr<MergedLogManager> _manager;
+    bool _opened;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_RAFTLOG_MERGED_LOG_STORAGE_H_
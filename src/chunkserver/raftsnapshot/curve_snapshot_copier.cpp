@@ -41,6 +41,11 @@
 
 #include "src/chunkserver/raftsnapshot/curve_snapshot_copier.h"
 
+#include <algorithm>
+#include <deque>
+
+#include "src/common/string_util.h"
+
 namespace curve {
 namespace chunkserver {
 
@@ -57,6 +62,9 @@ CurveSnapshotCopier::CurveSnapshotCopier(CurveSnapshotStorage* storage,
     , _storage(storage)
     , _reader(NULL)
     , _cur_session(NULL)
+    , _local_snapshot_index(0)
+    , _reused_files(0)
+    , _downloaded_files(0)
 {}
 
 CurveSnapshotCopier::~CurveSnapshotCopier() {
@@ -70,6 +78,10 @@ void *CurveSnapshotCopier::start_copy(void* arg) {
 }
 
 void CurveSnapshotCopier::copy() {
+    if (CurveSnapshotStorage::enable_incremental_snapshot()) {
+        BAIDU_SCOPED_LOCK(_storage->_mutex);
+        _local_snapshot_index = _storage->_last_snapshot_index;
+    }
     do {
         // 下载snapshot meta中记录的文件
         load_meta_table();
@@ -82,9 +94,7 @@ void CurveSnapshotCopier::copy() {
         }
         std::vector<std::string> files;
         _remote_snapshot.list_files(&files);
-        for (size_t i = 0; i < files.size() && ok(); ++i) {
-            copy_file(files[i]);
-        }
+        copy_files(files, false);
 
         // 下载snapshot attachment文件
         load_attach_meta_table();
@@ -93,9 +103,7 @@ void CurveSnapshotCopier::copy() {
         }
         std::vector<std::string> attachFiles;
         _remote_snapshot.list_attach_files(&attachFiles);
-        for (size_t i = 0; i < attachFiles.size() && ok(); ++i) {
-            copy_file(attachFiles[i], true);
-        }
+        copy_files(attachFiles, true);
     } while (0);
     if (!ok() && _writer && _writer->ok()) {
         LOG(WARNING) << "Fail to copy, error_code " << error_code()
@@ -114,6 +122,11 @@ void CurveSnapshotCopier::copy() {
     if (ok()) {
         _reader = _storage->open();
     }
+    if (_local_snapshot_index > 0) {
+        LOG(INFO) << "Incremental snapshot copy finished, local snapshot index "
+                  << _local_snapshot_index << ", reused " << _reused_files
+                  << " files, downloaded " << _downloaded_files << " files";
+    }
 }
 
 void CurveSnapshotCopier::load_meta_table() {
@@ -305,11 +318,42 @@ void CurveSnapshotCopier::filter() {
     }
 }
 
-void CurveSnapshotCopier::copy_file(const std::string& filename, bool attch) {
+void CurveSnapshotCopier::copy_files(const std::vector<std::string>& files,
+                                     bool attach) {
+    // 多个文件同时下载，下载的总带宽仍由_throttle限制；
+    // writer不是线程安全的，add_file和sync都在当前线程完成
+    const size_t concurrency = static_cast<size_t>(
+        std::max(1, CurveSnapshotStorage::copy_concurrency()));
+    std::deque<CopyTask> running;
+    for (size_t i = 0; i < files.size() && ok(); ++i) {
+        CopyTask task;
+        if (!start_copy_file(files[i], attach, &task)) {
+            continue;
+        }
+        running.push_back(task);
+        while (running.size() >= concurrency) {
+            finish_copy_file(&running.front());
+            running.pop_front();
+        }
+    }
+    if (!ok()) {
+        for (auto& task : running) {
+            task.session->cancel();
+        }
+    }
+    while (!running.empty()) {
+        finish_copy_file(&running.front());
+        running.pop_front();
+    }
+}
+
+bool CurveSnapshotCopier::start_copy_file(const std::string& filename,
+                                          bool attch,
+                                          CopyTask* task) {
     if (_writer->get_file_meta(filename, NULL) == 0) {
         LOG(INFO) << "Skipped downloading " << filename
                   << " path: " << _writer->get_path();
-        return;
+        return false;
     }
     std::string rfilename = get_rfilename(filename);
     std::string file_path = _writer->get_path() + '/' + rfilename;
@@ -331,14 +375,26 @@ void CurveSnapshotCopier::copy_file(const std::string& filename, bool attch) {
                        << " : " << butil::File::ErrorToString(e);
             set_error(braft::file_error_to_os_error(e),
                       "Fail to create directory");
+            return false;
         }
     }
     braft::LocalFileMeta meta;
     _remote_snapshot.get_file_meta(filename, &meta);
+    if (!attch && reuse_local_file(filename, meta, file_path)) {
+        ++_reused_files;
+        if (_writer->add_file(filename, &meta) != 0) {
+            set_error(EIO, "Fail to add file to writer");
+            return false;
+        }
+        if (_writer->sync() != 0) {
+            set_error(EIO, "Fail to sync writer");
+        }
+        return false;
+    }
     std::unique_lock<braft::raft_mutex_t> lck(_mutex);
     if (_cancelled) {
         set_error(ECANCELED, "%s", berror(ECANCELED));
-        return;
+        return false;
     }
     scoped_refptr<braft::RemoteFileCopier::Session> session
         = _copier.start_to_copy_to_file(filename, file_path, NULL);
@@ -346,33 +402,48 @@ void CurveSnapshotCopier::copy_file(const std::string& filename, bool attch) {
         LOG(WARNING) << "Fail to copy " << filename
                      << " path: " << _writer->get_path();
         set_error(-1, "Fail to copy %s", filename.c_str());
-        return;
+        return false;
     }
-    _cur_session = session.get();
+    _file_sessions.insert(session.get());
     lck.unlock();
-    session->join();
-    lck.lock();
-    _cur_session = NULL;
+    task->filename = filename;
+    task->file_path = file_path;
+    task->meta = meta;
+    task->attach = attch;
+    task->session = session;
+    return true;
+}
+
+void CurveSnapshotCopier::finish_copy_file(CopyTask* task) {
+    task->session->join();
+    std::unique_lock<braft::raft_mutex_t> lck(_mutex);
+    _file_sessions.erase(task->session.get());
     lck.unlock();
-    if (!session->status().ok()) {
+    if (!task->session->status().ok()) {
         // 如果是文件不存在，那么删除刚开始open的文件
-        if (session->status().error_code() == ENOENT) {
-            bool rc = _fs->delete_file(file_path, false);
+        if (task->session->status().error_code() == ENOENT) {
+            bool rc = _fs->delete_file(task->file_path, false);
             if (!rc) {
-                LOG(ERROR) << "Fail to delete file" << file_path
+                LOG(ERROR) << "Fail to delete file" << task->file_path
                            << " : " << ::berror(errno);
                 set_error(errno,
-                          "Fail to create delete file " + file_path);
+                          "Fail to create delete file " + task->file_path);
             }
             return;
         }
-
-        set_error(session->status().error_code(),
-                  session->status().error_cstr());
+        // 已经失败的情况下，其他被cancel的session不覆盖原来的错误
+        if (ok()) {
+            set_error(task->session->status().error_code(),
+                      task->session->status().error_cstr());
+        }
+        return;
+    }
+    if (!ok()) {
         return;
     }
+    ++_downloaded_files;
     // 如果是attach file，那么不需要持久化file meta信息
-    if (!attch && _writer->add_file(filename, &meta) != 0) {
+    if (!task->attach && _writer->add_file(task->filename, &task->meta) != 0) {
         set_error(EIO, "Fail to add file to writer");
         return;
     }
@@ -382,6 +453,39 @@ void CurveSnapshotCopier::copy_file(const std::string& filename, bool attch) {
     }
 }
 
+bool CurveSnapshotCopier::reuse_local_file(const std::string& filename,
+                                           const braft::LocalFileMeta& meta,
+                                           const std::string& file_path) {
+    // The leader records the last modified log index of the chunk in
+    // user_meta. All logs before the local last snapshot index have been
+    // applied, so the local file is identical to the remote one if the chunk
+    // has not been modified after that index
+    if (_local_snapshot_index <= 0 || !meta.has_user_meta()) {
+        return false;
+    }
+    uint64_t modified_index = 0;
+    if (!curve::common::StringToUll(meta.user_meta(), &modified_index) ||
+        modified_index > static_cast<uint64_t>(_local_snapshot_index)) {
+        return false;
+    }
+    // filename is relative to the snapshot directory and points to the
+    // copyset data directory, which is where the local copy lives
+    std::string local_path = _writer->get_path() + '/' + filename;
+    if (!_fs->path_exists(local_path)) {
+        return false;
+    }
+    _fs->delete_file(file_path, false);
+    if (!_fs->link(local_path, file_path)) {
+        PLOG(WARNING) << "Fail to link " << local_path << " to " << file_path
+                      << ", download it from remote";
+        return false;
+    }
+    LOG(INFO) << "Reuse local file " << local_path
+              << " modified_index=" << modified_index
+              << " local_snapshot_index=" << _local_snapshot_index;
+    return true;
+}
+
 std::string CurveSnapshotCopier::get_rfilename(const std::string& filename) {
     std::string rfilename;
     auto pos = filename.rfind("../");
@@ -414,6 +518,9 @@ void CurveSnapshotCopier::cancel() {
     if (_cur_session) {
         _cur_session->cancel();
     }
+    for (auto session : _file_sessions) {
+        session->cancel();
+    }
 }
 
 int CurveSnapshotCopier::init(const std::string& uri) {
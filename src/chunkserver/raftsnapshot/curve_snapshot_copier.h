@@ -43,8 +43,10 @@
 #define SRC_CHUNKSERVER_RAFTSNAPSHOT_CURVE_SNAPSHOT_COPIER_H_
 
 #include <braft/storage.h>
+#include <braft/remote_file_copier.h>
 #include <vector>
 #include <string>
+#include <set>
 #include "src/chunkserver/raftsnapshot/curve_snapshot.h"
 #include "src/chunkserver/raftsnapshot/curve_snapshot_storage.h"
 
@@ -74,7 +76,25 @@ class CurveSnapshotCopier : public braft::SnapshotCopier {
     int filter_before_copy(CurveSnapshotWriter* writer,
                            braft::SnapshotReader* last_snapshot);
     void filter();
-    void copy_file(const std::string& filename, bool attach = false);
+    // A file which is being downloaded from remote
+    struct CopyTask {
+        std::string filename;
+        std::string file_path;
+        braft::LocalFileMeta meta;
+        bool attach;
+        scoped_refptr<braft::RemoteFileCopier::Session> session;
+    };
+    // Download files with at most copy_concurrency sessions in flight
+    void copy_files(const std::vector<std::string>& files, bool attach);
+    // Return true if a session is started and task should be finished later
+    bool start_copy_file(const std::string& filename, bool attach,
+                         CopyTask* task);
+    void finish_copy_file(CopyTask* task);
+    // Link the local copy of a file instead of downloading it if the remote
+    // meta shows it has not been modified since the local last snapshot
+    bool reuse_local_file(const std::string& filename,
+                          const braft::LocalFileMeta& meta,
+                          const std::string& file_path);
     // 这里的filename是相对于快照目录的路径，为了先把文件下载到临时目录，需要把前面的..去掉
     std::string get_rfilename(const std::string& filename);
 
@@ -88,8 +108,15 @@ class CurveSnapshotCopier : public braft::SnapshotCopier {
     CurveSnapshotStorage* _storage;
     braft::SnapshotReader* _reader;
     braft::RemoteFileCopier::Session* _cur_session;
+    // Sessions of the files being downloaded concurrently
+    std::set<braft::RemoteFileCopier::Session*> _file_sessions;
     CurveSnapshot _remote_snapshot;
     braft::RemoteFileCopier _copier;
+    // Last snapshot index of local storage when copy starts, 0 if the
+    // incremental snapshot is disabled or there is no local snapshot
+    int64_t _local_snapshot_index;
+    int64_t _reused_files;
+    int64_t _downloaded_files;
 };
 }  // namespace chunkserver
 }  // namespace curve
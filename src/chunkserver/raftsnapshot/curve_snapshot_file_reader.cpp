@@ -41,6 +41,11 @@
 
 #include "src/chunkserver/raftsnapshot/curve_snapshot_file_reader.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <braft/util.h>
+
 namespace curve {
 namespace chunkserver {
 
@@ -158,8 +163,8 @@ int CurveSnapshotFileReader::read_file(butil::IOBuf* out,
             }
         }
         if (ret == 0) {
-            ret = LocalDirReader::read_file_with_meta(out, filename, &file_meta,
-                                    offset, new_max_count, read_count, is_eof);
+            ret = read_file_at(out, filename, offset, new_max_count,
+                               read_count, is_eof);
             used_count = out->size();
         }
         if ((ret == 0 || ret == EAGAIN) &&
@@ -169,8 +174,43 @@ int CurveSnapshotFileReader::read_file(butil::IOBuf* out,
         }
         return ret;
     }
-    return LocalDirReader::read_file_with_meta(out, filename, &file_meta,
-                                    offset, new_max_count, read_count, is_eof);
+    return read_file_at(out, filename, offset, new_max_count,
+                        read_count, is_eof);
+}
+
+int CurveSnapshotFileReader::read_file_at(butil::IOBuf* out,
+                                          const std::string &filename,
+                                          off_t offset,
+                                          size_t max_count,
+                                          size_t* read_count,
+                                          bool* is_eof) const {
+    std::string file_path(path() + "/" + filename);
+    int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return errno;
+    }
+    butil::IOPortal buf;
+    ssize_t nread = braft::file_pread(&buf, fd, offset, max_count);
+    if (nread < 0) {
+        int err = errno;
+        ::close(fd);
+        return err;
+    }
+    *read_count = nread;
+    if (static_cast<size_t>(nread) < max_count) {
+        *is_eof = true;
+    } else {
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            return err;
+        }
+        *is_eof = (st.st_size == offset + nread);
+    }
+    ::close(fd);
+    out->append(buf);
+    return 0;
 }
 
 }  // namespace chunkserver
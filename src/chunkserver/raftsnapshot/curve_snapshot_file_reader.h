@@ -114,6 +114,17 @@ class CurveSnapshotFileReader : public braft::LocalDirReader {
     }
 
  private:
+    // Read the file at offset without the per-reader sequential state kept by
+    // LocalDirReader, so that several files of the snapshot can be served
+    // concurrently. Data is read from the fd straight into the IOBuf blocks
+    // which become the rpc attachment
+    int read_file_at(butil::IOBuf* out,
+                     const std::string &filename,
+                     off_t offset,
+                     size_t max_count,
+                     size_t* read_count,
+                     bool* is_eof) const;
+
     braft::LocalSnapshotMetaTable _meta_table;
     CurveSnapshotAttachMetaTable _attach_meta_table;
     scoped_refptr<braft::SnapshotThrottle> _snapshot_throttle;
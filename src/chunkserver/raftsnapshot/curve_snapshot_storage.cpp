@@ -55,6 +55,8 @@ void RegisterCurveSnapshotStorageOrDie() {
 }
 
 butil::EndPoint CurveSnapshotStorage::_addr;
+bool CurveSnapshotStorage::_enable_incremental_snapshot = false;
+int CurveSnapshotStorage::_copy_concurrency = 1;
 
 const char* CurveSnapshotStorage::_s_temp_path = "temp";
 
@@ -88,6 +88,19 @@ friend class CurveSnapshotCopier;
         _addr = server_addr;
     }
     static bool has_server_addr() { return _addr != butil::EndPoint(); }
+    // When enabled, chunk files whose recorded modification index is not
+    // newer than the local last snapshot are reused instead of downloaded
+    static void set_enable_incremental_snapshot(bool enable) {
+        _enable_incremental_snapshot = enable;
+    }
+    static bool enable_incremental_snapshot() {
+        return _enable_incremental_snapshot;
+    }
+    // Max number of files downloaded concurrently when installing snapshot
+    static void set_copy_concurrency(int concurrency) {
+        _copy_concurrency = concurrency;
+    }
+    static int copy_concurrency() { return _copy_concurrency; }
 
  private:
     braft::SnapshotWriter* create(bool from_empty) WARN_UNUSED_RESULT;
@@ -104,6 +117,8 @@ friend class CurveSnapshotCopier;
     scoped_refptr<braft::FileSystemAdaptor> _fs;
     scoped_refptr<braft::SnapshotThrottle> _snapshot_throttle;
     static butil::EndPoint _addr;
+    static bool _enable_incremental_snapshot;
+    static int _copy_concurrency;
 };
 
 }  // namespace chunkserver
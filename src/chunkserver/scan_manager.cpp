@@ -21,16 +21,57 @@
  */
 
 #include "src/chunkserver/scan_manager.h"
+
+#include <algorithm>
+#include <string>
+
 #include "src/chunkserver/op_request.h"
+#include "src/common/background_io_scheduler.h"
 
 namespace curve {
 namespace chunkserver {
 
 using ::google::protobuf::util::MessageDifferencer;
+using ::curve::common::BackgroundIOScheduler;
+using ::curve::common::BackgroundIOType;
+
+namespace {
+// blockCrc只用于定位不一致的区间，旧版本的chunkserver不会携带，不参与比较
+bool ScanMapEquals(const ScanMap &map1, const ScanMap &map2) {
+    MessageDifferencer differencer;
+    differencer.IgnoreField(ScanMap::descriptor()->FindFieldByName(
+        "blockSize"));
+    differencer.IgnoreField(ScanMap::descriptor()->FindFieldByName(
+        "blockCrc"));
+    return differencer.Compare(map1, map2);
+}
+
+// 根据blockCrc找出两个scanmap不一致的区间，格式为[offset, len] ...
+std::string DiffBlocks(const ScanMap &map1, const ScanMap &map2) {
+    if (map1.blocksize() == 0 || map1.blocksize() != map2.blocksize() ||
+        map1.blockcrc_size() != map2.blockcrc_size()) {
+        return "unknown";
+    }
+    std::string diff;
+    for (int i = 0; i < map1.blockcrc_size(); ++i) {
+        if (map1.blockcrc(i) == map2.blockcrc(i)) {
+            continue;
+        }
+        uint64_t offset = map1.offset() +
+                          static_cast<uint64_t>(i) * map1.blocksize();
+        uint64_t len = std::min<uint64_t>(map1.blocksize(),
+                                          map1.offset() + map1.len() - offset);
+        diff += "[" + std::to_string(offset) + ", " +
+                std::to_string(len) + "] ";
+    }
+    return diff;
+}
+}  // namespace
 
 int ScanManager::Init(const ScanManagerOptions &options) {
     toStop_.store(false, std::memory_order_release);
     scanSize_ = options.scanSize;
+    scanBlockSize_ = options.scanBlockSize;
     chunkMetaPageSize_ = options.chunkMetaPageSize;
     timeoutMs_ = options.timeoutMs;
     retry_ = options.retry;
@@ -209,7 +250,7 @@ void ScanManager::GenScanJobs(ScanKey key) {
 // send scan request to braft
 int ScanManager::ScanJobProcess(const std::shared_ptr<ScanJob> job) {
     // check chunkmap
-    if (job->chunkMap.empty()) {
+    if (job->chunkMap == nullptr || job->chunkMap->empty()) {
         LOG(WARNING) << "GenScanJob failed, job's chunkmap is empty"
                      << " logicalpoolId = " << job->poolId
                      << " copysetId = " << job->id;
@@ -221,8 +262,8 @@ int ScanManager::ScanJobProcess(const std::shared_ptr<ScanJob> job) {
     std::vector<Peer> peers;
     nodePtr->ListPeers(&peers);
     auto replicaNum = peers.size();
-    auto iter = job->chunkMap.begin();
-    while (iter != job->chunkMap.end()) {
+    auto iter = job->chunkMap->begin();
+    while (iter != job->chunkMap->end()) {
         // check chunk version
         auto csChunkFile = iter->second;
         if (csChunkFile->GetChunkFileMetaPage().version !=
@@ -271,12 +312,18 @@ int ScanManager::ScanJobProcess(const std::shared_ptr<ScanJob> job) {
                     request->set_size(chunkMetaPageSize_);
                 } else {
                     request->set_size(scanSize_);
+                    if (scanBlockSize_ > 0) {
+                        request->set_scanblocksize(scanBlockSize_);
+                    }
                 }
                 ScanChunkClosure *done = new ScanChunkClosure(request,
                                                               response);
                 std::shared_ptr<ScanChunkRequest> req =
                     std::make_shared<ScanChunkRequest>(nodePtr, this, request,
                                                     response, done);
+                // 在扫描线程中申请配额，不阻塞apply线程
+                BackgroundIOScheduler::GetInstance().Acquire(
+                    BackgroundIOType::SCAN, request->size());
                 req->Process();
                 if (!scanChunkMetaPage) {
                     currentOffset += scanSize_;
@@ -380,17 +427,25 @@ void ScanManager::CompareMap(std::shared_ptr<ScanJob> job) {
                            << job->task.followerMap.size()
                            << " the leader scanmap initialied = "
                            << job->task.localMap.IsInitialized();
-            } else if (!(MessageDifferencer::Equals(job->task.localMap,
-                                             job->task.followerMap[0]) &&
-                       MessageDifferencer::Equals(job->task.localMap,
-                                                  job->task.followerMap[1]))) {
+            } else if (!(ScanMapEquals(job->task.localMap,
+                                       job->task.followerMap[0]) &&
+                         ScanMapEquals(job->task.localMap,
+                                       job->task.followerMap[1]))) {
                 LOG(ERROR) << "Compare scanmap failed,"
                            << " the leader scanmap: "
                            << job->task.localMap.ShortDebugString()
                            << "; the first follower scanmap: "
                            << job->task.followerMap[0].ShortDebugString()
                            << "; the second follower scanmap: "
-                           << job->task.followerMap[1].ShortDebugString();
+                           << job->task.followerMap[1].ShortDebugString()
+                           << "; the inconsistent ranges of the first"
+                           << " follower: "
+                           << DiffBlocks(job->task.localMap,
+                                         job->task.followerMap[0])
+                           << "; the inconsistent ranges of the second"
+                           << " follower: "
+                           << DiffBlocks(job->task.localMap,
+                                         job->task.followerMap[1]);
                 // set failed scanmap
                 auto nodePtr = copysetNodeManager_->GetCopysetNode(job->poolId,
                                                                    job->id);
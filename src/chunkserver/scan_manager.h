@@ -57,6 +57,8 @@ struct ScanManagerOptions {
     uint32_t intervalSec;
     // once scan buf size
     uint64_t scanSize;
+    // block size of the per block crc in scanmap, 0 means disabled
+    uint32_t scanBlockSize = 0;
     uint32_t chunkMetaPageSize;
     // use for follower send scanmap to leader
     uint64_t timeoutMs;
@@ -93,7 +95,7 @@ struct ScanJob {
     ScanTask task;
     bool isFinished;
     RWLock taskLock;
-    ChunkMap chunkMap;
+    ChunkMapPtr chunkMap;
     std::shared_ptr<CSDataStore> dataStore;
     ScanJob() : type(ScanType::Init) {}
 };
@@ -247,6 +249,7 @@ class ScanManager {
     uint32_t chunkSize_;
     uint32_t chunkMetaPageSize_;
     uint64_t scanSize_;
+    uint32_t scanBlockSize_;
     uint64_t timeoutMs_;
     uint32_t retry_;
     uint64_t retryIntervalUs_;
@@ -30,11 +30,14 @@
 #include "include/chunkserver/chunkserver_common.h"
 #include "src/common/uri_parser.h"
 #include "src/chunkserver/raftlog/define.h"
+#include "src/common/background_io_scheduler.h"
 
 using ::curve::chunkserver::RAFT_DATA_DIR;
 using ::curve::chunkserver::RAFT_META_DIR;
 using ::curve::chunkserver::RAFT_SNAP_DIR;
 using ::curve::chunkserver::RAFT_LOG_DIR;
+using ::curve::common::BackgroundIOScheduler;
+using ::curve::common::BackgroundIOType;
 
 namespace curve {
 namespace chunkserver {
@@ -136,6 +139,24 @@ int Trash::RecycleCopySet(const std::string &dirPath) {
     return 0;
 }
 
+int Trash::RecycleRaftLog(const std::string &logDir) {
+    if (!localFileSystem_->DirExists(logDir)) {
+        return 0;
+    }
+
+    if (!RecycleWALInDir(logDir)) {
+        LOG(ERROR) << "Failed to recycle wal files in " << logDir;
+        return -1;
+    }
+
+    if (0 != localFileSystem_->Delete(logDir)) {
+        LOG(ERROR) << "Trash fail to delete " << logDir;
+        return -1;
+    }
+    LOG(INFO) << "Recycle raft log success. Log path: " << logDir;
+    return 0;
+}
+
 void Trash::DeleteEligibleFileInTrashInterval() {
      while (sleeper_.wait_for(std::chrono::seconds(scanPeriodSec_))) {
         // 扫描回收站
@@ -260,6 +281,7 @@ bool Trash::RecycleChunksAndWALInDir(
 bool Trash::RecycleChunkfile(
     const std::string &filepath, const std::string &filename) {
     (void)filename;
+    BackgroundIOScheduler::GetInstance().Acquire(BackgroundIOType::TRASH, 0);
     LockGuard lg(mtx_);
     if (0 != chunkFilePool_->RecycleFile(filepath)) {
         LOG(ERROR) << "Trash  failed recycle chunk " << filepath
@@ -274,6 +296,7 @@ bool Trash::RecycleChunkfile(
 bool Trash::RecycleWAL(
     const std::string &filepath, const std::string &filename) {
     (void)filename;
+    BackgroundIOScheduler::GetInstance().Acquire(BackgroundIOType::TRASH, 0);
     LockGuard lg(mtx_);
     if (walPool_ != nullptr && 0 != walPool_->RecycleFile(filepath)) {
         LOG(ERROR) << "Trash  failed recycle WAL " << filepath
@@ -285,6 +308,36 @@ bool Trash::RecycleWAL(
     return true;
 }
 
+bool Trash::RecycleWALInDir(const std::string &dirPath) {
+    std::vector<std::string> files;
+    if (0 != localFileSystem_->List(dirPath, &files)) {
+        LOG(ERROR) << "Trash failed to list files in " << dirPath;
+        return false;
+    }
+
+    bool ret = true;
+    for (auto &file : files) {
+        std::string filePath = dirPath + "/" + file;
+        if (localFileSystem_->DirExists(filePath)) {
+            if (!RecycleWALInDir(filePath)) {
+                ret = false;
+            }
+            continue;
+        }
+
+        // 其他文件(例如log_meta)由调用方随目录一起删除
+        if (!IsWALFile(file) || walPool_ == nullptr) {
+            continue;
+        }
+        if (0 != walPool_->RecycleFile(filePath)) {
+            LOG(ERROR) << "Trash failed recycle WAL " << filePath
+                       << " to WALPool";
+            ret = false;
+        }
+    }
+    return ret;
+}
+
 bool Trash::IsWALFile(const std::string &fileName) {
     int match = 0;
     int64_t first_index = 0;
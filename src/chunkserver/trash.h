@@ -66,6 +66,18 @@ class Trash {
 
     int RecycleCopySet(const std::string &dirPath);
 
+    /*
+    * @brief RecycleRaftLog 回收copyset单独存放的raft日志目录
+    *        raft日志和数据不在同一块盘时，日志目录无法rename到回收站，
+    *        日志脱离数据也没有恢复的意义，因此直接把其中的wal文件
+    *        回收到同盘的walpool中，然后删除该目录
+    *
+    * @param[in] logDir copyset的raft日志目录
+    *
+    * @return 成功返回0，失败返回-1
+    */
+    int RecycleRaftLog(const std::string &logDir);
+
     /*
     * @brief 获取回收站中chunk的个数
     *
@@ -146,6 +158,15 @@ class Trash {
      */
     bool RecycleWAL(const std::string& filepath, const std::string& filename);
 
+    /*
+    * @brief 把目录下的wal文件回收到walpool，其余文件保留由调用方删除，
+    *        这些wal文件不计入回收站中的chunk个数
+    *
+    * @param[in] dirPath 目录路径
+    * @return 全部回收成功返回true
+    */
+    bool RecycleWALInDir(const std::string &dirPath);
+
     /*
     * @brief 统计copyset目录中的chunk个数
     *
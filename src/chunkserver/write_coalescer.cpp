@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/chunkserver/write_coalescer.h"
+
+#include <brpc/closure_guard.h>
+#include <bthread/bthread.h>
+#include <glog/logging.h>
+
+#include <mutex>
+#include <utility>
+
+#include "src/chunkserver/op_request.h"
+
+namespace curve {
+namespace chunkserver {
+
+WriteCoalescer::WriteCoalescer(const WriteCoalescerOptions& options)
+    : options_(options), draining_(false), mergedCount_(0) {}
+
+void WriteCoalescer::Submit(std::shared_ptr<ChunkOpRequest> op,
+                            const ChunkRequest* request,
+                            const butil::IOBuf* data) {
+    {
+        std::lock_guard<bthread::Mutex> lk(mtx_);
+        queue_.push_back(Pending{std::move(op), request, data});
+        // 已经有请求在负责propose，由它处理队列中的请求
+        if (draining_) {
+            return;
+        }
+        draining_ = true;
+    }
+
+    if (options_.waitUs > 0) {
+        bthread_usleep(options_.waitUs);
+    }
+
+    std::vector<Pending> pendings;
+    while (true) {
+        {
+            std::lock_guard<bthread::Mutex> lk(mtx_);
+            if (queue_.empty()) {
+                draining_ = false;
+                return;
+            }
+            pendings.swap(queue_);
+        }
+
+        // 按到达顺序propose，只合并相邻的请求，保证同一个chunk上的请求有序
+        std::vector<Pending> batch;
+        uint64_t batchBytes = 0;
+        for (auto& pending : pendings) {
+            if (!batch.empty() && !CanMerge(batch, batchBytes, pending)) {
+                ProposeBatch(&batch);
+                batchBytes = 0;
+            }
+            batchBytes += pending.request->size();
+            batch.push_back(std::move(pending));
+        }
+        ProposeBatch(&batch);
+        pendings.clear();
+    }
+}
+
+bool WriteCoalescer::CanMerge(const std::vector<Pending>& batch,
+                              uint64_t batchBytes,
+                              const Pending& next) const {
+    auto mergeable = [](const Pending& pending) {
+        const ChunkRequest* request = pending.request;
+        return request->optype() == CHUNK_OP_TYPE::CHUNK_OP_WRITE &&
+               !existCloneInfo(request) &&
+               pending.data != nullptr &&
+               pending.data->size() == request->size();
+    };
+
+    const Pending& last = batch.back();
+    if (!mergeable(last) || !mergeable(next)) {
+        return false;
+    }
+    const ChunkRequest* prev = last.request;
+    const ChunkRequest* cur = next.request;
+    return prev->chunkid() == cur->chunkid() &&
+           prev->sn() == cur->sn() &&
+           prev->has_correctedsn() == cur->has_correctedsn() &&
+           prev->correctedsn() == cur->correctedsn() &&
+           prev->offset() + prev->size() == cur->offset() &&
+           batchBytes + cur->size() <= options_.maxBytes;
+}
+
+void WriteCoalescer::ProposeBatch(std::vector<Pending>* batch) {
+    if (batch->size() == 1) {
+        ProposeOne(batch->front());
+        batch->clear();
+        return;
+    }
+
+    std::vector<std::shared_ptr<ChunkOpRequest>> ops;
+    butil::IOBuf data;
+    for (auto& pending : *batch) {
+        data.append(*pending.data);
+        ops.push_back(std::move(pending.op));
+    }
+    auto merged = std::make_shared<MergedWriteChunkRequest>(
+        *batch->front().request, std::move(ops), &data);
+    batch->clear();
+    mergedCount_.fetch_add(1, std::memory_order_relaxed);
+    ProposeOne(Pending{merged, merged->GetChunkRequest(),
+                       merged->GetWriteData()});
+}
+
+void WriteCoalescer::ProposeOne(const Pending& pending) {
+    if (0 != pending.op->ProposeToRaft(pending.request, pending.data)) {
+        brpc::ClosureGuard doneGuard(pending.op->Closure());
+    }
+}
+
+}  // namespace chunkserver
+}  // namespace curve
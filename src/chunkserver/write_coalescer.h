@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_CHUNKSERVER_WRITE_COALESCER_H_
+#define SRC_CHUNKSERVER_WRITE_COALESCER_H_
+
+#include <bthread/mutex.h>
+#include <butil/iobuf.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "proto/chunk.pb.h"
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace chunkserver {
+
+class ChunkOpRequest;
+
+struct WriteCoalescerOptions {
+    // 合并后一次写入的最大字节数
+    uint32_t maxBytes = 128 * 1024;
+    // 发起合并前等待后续请求到达的时间，为0表示不等待，
+    // 只合并propose过程中积压的请求
+    uint32_t waitUs = 0;
+};
+
+/**
+ * copyset的写合并模块
+ * 开启后copyset所有需要propose的请求都先按到达顺序进入队列，由先到达的请求
+ * 负责依次propose。队列中对同一个chunk的相邻顺序小写会被合并成一个
+ * MergedWriteChunkRequest，只产生一条raft日志和一次pwrite，
+ * 执行结果再分发给各个原始请求。其他请求按原顺序单独propose。
+ */
+class WriteCoalescer : public curve::common::Uncopyable {
+ public:
+    explicit WriteCoalescer(const WriteCoalescerOptions& options);
+    ~WriteCoalescer() = default;
+
+    /**
+     * 提交一个请求，成功或失败都会在之后调用请求的done
+     * @param op: 需要propose的请求
+     * @param request: op的Chunk Request
+     * @param data: op的数据，需要保证在调用done之前有效
+     */
+    void Submit(std::shared_ptr<ChunkOpRequest> op,
+                const ChunkRequest* request,
+                const butil::IOBuf* data);
+
+    // 合并后propose的写请求个数
+    uint64_t MergedCount() const { return mergedCount_.load(); }
+
+ private:
+    struct Pending {
+        std::shared_ptr<ChunkOpRequest> op;
+        const ChunkRequest* request;
+        const butil::IOBuf* data;
+    };
+
+    // 判断next是否可以追加到合并的写请求batch之后
+    bool CanMerge(const std::vector<Pending>& batch, uint64_t batchBytes,
+                  const Pending& next) const;
+    void ProposeBatch(std::vector<Pending>* batch);
+    void ProposeOne(const Pending& pending);
+
+ private:
+    WriteCoalescerOptions options_;
+
+    bthread::Mutex mtx_;
+    std::vector<Pending> queue_;
+    // 是否有请求正在负责propose
+    bool draining_;
+    std::atomic<uint64_t> mergedCount_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_WRITE_COALESCER_H_
@@ -128,6 +128,12 @@ int ClientConfig::Init(const std::string& configpath) {
                           << fileServiceOption_.ioOpt.ioSenderOpt.failRequestOpt
                                  .chunkserverSlowRequestThresholdMS;
 
+    ret = conf_.GetUInt32Value("chunkserver.connectionNum",
+        &fileServiceOption_.ioOpt.ioSenderOpt.chunkserverConnectionNum);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.connectionNum info, using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.chunkserverConnectionNum;
+
     ret = conf_.GetUInt64Value("global.fileMaxInFlightRPCNum",
         &fileServiceOption_.ioOpt.ioSenderOpt.inflightOpt.fileMaxInFlightRPCNum);   // NOLINT
     LOG_IF(ERROR, ret == false) << "config no global.fileMaxInFlightRPCNum info";   // NOLINT
@@ -268,6 +274,65 @@ int ClientConfig::Init(const std::string& configpath) {
         << "config no throttle.enable info, using default value "
         << fileServiceOption_.ioOpt.throttleOption.enable;
 
+    ReadCacheOption& readCacheOpt = fileServiceOption_.ioOpt.readCacheOpt;
+    ret = conf_.GetBoolValue("readCache.enable", &readCacheOpt.enable);
+    LOG_IF(WARNING, ret == false)
+        << "config no readCache.enable info, using default value "
+        << readCacheOpt.enable;
+
+    ret = conf_.GetUInt32Value("readCache.blockSize",
+                               &readCacheOpt.blockSize);
+    LOG_IF(WARNING, ret == false)
+        << "config no readCache.blockSize info, using default value "
+        << readCacheOpt.blockSize;
+
+    ret = conf_.GetUInt64Value("readCache.memoryCapacityMB",
+                               &readCacheOpt.memoryCapacityMB);
+    LOG_IF(WARNING, ret == false)
+        << "config no readCache.memoryCapacityMB info, using default value "
+        << readCacheOpt.memoryCapacityMB;
+
+    ret = conf_.GetStringValue("readCache.ssdCachePath",
+                               &readCacheOpt.ssdCachePath);
+    LOG_IF(WARNING, ret == false)
+        << "config no readCache.ssdCachePath info, ssd cache is disabled";
+
+    ret = conf_.GetUInt64Value("readCache.ssdCapacityMB",
+                               &readCacheOpt.ssdCapacityMB);
+    LOG_IF(WARNING, ret == false)
+        << "config no readCache.ssdCapacityMB info, using default value "
+        << readCacheOpt.ssdCapacityMB;
+
+    ReadaheadOption& readaheadOpt = fileServiceOption_.ioOpt.readaheadOpt;
+    ret = conf_.GetBoolValue("readahead.enable", &readaheadOpt.enable);
+    LOG_IF(WARNING, ret == false)
+        << "config no readahead.enable info, using default value "
+        << readaheadOpt.enable;
+
+    ret = conf_.GetUInt32Value("readahead.triggerCount",
+                               &readaheadOpt.triggerCount);
+    LOG_IF(WARNING, ret == false)
+        << "config no readahead.triggerCount info, using default value "
+        << readaheadOpt.triggerCount;
+
+    ret = conf_.GetUInt64Value("readahead.minWindowKB",
+                               &readaheadOpt.minWindowKB);
+    LOG_IF(WARNING, ret == false)
+        << "config no readahead.minWindowKB info, using default value "
+        << readaheadOpt.minWindowKB;
+
+    ret = conf_.GetUInt64Value("readahead.maxWindowKB",
+                               &readaheadOpt.maxWindowKB);
+    LOG_IF(WARNING, ret == false)
+        << "config no readahead.maxWindowKB info, using default value "
+        << readaheadOpt.maxWindowKB;
+
+    ret = conf_.GetUInt32Value("readahead.maxStreams",
+                               &readaheadOpt.maxStreams);
+    LOG_IF(WARNING, ret == false)
+        << "config no readahead.maxStreams info, using default value "
+        << readaheadOpt.maxStreams;
+
     ret = conf_.GetBoolValue("discard.enable",
                              &fileServiceOption_.ioOpt.discardOption.enable);
     LOG_IF(ERROR, ret == false) << "config no discard.enable info";
@@ -25,6 +25,7 @@
 
 #include <bvar/bvar.h>
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -41,6 +42,11 @@ inline void GetStringValue(std::ostream& os, void* arg) {
     os << *static_cast<std::string*>(arg);
 }
 
+inline int64_t GetAtomicInt64Value(void* arg) {
+    return static_cast<std::atomic<int64_t>*>(arg)->load(
+        std::memory_order_relaxed);
+}
+
 struct SlowRequestMetric {
     bvar::Adder<uint64_t> count;
 
@@ -102,6 +108,50 @@ struct DiscardMetric {
     bvar::Adder<int64_t> pending;
 };
 
+// readahead of a file, shows how many of the prefetched bytes are useful
+struct ReadaheadMetric {
+    const std::string prefix = "curve_client";
+
+    // bytes prefetched
+    PerSecondMetric prefetchBytes;
+    // prefetches failed
+    bvar::Adder<uint64_t> prefetchError;
+    // bytes of sequential reads covered by finished prefetches
+    bvar::Adder<uint64_t> hitBytes;
+    // bytes of sequential reads whose prefetch was not finished yet
+    bvar::Adder<uint64_t> lateBytes;
+    // prefetched bytes not read before the stream was dropped
+    bvar::Adder<uint64_t> wastedBytes;
+    // latency of prefetches
+    bvar::LatencyRecorder latency;
+
+    explicit ReadaheadMetric(const std::string& name)
+        : prefetchBytes(prefix, name + "_prefetch_bytes"),
+          prefetchError(prefix, name + "_prefetch_error"),
+          hitBytes(prefix, name + "_hit_bytes"),
+          lateBytes(prefix, name + "_late_bytes"),
+          wastedBytes(prefix, name + "_wasted_bytes"),
+          latency(prefix, name + "_prefetch_lat") {}
+};
+
+// 与chunkserver之间一个连接的metric统计，进程内发往同一chunkserver的
+// 同一序号的连接共享同一个socket，所以该统计也是进程内共享的
+struct ConnectionMetric {
+    const std::string prefix = "curve_client";
+
+    // 连接上未返回的rpc数量，发送rpc时据此选择连接
+    std::atomic<int64_t> inflightRPC;
+    bvar::PassiveStatus<int64_t> inflightRPCNum;
+    // 连接上发送rpc的qps
+    PerSecondMetric rpc;
+
+    explicit ConnectionMetric(const std::string& name)
+        : inflightRPC(0),
+          inflightRPCNum(prefix, name + "_inflight_rpc_num",
+                         GetAtomicInt64Value, &inflightRPC),
+          rpc(prefix, name + "_rpc") {}
+};
+
 // 文件级别metric信息统计
 struct FileMetric {
     const std::string prefix = "curve_client";
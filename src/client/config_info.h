@@ -157,10 +157,13 @@ struct FailureRequestOption {
  * 发送rpc给chunkserver的配置
  * @inflightOpt: 一个文件向chunkserver发送请求时的inflight 请求控制配置
  * @failRequestOpt: rpc发送失败之后，需要进行rpc重试的相关配置
+ * @chunkserverConnectionNum: 与每个chunkserver之间的连接数，发送rpc时选择
+ *                            inflight rpc最少的连接
  */
 struct IOSenderOption {
     InFlightIOCntlInfo inflightOpt;
     FailureRequestOption failRequestOpt;
+    uint32_t chunkserverConnectionNum = 1;
 };
 
 /**
@@ -249,6 +252,40 @@ struct ThrottleOption {
     bool enable = false;
 };
 
+/**
+ * read cache of the file opened for writing
+ * @enable: whether to cache the data read and written by the client
+ * @blockSize: size of a cached block, must divide the chunk size
+ * @memoryCapacityMB: memory used by the cache of each file
+ * @ssdCachePath: directory on local ssd holding the blocks evicted from
+ *                memory, the ssd tier is disabled if it is empty
+ * @ssdCapacityMB: ssd space used by the cache of each file
+ */
+struct ReadCacheOption {
+    bool enable = false;
+    uint32_t blockSize = 4096;
+    uint64_t memoryCapacityMB = 256;
+    std::string ssdCachePath;
+    uint64_t ssdCapacityMB = 0;
+};
+
+/**
+ * readahead of sequential reads, the prefetched data is kept in the read
+ * cache, so it only works when the read cache is enabled
+ * @enable: whether to prefetch for sequential reads
+ * @triggerCount: number of sequential reads of a stream before prefetching
+ * @minWindowKB: initial prefetch window of a stream
+ * @maxWindowKB: max prefetch window of a stream
+ * @maxStreams: max number of sequential streams tracked for each file
+ */
+struct ReadaheadOption {
+    bool enable = false;
+    uint32_t triggerCount = 3;
+    uint64_t minWindowKB = 512;
+    uint64_t maxWindowKB = 8192;
+    uint32_t maxStreams = 4;
+};
+
 /**
  * IOOption存储了当前io 操作所需要的所有配置信息
  */
@@ -261,6 +298,8 @@ struct IOOption {
     CloseFdThreadOption closeFdThreadOption;
     ThrottleOption throttleOption;
     DiscardOption discardOption;
+    ReadCacheOption readCacheOpt;
+    ReadaheadOption readaheadOpt;
 };
 
 /**
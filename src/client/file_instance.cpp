@@ -190,6 +190,62 @@ int FileInstance::AioDiscard(CurveAioContext *aioctx) {
     return -1;
 }
 
+int FileInstance::AioSubmit(const CurveAioRequest* requests, int count) {
+    for (int i = 0; i < count; ++i) {
+        const CurveAioRequest& request = requests[i];
+        const CurveAioContext* aioctx = request.ctx;
+        if (CURVE_UNLIKELY(aioctx == nullptr || aioctx->cb == nullptr)) {
+            LOG(ERROR) << "invalid aio context, index: " << i;
+            return -LIBCURVE_ERROR::PARAM_ERROR;
+        }
+
+        switch (aioctx->op) {
+            case LIBCURVE_OP_READ:
+                break;
+            case LIBCURVE_OP_WRITE:
+            case LIBCURVE_OP_DISCARD:
+                if (CURVE_UNLIKELY(readonly_)) {
+                    LOG(ERROR) << "Open with read only, not support write "
+                                  "and discard";
+                    return -LIBCURVE_ERROR::FAILED;
+                }
+                break;
+            default:
+                LOG(ERROR) << "invalid aio op: " << aioctx->op;
+                return -LIBCURVE_ERROR::PARAM_ERROR;
+        }
+
+        if (request.iov != nullptr) {
+            size_t total = 0;
+            for (int j = 0; j < request.iovcnt; ++j) {
+                total += request.iov[j].iov_len;
+            }
+            if (CURVE_UNLIKELY(aioctx->op == LIBCURVE_OP_DISCARD ||
+                               request.iovcnt <= 0 ||
+                               total != aioctx->length)) {
+                LOG(ERROR) << "invalid iovec, op: " << aioctx->op
+                           << ", iovcnt: " << request.iovcnt
+                           << ", iov length: " << total
+                           << ", length: " << aioctx->length;
+                return -LIBCURVE_ERROR::PARAM_ERROR;
+            }
+        }
+
+        if (CURVE_UNLIKELY(aioctx->op != LIBCURVE_OP_DISCARD &&
+                           !CheckAlign(aioctx->offset, aioctx->length,
+                                       blocksize_))) {
+            LOG(ERROR) << "IO not aligned, off: " << aioctx->offset
+                       << ", length: " << aioctx->length
+                       << ", block size: " << blocksize_;
+            return -LIBCURVE_ERROR::NOT_ALIGNED;
+        }
+    }
+
+    DLOG_EVERY_SECOND(INFO) << "begin AioSubmit " << finfo_.fullPathName
+                            << ", count = " << count;
+    return iomanager4file_.AioSubmit(requests, count, mdsclient_.get());
+}
+
 // 两种场景会造成在Open的时候返回LIBCURVE_ERROR::FILE_OCCUPIED
 // 1. 强制重启qemu不会调用close逻辑，然后启动的时候原来的文件sessio还没过期.
 //    导致再次去发起open的时候，返回被占用，这种情况可以通过load sessionmap
@@ -213,6 +269,7 @@ int FileInstance::Open(std::string* sessionId) {
             sessionId->assign(lease.sessionID);
         }
         iomanager4file_.UpdateFileEpoch(fEpoch);
+        iomanager4file_.EnableReadCache(finfo_.chunksize);
         blocksize_ = finfo_.blocksize;
     }
     return -ret;
@@ -109,6 +109,16 @@ class CURVE_CACHELINE_ALIGNMENT FileInstance {
      */
     int AioDiscard(CurveAioContext* aioctx);
 
+    /**
+     * @brief Submit a batch of asynchronous requests, all the requests are
+     *        checked before any of them is submitted
+     * @param requests requests to submit, see CurveAioRequest
+     * @param count number of requests
+     * @return 0 means all the requests are submitted, otherwise none of
+     *         them is submitted and no callback is called
+     */
+    int AioSubmit(const CurveAioRequest* requests, int count);
+
     int Close();
 
     void UnInitialize();
@@ -0,0 +1,410 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/client/file_read_cache.h"
+
+#include <glog/logging.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace curve {
+namespace client {
+
+using curve::common::CacheMetrics;
+
+FileReadCache::FileReadCache(const ReadCacheOption& option,
+                             uint64_t chunkSize,
+                             const std::string& metricPrefix)
+    : option_(option),
+      blockSize_(option.blockSize),
+      chunkSize_(chunkSize),
+      metricPrefix_(metricPrefix),
+      sequence_(0),
+      dropSequence_(0),
+      ssdFd_(-1) {}
+
+FileReadCache::~FileReadCache() {
+    if (ssdFd_ >= 0) {
+        ::close(ssdFd_);
+    }
+}
+
+bool FileReadCache::Init() {
+    if (blockSize_ == 0 || chunkSize_ == 0 || chunkSize_ % blockSize_ != 0) {
+        LOG(ERROR) << "Invalid read cache block size " << blockSize_
+                   << ", chunk size " << chunkSize_;
+        return false;
+    }
+
+    // ARCCache keeps half of max_count resident, the rest are ghost keys
+    uint64_t blockNum = std::max<uint64_t>(
+        option_.memoryCapacityMB * 1024 * 1024 / blockSize_, 1);
+    memoryCache_.reset(new BlockARCCache(2 * blockNum,
+        std::make_shared<CacheMetrics>(metricPrefix_ + "_memory")));
+
+    uint64_t slotNum = option_.ssdCapacityMB * 1024 * 1024 / blockSize_;
+    if (option_.ssdCachePath.empty() || slotNum == 0) {
+        return true;
+    }
+
+    std::string path = option_.ssdCachePath + "/curve_read_cache_XXXXXX";
+    std::vector<char> pathTemplate(path.begin(), path.end());
+    pathTemplate.push_back('\0');
+    int fd = ::mkstemp(pathTemplate.data());
+    if (fd < 0) {
+        LOG(ERROR) << "Create read cache file in " << option_.ssdCachePath
+                   << " failed, errno = " << errno;
+        return false;
+    }
+    // the space is released when the file is closed, even if the client
+    // crashes
+    ::unlink(pathTemplate.data());
+
+    ssdFd_ = fd;
+    // the slots are recycled by the cache itself, so the index is unbounded
+    ssdIndex_.reset(new SlotLRUCache());
+    slots_.resize(slotNum);
+    freeSlots_.reserve(slotNum);
+    for (uint64_t slot = slotNum; slot > 0; --slot) {
+        freeSlots_.push_back(slot - 1);
+    }
+    ssdMetrics_ = std::make_shared<CacheMetrics>(metricPrefix_ + "_ssd");
+    return true;
+}
+
+bool FileReadCache::Read(off_t offset, size_t length, butil::IOBuf* data) {
+    if (length == 0) {
+        return false;
+    }
+
+    uint64_t beginIndex = offset / blockSize_;
+    uint64_t endIndex = (offset + length - 1) / blockSize_;
+    std::vector<CachedBlockPtr> blocks;
+    blocks.reserve(endIndex - beginIndex + 1);
+    for (uint64_t index = beginIndex; index <= endIndex; ++index) {
+        CachedBlockPtr block;
+        bool hit = false;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            hit = GetLocked(index, &block);
+        }
+        if (!hit && !ReadFromSsd(index, &block)) {
+            return false;
+        }
+        blocks.push_back(std::move(block));
+    }
+
+    butil::IOBuf result;
+    uint64_t pos = offset;
+    uint64_t end = offset + length;
+    for (const auto& block : blocks) {
+        uint64_t blockOffset = block->index * blockSize_;
+        uint64_t len = std::min<uint64_t>(end, blockOffset + blockSize_) - pos;
+        result.append(block->data.data() + (pos - blockOffset), len);
+        pos += len;
+    }
+    data->swap(result);
+    return true;
+}
+
+uint64_t FileReadCache::BeginFill() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return ++sequence_;
+}
+
+void FileReadCache::Fill(uint64_t ticket, off_t offset,
+                         const butil::IOBuf& data, bool prefetched) {
+    std::vector<CachedBlockPtr> blocks;
+    SplitBlocks(offset, data, &blocks);
+    if (blocks.empty()) {
+        return;
+    }
+
+    std::vector<PendingSpill> spills;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        FillLocked(ticket, prefetched, blocks, &spills);
+    }
+    Spill(spills);
+}
+
+void FileReadCache::Invalidate(off_t offset, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lk(mtx_);
+    InvalidateLocked(offset / blockSize_, (offset + length - 1) / blockSize_);
+}
+
+void FileReadCache::WriteThrough(uint64_t ticket, off_t offset,
+                                 const butil::IOBuf& data) {
+    if (data.empty()) {
+        return;
+    }
+
+    std::vector<CachedBlockPtr> blocks;
+    SplitBlocks(offset, data, &blocks);
+
+    uint64_t beginIndex = offset / blockSize_;
+    uint64_t endIndex = (offset + data.size() - 1) / blockSize_;
+    std::vector<PendingSpill> spills;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        // another write of the chunks finished in the meantime, the order
+        // in which the chunkservers applied them is unknown
+        bool stale = ModifiedSinceLocked(ticket, beginIndex, endIndex);
+        InvalidateLocked(beginIndex, endIndex);
+        if (!stale) {
+            FillLocked(sequence_, false, blocks, &spills);
+        }
+    }
+    Spill(spills);
+}
+
+void FileReadCache::Drop() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    // the blocks are left in the cache until evicted, but the tickets they
+    // were filled with are not valid any more
+    dropSequence_ = ++sequence_;
+    modified_.clear();
+
+    if (ssdFd_ < 0) {
+        return;
+    }
+    // recycle the slots at once, the file is much larger than the memory
+    uint64_t count = ssdIndex_->Size();
+    ssdMetrics_->cacheCount << (0 - static_cast<uint32_t>(count));
+    ssdMetrics_->UpdateRemoveFromCacheBytes(count * blockSize_);
+    ssdIndex_.reset(new SlotLRUCache());
+    freeSlots_.clear();
+    for (uint64_t slot = slots_.size(); slot > 0; --slot) {
+        Slot& s = slots_[slot - 1];
+        ++s.version;
+        s.ticket = 0;
+        s.ready = false;
+        if (!s.writing) {
+            freeSlots_.push_back(slot - 1);
+        }
+    }
+}
+
+bool FileReadCache::ModifiedSinceLocked(uint64_t ticket,
+                                        uint64_t beginIndex,
+                                        uint64_t endIndex) const {
+    if (ticket <= dropSequence_) {
+        return true;
+    }
+    for (uint64_t chunk = ChunkIndex(beginIndex);
+         chunk <= ChunkIndex(endIndex); ++chunk) {
+        auto iter = modified_.find(chunk);
+        if (iter != modified_.end() && iter->second > ticket) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FileReadCache::InvalidateLocked(uint64_t beginIndex,
+                                     uint64_t endIndex) {
+    uint64_t sequence = ++sequence_;
+    for (uint64_t chunk = ChunkIndex(beginIndex);
+         chunk <= ChunkIndex(endIndex); ++chunk) {
+        modified_[chunk] = sequence;
+    }
+    for (uint64_t index = beginIndex; index <= endIndex; ++index) {
+        memoryCache_->Remove(index);
+        ReleaseSlotLocked(index);
+    }
+}
+
+void FileReadCache::SplitBlocks(off_t offset, const butil::IOBuf& data,
+                                std::vector<CachedBlockPtr>* blocks) const {
+    uint64_t end = offset + data.size();
+    for (uint64_t index = (offset + blockSize_ - 1) / blockSize_;
+         (index + 1) * blockSize_ <= end; ++index) {
+        auto block = std::make_shared<CachedBlock>();
+        block->index = index;
+        block->ticket = 0;
+        block->prefetched = false;
+        data.copy_to(&block->data, blockSize_, index * blockSize_ - offset);
+        blocks->push_back(std::move(block));
+    }
+}
+
+void FileReadCache::FillLocked(uint64_t ticket, bool prefetched,
+                               const std::vector<CachedBlockPtr>& blocks,
+                               std::vector<PendingSpill>* spills) {
+    for (const auto& block : blocks) {
+        if (ModifiedSinceLocked(ticket, block->index, block->index)) {
+            continue;
+        }
+        block->ticket = ticket;
+        block->prefetched = prefetched;
+        InsertLocked(block, spills);
+    }
+}
+
+void FileReadCache::InsertLocked(const CachedBlockPtr& block,
+                                 std::vector<PendingSpill>* spills) {
+    CachedBlockPtr evicted;
+    if (memoryCache_->Put(block->index, block, &evicted) && evicted &&
+        evicted->ticket > dropSequence_ && ssdFd_ >= 0) {
+        ReserveSlotLocked(evicted, spills);
+    }
+}
+
+bool FileReadCache::GetLocked(uint64_t index, CachedBlockPtr* block) {
+    if (!memoryCache_->Get(index, block, &FileReadCache::ShouldPromote)) {
+        return false;
+    }
+    if ((*block)->ticket <= dropSequence_) {
+        memoryCache_->Remove(index);
+        return false;
+    }
+    (*block)->prefetched = false;
+    return true;
+}
+
+void FileReadCache::ReserveSlotLocked(const CachedBlockPtr& block,
+                                      std::vector<PendingSpill>* spills) {
+    uint64_t slot;
+    if (ssdIndex_->Get(block->index, &slot)) {
+        // the block promoted from ssd is still there
+        if (slots_[slot].ticket > dropSequence_) {
+            return;
+        }
+        ReleaseSlotLocked(block->index);
+    }
+
+    if (freeSlots_.empty()) {
+        uint64_t oldest;
+        if (!ssdIndex_->GetLast(&oldest, &slot)) {
+            return;
+        }
+        ReleaseSlotLocked(oldest);
+        if (freeSlots_.empty()) {
+            return;
+        }
+    }
+
+    slot = freeSlots_.back();
+    freeSlots_.pop_back();
+    Slot& s = slots_[slot];
+    ++s.version;
+    s.ticket = block->ticket;
+    s.ready = false;
+    s.writing = true;
+    ssdIndex_->Put(block->index, slot);
+    ssdMetrics_->UpdateAddToCacheCount();
+    ssdMetrics_->UpdateAddToCacheBytes(blockSize_);
+    spills->push_back({slot, s.version, block});
+}
+
+void FileReadCache::ReleaseSlotLocked(uint64_t index) {
+    uint64_t slot;
+    if (ssdFd_ < 0 || !ssdIndex_->Get(index, &slot)) {
+        return;
+    }
+    ssdIndex_->Remove(index);
+    Slot& s = slots_[slot];
+    ++s.version;
+    s.ticket = 0;
+    s.ready = false;
+    if (!s.writing) {
+        freeSlots_.push_back(slot);
+    }
+    ssdMetrics_->UpdateRemoveFromCacheCount();
+    ssdMetrics_->UpdateRemoveFromCacheBytes(blockSize_);
+}
+
+void FileReadCache::Spill(const std::vector<PendingSpill>& spills) {
+    for (const auto& spill : spills) {
+        ssize_t ret = ::pwrite(ssdFd_, spill.block->data.data(), blockSize_,
+                               spill.slot * blockSize_);
+        std::lock_guard<std::mutex> lk(mtx_);
+        Slot& s = slots_[spill.slot];
+        s.writing = false;
+        if (s.version != spill.version) {
+            // released during the write
+            freeSlots_.push_back(spill.slot);
+            continue;
+        }
+        if (ret == static_cast<ssize_t>(blockSize_)) {
+            s.ready = true;
+        } else {
+            LOG(WARNING) << "Write read cache file failed, ret = " << ret
+                         << ", errno = " << errno;
+            ReleaseSlotLocked(spill.block->index);
+        }
+    }
+}
+
+bool FileReadCache::ReadFromSsd(uint64_t index, CachedBlockPtr* block) {
+    if (ssdFd_ < 0) {
+        return false;
+    }
+
+    uint64_t slot;
+    uint64_t version;
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (!ssdIndex_->Get(index, &slot) || !slots_[slot].ready ||
+            slots_[slot].ticket <= dropSequence_) {
+            ssdMetrics_->OnCacheMiss();
+            return false;
+        }
+        version = slots_[slot].version;
+        ticket = slots_[slot].ticket;
+    }
+
+    // read without the lock held, the slot may be reused in the meantime
+    auto result = std::make_shared<CachedBlock>();
+    result->index = index;
+    result->ticket = ticket;
+    result->prefetched = false;
+    result->data.resize(blockSize_);
+    ssize_t ret = ::pread(ssdFd_, &result->data[0], blockSize_,
+                          slot * blockSize_);
+
+    std::vector<PendingSpill> spills;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (slots_[slot].version != version ||
+            ticket <= dropSequence_) {
+            ssdMetrics_->OnCacheMiss();
+            return false;
+        }
+        if (ret != static_cast<ssize_t>(blockSize_)) {
+            LOG(WARNING) << "Read read cache file failed, ret = " << ret
+                         << ", errno = " << errno;
+            ReleaseSlotLocked(index);
+            ssdMetrics_->OnCacheMiss();
+            return false;
+        }
+        ssdMetrics_->OnCacheHit();
+        InsertLocked(result, &spills);
+    }
+    Spill(spills);
+
+    *block = std::move(result);
+    return true;
+}
+
+}  // namespace client
+}  // namespace curve
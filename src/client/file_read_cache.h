@@ -0,0 +1,232 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_CLIENT_FILE_READ_CACHE_H_
+#define SRC_CLIENT_FILE_READ_CACHE_H_
+
+#include <butil/iobuf.h>
+#include <sys/types.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/client/config_info.h"
+#include "src/common/lru_cache.h"
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace client {
+
+/**
+ * Read cache of one opened file, blocks are kept in memory and spilled to
+ * an optional file on local ssd when evicted from memory.
+ *
+ * The cache is only used by the client that opened the file for writing,
+ * so all the modifications of the file go through this cache:
+ * a read that misses takes a ticket with BeginFill before sending the
+ * requests, and the blocks are only inserted by Fill if the chunks they
+ * belong to have not been modified since. Writes and discards invalidate
+ * the range after they are finished, and a successful write puts its data
+ * into the cache if no other modification of the chunks finished in the
+ * meantime. When the lease or the epoch of the file is lost, another
+ * client may modify the file, so all the blocks are dropped.
+ */
+class FileReadCache : public curve::common::Uncopyable {
+ public:
+    /**
+     * @param option: the options of the cache
+     * @param chunkSize: chunk size of the file, modifications are tracked
+     *                   per chunk
+     * @param metricPrefix: prefix of the hit/miss/bytes metrics
+     */
+    FileReadCache(const ReadCacheOption& option, uint64_t chunkSize,
+                  const std::string& metricPrefix);
+    ~FileReadCache();
+
+    /**
+     * @brief create the memory tier, and the ssd tier if it is configured
+     * @return true on success, false if the block size is invalid or the
+     *         cache file can not be created
+     */
+    bool Init();
+
+    /**
+     * @brief read the range from the cache
+     * @param[out] data: the data of the range if all of it is cached
+     * @return true if the whole range is cached
+     */
+    bool Read(off_t offset, size_t length, butil::IOBuf* data);
+
+    /**
+     * @brief take a ticket before sending the requests of a read or write
+     */
+    uint64_t BeginFill();
+
+    /**
+     * @brief insert the blocks fully covered by the data read from
+     *        chunkservers, they are dropped if the chunks have been
+     *        modified after the ticket was taken
+     * @param prefetched: the data is read ahead of the user, the first read
+     *                    of the user does not promote the blocks to the
+     *                    frequency list of the memory tier
+     */
+    void Fill(uint64_t ticket, off_t offset, const butil::IOBuf& data,
+              bool prefetched = false);
+
+    /**
+     * @brief invalidate the blocks overlapping with the range after it is
+     *        written or discarded
+     */
+    void Invalidate(off_t offset, size_t length);
+
+    /**
+     * @brief invalidate the range after a successful write, and insert the
+     *        blocks fully covered by the written data if no other
+     *        modification of the chunks finished after the ticket was taken
+     */
+    void WriteThrough(uint64_t ticket, off_t offset,
+                      const butil::IOBuf& data);
+
+    /**
+     * @brief drop all the cached blocks
+     */
+    void Drop();
+
+    uint32_t BlockSize() const { return blockSize_; }
+
+ private:
+    struct CachedBlock {
+        uint64_t index;
+        // the ticket of the read or write that filled the block
+        uint64_t ticket;
+        // filled by a prefetch and not read by the user yet
+        bool prefetched;
+        std::string data;
+    };
+    using CachedBlockPtr = std::shared_ptr<CachedBlock>;
+
+    // the first hit of a prefetched block is the first access of the user,
+    // so it stays in the recency list
+    static bool ShouldPromote(const CachedBlockPtr& block) {
+        return !block->prefetched;
+    }
+
+    struct CachedBlockTraits {
+        static uint64_t CountBytes(const CachedBlockPtr& block) {
+            return block->data.size();
+        }
+    };
+
+    // ARC keeps blocks read more than once from being flushed by scans
+    using BlockARCCache = curve::common::ARCCache<uint64_t, CachedBlockPtr,
+        curve::common::CacheTraits<uint64_t>, CachedBlockTraits>;
+    // block index -> slot of the ssd cache file
+    using SlotLRUCache = curve::common::LRUCache<uint64_t, uint64_t>;
+
+    struct Slot {
+        // bumped every time the slot is allocated or released, a reader
+        // checks it after reading the slot without the lock held
+        uint64_t version = 0;
+        uint64_t ticket = 0;
+        // the block has been written to the slot
+        bool ready = false;
+        // a block is being written to the slot, the slot is not reused
+        // until the write is finished
+        bool writing = false;
+    };
+
+    // a block to be written to the ssd tier after the lock is released
+    struct PendingSpill {
+        uint64_t slot;
+        uint64_t version;
+        CachedBlockPtr block;
+    };
+
+    uint64_t ChunkIndex(uint64_t blockIndex) const {
+        return blockIndex * blockSize_ / chunkSize_;
+    }
+
+    // whether the chunks of [beginIndex, endIndex] were modified after the
+    // ticket was taken, called with mtx_ held
+    bool ModifiedSinceLocked(uint64_t ticket, uint64_t beginIndex,
+                             uint64_t endIndex) const;
+
+    // mark the chunks modified and remove the blocks in [beginIndex,
+    // endIndex], called with mtx_ held
+    void InvalidateLocked(uint64_t beginIndex, uint64_t endIndex);
+
+    // copy the blocks fully covered by the data
+    void SplitBlocks(off_t offset, const butil::IOBuf& data,
+                     std::vector<CachedBlockPtr>* blocks) const;
+
+    // insert the blocks whose chunks were not modified after the ticket
+    // was taken, called with mtx_ held
+    void FillLocked(uint64_t ticket, bool prefetched,
+                    const std::vector<CachedBlockPtr>& blocks,
+                    std::vector<PendingSpill>* spills);
+
+    // insert a block into memory, the evicted block is spilled to ssd,
+    // called with mtx_ held
+    void InsertLocked(const CachedBlockPtr& block,
+                      std::vector<PendingSpill>* spills);
+
+    // get a block from memory, called with mtx_ held
+    bool GetLocked(uint64_t index, CachedBlockPtr* block);
+
+    // reserve a slot of the ssd tier for the block, called with mtx_ held
+    void ReserveSlotLocked(const CachedBlockPtr& block,
+                           std::vector<PendingSpill>* spills);
+
+    void ReleaseSlotLocked(uint64_t index);
+
+    // write the blocks to the ssd tier, called without mtx_ held
+    void Spill(const std::vector<PendingSpill>& spills);
+
+    // read a block from the ssd tier and promote it to memory
+    bool ReadFromSsd(uint64_t index, CachedBlockPtr* block);
+
+ private:
+    const ReadCacheOption option_;
+    const uint32_t blockSize_;
+    const uint64_t chunkSize_;
+    const std::string metricPrefix_;
+
+    std::mutex mtx_;
+    // tickets are taken from the same sequence as the modifications
+    uint64_t sequence_;
+    // blocks filled with a ticket before the last drop are not valid
+    uint64_t dropSequence_;
+    // chunk index -> sequence of the last modification
+    std::unordered_map<uint64_t, uint64_t> modified_;
+
+    std::unique_ptr<BlockARCCache> memoryCache_;
+
+    // ssd tier, disabled if ssdFd_ < 0
+    int ssdFd_;
+    std::unique_ptr<SlotLRUCache> ssdIndex_;
+    std::vector<Slot> slots_;
+    std::vector<uint64_t> freeSlots_;
+    std::shared_ptr<curve::common::CacheMetrics> ssdMetrics_;
+};
+
+}  // namespace client
+}  // namespace curve
+
+#endif  // SRC_CLIENT_FILE_READ_CACHE_H_
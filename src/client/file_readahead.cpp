@@ -0,0 +1,207 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/client/file_readahead.h"
+
+#include <algorithm>
+
+#include "src/common/timeutility.h"
+
+namespace curve {
+namespace client {
+
+using curve::common::TimeUtility;
+
+namespace {
+
+// weight of a new sample in the moving averages
+const double kSampleWeight = 0.2;
+
+double MovingAverage(double average, double sample) {
+    if (average == 0) {
+        return sample;
+    }
+    return average * (1 - kSampleWeight) + sample * kSampleWeight;
+}
+
+}  // namespace
+
+FileReadahead::FileReadahead(const ReadaheadOption& option,
+                             uint32_t blockSize,
+                             const std::string& metricName)
+    : triggerCount_(option.triggerCount),
+      minWindow_(std::max<uint64_t>(option.minWindowKB * 1024, blockSize)),
+      maxWindow_(std::max<uint64_t>(option.maxWindowKB * 1024,
+                                    minWindow_)),
+      blockSize_(blockSize),
+      streams_(std::max<uint32_t>(option.maxStreams, 1)),
+      generation_(0),
+      latencyUs_(0),
+      metric_(metricName) {}
+
+bool FileReadahead::OnRead(uint64_t offset, uint64_t length,
+                           uint64_t fileLength, ReadaheadRange* range) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    bool sequential = false;
+    Stream* stream = MatchLocked(offset, &sequential);
+    uint64_t now = TimeUtility::GetTimeofDayUs();
+    uint64_t end = offset + length;
+
+    if (!sequential) {
+        stream->generation = ++generation_;
+        stream->nextOffset = end;
+        stream->sequentialCount = 1;
+        stream->window = minWindow_;
+        stream->lastReadUs = now;
+        return false;
+    }
+
+    if (now > stream->lastReadUs) {
+        stream->readRate = MovingAverage(
+            stream->readRate,
+            static_cast<double>(length) / (now - stream->lastReadUs));
+    }
+    stream->lastReadUs = now;
+    ++stream->sequentialCount;
+    stream->nextOffset = std::max(stream->nextOffset, end);
+
+    if (stream->prefetchEnd != 0 && offset >= stream->prefetchBegin &&
+        end <= stream->prefetchEnd) {
+        if (end <= stream->readyEnd) {
+            metric_.hitBytes << length;
+        } else {
+            // the prefetch is not far enough ahead of the reader
+            metric_.lateBytes << length;
+            if (!stream->late) {
+                stream->late = true;
+                stream->window = std::min(2 * stream->window, maxWindow_);
+            }
+        }
+    }
+
+    if (stream->sequentialCount < triggerCount_ || stream->inflight) {
+        return false;
+    }
+
+    UpdateWindowLocked(stream);
+
+    // enough data is prefetched ahead of the reader
+    uint64_t begin = std::max(stream->prefetchEnd, stream->nextOffset);
+    if (begin - stream->nextOffset >= stream->window / 2) {
+        return false;
+    }
+
+    begin = begin / blockSize_ * blockSize_;
+    uint64_t limit = std::min(stream->nextOffset + stream->window, fileLength);
+    limit = limit / blockSize_ * blockSize_;
+    if (limit <= begin) {
+        return false;
+    }
+
+    if (stream->prefetchEnd < begin) {
+        // the reader has passed all the prefetched data
+        stream->prefetchBegin = begin;
+        stream->readyEnd = begin;
+    }
+    stream->prefetchEnd = limit;
+    stream->inflight = true;
+    stream->late = false;
+
+    range->stream = stream - streams_.data();
+    range->generation = stream->generation;
+    range->offset = begin;
+    range->length = limit - begin;
+    metric_.prefetchBytes.count << range->length;
+    return true;
+}
+
+void FileReadahead::OnPrefetchDone(const ReadaheadRange& range, bool success,
+                                   uint64_t latencyUs) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (success) {
+        latencyUs_ = MovingAverage(latencyUs_, latencyUs);
+        metric_.latency << latencyUs;
+    } else {
+        metric_.prefetchError << 1;
+    }
+
+    Stream& stream = streams_[range.stream];
+    if (stream.generation != range.generation) {
+        return;
+    }
+
+    stream.inflight = false;
+    if (success) {
+        stream.readyEnd = range.offset + range.length;
+    } else {
+        // prefetch the range again at the next sequential read
+        stream.prefetchEnd = std::max(range.offset, stream.readyEnd);
+    }
+}
+
+void FileReadahead::Reset() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (auto& stream : streams_) {
+        stream = Stream();
+    }
+}
+
+FileReadahead::Stream* FileReadahead::MatchLocked(uint64_t offset,
+                                                  bool* sequential) {
+    Stream* victim = nullptr;
+    for (auto& stream : streams_) {
+        if (stream.generation == 0) {
+            if (victim == nullptr || victim->generation != 0) {
+                victim = &stream;
+            }
+            continue;
+        }
+
+        // reads of a stream may be reordered by the io queue of the guest
+        if (offset + minWindow_ >= stream.nextOffset &&
+            offset <= stream.nextOffset + minWindow_) {
+            *sequential = true;
+            return &stream;
+        }
+
+        if (victim == nullptr ||
+            (victim->generation != 0 &&
+             stream.lastReadUs < victim->lastReadUs)) {
+            victim = &stream;
+        }
+    }
+
+    if (victim->prefetchEnd > victim->nextOffset) {
+        metric_.wastedBytes
+            << victim->prefetchEnd -
+                   std::max(victim->nextOffset, victim->prefetchBegin);
+    }
+    *victim = Stream();
+    *sequential = false;
+    return victim;
+}
+
+void FileReadahead::UpdateWindowLocked(Stream* stream) {
+    // the data consumed by the reader while two prefetches are sent
+    uint64_t target =
+        static_cast<uint64_t>(stream->readRate * latencyUs_ * 2);
+    uint64_t window = std::max(stream->window, std::min(target,
+                                                        2 * stream->window));
+    stream->window = std::max(std::min(window, maxWindow_), minWindow_);
+}
+
+}  // namespace client
+}  // namespace curve
@@ -0,0 +1,138 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_CLIENT_FILE_READAHEAD_H_
+#define SRC_CLIENT_FILE_READAHEAD_H_
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "src/client/client_metric.h"
+#include "src/client/config_info.h"
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace client {
+
+// a prefetch decided by the readahead
+struct ReadaheadRange {
+    // index of the stream
+    uint32_t stream = 0;
+    // generation of the stream, the prefetches of a replaced stream are
+    // ignored when they are finished
+    uint64_t generation = 0;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
+
+/**
+ * Sequential read detection of one opened file.
+ *
+ * Every read is matched against a few streams, a read starting near the
+ * end of the last read of a stream continues it, otherwise it replaces the
+ * least recently used stream. After triggerCount sequential reads, a stream
+ * keeps one prefetch in flight ahead of the reader. The prefetched data is
+ * put into the read cache of the file by the caller, so random reads and
+ * the data read by the user are not affected.
+ *
+ * The window of a stream starts at minWindowKB, it is doubled when the
+ * reader catches up with an unfinished prefetch, and grows to cover the
+ * data consumed by the reader during two prefetch latencies, but never more
+ * than doubled at once, and never larger than maxWindowKB.
+ */
+class FileReadahead : public curve::common::Uncopyable {
+ public:
+    /**
+     * @param option: the options of the readahead
+     * @param blockSize: block size of the read cache, prefetches are
+     *                   aligned to it
+     * @param metricName: name of the metrics
+     */
+    FileReadahead(const ReadaheadOption& option, uint32_t blockSize,
+                  const std::string& metricName);
+
+    /**
+     * @brief record a read of the user
+     * @param fileLength: length of the file, prefetches do not go beyond it
+     * @param[out] range: the range to prefetch
+     * @return true if the caller should prefetch the range, and report the
+     *         result by OnPrefetchDone
+     */
+    bool OnRead(uint64_t offset, uint64_t length, uint64_t fileLength,
+                ReadaheadRange* range);
+
+    /**
+     * @brief a prefetch returned by OnRead is finished
+     * @param latencyUs: time spent by the prefetch
+     */
+    void OnPrefetchDone(const ReadaheadRange& range, bool success,
+                        uint64_t latencyUs);
+
+    /**
+     * @brief forget all the streams, called when the read cache is dropped
+     */
+    void Reset();
+
+ private:
+    struct Stream {
+        // 0 means the stream is not used
+        uint64_t generation = 0;
+        // expected offset of the next read
+        uint64_t nextOffset = 0;
+        uint32_t sequentialCount = 0;
+        uint64_t window = 0;
+        // [prefetchBegin, readyEnd) is prefetched, and
+        // [readyEnd, prefetchEnd) is being prefetched
+        uint64_t prefetchBegin = 0;
+        uint64_t readyEnd = 0;
+        uint64_t prefetchEnd = 0;
+        bool inflight = false;
+        // the reader has caught up with the prefetch in flight
+        bool late = false;
+        uint64_t lastReadUs = 0;
+        // bytes read by the user per microsecond
+        double readRate = 0;
+    };
+
+    // find the stream continued by the read, or replace the least recently
+    // used one, called with mtx_ held
+    Stream* MatchLocked(uint64_t offset, bool* sequential);
+
+    // adjust the window of the stream before prefetching, called with
+    // mtx_ held
+    void UpdateWindowLocked(Stream* stream);
+
+ private:
+    const uint32_t triggerCount_;
+    const uint64_t minWindow_;
+    const uint64_t maxWindow_;
+    const uint32_t blockSize_;
+
+    std::mutex mtx_;
+    std::vector<Stream> streams_;
+    uint64_t generation_;
+    // average latency of prefetches
+    double latencyUs_;
+
+    ReadaheadMetric metric_;
+};
+
+}  // namespace client
+}  // namespace curve
+
+#endif  // SRC_CLIENT_FILE_READAHEAD_H_
@@ -35,6 +35,7 @@
 #include "src/client/source_reader.h"
 #include "src/client/metacache_struct.h"
 #include "src/client/discard_task.h"
+#include "src/client/file_read_cache.h"
 
 namespace curve {
 namespace client {
@@ -53,7 +54,10 @@ IOTracker::IOTracker(IOManager* iomanager,
       scheduler_(scheduler),
       iomanager_(iomanager),
       fileMetric_(clientMetric),
-      disableStripe_(disableStripe) {
+      disableStripe_(disableStripe),
+      readCache_(nullptr),
+      readCacheTicket_(0),
+      readahead_(false) {
     id_         = tracekerID_.fetch_add(1, std::memory_order_relaxed);
     scc_        = nullptr;
     aioctx_     = nullptr;
@@ -106,6 +110,17 @@ void IOTracker::DoRead(MDSClient* mdsclient, const FInfo_t* fileInfo,
         throttle->Add(true, length_);
     }
 
+    if (readCache_ != nullptr) {
+        butil::IOBuf cached;
+        if (readCache_->Read(offset_, length_, &cached)) {
+            PrepareReadIOBuffers(1);
+            SetReadData(0, cached);
+            Done();
+            return;
+        }
+        readCacheTicket_ = readCache_->BeginFill();
+    }
+
     int ret = Splitor::IO2ChunkRequests(this, mc_, &reqlist_, nullptr, offset_,
                                         length_, mdsclient, fileInfo, nullptr);
     if (ret == 0) {
@@ -192,25 +207,36 @@ void IOTracker::StartAioWrite(CurveAioContext* ctx, MDSClient* mdsclient,
 void IOTracker::DoWrite(MDSClient* mdsclient, const FInfo_t* fileInfo,
                         const FileEpoch* fEpoch,
                         Throttle* throttle) {
-    if (nullptr == data_) {
+    if (!iovecs_.empty()) {
+        for (const auto& iov : iovecs_) {
+            if (iov.iov_len > 0) {
+                writeData_.append_user_data(iov.iov_base, iov.iov_len,
+                                            TrivialDeleter);
+            }
+        }
+    } else if (nullptr == data_) {
         ReturnOnFail();
         return;
-    }
-
-    switch (userDataType_) {
-        case UserDataType::RawBuffer:
-            writeData_.append_user_data(data_, length_,
-                                        TrivialDeleter);
-            break;
-        case UserDataType::IOBuffer:
-            writeData_ = *reinterpret_cast<const butil::IOBuf*>(data_);
-            break;
+    } else {
+        switch (userDataType_) {
+            case UserDataType::RawBuffer:
+                writeData_.append_user_data(data_, length_,
+                                            TrivialDeleter);
+                break;
+            case UserDataType::IOBuffer:
+                writeData_ = *reinterpret_cast<const butil::IOBuf*>(data_);
+                break;
+        }
     }
 
     if (throttle) {
         throttle->Add(false, length_);
     }
 
+    if (readCache_ != nullptr) {
+        readCacheTicket_ = readCache_->BeginFill();
+    }
+
     int ret = Splitor::IO2ChunkRequests(this, mc_, &reqlist_, &writeData_,
                                         offset_, length_,
                                         mdsclient, fileInfo, fEpoch);
@@ -469,9 +495,12 @@ void IOTracker::Done() {
     }
 
     if (errcode_ == LIBCURVE_ERROR::OK) {
-        uint64_t duration = TimeUtility::GetTimeofDayUs() - opStartTimePoint_;
-        MetricHelper::UserLatencyRecord(fileMetric_, duration, type_);
-        MetricHelper::IncremUserQPSCount(fileMetric_, length_, type_);
+        if (!readahead_) {
+            uint64_t duration =
+                TimeUtility::GetTimeofDayUs() - opStartTimePoint_;
+            MetricHelper::UserLatencyRecord(fileMetric_, duration, type_);
+            MetricHelper::IncremUserQPSCount(fileMetric_, length_, type_);
+        }
 
         // copy read data to user buffer
         if (OpType::READ == type_ || OpType::READ_SNAP == type_) {
@@ -480,22 +509,32 @@ void IOTracker::Done() {
                 readData.append(buf);
             }
 
-            switch (userDataType_) {
-                case UserDataType::RawBuffer: {
-                    size_t nc = readData.copy_to(data_, readData.size());
-                    if (nc != length_) {
-                        errcode_ = LIBCURVE_ERROR::FAILED;
-                    }
-                    break;
+            if (!iovecs_.empty()) {
+                size_t nc = 0;
+                for (const auto& iov : iovecs_) {
+                    nc += readData.copy_to(iov.iov_base, iov.iov_len, nc);
+                }
+                if (nc != length_) {
+                    errcode_ = LIBCURVE_ERROR::FAILED;
                 }
-                case UserDataType::IOBuffer: {
-                    butil::IOBuf* userData =
-                        reinterpret_cast<butil::IOBuf*>(data_);
-                    *userData = readData;
-                    if (userData->size() != length_) {
-                        errcode_ = LIBCURVE_ERROR::FAILED;
+            } else {
+                switch (userDataType_) {
+                    case UserDataType::RawBuffer: {
+                        size_t nc = readData.copy_to(data_, readData.size());
+                        if (nc != length_) {
+                            errcode_ = LIBCURVE_ERROR::FAILED;
+                        }
+                        break;
+                    }
+                    case UserDataType::IOBuffer: {
+                        butil::IOBuf* userData =
+                            reinterpret_cast<butil::IOBuf*>(data_);
+                        *userData = readData;
+                        if (userData->size() != length_) {
+                            errcode_ = LIBCURVE_ERROR::FAILED;
+                        }
+                        break;
                     }
-                    break;
                 }
             }
 
@@ -504,10 +543,15 @@ void IOTracker::Done() {
                            << ", filename: " << fileMetric_->filename
                            << ", offset: " << offset_
                            << ", length: " << length_;
+            } else if (readCache_ != nullptr && readCacheTicket_ != 0) {
+                readCache_->Fill(readCacheTicket_, offset_, readData,
+                                 readahead_);
             }
         }
     } else {
-        MetricHelper::IncremUserEPSCount(fileMetric_, type_);
+        if (!readahead_) {
+            MetricHelper::IncremUserEPSCount(fileMetric_, type_);
+        }
         if (type_ == OpType::READ || type_ == OpType::WRITE) {
             if (LIBCURVE_ERROR::EPOCH_TOO_OLD == errcode_) {
                 LOG(WARNING) << "file [" << fileMetric_->filename << "]"
@@ -531,6 +575,8 @@ void IOTracker::Done() {
         }
     }
 
+    UpdateReadCache();
+
     DestoryRequestList();
 
     // scc_和aioctx都为空的时候肯定是个同步调用
@@ -552,6 +598,29 @@ void IOTracker::Done() {
     iomanager_->HandleAsyncIOResponse(this);
 }
 
+void IOTracker::UpdateReadCache() {
+    if (readCache_ == nullptr) {
+        return;
+    }
+
+    // another client has opened the file, the cached data may be stale
+    if (errcode_ == LIBCURVE_ERROR::EPOCH_TOO_OLD) {
+        readCache_->Drop();
+        return;
+    }
+
+    if (type_ == OpType::WRITE) {
+        // a failed write may have modified part of the range
+        if (errcode_ == LIBCURVE_ERROR::OK) {
+            readCache_->WriteThrough(readCacheTicket_, offset_, writeData_);
+        } else {
+            readCache_->Invalidate(offset_, length_);
+        }
+    } else if (type_ == OpType::DISCARD) {
+        readCache_->Invalidate(offset_, length_);
+    }
+}
+
 void IOTracker::DestoryRequestList() {
     for (auto iter : reqlist_) {
         iter->UnInit();
@@ -48,6 +48,7 @@ using curve::common::Throttle;
 class IOManager;
 class FileSegment;
 class DiscardTaskManager;
+class FileReadCache;
 
 // IOTracker用于跟踪一个用户IO，因为一个用户IO可能会跨chunkserver，
 // 因此在真正下发的时候会被拆分成多个小IO并发的向下发送，因此我们需要
@@ -210,6 +211,12 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
         userDataType_ = dataType;
     }
 
+    // set the user buffers of a vectored read or write, they are used
+    // instead of the buffer of the aio context
+    void SetIOVec(const struct iovec* iov, int iovcnt) {
+        iovecs_.assign(iov, iov + iovcnt);
+    }
+
     /**
      * @brief prepare space to store read data
      * @param subIoCount #space to store read data
@@ -226,6 +233,18 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
         return disableStripe_;
     }
 
+    // set the read cache of the file, reads are served from it and
+    // writes and discards update it
+    void SetReadCache(FileReadCache* readCache) {
+        readCache_ = readCache;
+    }
+
+    // mark the read as a prefetch of the readahead, it is not counted in
+    // the metrics of user requests
+    void SetReadahead() {
+        readahead_ = true;
+    }
+
     static void InitDiscardOption(const DiscardOption& opt);
 
  private:
@@ -289,6 +308,9 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
     void DoDiscard(MDSClient* mdsclient, const FInfo_t* fileInfo,
                    DiscardTaskManager* taskManager);
 
+    // update the read cache after a write or discard is finished
+    void UpdateReadCache();
+
     int ToReturnCode() const {
         return errcode_ == LIBCURVE_ERROR::OK
                    ? (type_ != OpType::DISCARD ? length_ : 0)
@@ -309,6 +331,9 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
     // user data type
     UserDataType userDataType_;
 
+    // user buffers of a vectored read or write
+    std::vector<struct iovec> iovecs_;
+
     // save write data
     butil::IOBuf writeData_;
 
@@ -365,6 +390,16 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
     // so store corresponding segment lock and release after operations finished
     std::vector<FileSegment*> segmentLocks_;
 
+    // read cache of the file, nullptr if disabled
+    FileReadCache* readCache_;
+
+    // ticket taken from the read cache before sending the requests,
+    // 0 if the read is served by the cache
+    uint64_t readCacheTicket_;
+
+    // whether the read is a prefetch of the readahead
+    bool readahead_;
+
     // id生成器
     static std::atomic<uint64_t> tracekerID_;
 
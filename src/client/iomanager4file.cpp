@@ -22,16 +22,23 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <chrono>   // NOLINT
+#include <utility>
+#include <vector>
 
 #include "src/client/metacache.h"
 #include "src/client/iomanager4file.h"
 #include "src/client/file_instance.h"
 #include "src/client/io_tracker.h"
 #include "src/client/splitor.h"
+#include "src/common/timeutility.h"
 
 namespace curve {
 namespace client {
+
+using curve::common::TimeUtility;
+
 Atomic<uint64_t> IOManager::idRecorder_(1);
 IOManager4File::IOManager4File() : scheduler_(nullptr), exit_(false) {}
 
@@ -137,6 +144,8 @@ void IOManager4File::UnInitialize() {
         delete fileMetric_;
         scheduler_ = nullptr;
         fileMetric_ = nullptr;
+        readahead_.reset();
+        readCache_.reset();
     }
 }
 
@@ -147,8 +156,11 @@ int IOManager4File::Read(char* buf, off_t offset,
 
     butil::IOBuf data;
 
+    Readahead(offset, length, mdsclient);
+
     IOTracker temp(this, &mc_, scheduler_, fileMetric_, disableStripe_);
     temp.SetUserDataType(UserDataType::IOBuffer);
+    temp.SetReadCache(readCache_.get());
     temp.StartRead(&data, offset, length, mdsclient, this->GetFileInfo(),
                    throttle_.get());
 
@@ -174,6 +186,7 @@ int IOManager4File::Write(const char* buf,
 
     IOTracker temp(this, &mc_, scheduler_, fileMetric_, disableStripe_);
     temp.SetUserDataType(UserDataType::IOBuffer);
+    temp.SetReadCache(readCache_.get());
     temp.StartWrite(&data, offset, length, mdsclient, this->GetFileInfo(),
                     this->GetFileEpoch(),
                     throttle_.get());
@@ -196,13 +209,18 @@ int IOManager4File::AioRead(CurveAioContext* ctx, MDSClient* mdsclient,
     }
 
     temp->SetUserDataType(dataType);
+    temp->SetReadCache(readCache_.get());
     inflightCntl_.IncremInflightNum();
     auto task = [this, ctx, mdsclient, temp]() {
         temp->StartAioRead(ctx, mdsclient, this->GetFileInfo(),
                            throttle_.get());
     };
 
+    // ctx may be released once the task is enqueued
+    off_t offset = ctx->offset;
+    size_t length = ctx->length;
     taskPool_.Enqueue(task);
+    Readahead(offset, length, mdsclient);
     return LIBCURVE_ERROR::OK;
 }
 
@@ -220,6 +238,7 @@ int IOManager4File::AioWrite(CurveAioContext* ctx, MDSClient* mdsclient,
     }
 
     temp->SetUserDataType(dataType);
+    temp->SetReadCache(readCache_.get());
     inflightCntl_.IncremInflightNum();
     auto task = [this, ctx, mdsclient, temp]() {
         temp->StartAioWrite(ctx, mdsclient, this->GetFileInfo(),
@@ -241,6 +260,7 @@ int IOManager4File::Discard(off_t offset, size_t length, MDSClient* mdsclient) {
     FlightIOGuard guard(this);
 
     IOTracker tracker(this, &mc_, scheduler_, fileMetric_);
+    tracker.SetReadCache(readCache_.get());
     tracker.StartDiscard(offset, length, mdsclient, GetFileInfo(),
                          discardTaskManager_.get());
     return tracker.Wait();
@@ -265,6 +285,7 @@ int IOManager4File::AioDiscard(CurveAioContext* aioctx, MDSClient* mdsclient) {
         return LIBCURVE_ERROR::OK;
     }
 
+    ioTracker->SetReadCache(readCache_.get());
     inflightCntl_.IncremInflightNum();
     auto task = [this, aioctx, mdsclient, ioTracker]() {
         ioTracker->StartAioDiscard(aioctx, mdsclient, this->GetFileInfo(),
@@ -275,6 +296,102 @@ int IOManager4File::AioDiscard(CurveAioContext* aioctx, MDSClient* mdsclient) {
     return LIBCURVE_ERROR::OK;
 }
 
+int IOManager4File::AioSubmit(const CurveAioRequest* requests, int count,
+                              MDSClient* mdsclient) {
+    std::vector<std::pair<IOTracker*, CurveAioContext*>> trackers;
+    trackers.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        CurveAioContext* ctx = requests[i].ctx;
+        OpType type = OpType::READ;
+        if (ctx->op == LIBCURVE_OP_WRITE) {
+            type = OpType::WRITE;
+        } else if (ctx->op == LIBCURVE_OP_DISCARD) {
+            type = OpType::DISCARD;
+        }
+        MetricHelper::IncremUserRPSCount(fileMetric_, type);
+
+        // nothing to do, finish the request directly
+        if (ctx->length == 0 ||
+            (type == OpType::DISCARD && !IsNeedDiscard(ctx->length))) {
+            ctx->ret = 0;
+            ctx->cb(ctx);
+            continue;
+        }
+
+        IOTracker* tracker = nullptr;
+        if (type == OpType::DISCARD) {
+            tracker = new (std::nothrow)
+                IOTracker(this, &mc_, scheduler_, fileMetric_);
+        } else {
+            tracker = new (std::nothrow)
+                IOTracker(this, &mc_, scheduler_, fileMetric_, disableStripe_);
+        }
+        if (tracker == nullptr) {
+            ctx->ret = -LIBCURVE_ERROR::FAILED;
+            ctx->cb(ctx);
+            LOG(ERROR) << "allocate tracker failed!";
+            continue;
+        }
+
+        tracker->SetUserDataType(UserDataType::RawBuffer);
+        if (requests[i].iov != nullptr) {
+            tracker->SetIOVec(requests[i].iov, requests[i].iovcnt);
+        }
+        tracker->SetReadCache(readCache_.get());
+        inflightCntl_.IncremInflightNum();
+        trackers.emplace_back(tracker, ctx);
+    }
+
+    if (trackers.empty()) {
+        return LIBCURVE_ERROR::OK;
+    }
+
+    // start all the requests in one task, so the task pool is only woken up
+    // once for the whole batch
+    auto task = [this, trackers, mdsclient]() {
+        for (const auto& tracker : trackers) {
+            CurveAioContext* ctx = tracker.second;
+            switch (ctx->op) {
+                case LIBCURVE_OP_WRITE:
+                    tracker.first->StartAioWrite(ctx, mdsclient,
+                                                 this->GetFileInfo(),
+                                                 this->GetFileEpoch(),
+                                                 throttle_.get());
+                    break;
+                case LIBCURVE_OP_DISCARD:
+                    tracker.first->StartAioDiscard(ctx, mdsclient,
+                                                   this->GetFileInfo(),
+                                                   discardTaskManager_.get());
+                    break;
+                default:
+                    tracker.first->StartAioRead(ctx, mdsclient,
+                                                this->GetFileInfo(),
+                                                throttle_.get());
+                    break;
+            }
+        }
+    };
+
+    // the contexts may be released once the task is enqueued
+    std::vector<std::pair<off_t, size_t>> reads;
+    if (readahead_ != nullptr) {
+        for (const auto& tracker : trackers) {
+            if (tracker.second->op == LIBCURVE_OP_READ) {
+                reads.emplace_back(tracker.second->offset,
+                                   tracker.second->length);
+            }
+        }
+    }
+
+    taskPool_.Enqueue(task);
+
+    for (const auto& read : reads) {
+        Readahead(read.first, read.second, mdsclient);
+    }
+    return LIBCURVE_ERROR::OK;
+}
+
 void IOManager4File::UpdateFileInfo(const FInfo_t& fi) {
     mc_.UpdateFileInfo(fi);
 }
@@ -290,6 +407,122 @@ void IOManager4File::SetDisableStripe() {
     disableStripe_ = true;
 }
 
+void IOManager4File::EnableReadCache(uint64_t chunkSize) {
+    if (!ioopt_.readCacheOpt.enable) {
+        return;
+    }
+
+    // the file is opened again, the data cached before may be stale
+    if (readCache_ != nullptr) {
+        readCache_->Drop();
+        if (readahead_ != nullptr) {
+            readahead_->Reset();
+        }
+        return;
+    }
+
+    std::unique_ptr<FileReadCache> readCache(new FileReadCache(
+        ioopt_.readCacheOpt, chunkSize,
+        fileMetric_->prefix + "_" + fileMetric_->filename + "_read_cache"));
+    if (!readCache->Init()) {
+        LOG(ERROR) << "Init read cache failed, read cache is disabled"
+                   << ", filename = " << fileMetric_->filename;
+        return;
+    }
+    readCache_ = std::move(readCache);
+
+    LOG(INFO) << "read cache enabled, filename = " << fileMetric_->filename
+              << ", block size = " << ioopt_.readCacheOpt.blockSize
+              << ", memory capacity MB = "
+              << ioopt_.readCacheOpt.memoryCapacityMB
+              << ", ssd cache path = " << ioopt_.readCacheOpt.ssdCachePath
+              << ", ssd capacity MB = " << ioopt_.readCacheOpt.ssdCapacityMB;
+
+    if (!ioopt_.readaheadOpt.enable) {
+        return;
+    }
+
+    // the prefetched data of all the streams should not take more than
+    // half of the memory of the read cache
+    ReadaheadOption readaheadOpt = ioopt_.readaheadOpt;
+    readaheadOpt.maxStreams = std::max<uint32_t>(readaheadOpt.maxStreams, 1);
+    readaheadOpt.maxWindowKB = std::min<uint64_t>(
+        readaheadOpt.maxWindowKB,
+        ioopt_.readCacheOpt.memoryCapacityMB * 1024 / 2 /
+            readaheadOpt.maxStreams);
+    readahead_.reset(new FileReadahead(readaheadOpt,
+                                       ioopt_.readCacheOpt.blockSize,
+                                       fileMetric_->filename + "_readahead"));
+
+    LOG(INFO) << "readahead enabled, filename = " << fileMetric_->filename
+              << ", trigger count = " << readaheadOpt.triggerCount
+              << ", min window KB = " << readaheadOpt.minWindowKB
+              << ", max window KB = " << readaheadOpt.maxWindowKB
+              << ", max streams = " << readaheadOpt.maxStreams;
+}
+
+namespace {
+
+// context of a prefetch, the data is dropped after it is put into the
+// read cache
+struct ReadaheadContext : public CurveAioContext {
+    FileReadahead* readahead;
+    ReadaheadRange range;
+    butil::IOBuf data;
+    uint64_t startUs;
+};
+
+void ReadaheadCallback(CurveAioContext* ctx) {
+    ReadaheadContext* context = static_cast<ReadaheadContext*>(ctx);
+    uint64_t latencyUs = TimeUtility::GetTimeofDayUs() - context->startUs;
+    bool success = context->ret >= 0 &&
+                   static_cast<uint64_t>(context->ret) == context->length;
+    context->readahead->OnPrefetchDone(context->range, success, latencyUs);
+    delete context;
+}
+
+}  // namespace
+
+void IOManager4File::Readahead(off_t offset, size_t length,
+                               MDSClient* mdsclient) {
+    ReadaheadRange range;
+    if (readahead_ == nullptr || length == 0 ||
+        !readahead_->OnRead(offset, length, GetFileInfo()->length, &range)) {
+        return;
+    }
+
+    ReadaheadContext* ctx = new ReadaheadContext();
+    ctx->offset = range.offset;
+    ctx->length = range.length;
+    ctx->ret = LIBCURVE_ERROR::OK;
+    ctx->op = LIBCURVE_OP_READ;
+    ctx->cb = ReadaheadCallback;
+    ctx->buf = &ctx->data;
+    ctx->readahead = readahead_.get();
+    ctx->range = range;
+    ctx->startUs = TimeUtility::GetTimeofDayUs();
+
+    IOTracker* tracker = new (std::nothrow)
+        IOTracker(this, &mc_, scheduler_, fileMetric_, disableStripe_);
+    if (tracker == nullptr) {
+        LOG(ERROR) << "allocate tracker for readahead failed!";
+        ctx->ret = -LIBCURVE_ERROR::FAILED;
+        ctx->cb(ctx);
+        return;
+    }
+
+    tracker->SetUserDataType(UserDataType::IOBuffer);
+    tracker->SetReadCache(readCache_.get());
+    tracker->SetReadahead();
+    inflightCntl_.IncremInflightNum();
+    auto task = [this, ctx, mdsclient, tracker]() {
+        tracker->StartAioRead(ctx, mdsclient, this->GetFileInfo(),
+                              throttle_.get());
+    };
+
+    taskPool_.Enqueue(task);
+}
+
 void IOManager4File::HandleAsyncIOResponse(IOTracker* iotracker) {
     inflightCntl_.DecremInflightNum();
     delete iotracker;
@@ -308,6 +541,13 @@ void IOManager4File::LeaseTimeoutBlockIO() {
     std::unique_lock<std::mutex> lk(exitMtx_);
     if (exit_ == false) {
         scheduler_->LeaseTimeoutBlockIO();
+        // another client may open the file after the lease expires
+        if (readCache_ != nullptr) {
+            readCache_->Drop();
+        }
+        if (readahead_ != nullptr) {
+            readahead_->Reset();
+        }
     } else {
         LOG(WARNING) << "io manager already exit, no need block io!";
     }
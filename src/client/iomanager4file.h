@@ -43,6 +43,8 @@
 #include "src/common/concurrent/task_thread_pool.h"
 #include "src/common/throttle.h"
 #include "src/client/discard_task.h"
+#include "src/client/file_read_cache.h"
+#include "src/client/file_readahead.h"
 
 namespace curve {
 namespace client {
@@ -127,6 +129,18 @@ class IOManager4File : public IOManager {
      */
     int AioDiscard(CurveAioContext* aioctx, MDSClient* mdsclient);
 
+    /**
+     * @brief Submit a batch of asynchronous reads, writes and discards,
+     *        the type of each request is decided by its ctx->op, and all
+     *        the requests are started in one task of the task pool
+     * @param requests requests checked by the caller
+     * @param count number of requests
+     * @param mdsclient for communicate with MDS
+     * @return 0 means success, and the callback of every request is called
+     */
+    int AioSubmit(const CurveAioRequest* requests, int count,
+                  MDSClient* mdsclient);
+
     /**
      * @brief 获取rpc发送令牌
      */
@@ -216,6 +230,20 @@ class IOManager4File : public IOManager {
 
     void SetDisableStripe();
 
+    /**
+     * @brief create the read cache if it is enabled, and the readahead if
+     *        it is also enabled, called after the file is opened for writing
+     * @param chunkSize chunk size of the file
+     */
+    void EnableReadCache(uint64_t chunkSize);
+
+    /**
+     * @brief get the read cache, nullptr if disabled, for unit test
+     */
+    FileReadCache* GetReadCache() {
+        return readCache_.get();
+    }
+
  private:
     friend class LeaseExecutor;
     friend class FlightIOGuard;
@@ -260,6 +288,12 @@ class IOManager4File : public IOManager {
 
     bool IsNeedDiscard(size_t len) const;
 
+    /**
+     * @brief record a read of the user, and prefetch the data following it
+     *        into the read cache if the reads are sequential
+     */
+    void Readahead(off_t offset, size_t length, MDSClient* mdsclient);
+
  private:
     // 每个IOManager都有其IO配置，保存在iooption里
     IOOption ioopt_;
@@ -306,6 +340,13 @@ class IOManager4File : public IOManager {
     bool disableStripe_;
 
     std::unique_ptr<DiscardTaskManager> discardTaskManager_;
+
+    // read cache of the file, only created for the client that opened the
+    // file for writing
+    std::unique_ptr<FileReadCache> readCache_;
+
+    // readahead of sequential reads, prefetches into readCache_
+    std::unique_ptr<FileReadahead> readahead_;
 };
 
 }  // namespace client
@@ -112,6 +112,21 @@ int CurveClient::AioDiscard(int fd, CurveAioContext* aioctx) {
     return fileClient_->AioDiscard(fd, aioctx);
 }
 
+int CurveClient::AioReadv(int fd, CurveAioContext* aioctx,
+                          const struct iovec* iov, int iovcnt) {
+    return fileClient_->AioReadv(fd, aioctx, iov, iovcnt);
+}
+
+int CurveClient::AioWritev(int fd, CurveAioContext* aioctx,
+                           const struct iovec* iov, int iovcnt) {
+    return fileClient_->AioWritev(fd, aioctx, iov, iovcnt);
+}
+
+int CurveClient::AioSubmit(int fd, const CurveAioRequest* requests,
+                           int count) {
+    return fileClient_->AioSubmit(fd, requests, count);
+}
+
 void CurveClient::SetFileClient(FileClient* client) {
     delete fileClient_;
     fileClient_ = client;
@@ -451,6 +451,39 @@ int FileClient::AioDiscard(int fd, CurveAioContext *aioctx) {
     }
 }
 
+int FileClient::AioReadv(int fd, CurveAioContext *aioctx,
+                         const struct iovec *iov, int iovcnt) {
+    aioctx->op = LIBCURVE_OP_READ;
+    CurveAioRequest request{aioctx, iov, iovcnt};
+    return AioSubmit(fd, &request, 1);
+}
+
+int FileClient::AioWritev(int fd, CurveAioContext *aioctx,
+                          const struct iovec *iov, int iovcnt) {
+    aioctx->op = LIBCURVE_OP_WRITE;
+    CurveAioRequest request{aioctx, iov, iovcnt};
+    return AioSubmit(fd, &request, 1);
+}
+
+int FileClient::AioSubmit(int fd, const CurveAioRequest *requests,
+                          int count) {
+    if (count == 0) {
+        return LIBCURVE_ERROR::OK;
+    } else if (requests == nullptr || count < 0) {
+        LOG(ERROR) << "invalid aio requests, count = " << count;
+        return -LIBCURVE_ERROR::PARAM_ERROR;
+    }
+
+    ReadLockGuard lk(rwlock_);
+    auto iter = fileserviceMap_.find(fd);
+    if (CURVE_UNLIKELY(iter == fileserviceMap_.end())) {
+        LOG(ERROR) << "invalid fd, fd = " << fd;
+        return -LIBCURVE_ERROR::BAD_FD;
+    }
+
+    return iter->second->AioSubmit(requests, count);
+}
+
 int FileClient::Rename(const UserInfo_t &userinfo, const std::string &oldpath,
                        const std::string &newpath) {
     LIBCURVE_ERROR ret;
@@ -909,6 +942,35 @@ int AioDiscard(int fd, CurveAioContext *aioctx) {
     return globalclient->AioDiscard(fd, aioctx);
 }
 
+int AioReadv(int fd, CurveAioContext *aioctx, const struct iovec *iov,
+             int iovcnt) {
+    if (globalclient == nullptr) {
+        LOG(ERROR) << "not inited!";
+        return -LIBCURVE_ERROR::FAILED;
+    }
+
+    return globalclient->AioReadv(fd, aioctx, iov, iovcnt);
+}
+
+int AioWritev(int fd, CurveAioContext *aioctx, const struct iovec *iov,
+              int iovcnt) {
+    if (globalclient == nullptr) {
+        LOG(ERROR) << "not inited!";
+        return -LIBCURVE_ERROR::FAILED;
+    }
+
+    return globalclient->AioWritev(fd, aioctx, iov, iovcnt);
+}
+
+int AioSubmit(int fd, const CurveAioRequest *requests, int count) {
+    if (globalclient == nullptr) {
+        LOG(ERROR) << "not inited!";
+        return -LIBCURVE_ERROR::FAILED;
+    }
+
+    return globalclient->AioSubmit(fd, requests, count);
+}
+
 int Create(const char *filename, const C_UserInfo_t *userinfo, size_t size) {
     if (globalclient == nullptr) {
         LOG(ERROR) << "not inited!";
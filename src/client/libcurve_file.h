@@ -162,6 +162,44 @@ class FileClient {
      */
     virtual int AioDiscard(int fd, CurveAioContext* aioctx);
 
+    /**
+     * @brief Asynchronous vectored read
+     * @param fd file descriptor
+     * @param aioctx async request context, aioctx->buf is not used and
+     *        aioctx->length is the total length of the buffers
+     * @param iov buffers to read into, see CurveAioRequest
+     * @param iovcnt number of buffers
+     * @return 0 means success, otherwise it means failure and the callback
+     *         will not be called
+     */
+    virtual int AioReadv(int fd, CurveAioContext* aioctx,
+                         const struct iovec* iov, int iovcnt);
+
+    /**
+     * @brief Asynchronous vectored write
+     * @param fd file descriptor
+     * @param aioctx async request context, aioctx->buf is not used and
+     *        aioctx->length is the total length of the buffers
+     * @param iov buffers to write, see CurveAioRequest
+     * @param iovcnt number of buffers
+     * @return 0 means success, otherwise it means failure and the callback
+     *         will not be called
+     */
+    virtual int AioWritev(int fd, CurveAioContext* aioctx,
+                          const struct iovec* iov, int iovcnt);
+
+    /**
+     * @brief Submit a batch of asynchronous reads, writes and discards of a
+     *        file, the type of each request is decided by its ctx->op
+     * @param fd file descriptor
+     * @param requests requests to submit
+     * @param count number of requests
+     * @return 0 means all the requests are submitted and the callback of
+     *         each request will be called, otherwise none of them is
+     *         submitted
+     */
+    virtual int AioSubmit(int fd, const CurveAioRequest* requests, int count);
+
     /**
      * 重命名文件
      * @param: userinfo是用户信息
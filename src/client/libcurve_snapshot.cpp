@@ -24,6 +24,9 @@
 
 #include <glog/logging.h>
 
+#include <utility>
+#include <vector>
+
 #include "include/curve_compiler_specific.h"
 #include "src/client/client_common.h"
 #include "src/client/client_config.h"
@@ -189,13 +192,16 @@ int SnapshotClient::GetOrAllocateSegmentInfo(bool allocate, uint64_t offset,
     }
 
     // update metacache
+    std::vector<std::pair<ChunkIndex, ChunkIDInfo>> chunkInfos;
+    chunkInfos.reserve(segInfo->chunkvec.size());
     int count = 0;
-    for (auto iter : segInfo->chunkvec) {
+    for (const auto& iter : segInfo->chunkvec) {
         uint64_t index =
             (segInfo->startoffset + count * fi->chunksize) / fi->chunksize;
-        iomanager4chunk_.GetMetaCache()->UpdateChunkInfoByIndex(index, iter);
+        chunkInfos.emplace_back(index, iter);
         ++count;
     }
+    iomanager4chunk_.GetMetaCache()->UpdateChunkInfoByIndex(chunkInfos);
     return GetServerList(segInfo->lpcpIDInfo.lpid, segInfo->lpcpIDInfo.cpidVec);
 }
 
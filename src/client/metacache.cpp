@@ -41,6 +41,13 @@ using curve::common::WriteLockGuard;
 using curve::common::ReadLockGuard;
 using curve::client::ClientConfig;
 
+using ChunkIndexInfoMapPtr =
+    butil::DoublyBufferedData<MetaCache::ChunkIndexInfoMap>::ScopedPtr;
+using FileSegmentMapPtr =
+    butil::DoublyBufferedData<MetaCache::FileSegmentMap>::ScopedPtr;
+using CopysetInfoMapPtr =
+    butil::DoublyBufferedData<MetaCache::CopysetInfoMap>::ScopedPtr;
+
 void MetaCache::Init(const MetaCacheOption& metaCacheOpt,
                      MDSClient* mdsclient) {
     mdsclient_ = mdsclient;
@@ -57,9 +64,15 @@ void MetaCache::Init(const MetaCacheOption& metaCacheOpt,
 
 MetaCacheErrorType MetaCache::GetChunkInfoByIndex(ChunkIndex chunkidx,
                                                   ChunkIDInfo* chunxinfo) {
-    ReadLockGuard rdlk(rwlock4ChunkInfo_);
-    auto iter = chunkindex2idMap_.find(chunkidx);
-    if (iter != chunkindex2idMap_.end()) {
+    ChunkIndexInfoMapPtr ptr;
+    if (chunkindex2idMap_.Read(&ptr) != 0) {
+        LOG(ERROR) << "failed to read chunk info map, chunk index = "
+                   << chunkidx;
+        return MetaCacheErrorType::UNKNOWN_ERROR;
+    }
+
+    auto iter = ptr->find(chunkidx);
+    if (iter != ptr->end()) {
         *chunxinfo = iter->second;
         return MetaCacheErrorType::OK;
     }
@@ -68,23 +81,40 @@ MetaCacheErrorType MetaCache::GetChunkInfoByIndex(ChunkIndex chunkidx,
 
 void MetaCache::UpdateChunkInfoByIndex(ChunkIndex cindex,
                                        const ChunkIDInfo& cinfo) {
-    WriteLockGuard wrlk(rwlock4ChunkInfo_);
-    chunkindex2idMap_[cindex] = cinfo;
+    auto update = [cindex, &cinfo](ChunkIndexInfoMap& bg) -> size_t {
+        bg[cindex] = cinfo;
+        return 1;
+    };
+    chunkindex2idMap_.Modify(update);
+}
+
+void MetaCache::UpdateChunkInfoByIndex(
+    const std::vector<std::pair<ChunkIndex, ChunkIDInfo>>& chunkinfos) {
+    if (chunkinfos.empty()) {
+        return;
+    }
+    auto update = [&chunkinfos](ChunkIndexInfoMap& bg) -> size_t {
+        for (const auto& info : chunkinfos) {
+            bg[info.first] = info.second;
+        }
+        return chunkinfos.size();
+    };
+    chunkindex2idMap_.Modify(update);
 }
 
 bool MetaCache::IsLeaderMayChange(LogicPoolID logicPoolId,
                                   CopysetID copysetId) {
-    rwlock4ChunkInfo_.RDLock();
-    auto iter = lpcsid2CopsetInfoMap_.find(
-        CalcLogicPoolCopysetID(logicPoolId, copysetId));
-    if (iter == lpcsid2CopsetInfoMap_.end()) {
-        rwlock4ChunkInfo_.Unlock();
+    CopysetInfoMapPtr ptr;
+    if (lpcsid2CopsetInfoMap_.Read(&ptr) != 0) {
         return false;
     }
 
-    bool flag = iter->second.LeaderMayChange();
-    rwlock4ChunkInfo_.Unlock();
-    return flag;
+    auto iter = ptr->find(CalcLogicPoolCopysetID(logicPoolId, copysetId));
+    if (iter == ptr->end()) {
+        return false;
+    }
+
+    return iter->second.LeaderMayChange();
 }
 
 int MetaCache::GetLeader(LogicPoolID logicPoolId,
@@ -96,41 +126,50 @@ int MetaCache::GetLeader(LogicPoolID logicPoolId,
     const auto key = CalcLogicPoolCopysetID(logicPoolId, copysetId);
 
     CopysetInfo<ChunkServerID> targetInfo;
-    rwlock4CopysetInfo_.RDLock();
-    auto iter = lpcsid2CopsetInfoMap_.find(key);
-    if (iter == lpcsid2CopsetInfoMap_.end()) {
-        rwlock4CopysetInfo_.Unlock();
-        LOG(ERROR) << "server list not exist, LogicPoolID = " << logicPoolId
-                   << ", CopysetID = " << copysetId;
-        return -1;
+    {
+        CopysetInfoMapPtr ptr;
+        if (lpcsid2CopsetInfoMap_.Read(&ptr) != 0) {
+            LOG(ERROR) << "failed to read copyset info map, LogicPoolID = "
+                       << logicPoolId << ", CopysetID = " << copysetId;
+            return -1;
+        }
+
+        auto iter = ptr->find(key);
+        if (iter == ptr->end()) {
+            LOG(ERROR) << "server list not exist, LogicPoolID = "
+                       << logicPoolId << ", CopysetID = " << copysetId;
+            return -1;
+        }
+
+        // 不需要刷新leader时直接从前台数据中获取，不拷贝copyset信息
+        if (!refresh && !iter->second.LeaderMayChange()) {
+            return iter->second.GetLeaderInfo(serverId, serverAddr);
+        }
+        targetInfo = iter->second;
     }
-    targetInfo = iter->second;
-    rwlock4CopysetInfo_.Unlock();
 
     int ret = 0;
-    if (refresh || targetInfo.LeaderMayChange()) {
-        uint32_t retry = 0;
-        while (retry++ < metacacheopt_.metacacheGetLeaderRetry) {
-            ret = UpdateLeaderInternal(logicPoolId, copysetId, &targetInfo, fm);
-            if (ret != -1) {
-                targetInfo.ResetSetLeaderUnstableFlag();
-                UpdateCopysetInfo(logicPoolId, copysetId, targetInfo);
-                break;
-            }
+    uint32_t retry = 0;
+    while (retry++ < metacacheopt_.metacacheGetLeaderRetry) {
+        ret = UpdateLeaderInternal(logicPoolId, copysetId, &targetInfo, fm);
+        if (ret != -1) {
+            targetInfo.ResetSetLeaderUnstableFlag();
+            UpdateCopysetInfo(logicPoolId, copysetId, targetInfo);
+            break;
+        }
 
-            LOG(INFO) << "refresh leader from chunkserver failed, "
-                      << "get copyset chunkserver list from mds, "
-                      << "logicpool id = " << logicPoolId
-                      << ", copyset id = " << copysetId;
+        LOG(INFO) << "refresh leader from chunkserver failed, "
+                  << "get copyset chunkserver list from mds, "
+                  << "logicpool id = " << logicPoolId
+                  << ", copyset id = " << copysetId;
 
-            // 重试失败，这时候需要向mds重新拉取最新的copyset信息了
-            ret = UpdateCopysetInfoFromMDS(logicPoolId, copysetId);
-            if (ret == 0) {
-                continue;
-            }
-
-            bthread_usleep(metacacheopt_.metacacheRPCRetryIntervalUS);
+        // 重试失败，这时候需要向mds重新拉取最新的copyset信息了
+        ret = UpdateCopysetInfoFromMDS(logicPoolId, copysetId);
+        if (ret == 0) {
+            continue;
         }
+
+        bthread_usleep(metacacheopt_.metacacheRPCRetryIntervalUS);
     }
 
     if (ret == -1) {
@@ -233,16 +272,7 @@ void MetaCache::UpdateCopysetInfoIfMatchCurrentLeader(
 
 CopysetInfo<ChunkServerID> MetaCache::GetServerList(LogicPoolID logicPoolId,
                                      CopysetID copysetId) {
-    const auto key = CalcLogicPoolCopysetID(logicPoolId, copysetId);
-    CopysetInfo<ChunkServerID> ret;
-
-    ReadLockGuard rdlk(rwlock4CopysetInfo_);
-    auto iter = lpcsid2CopsetInfoMap_.find(key);
-    if (iter == lpcsid2CopsetInfoMap_.end()) {
-        // it's impossible to get here
-        return ret;
-    }
-    return iter->second;
+    return GetCopysetinfo(logicPoolId, copysetId);
 }
 
 /**
@@ -254,37 +284,48 @@ int MetaCache::UpdateLeader(LogicPoolID logicPoolId,
                             CopysetID copysetId,
                             const EndPoint& leaderAddr) {
     const auto key = CalcLogicPoolCopysetID(logicPoolId, copysetId);
+    const PeerAddr csAddr(leaderAddr);
+
+    // it's impossible that the copyset doesn't exist
+    int ret = -1;
+    auto update = [key, &csAddr, &ret](CopysetInfoMap& bg) -> size_t {
+        auto iter = bg.find(key);
+        if (iter == bg.end()) {
+            return 0;
+        }
+        ret = iter->second.UpdateLeaderInfo(csAddr);
+        return ret == 0 ? 1 : 0;
+    };
+    lpcsid2CopsetInfoMap_.Modify(update);
 
-    ReadLockGuard rdlk(rwlock4CopysetInfo_);
-    auto iter = lpcsid2CopsetInfoMap_.find(key);
-    if (iter == lpcsid2CopsetInfoMap_.end()) {
-        // it's impossible to get here
-        return -1;
-    }
-
-    PeerAddr csAddr(leaderAddr);
-    return iter->second.UpdateLeaderInfo(csAddr);
+    return ret;
 }
 
 void MetaCache::UpdateCopysetInfo(LogicPoolID logicPoolid, CopysetID copysetid,
                                   const CopysetInfo<ChunkServerID>& csinfo) {
     const auto key = CalcLogicPoolCopysetID(logicPoolid, copysetid);
-    WriteLockGuard wrlk(rwlock4CopysetInfo_);
-    lpcsid2CopsetInfoMap_[key] = csinfo;
+    auto update = [key, &csinfo](CopysetInfoMap& bg) -> size_t {
+        bg[key] = csinfo;
+        return 1;
+    };
+    lpcsid2CopsetInfoMap_.Modify(update);
 }
 
 void MetaCache::AddCopysetsInfo(
     LogicPoolID poolId,
     std::vector<CopysetInfo<ChunkServerID>>&& copysetsInfo) {
-    WriteLockGuard guard(rwlock4CopysetInfo_);
-
-    for (auto& copyset : copysetsInfo) {
-        const auto key = CalcLogicPoolCopysetID(poolId, copyset.cpid_);
-        auto it = lpcsid2CopsetInfoMap_.find(key);
-        if (it == lpcsid2CopsetInfoMap_.end()) {
-            lpcsid2CopsetInfoMap_.emplace(key, std::move(copyset));
+    // 修改函数对两份数据各执行一次，所以不能移动copysetsInfo中的元素
+    auto update = [poolId, &copysetsInfo](CopysetInfoMap& bg) -> size_t {
+        size_t added = 0;
+        for (const auto& copyset : copysetsInfo) {
+            const auto key = CalcLogicPoolCopysetID(poolId, copyset.cpid_);
+            if (bg.emplace(key, copyset).second) {
+                ++added;
+            }
         }
-    }
+        return added;
+    };
+    lpcsid2CopsetInfoMap_.Modify(update);
 }
 
 void MetaCache::UpdateChunkInfoByID(ChunkID cid, const ChunkIDInfo& cidinfo) {
@@ -321,23 +362,35 @@ void MetaCache::SetChunkserverUnstable(ChunkServerID csid) {
         }
     }
 
-    ReadLockGuard rdlk(rwlock4CopysetInfo_);
-    for (auto it : copysetIDSet) {
-        const auto key = CalcLogicPoolCopysetID(it.lpid, it.cpid);
-        auto cpinfo = lpcsid2CopsetInfoMap_.find(key);
-        if (cpinfo != lpcsid2CopsetInfoMap_.end()) {
+    if (copysetIDSet.empty()) {
+        return;
+    }
+
+    auto update = [csid, &copysetIDSet](CopysetInfoMap& bg) -> size_t {
+        size_t changed = 0;
+        for (const auto& it : copysetIDSet) {
+            const auto key = CalcLogicPoolCopysetID(it.lpid, it.cpid);
+            auto cpinfo = bg.find(key);
+            if (cpinfo == bg.end()) {
+                continue;
+            }
+
             ChunkServerID leaderid;
             if (cpinfo->second.GetCurrentLeaderID(&leaderid)) {
                 if (leaderid == csid) {
                     // 只设置leaderid为当前serverid的Lcopyset
                     cpinfo->second.SetLeaderUnstableFlag();
+                    ++changed;
                 }
             } else {
                 // 当前copyset集群信息未知，直接设置LeaderUnStable
                 cpinfo->second.SetLeaderUnstableFlag();
+                ++changed;
             }
         }
-    }
+        return changed;
+    };
+    lpcsid2CopsetInfoMap_.Modify(update);
 }
 
 void MetaCache::AddCopysetIDInfo(ChunkServerID csid,
@@ -348,19 +401,29 @@ void MetaCache::AddCopysetIDInfo(ChunkServerID csid,
 
 void MetaCache::UpdateChunkserverCopysetInfo(LogicPoolID lpid,
                                  const CopysetInfo<ChunkServerID>& cpinfo) {
-    ReadLockGuard rdlk(rwlock4CopysetInfo_);
     const auto key = CalcLogicPoolCopysetID(lpid, cpinfo.cpid_);
-    // 先获取原来的chunkserver到copyset映射
-    auto previouscpinfo = lpcsid2CopsetInfoMap_.find(key);
-    if (previouscpinfo != lpcsid2CopsetInfoMap_.end()) {
-        std::vector<ChunkServerID> newID;
-        std::vector<ChunkServerID> changedID;
+    std::vector<ChunkServerID> changedID;
+    bool exist = false;
+    {
+        // 先获取原来的chunkserver到copyset映射
+        CopysetInfoMapPtr ptr;
+        if (lpcsid2CopsetInfoMap_.Read(&ptr) != 0) {
+            return;
+        }
 
-        // 先判断当前copyset有没有变更chunkserverid
-        for (auto iter : previouscpinfo->second.csinfos_) {
-            changedID.push_back(iter.peerID);
+        auto previouscpinfo = ptr->find(key);
+        if (previouscpinfo != ptr->end()) {
+            exist = true;
+            for (const auto& iter : previouscpinfo->second.csinfos_) {
+                changedID.push_back(iter.peerID);
+            }
         }
+    }
 
+    if (exist) {
+        std::vector<ChunkServerID> newID;
+
+        // 先判断当前copyset有没有变更chunkserverid
         for (auto iter : cpinfo.csinfos_) {
             auto it = std::find(changedID.begin(), changedID.end(),
                                 iter.peerID);
@@ -392,47 +455,66 @@ void MetaCache::UpdateChunkserverCopysetInfo(LogicPoolID lpid,
 
 CopysetInfo<ChunkServerID> MetaCache::GetCopysetinfo(
     LogicPoolID lpid, CopysetID csid) {
-    ReadLockGuard rdlk(rwlock4CopysetInfo_);
     const auto key = CalcLogicPoolCopysetID(lpid, csid);
-    auto cpinfo = lpcsid2CopsetInfoMap_.find(key);
-    if (cpinfo != lpcsid2CopsetInfoMap_.end()) {
+    CopysetInfoMapPtr ptr;
+    if (lpcsid2CopsetInfoMap_.Read(&ptr) != 0) {
+        return CopysetInfo<ChunkServerID>();
+    }
+
+    auto cpinfo = ptr->find(key);
+    if (cpinfo != ptr->end()) {
         return cpinfo->second;
     }
     return CopysetInfo<ChunkServerID>();
 }
 
 FileSegment* MetaCache::GetFileSegment(SegmentIndex segmentIndex) {
-    {
-        ReadLockGuard lk(rwlock4Segments_);
-        auto iter = segments_.find(segmentIndex);
-        if (iter != segments_.end()) {
-            return &iter->second;
+    auto find = [this, segmentIndex]() -> FileSegment* {
+        FileSegmentMapPtr ptr;
+        if (segments_.Read(&ptr) != 0) {
+            return nullptr;
         }
+        auto iter = ptr->find(segmentIndex);
+        return iter != ptr->end() ? iter->second.get() : nullptr;
+    };
+
+    FileSegment* segment = find();
+    if (segment != nullptr) {
+        return segment;
     }
 
-    WriteLockGuard lk(rwlock4Segments_);
-    auto ret = segments_.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(segmentIndex),
-        std::forward_as_tuple(segmentIndex,
-                              fileInfo_.segmentsize,
-                              metacacheopt_.discardGranularity));
+    std::lock_guard<std::mutex> lk(createSegmentMtx_);
+    segment = find();
+    if (segment != nullptr) {
+        return segment;
+    }
 
-    return &(ret.first->second);
+    auto newSegment = std::make_shared<FileSegment>(
+        segmentIndex, fileInfo_.segmentsize, metacacheopt_.discardGranularity);
+    auto insert = [segmentIndex, &newSegment](FileSegmentMap& bg) -> size_t {
+        bg.emplace(segmentIndex, newSegment);
+        return 1;
+    };
+    segments_.Modify(insert);
+
+    return newSegment.get();
 }
 
 void MetaCache::CleanChunksInSegment(SegmentIndex segmentIndex) {
-    WriteLockGuard lk(rwlock4chunkInfoMap_);
     ChunkIndex beginChunkIndex = static_cast<uint64_t>(segmentIndex) *
                                  fileInfo_.segmentsize / fileInfo_.chunksize;
     ChunkIndex endChunkIndex = static_cast<uint64_t>(segmentIndex + 1) *
                                fileInfo_.segmentsize / fileInfo_.chunksize;
 
-    auto currentIndex = beginChunkIndex;
-    while (currentIndex < endChunkIndex) {
-        chunkindex2idMap_.erase(currentIndex);
-        ++currentIndex;
-    }
+    auto clean = [beginChunkIndex,
+                  endChunkIndex](ChunkIndexInfoMap& bg) -> size_t {
+        size_t erased = 0;
+        for (auto index = beginChunkIndex; index < endChunkIndex; ++index) {
+            erased += bg.erase(index);
+        }
+        return erased;
+    };
+    chunkindex2idMap_.Modify(clean);
 }
 
 }   // namespace client
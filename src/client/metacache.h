@@ -22,9 +22,14 @@
 #ifndef SRC_CLIENT_METACACHE_H_
 #define SRC_CLIENT_METACACHE_H_
 
+#include <butil/containers/doubly_buffered_data.h>
+
+#include <memory>
+#include <mutex>  // NOLINT
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "src/client/client_common.h"
@@ -56,6 +61,8 @@ class MetaCache {
     using CopysetInfoMap =
         std::unordered_map<LogicPoolCopysetID, CopysetInfo<ChunkServerID>>;
     using ChunkIndexInfoMap = std::unordered_map<ChunkIndex, ChunkIDInfo>;
+    using FileSegmentMap =
+        std::unordered_map<SegmentIndex, std::shared_ptr<FileSegment>>;
 
     MetaCache() = default;
     virtual ~MetaCache() = default;
@@ -89,6 +96,13 @@ class MetaCache {
     virtual void UpdateChunkInfoByIndex(ChunkIndex cindex,
                                         const ChunkIDInfo &chunkinfo);
 
+    /**
+     * @brief Update cached chunk infos of several chunk indexes at once,
+     *        e.g. all the chunks of a segment
+     */
+    virtual void UpdateChunkInfoByIndex(
+        const std::vector<std::pair<ChunkIndex, ChunkIDInfo>>& chunkinfos);
+
     /**
      * sender发送数据的时候需要知道对应的leader然后发送给对应的chunkserver
      * 如果get不到的时候，外围设置refresh为true，然后向chunkserver端拉取最新的
@@ -272,23 +286,27 @@ class MetaCache {
     MDSClient *mdsclient_;
     MetaCacheOption metacacheopt_;
 
+    // IO路径上每次都要查询的映射表使用DoublyBufferedData保存，
+    // 读的时候只加当前线程的锁，不同线程之间没有竞争；
+    // 更新的时候先修改后台数据，切换为前台数据后再修改另一份数据，
+    // 所以修改函数会被执行两次，并且持有ScopedPtr时不能修改
+
     // chunkindex到chunkidinfo的映射表
-    CURVE_CACHELINE_ALIGNMENT ChunkIndexInfoMap chunkindex2idMap_;
+    butil::DoublyBufferedData<ChunkIndexInfoMap> chunkindex2idMap_;
 
-    CURVE_CACHELINE_ALIGNMENT RWLock rwlock4Segments_;
-    CURVE_CACHELINE_ALIGNMENT std::unordered_map<SegmentIndex, FileSegment>
-        segments_;  // NOLINT
+    // segmentindex到FileSegment的映射表，FileSegment创建后不会被删除
+    butil::DoublyBufferedData<FileSegmentMap> segments_;
+    // 创建FileSegment时加锁，避免同一个segment被重复创建
+    std::mutex createSegmentMtx_;
 
     // logicalpoolid和copysetid到copysetinfo的映射表
-    CURVE_CACHELINE_ALIGNMENT CopysetInfoMap lpcsid2CopsetInfoMap_;
+    butil::DoublyBufferedData<CopysetInfoMap> lpcsid2CopsetInfoMap_;
 
     // chunkid到chunkidinfo的映射表
     CURVE_CACHELINE_ALIGNMENT ChunkInfoMap chunkid2chunkInfoMap_;
 
-    // 三个读写锁分别保护上述三个映射表
+    // 读写锁保护chunkid2chunkInfoMap_
     CURVE_CACHELINE_ALIGNMENT RWLock rwlock4chunkInfoMap_;
-    CURVE_CACHELINE_ALIGNMENT RWLock rwlock4ChunkInfo_;
-    CURVE_CACHELINE_ALIGNMENT RWLock rwlock4CopysetInfo_;
 
     // chunkserverCopysetIDMap_存放当前chunkserver到copyset的映射
     // 当rpc closure设置SetChunkserverUnstable时，会设置该chunkserver
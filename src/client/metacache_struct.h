@@ -198,7 +198,7 @@ template <typename T> struct CURVE_CACHELINE_ALIGNMENT CopysetInfo {
      * @param[out]: peer id
      * @param[out]: ep
      */
-    int GetLeaderInfo(T *peerid, EndPoint *ep) {
+    int GetLeaderInfo(T *peerid, EndPoint *ep) const {
         // 第一次获取leader,如果当前leader信息没有确定，返回-1，由外部主动发起更新leader
         if (leaderindex_ < 0 ||
             leaderindex_ >= static_cast<int>(csinfos_.size())) {
@@ -90,18 +90,28 @@ int RequestScheduler::ScheduleRequest(
     const std::vector<RequestContext*>& requests) {
     if (running_.load(std::memory_order_acquire)) {
         /* TODO(wudemiao): 后期考虑 qos */
+        std::vector<BBQItem<RequestContext *>> reqs;
+        std::vector<RequestContext *> fakeReqs;
+        reqs.reserve(requests.size());
         for (auto it : requests) {
             // skip the fake request
             if (!it->idinfo_.chunkExist) {
                 if (it->sourceInfo_.cloneFileSource.empty()) {
-                    it->done_->Run();
+                    fakeReqs.push_back(it);
                 }
                 continue;
             }
 
-            BBQItem<RequestContext *> req(it);
-            queue_.PutBack(req);
+            reqs.emplace_back(it);
         }
+
+        // running the fake requests may release the requests, so they
+        // are collected before, and all the other requests are put into
+        // the queue under one lock
+        for (auto it : fakeReqs) {
+            it->done_->Run();
+        }
+        queue_.PutBack(reqs.begin(), reqs.end());
         return 0;
     }
     return -1;
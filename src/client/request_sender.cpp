@@ -24,6 +24,8 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <map>
+#include <mutex>  // NOLINT
 
 #include "proto/chunk.pb.h"
 #include "src/common/timeutility.h"
@@ -41,6 +43,45 @@ using curve::chunkserver::GetChunkInfoResponse;
 using curve::common::TimeUtility;
 using ::google::protobuf::Closure;
 
+namespace {
+
+// 同一进程内到同一个chunkserver的连接是共享的，所以连接的metric也在进程内共享，
+// 不会被释放，避免重复暴露同名的bvar
+std::shared_ptr<ConnectionMetric> GetConnectionMetric(
+    const butil::EndPoint& endPoint, uint32_t index) {
+    static std::mutex mtx;
+    static std::map<std::string, std::shared_ptr<ConnectionMetric>> metrics;
+
+    std::string name = "chunkserver_" +
+                       std::string(butil::endpoint2str(endPoint).c_str()) +
+                       "_connection_" + std::to_string(index);
+    std::lock_guard<std::mutex> lk(mtx);
+    auto& metric = metrics[name];
+    if (metric == nullptr) {
+        metric = std::make_shared<ConnectionMetric>(name);
+    }
+    return metric;
+}
+
+// rpc返回时减少连接上的inflight rpc数，然后执行上层的回调
+class InflightClosure : public Closure {
+ public:
+    InflightClosure(std::shared_ptr<ConnectionMetric> metric, Closure* done)
+        : metric_(std::move(metric)), done_(done) {}
+
+    void Run() override {
+        std::unique_ptr<InflightClosure> selfGuard(this);
+        metric_->inflightRPC.fetch_sub(1, std::memory_order_relaxed);
+        done_->Run();
+    }
+
+ private:
+    std::shared_ptr<ConnectionMetric> metric_;
+    Closure* done_;
+};
+
+}  // namespace
+
 inline void RequestSender::UpdateRpcRPS(ClientClosure* done,
                                         OpType type) const {
     RequestClosure* request = static_cast<RequestClosure*>(done->GetClosure());
@@ -62,17 +103,69 @@ inline void RequestSender::SetRpcStuff(
 }
 
 int RequestSender::Init(const IOSenderOption& ioSenderOpt) {
-    if (0 != channel_.Init(serverEndPoint_, NULL)) {
-        LOG(ERROR) << "failed to init channel to server, id: " << chunkServerId_
-                   << ", "<< serverEndPoint_.ip << ":" << serverEndPoint_.port;
-        return -1;
+    uint32_t connectionNum = std::max(1u, ioSenderOpt.chunkserverConnectionNum);
+    std::vector<std::unique_ptr<Connection>> connections;
+    for (uint32_t i = 0; i < connectionNum; ++i) {
+        std::unique_ptr<Connection> conn(new Connection());
+        brpc::ChannelOptions options;
+        // 第一个连接使用默认的connection group，与之前只有一个连接时一致
+        if (i > 0) {
+            options.connection_group =
+                "curve_client_connection_" + std::to_string(i);
+        }
+        if (0 != conn->channel.Init(serverEndPoint_, &options)) {
+            LOG(ERROR) << "failed to init channel to server, id: "
+                       << chunkServerId_ << ", " << serverEndPoint_.ip << ":"
+                       << serverEndPoint_.port << ", connection index: " << i;
+            return -1;
+        }
+        conn->metric = GetConnectionMetric(serverEndPoint_, i);
+        connections.emplace_back(std::move(conn));
     }
+
+    connections_.swap(connections);
     iosenderopt_ = ioSenderOpt;
     ClientClosure::SetFailureRequestOption(iosenderopt_.failRequestOpt);
 
     return 0;
 }
 
+bool RequestSender::IsSocketHealth() {
+    for (auto& conn : connections_) {
+        if (conn->channel.CheckHealth() != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+RequestSender::Connection* RequestSender::SelectConnection() {
+    const uint32_t size = connections_.size();
+    if (size == 1) {
+        return connections_[0].get();
+    }
+
+    uint32_t start = nextConnection_.fetch_add(1, std::memory_order_relaxed);
+    Connection* selected = nullptr;
+    int64_t minInflight = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        Connection* conn = connections_[(start + i) % size].get();
+        int64_t inflight =
+            conn->metric->inflightRPC.load(std::memory_order_relaxed);
+        if (selected == nullptr || inflight < minInflight) {
+            selected = conn;
+            minInflight = inflight;
+        }
+    }
+    return selected;
+}
+
+Closure* RequestSender::TrackInflight(Connection* conn, Closure* done) {
+    conn->metric->inflightRPC.fetch_add(1, std::memory_order_relaxed);
+    conn->metric->rpc.count << 1;
+    return new InflightClosure(conn->metric, done);
+}
+
 int RequestSender::ReadChunk(const ChunkIDInfo& idinfo,
                              uint64_t sn,
                              off_t offset,
@@ -100,8 +193,10 @@ int RequestSender::ReadChunk(const ChunkIDInfo& idinfo,
         request.set_clonefileoffset(sourceInfo.cloneFileOffset);
     }
 
-    ChunkService_Stub stub(&channel_);
-    stub.ReadChunk(cntl, &request, response, doneGuard.release());
+    Connection* conn = SelectConnection();
+    ChunkService_Stub stub(&conn->channel);
+    stub.ReadChunk(cntl, &request, response,
+        TrackInflight(conn, doneGuard.release()));
 
     return 0;
 }
@@ -144,8 +239,10 @@ int RequestSender::WriteChunk(const ChunkIDInfo& idinfo,
     }
 
     cntl->request_attachment().append(data);
-    ChunkService_Stub stub(&channel_);
-    stub.WriteChunk(cntl, &request, response, doneGuard.release());
+    Connection* conn = SelectConnection();
+    ChunkService_Stub stub(&conn->channel);
+    stub.WriteChunk(cntl, &request, response,
+        TrackInflight(conn, doneGuard.release()));
 
     return 0;
 }
@@ -170,8 +267,10 @@ int RequestSender::ReadChunkSnapshot(const ChunkIDInfo& idinfo,
     request.set_sn(sn);
     request.set_offset(offset);
     request.set_size(length);
-    ChunkService_Stub stub(&channel_);
-    stub.ReadChunkSnapshot(cntl, &request, response, doneGuard.release());
+    Connection* conn = SelectConnection();
+    ChunkService_Stub stub(&conn->channel);
+    stub.ReadChunkSnapshot(cntl, &request, response,
+        TrackInflight(conn, doneGuard.release()));
 
     return 0;
 }
@@ -192,11 +291,13 @@ int RequestSender::DeleteChunkSnapshotOrCorrectSn(const ChunkIDInfo& idinfo,
     request.set_copysetid(idinfo.cpid_);
     request.set_chunkid(idinfo.cid_);
     request.set_correctedsn(correctedSn);
-    ChunkService_Stub stub(&channel_);
+    Connection* conn = SelectConnection();
+    ChunkService_Stub stub(&conn->channel);
     stub.DeleteChunkSnapshotOrCorrectSn(cntl,
                                         &request,
                                         response,
-                                        doneGuard.release());
+                                        TrackInflight(conn,
+                                                      doneGuard.release()));
     return 0;
 }
 
@@ -213,8 +314,10 @@ int RequestSender::GetChunkInfo(const ChunkIDInfo& idinfo,
     request.set_logicpoolid(idinfo.lpid_);
     request.set_copysetid(idinfo.cpid_);
     request.set_chunkid(idinfo.cid_);
-    ChunkService_Stub stub(&channel_);
-    stub.GetChunkInfo(cntl, &request, response, doneGuard.release());
+    Connection* conn = SelectConnection();
+    ChunkService_Stub stub(&conn->channel);
+    stub.GetChunkInfo(cntl, &request, response,
+        TrackInflight(conn, doneGuard.release()));
     return 0;
 }
 
@@ -242,8 +345,10 @@ int RequestSender::CreateCloneChunk(const ChunkIDInfo& idinfo,
     request.set_correctedsn(correntSn);
     request.set_size(chunkSize);
 
-    ChunkService_Stub stub(&channel_);
-    stub.CreateCloneChunk(cntl, &request, response, doneGuard.release());
+    Connection* conn = SelectConnection();
+    ChunkService_Stub stub(&conn->channel);
+    stub.CreateCloneChunk(cntl, &request, response,
+        TrackInflight(conn, doneGuard.release()));
 
     return 0;
 }
@@ -267,8 +372,10 @@ int RequestSender::RecoverChunk(const ChunkIDInfo& idinfo,
     request.set_offset(offset);
     request.set_size(len);
 
-    ChunkService_Stub stub(&channel_);
-    stub.RecoverChunk(cntl, &request, response, doneGuard.release());
+    Connection* conn = SelectConnection();
+    ChunkService_Stub stub(&conn->channel);
+    stub.RecoverChunk(cntl, &request, response,
+        TrackInflight(conn, doneGuard.release()));
 
     return 0;
 }
@@ -27,10 +27,14 @@
 #include <butil/endpoint.h>
 #include <butil/iobuf.h>
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "src/client/client_config.h"
 #include "src/client/client_common.h"
+#include "src/client/client_metric.h"
 #include "src/client/chunk_closure.h"
 #include "include/curve_compiler_specific.h"
 #include "src/client/request_context.h"
@@ -40,7 +44,8 @@ namespace client {
 
 /**
  * 一个RequestSender负责管理一个ChunkServer的所有
- * connection，目前一个ChunkServer仅有一个connection
+ * connection，连接数由chunkserverConnectionNum配置，
+ * 每个rpc选择inflight rpc最少的连接发送
  */
 class RequestSender {
  public:
@@ -48,7 +53,7 @@ class RequestSender {
                   butil::EndPoint serverEndPoint)
         : chunkServerId_(chunkServerId),
           serverEndPoint_(serverEndPoint),
-          channel_() {}
+          nextConnection_(0) {}
     virtual ~RequestSender() {}
 
     int Init(const IOSenderOption& ioSenderOpt);
@@ -170,16 +175,38 @@ class RequestSender {
     int ResetSender(ChunkServerID chunkServerId,
                     butil::EndPoint serverEndPoint);
 
-    bool IsSocketHealth() {
-       return channel_.CheckHealth() == 0;
-    }
+    /**
+     * 所有连接都健康时返回true
+     */
+    bool IsSocketHealth();
 
  private:
+    // 与chunkserver之间的一个连接，不同序号的连接使用不同的connection group，
+    // 从而使用不同的socket
+    struct Connection {
+        brpc::Channel channel;
+        std::shared_ptr<ConnectionMetric> metric;
+    };
+
     void UpdateRpcRPS(ClientClosure* done, OpType type) const;
 
     void SetRpcStuff(ClientClosure* done, brpc::Controller* cntl,
                      google::protobuf::Message* rpcResponse) const;
 
+    /**
+     * 选择inflight rpc最少的连接，inflight rpc数相同时轮流选择
+     */
+    Connection* SelectConnection();
+
+    /**
+     * 记录连接上的inflight rpc，rpc返回时减少
+     * @param conn: 发送rpc的连接
+     * @param done: 上一层异步回调的closure
+     * @return: 传给rpc stub的closure
+     */
+    google::protobuf::Closure* TrackInflight(Connection* conn,
+                                             google::protobuf::Closure* done);
+
  private:
     // Rpc stub配置
     IOSenderOption iosenderopt_;
@@ -187,7 +214,10 @@ class RequestSender {
     ChunkServerID chunkServerId_;
     // ChunkServer 的地址
     butil::EndPoint serverEndPoint_;
-    brpc::Channel channel_; /* TODO(wudemiao): 后期会维护多个 channel */
+    // 与chunkserver之间的连接
+    std::vector<std::unique_ptr<Connection>> connections_;
+    // 下次选择连接时开始比较的位置
+    std::atomic<uint32_t> nextConnection_;
 };
 
 }   // namespace client
@@ -242,13 +242,16 @@ bool Splitor::GetOrAllocateSegment(bool allocateIfNotExist,
     }
 
     const auto chunksize = fileInfo->chunksize;
+    std::vector<std::pair<ChunkIndex, ChunkIDInfo>> chunkInfos;
+    chunkInfos.reserve(segmentInfo.chunkvec.size());
     uint32_t count = 0;
     for (const auto& chunkIdInfo : segmentInfo.chunkvec) {
         uint64_t chunkIdx =
             (segmentInfo.startoffset + count * chunksize) / chunksize;
-        metaCache->UpdateChunkInfoByIndex(chunkIdx, chunkIdInfo);
+        chunkInfos.emplace_back(chunkIdx, chunkIdInfo);
         ++count;
     }
+    metaCache->UpdateChunkInfoByIndex(chunkInfos);
 
     std::vector<CopysetInfo<ChunkServerID>> copysetInfos;
     errCode = mdsClient->GetServerList(segmentInfo.lpcpIDInfo.lpid,
@@ -0,0 +1,214 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/common/aligned_buffer_pool.h"
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <stdlib.h>
+
+#include <cstring>
+
+DEFINE_uint64(alignedBufferPoolMaxCachedMB, 256,
+              "max size of the free buffers cached by aligned buffer pool");
+DEFINE_uint64(alignedBufferPoolThreadCacheKB, 1024,
+              "max size of the free buffers cached by each thread");
+
+namespace curve {
+namespace common {
+
+const size_t AlignedBufferPool::kAlignment;
+const size_t AlignedBufferPool::kMaxPooledSize;
+const int AlignedBufferPool::kClassNum;
+
+namespace {
+// 线程缓存析构后置为true，之后该线程的申请和释放直接访问全局空闲链表
+thread_local bool threadCacheDestroyed = false;
+}  // namespace
+
+struct AlignedBufferPool::ThreadCache {
+    std::vector<char*> buffers[kClassNum];
+    uint64_t bytes = 0;
+
+    ~ThreadCache() {
+        threadCacheDestroyed = true;
+        // 线程退出时把缓存的buffer归还到全局空闲链表，供其他线程使用
+        AlignedBufferPool& pool = GetInstance();
+        for (int i = 0; i < kClassNum; ++i) {
+            for (char* buf : buffers[i]) {
+                pool.FreeToGlobal(i, buf);
+            }
+        }
+    }
+};
+
+AlignedBufferPool::ThreadCache* AlignedBufferPool::GetThreadCache() {
+    if (threadCacheDestroyed) {
+        return nullptr;
+    }
+    static thread_local ThreadCache cache;
+    return &cache;
+}
+
+uint64_t AlignedBufferPool::GetCachedBytes(void* arg) {
+    return static_cast<AlignedBufferPool*>(arg)->CachedBytes();
+}
+
+AlignedBufferPool& AlignedBufferPool::GetInstance() {
+    // never destroyed, buffers held by IOBuf may be released after exit
+    static AlignedBufferPool* pool = new AlignedBufferPool();
+    return *pool;
+}
+
+AlignedBufferPool::AlignedBufferPool()
+    : cachedBytes_(0),
+      maxCachedBytes_(FLAGS_alignedBufferPoolMaxCachedMB * 1024 * 1024),
+      hitCount_("aligned_buffer_pool_hit"),
+      missCount_("aligned_buffer_pool_miss"),
+      cachedBytesStatus_("aligned_buffer_pool_cached_bytes",
+                         &AlignedBufferPool::GetCachedBytes, this) {}
+
+AlignedBufferPool::~AlignedBufferPool() {
+    Clear();
+}
+
+int AlignedBufferPool::SizeClass(size_t size) {
+    int index = 0;
+    size_t classSize = kAlignment;
+    while (classSize < size) {
+        classSize <<= 1;
+        ++index;
+    }
+    return index < kClassNum ? index : -1;
+}
+
+char* AlignedBufferPool::Alloc(size_t size) {
+    int index = SizeClass(size);
+    size_t allocSize = size;
+    if (index >= 0) {
+        size_t classSize = kAlignment << index;
+        char* buf = nullptr;
+        ThreadCache* cache = GetThreadCache();
+        if (cache != nullptr && !cache->buffers[index].empty()) {
+            buf = cache->buffers[index].back();
+            cache->buffers[index].pop_back();
+            cache->bytes -= classSize;
+        } else {
+            FreeList& list = freeLists_[index];
+            list.lock.Lock();
+            if (!list.buffers.empty()) {
+                buf = list.buffers.back();
+                list.buffers.pop_back();
+            }
+            list.lock.UnLock();
+        }
+        if (buf != nullptr) {
+            cachedBytes_.fetch_sub(classSize, std::memory_order_relaxed);
+            hitCount_ << 1;
+            return buf;
+        }
+        allocSize = classSize;
+    }
+
+    missCount_ << 1;
+    void* buf = nullptr;
+    int ret = posix_memalign(&buf, kAlignment, allocSize);
+    if (ret != 0) {
+        LOG(ERROR) << "posix_memalign failed, size: " << allocSize
+                   << ", error: " << strerror(ret);
+        return nullptr;
+    }
+    return static_cast<char*>(buf);
+}
+
+void AlignedBufferPool::Free(char* buf, size_t size) {
+    if (buf == nullptr) {
+        return;
+    }
+    int index = SizeClass(size);
+    if (index < 0) {
+        free(buf);
+        return;
+    }
+    FreeToList(index, buf);
+}
+
+void AlignedBufferPool::FreeToList(int index, char* buf) {
+    size_t classSize = kAlignment << index;
+    uint64_t cached = cachedBytes_.fetch_add(classSize,
+                                             std::memory_order_relaxed);
+    if (cached + classSize > maxCachedBytes_.load(std::memory_order_relaxed)) {
+        cachedBytes_.fetch_sub(classSize, std::memory_order_relaxed);
+        free(buf);
+        return;
+    }
+    ThreadCache* cache = GetThreadCache();
+    uint64_t threadCacheLimit = FLAGS_alignedBufferPoolThreadCacheKB * 1024;
+    if (cache != nullptr && cache->bytes + classSize <= threadCacheLimit) {
+        cache->buffers[index].push_back(buf);
+        cache->bytes += classSize;
+        return;
+    }
+    FreeToGlobal(index, buf);
+}
+
+void AlignedBufferPool::FreeToGlobal(int index, char* buf) {
+    FreeList& list = freeLists_[index];
+    list.lock.Lock();
+    list.buffers.push_back(buf);
+    list.lock.UnLock();
+}
+
+void AlignedBufferPool::FreeLarge(void* buf) {
+    free(buf);
+}
+
+AlignedBufferPool::Deleter AlignedBufferPool::GetDeleter(size_t size) const {
+    static const Deleter deleters[kClassNum] = {
+        &FreeToClass<0>, &FreeToClass<1>, &FreeToClass<2>,
+        &FreeToClass<3>, &FreeToClass<4>, &FreeToClass<5>,
+        &FreeToClass<6>, &FreeToClass<7>, &FreeToClass<8>,
+    };
+    int index = SizeClass(size);
+    return index < 0 ? &FreeLarge : deleters[index];
+}
+
+void AlignedBufferPool::Clear() {
+    ThreadCache* cache = GetThreadCache();
+    for (int i = 0; i < kClassNum; ++i) {
+        FreeList& list = freeLists_[i];
+        std::vector<char*> buffers;
+        list.lock.Lock();
+        buffers.swap(list.buffers);
+        list.lock.UnLock();
+        if (cache != nullptr) {
+            buffers.insert(buffers.end(), cache->buffers[i].begin(),
+                           cache->buffers[i].end());
+            cache->buffers[i].clear();
+        }
+        for (char* buf : buffers) {
+            free(buf);
+        }
+        cachedBytes_.fetch_sub(buffers.size() * (kAlignment << i),
+                               std::memory_order_relaxed);
+    }
+    if (cache != nullptr) {
+        cache->bytes = 0;
+    }
+}
+
+}  // namespace common
+}  // namespace curve
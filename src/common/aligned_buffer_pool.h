@@ -0,0 +1,138 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_COMMON_ALIGNED_BUFFER_POOL_H_
+#define SRC_COMMON_ALIGNED_BUFFER_POOL_H_
+
+#include <bvar/bvar.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "src/common/concurrent/spinlock.h"
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace common {
+
+/**
+ * 按kAlignment对齐的buffer池，可以直接用于O_DIRECT读写
+ * buffer大小按2的幂划分为多个规格，释放的buffer缓存在对应规格的空闲链表中
+ * 供后续复用，缓存的总大小超过上限后直接释放
+ * 每个线程先在自己的缓存中申请和释放，线程缓存满了才访问全局的空闲链表
+ * 超过kMaxPooledSize的buffer不缓存
+ */
+class AlignedBufferPool : public Uncopyable {
+ public:
+    using Deleter = void (*)(void*);
+
+    // buffer的对齐大小，也是最小的buffer规格
+    static const size_t kAlignment = 4096;
+    // 缓存的最大buffer规格
+    static const size_t kMaxPooledSize = 1024 * 1024;
+
+    static AlignedBufferPool& GetInstance();
+
+    /**
+     * 申请buffer，实际分配的大小会向上取整到所属的规格
+     * @param size: 需要的大小
+     * @return: 按kAlignment对齐的buffer，失败返回nullptr
+     */
+    char* Alloc(size_t size);
+
+    /**
+     * 释放buffer
+     * @param buf: 通过Alloc申请的buffer
+     * @param size: 申请时传入的大小
+     */
+    void Free(char* buf, size_t size);
+
+    /**
+     * 获取释放指定大小buffer的函数，用于butil::IOBuf::append_user_data，
+     * 使IOBuf释放时将buffer归还到池中
+     * @param size: 申请时传入的大小
+     */
+    Deleter GetDeleter(size_t size) const;
+
+    // 设置缓存buffer总大小的上限
+    void SetMaxCachedBytes(uint64_t bytes) {
+        maxCachedBytes_.store(bytes, std::memory_order_relaxed);
+    }
+
+    // 当前缓存的buffer总大小，包括各线程缓存的buffer
+    uint64_t CachedBytes() const {
+        return cachedBytes_.load(std::memory_order_relaxed);
+    }
+
+    // 从缓存中申请到buffer的次数
+    uint64_t HitCount() const {
+        return hitCount_.get_value();
+    }
+
+    // 缓存中没有可用buffer，需要重新分配的次数
+    uint64_t MissCount() const {
+        return missCount_.get_value();
+    }
+
+    // 释放全局空闲链表和当前线程缓存的buffer
+    void Clear();
+
+ private:
+    AlignedBufferPool();
+    ~AlignedBufferPool();
+
+    struct FreeList {
+        SpinLock lock;
+        std::vector<char*> buffers;
+    };
+
+    struct ThreadCache;
+
+    // 规格的数量，规格i的大小为kAlignment << i
+    static const int kClassNum = 9;
+    static_assert((kAlignment << (kClassNum - 1)) == kMaxPooledSize,
+                  "size classes must end at kMaxPooledSize");
+
+    // 返回size所属的规格，超过kMaxPooledSize返回-1
+    static int SizeClass(size_t size);
+
+    template <int kIndex>
+    static void FreeToClass(void* buf) {
+        GetInstance().FreeToList(kIndex, static_cast<char*>(buf));
+    }
+    static void FreeLarge(void* buf);
+
+    void FreeToList(int index, char* buf);
+    void FreeToGlobal(int index, char* buf);
+    static ThreadCache* GetThreadCache();
+    static uint64_t GetCachedBytes(void* arg);
+
+ private:
+    FreeList freeLists_[kClassNum];
+    std::atomic<uint64_t> cachedBytes_;
+    std::atomic<uint64_t> maxCachedBytes_;
+
+    bvar::Adder<uint64_t> hitCount_;
+    bvar::Adder<uint64_t> missCount_;
+    bvar::PassiveStatus<uint64_t> cachedBytesStatus_;
+};
+
+}  // namespace common
+}  // namespace curve
+
+#endif  // SRC_COMMON_ALIGNED_BUFFER_POOL_H_
@@ -42,6 +42,9 @@ class ARCCache : public LRUCacheInterface<K, V> {
     void Put(const K& key, const V& value);
     bool Put(const K& key, const V& value, V* eliminated);
     bool Get(const K& key, V* value);
+    // a key hit in T1 is only promoted to T2 if promote returns true for
+    // its value, otherwise it is moved to the MRU end of T1
+    bool Get(const K& key, V* value, bool (*promote)(const V& value));
     void Remove(const K& key);
     uint64_t Size();
     std::shared_ptr<CacheMetrics> GetCacheMetrics() const;
@@ -230,9 +233,9 @@ class ARCCache : public LRUCacheInterface<K, V> {
                 return;
             }
             if (v != nullptr) {
-                list.push_back(*v);
+                list.emplace_back(map_iter, *v);
             } else {
-                list.push_back(map_iter->second.list_iter->value);
+                list.emplace_back(map_iter, map_iter->second.list_iter->value);
             }
             list.erase(map_iter->second.list_iter);
             map_iter->second.list_iter = --list.end();
@@ -274,13 +277,23 @@ class ARCCache : public LRUCacheInterface<K, V> {
 
 template <typename K, typename V, typename KeyTraits, typename ValueTraits>
 bool ARCCache<K, V, KeyTraits, ValueTraits>::Get(const K& key, V* value) {
+    return Get(key, value, nullptr);
+}
+
+template <typename K, typename V, typename KeyTraits, typename ValueTraits>
+bool ARCCache<K, V, KeyTraits, ValueTraits>::Get(const K& key, V* value,
+    bool (*promote)(const V& value)) {
     ::curve::common::WriteLockGuard guard(lock_);
     tmap_iter it;
 
     if (t1_.Find(key, &it)) {
         if (value) *value = it->second.list_iter->value;
-        t2_.Insert(key, it->second.list_iter->value, nullptr);
-        t1_.Remove(std::move(it), nullptr);
+        if (promote != nullptr && !promote(it->second.list_iter->value)) {
+            t1_.Touch(it, nullptr, nullptr);
+        } else {
+            t2_.Insert(key, it->second.list_iter->value, nullptr);
+            t1_.Remove(std::move(it), nullptr);
+        }
         if (cacheMetrics_ != nullptr) {
             cacheMetrics_->OnCacheHit();
         }
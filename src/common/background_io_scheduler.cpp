@@ -0,0 +1,199 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "src/common/background_io_scheduler.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "src/common/timeutility.h"
+
+namespace curve {
+namespace common {
+
+namespace {
+
+const char kMetricPrefix[] = "chunkserver_background_io";
+// 时延正常时每个周期恢复的配额百分比
+const uint32_t kRatioIncreaseStep = 10;
+
+}  // namespace
+
+const char* BackgroundIOTypeName(BackgroundIOType type) {
+    switch (type) {
+        case BackgroundIOType::SCAN:
+            return "scan";
+        case BackgroundIOType::CLONE:
+            return "clone";
+        case BackgroundIOType::TRASH:
+            return "trash";
+        case BackgroundIOType::FORMAT:
+            return "format";
+        case BackgroundIOType::CLEAN:
+            return "clean";
+        default:
+            return "unknown";
+    }
+}
+
+BackgroundIOScheduler::BackgroundIOScheduler()
+    : running_(false),
+      ratioPercent_(100),
+      foregroundLatencyUs_(0),
+      foregroundCount_(0) {}
+
+BackgroundIOScheduler::~BackgroundIOScheduler() {
+    Stop();
+}
+
+BackgroundIOScheduler& BackgroundIOScheduler::GetInstance() {
+    static BackgroundIOScheduler scheduler;
+    return scheduler;
+}
+
+int BackgroundIOScheduler::Init(const BackgroundIOSchedulerOptions& options) {
+    if (running_.load()) {
+        LOG(WARNING) << "Background io scheduler is already running.";
+        return 0;
+    }
+    if (options.adjustIntervalMs == 0 || options.minRatioPercent == 0 ||
+        options.minRatioPercent > 100) {
+        LOG(ERROR) << "Invalid background io scheduler options"
+                   << ", adjust interval ms: " << options.adjustIntervalMs
+                   << ", min ratio percent: " << options.minRatioPercent;
+        return -1;
+    }
+    options_ = options;
+    ratioPercent_.store(100);
+
+    for (int i = 0; i < kBackgroundIOTypeNum; ++i) {
+        std::string name =
+            BackgroundIOTypeName(static_cast<BackgroundIOType>(i));
+        IOClass& ioClass = classes_[i];
+        ioClass.bytes.expose_as(kMetricPrefix, name + "_bytes");
+        ioClass.ios.expose_as(kMetricPrefix, name + "_ios");
+        ioClass.waitUs.expose_as(kMetricPrefix, name + "_wait_us");
+        ioClass.bps.expose_as(kMetricPrefix, name + "_bps");
+        ioClass.iops.expose_as(kMetricPrefix, name + "_iops");
+    }
+    if (ratioStatus_ == nullptr) {
+        ratioStatus_.reset(new bvar::PassiveStatus<uint32_t>(
+            std::string(kMetricPrefix) + "_ratio_percent",
+            GetRatioPercent, this));
+    }
+
+    // 初始时所有类别都按加入后的份额限制，第一个周期后再按实际的IO调整
+    Adjust();
+
+    sleeper_.init();
+    running_.store(true);
+    adjustThread_ = Thread(&BackgroundIOScheduler::AdjustWorker, this);
+    LOG(INFO) << "Background io scheduler started, bps limit: "
+              << options_.bpsLimit << ", iops limit: " << options_.iopsLimit
+              << ", latency threshold us: " << options_.latencyThresholdUs;
+    return 0;
+}
+
+void BackgroundIOScheduler::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    sleeper_.interrupt();
+    if (adjustThread_.joinable()) {
+        adjustThread_.join();
+    }
+    LOG(INFO) << "Background io scheduler stopped.";
+}
+
+void BackgroundIOScheduler::Acquire(BackgroundIOType type, uint64_t length) {
+    IOClass& ioClass = classes_[static_cast<int>(type)];
+    ioClass.bytes << length;
+    ioClass.ios << 1;
+    ioClass.recentIOs.fetch_add(1, std::memory_order_relaxed);
+    if (!running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    uint64_t startUs = TimeUtility::GetTimeofDayUs();
+    ioClass.throttle.Add(false, length);
+    ioClass.waitUs << (TimeUtility::GetTimeofDayUs() - startUs);
+}
+
+void BackgroundIOScheduler::Adjust() {
+    // 根据上个周期的前台平均时延调整后台IO的总配额
+    uint64_t latencyUs = foregroundLatencyUs_.exchange(0);
+    uint64_t count = foregroundCount_.exchange(0);
+    uint32_t ratio = ratioPercent_.load();
+    if (options_.latencyThresholdUs == 0) {
+        ratio = 100;
+    } else if (count > 0 && latencyUs / count > options_.latencyThresholdUs) {
+        ratio = std::max(ratio / 2, options_.minRatioPercent);
+    } else {
+        ratio = std::min(ratio + kRatioIncreaseStep, 100u);
+    }
+    ratioPercent_.store(ratio);
+
+    bool active[kBackgroundIOTypeNum];
+    uint64_t activeWeight = 0;
+    for (int i = 0; i < kBackgroundIOTypeNum; ++i) {
+        active[i] = classes_[i].recentIOs.exchange(0) > 0;
+        if (active[i]) {
+            activeWeight += options_.weights[i];
+        }
+    }
+
+    // 按权重在活跃的类别之间分配配额，不活跃的类别按加入后能获得的份额限制
+    auto share = [&](uint64_t total, int i) -> uint64_t {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t weight = options_.weights[i];
+        uint64_t sum = activeWeight + (active[i] ? 0 : weight);
+        if (sum == 0) {
+            return 0;
+        }
+        return std::max<uint64_t>(total * ratio / 100 * weight / sum, 1);
+    };
+
+    for (int i = 0; i < kBackgroundIOTypeNum; ++i) {
+        IOClass& ioClass = classes_[i];
+        uint64_t bps = share(options_.bpsLimit, i);
+        uint64_t iops = share(options_.iopsLimit, i);
+        ioClass.bpsLimit.store(bps);
+        ioClass.iopsLimit.store(iops);
+
+        ReadWriteThrottleParams params;
+        params.bpsTotal = ThrottleParams(bps, 0, 0);
+        params.iopsTotal = ThrottleParams(iops, 0, 0);
+        ioClass.throttle.UpdateThrottleParams(params);
+    }
+}
+
+void BackgroundIOScheduler::AdjustWorker() {
+    while (sleeper_.wait_for(
+        std::chrono::milliseconds(options_.adjustIntervalMs))) {
+        Adjust();
+    }
+}
+
+uint32_t BackgroundIOScheduler::GetRatioPercent(void* arg) {
+    auto scheduler = reinterpret_cast<BackgroundIOScheduler*>(arg);
+    return scheduler->RatioPercent();
+}
+
+}  // namespace common
+}  // namespace curve
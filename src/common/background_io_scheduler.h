@@ -0,0 +1,168 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_COMMON_BACKGROUND_IO_SCHEDULER_H_
+#define SRC_COMMON_BACKGROUND_IO_SCHEDULER_H_
+
+#include <bvar/bvar.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "src/common/concurrent/concurrent.h"
+#include "src/common/interruptible_sleeper.h"
+#include "src/common/throttle.h"
+#include "src/common/uncopyable.h"
+
+namespace curve {
+namespace common {
+
+// 后台IO的类别
+enum class BackgroundIOType {
+    // 副本一致性扫描
+    SCAN = 0,
+    // 从源端恢复clone chunk
+    CLONE = 1,
+    // 回收站回收chunk和wal文件
+    TRASH = 2,
+    // 预分配chunk文件池
+    FORMAT = 3,
+    // 清理回收的chunk
+    CLEAN = 4,
+};
+
+const int kBackgroundIOTypeNum = 5;
+
+const char* BackgroundIOTypeName(BackgroundIOType type);
+
+struct BackgroundIOSchedulerOptions {
+    // 所有后台IO的总带宽上限(bytes/s)，为0表示不限制
+    uint64_t bpsLimit = 0;
+    // 所有后台IO的总iops上限，为0表示不限制
+    uint64_t iopsLimit = 0;
+    // 各类后台IO分配带宽和iops的权重，按BackgroundIOType排列
+    uint32_t weights[kBackgroundIOTypeNum] = {1, 2, 1, 2, 1};
+    // 前台读写的平均时延超过该值时减少后台IO的配额，为0表示不根据时延调整
+    uint64_t latencyThresholdUs = 0;
+    // 根据时延调整后，后台IO配额的最小百分比
+    uint32_t minRatioPercent = 10;
+    // 调整配额的周期
+    uint32_t adjustIntervalMs = 1000;
+};
+
+/**
+ * chunkserver的后台IO调度器
+ * 扫描、克隆恢复、回收站、文件池格式化和清理在发起磁盘IO前调用Acquire，
+ * 总的带宽和iops按权重分配给最近有IO的类别，没有IO的类别的份额由其他类别使用。
+ * 前台读写完成后调用OnForegroundIO上报时延，每个调整周期内平均时延超过阈值时
+ * 后台IO的总配额减半，否则逐步恢复
+ */
+class BackgroundIOScheduler : public Uncopyable {
+ public:
+    BackgroundIOScheduler();
+    ~BackgroundIOScheduler();
+
+    static BackgroundIOScheduler& GetInstance();
+
+    /**
+     * 初始化并启动配额调整线程，未初始化时Acquire只统计metric，不做限制
+     * @return 成功返回0，失败返回-1
+     */
+    int Init(const BackgroundIOSchedulerOptions& options);
+
+    /**
+     * 停止调整线程，之后的Acquire只统计metric，不做限制
+     */
+    void Stop();
+
+    /**
+     * 申请一次后台IO的配额，配额不足时阻塞，不能在前台IO路径上调用
+     * @param type: 后台IO的类别
+     * @param length: IO的字节数，只有元数据操作时为0
+     */
+    void Acquire(BackgroundIOType type, uint64_t length);
+
+    /**
+     * 上报一次前台读写的时延
+     */
+    void OnForegroundIO(uint64_t latencyUs) {
+        foregroundLatencyUs_.fetch_add(latencyUs, std::memory_order_relaxed);
+        foregroundCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * 根据上一个周期的前台时延和各类别的IO情况重新计算配额，
+     * 由调整线程周期性调用
+     */
+    void Adjust();
+
+    // 当前后台IO总配额的百分比
+    uint32_t RatioPercent() const {
+        return ratioPercent_.load(std::memory_order_relaxed);
+    }
+
+    // 当前分配给某类后台IO的带宽上限，为0表示不限制
+    uint64_t BpsLimit(BackgroundIOType type) const {
+        return classes_[static_cast<int>(type)].bpsLimit.load(
+            std::memory_order_relaxed);
+    }
+
+    // 当前分配给某类后台IO的iops上限，为0表示不限制
+    uint64_t IopsLimit(BackgroundIOType type) const {
+        return classes_[static_cast<int>(type)].iopsLimit.load(
+            std::memory_order_relaxed);
+    }
+
+ private:
+    struct IOClass {
+        IOClass() : bps(&bytes), iops(&ios) {}
+
+        Throttle throttle;
+        // 本周期内的IO次数，用于判断是否活跃
+        std::atomic<uint64_t> recentIOs{0};
+        std::atomic<uint64_t> bpsLimit{0};
+        std::atomic<uint64_t> iopsLimit{0};
+
+        bvar::Adder<uint64_t> bytes;
+        bvar::Adder<uint64_t> ios;
+        // 因配额不足而等待的总时间
+        bvar::Adder<uint64_t> waitUs;
+        bvar::PerSecond<bvar::Adder<uint64_t>> bps;
+        bvar::PerSecond<bvar::Adder<uint64_t>> iops;
+    };
+
+    void AdjustWorker();
+    static uint32_t GetRatioPercent(void* arg);
+
+ private:
+    BackgroundIOSchedulerOptions options_;
+    std::atomic<bool> running_;
+    std::atomic<uint32_t> ratioPercent_;
+    std::atomic<uint64_t> foregroundLatencyUs_;
+    std::atomic<uint64_t> foregroundCount_;
+    IOClass classes_[kBackgroundIOTypeNum];
+
+    Thread adjustThread_;
+    InterruptibleSleeper sleeper_;
+    std::unique_ptr<bvar::PassiveStatus<uint32_t>> ratioStatus_;
+};
+
+}  // namespace common
+}  // namespace curve
+
+#endif  // SRC_COMMON_BACKGROUND_IO_SCHEDULER_H_
@@ -138,10 +138,7 @@ void Bitmap::Set(uint32_t index) {
 }
 
 void Bitmap::Set(uint32_t startIndex, uint32_t endIndex) {
-    // TODO(wuhanqing): implement fast algorithm if one byte is all set
-    for (uint32_t index = startIndex; index <= endIndex; ++index) {
-        Set(index);
-    }
+    SetRange(startIndex, endIndex, true);
 }
 
 void Bitmap::Clear() {
@@ -154,9 +151,29 @@ void Bitmap::Clear(uint32_t index) {
 }
 
 void Bitmap::Clear(uint32_t startIndex, uint32_t endIndex) {
-    // TODO(wuhanqing): implement fast algorithm if one byte is all clear
-    for (uint32_t index = startIndex; index <= endIndex; ++index) {
-        Clear(index);
+    SetRange(startIndex, endIndex, false);
+}
+
+void Bitmap::SetRange(uint32_t startIndex, uint32_t endIndex, bool set) {
+    if (bits_ == 0 || startIndex > endIndex || startIndex >= bits_)
+        return;
+    if (endIndex > bits_ - 1)
+        endIndex = bits_ - 1;
+
+    uint64_t index = startIndex;
+    // 起始的不完整字节逐位处理
+    for (; index <= endIndex && (index % BITMAP_UNIT_SIZE) != 0; ++index) {
+        set ? Set(index) : Clear(index);
+    }
+    // 中间的完整字节整体处理
+    uint64_t units = (endIndex + 1 - index) >> ALIGN_FACTOR;
+    if (index <= endIndex && units > 0) {
+        memset(bitmap_ + indexOfUnit(index), set ? 0xff : 0, units);
+        index += units << ALIGN_FACTOR;
+    }
+    // 结尾的不完整字节逐位处理
+    for (; index <= endIndex; ++index) {
+        set ? Set(index) : Clear(index);
     }
 }
 
@@ -168,54 +185,65 @@ bool Bitmap::Test(uint32_t index) const {
 }
 
 uint32_t Bitmap::NextSetBit(uint32_t index) const {
-    for (; index < bits_; ++index) {
-        if (Test(index))
-            break;
-    }
-    if (index >= bits_)
-        index = NO_POS;
-    return index;
+    return NextBit(index, bits_ - 1, true);
 }
 
 uint32_t Bitmap::NextSetBit(uint32_t startIndex, uint32_t endIndex) const {
-    uint32_t index = startIndex;
-    // bitmap中最后一个bit的index值
-    uint32_t lastIndex = bits_ - 1;
-    // endIndex值不能超过lastIndex
-    if (endIndex > lastIndex)
-        endIndex = lastIndex;
-    for (; index <= endIndex; ++index) {
-        if (Test(index))
-            break;
-    }
-    if (index > endIndex)
-        index = NO_POS;
-    return index;
+    return NextBit(startIndex, endIndex, true);
 }
 
 uint32_t Bitmap::NextClearBit(uint32_t index) const {
-    for (; index < bits_; ++index) {
-        if (!Test(index))
-            break;
-    }
-    if (index >= bits_)
-        index = NO_POS;
-    return index;
+    return NextBit(index, bits_ - 1, false);
 }
 
 uint32_t Bitmap::NextClearBit(uint32_t startIndex, uint32_t endIndex) const {
-    uint32_t index = startIndex;
-    uint32_t lastIndex = bits_ - 1;
+    return NextBit(startIndex, endIndex, false);
+}
+
+uint32_t Bitmap::NextBit(uint32_t startIndex,
+                         uint32_t endIndex,
+                         bool set) const {
+    if (bits_ == 0)
+        return NO_POS;
     // endIndex值不能超过lastIndex
-    if (endIndex > lastIndex)
-        endIndex = lastIndex;
-    for (; index <= endIndex; ++index) {
-        if (!Test(index))
-            break;
+    if (endIndex > bits_ - 1)
+        endIndex = bits_ - 1;
+
+    // 不包含要查找的位的字节的值
+    const uint64_t skipWord = set ? 0 : ~0ULL;
+    const unsigned char skipUnit = set ? 0 : 0xff;
+    const uint32_t lastUnit = indexOfUnit(endIndex);
+    uint64_t index = startIndex;
+    while (index <= endIndex) {
+        if (index % BITMAP_UNIT_SIZE == 0) {
+            // 按8个字节和单个字节跳过不包含要查找的位的区域
+            uint32_t unit = indexOfUnit(index);
+            while (unit + sizeof(uint64_t) <= lastUnit) {
+                uint64_t word;
+                memcpy(&word, bitmap_ + unit, sizeof(word));
+                if (word != skipWord)
+                    break;
+                unit += sizeof(uint64_t);
+            }
+            while (unit < lastUnit &&
+                   static_cast<unsigned char>(bitmap_[unit]) == skipUnit) {
+                ++unit;
+            }
+            index = static_cast<uint64_t>(unit) << ALIGN_FACTOR;
+        }
+
+        unsigned char unitValue = bitmap_[indexOfUnit(index)];
+        if (!set)
+            unitValue = ~unitValue;
+        unitValue >>= index % BITMAP_UNIT_SIZE;
+        if (unitValue != 0) {
+            uint64_t found = index + __builtin_ctz(unitValue);
+            return found <= endIndex ? found : NO_POS;
+        }
+        // 跳到下一个字节的起始位置
+        index = (index | (BITMAP_UNIT_SIZE - 1)) + 1;
     }
-    if (index > endIndex)
-        index = NO_POS;
-    return index;
+    return NO_POS;
 }
 
 void Bitmap::Divide(uint32_t startIndex,
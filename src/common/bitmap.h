@@ -182,6 +182,11 @@ class Bitmap {
     const char* GetBitmap() const;
 
  private:
+    // 将指定范围的位置为1或0，完整的字节整体设置
+    void SetRange(uint32_t startIndex, uint32_t endIndex, bool set);
+    // 查找指定范围内首个状态为set的位，跳过全0或全1的字节
+    uint32_t NextBit(uint32_t startIndex, uint32_t endIndex, bool set) const;
+
     // bitmap的字节数
     int unitCount() const {
         // 同 (bits_ + BITMAP_UNIT_SIZE - 1) / BITMAP_UNIT_SIZE
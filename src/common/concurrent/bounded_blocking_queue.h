@@ -100,6 +100,25 @@ class BoundedBlockingDeque : public Uncopyable {
         notEmpty_.notify_one();
     }
 
+    /**
+     * 批量放入[first, last)中的元素，只加一次锁，队列满时先唤醒消费者再等待
+     */
+    template<typename Iter>
+    void PutBack(Iter first, Iter last) {
+        if (first == last) {
+            return;
+        }
+        std::unique_lock<std::mutex> guard(mutex_);
+        for (; first != last; ++first) {
+            while (deque_.size() == capacity_) {
+                notEmpty_.notify_all();
+                notFull_.wait(guard);
+            }
+            deque_.push_back(*first);
+        }
+        notEmpty_.notify_all();
+    }
+
     void PutFront(const T &x) {
         std::unique_lock<std::mutex> guard(mutex_);
         while (deque_.size() == capacity_) {
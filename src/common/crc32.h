@@ -54,6 +54,77 @@ inline uint32_t CRC32(uint32_t crc, const char *pData, size_t iLen) {
     return butil::crc32c::Extend(crc, pData, iLen);
 }
 
+namespace detail {
+
+inline uint32_t GF2MatrixTimes(const uint32_t *mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+inline void GF2MatrixSquare(uint32_t *square, const uint32_t *mat) {
+    for (int n = 0; n < 32; n++) {
+        square[n] = GF2MatrixTimes(mat, mat[n]);
+    }
+}
+
+}  // namespace detail
+
+/**
+ * 由两段数据各自的CRC32C拼接出整段数据的CRC32C，不需要重新读取数据，
+ * 算法同zlib的crc32_combine。满足如下约束:
+ * CRC32("hello world", 11) ==
+ *     CRC32Combine(CRC32("hello ", 6), CRC32("world", 5), 5)
+ * @param crc1 第一段数据的crc校验码
+ * @param crc2 第二段数据的crc校验码
+ * @param len2 第二段数据的长度
+ * @return 32位的数据CRC32校验码
+ */
+inline uint32_t CRC32Combine(uint32_t crc1, uint32_t crc2, size_t len2) {
+    if (len2 == 0) {
+        return crc1;
+    }
+
+    uint32_t even[32];
+    uint32_t odd[32];
+    // 长度为1bit的0对应的变换矩阵，CRC32C的多项式(反转)为0x82F63B78
+    odd[0] = 0x82F63B78;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; n++) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    // 2bit
+    detail::GF2MatrixSquare(even, odd);
+    // 4bit
+    detail::GF2MatrixSquare(odd, even);
+
+    // 按len2的二进制位依次叠加长度为1,2,4...字节的0对crc1的变换
+    do {
+        detail::GF2MatrixSquare(even, odd);
+        if (len2 & 1) {
+            crc1 = detail::GF2MatrixTimes(even, crc1);
+        }
+        len2 >>= 1;
+        if (len2 == 0) {
+            break;
+        }
+        detail::GF2MatrixSquare(odd, even);
+        if (len2 & 1) {
+            crc1 = detail::GF2MatrixTimes(odd, crc1);
+        }
+        len2 >>= 1;
+    } while (len2 != 0);
+
+    return crc1 ^ crc2;
+}
+
 }  // namespace common
 }  // namespace curve
 
@@ -85,12 +85,13 @@ void Throttle::ResetThrottleParams(Type type, uint64_t limit, uint64_t burst,
             continue;
         }
 
-        throttle.enabled = (limit != 0);
+        throttle.enabled.store(limit != 0);
         throttle.leakyBucket->SetLimit(limit, burst, burstLength);
     }
 }
 
 void Throttle::UpdateThrottleParams(const ReadWriteThrottleParams& params) {
+    std::lock_guard<std::mutex> lk(updateMtx_);
     UpdateIfNotEqual(Type::IOPS_TOTAL, throttleParams_.iopsTotal,
                      params.iopsTotal);
     UpdateIfNotEqual(Type::IOPS_READ, throttleParams_.iopsRead,
@@ -23,8 +23,10 @@
 #ifndef SRC_COMMON_THROTTLE_H_
 #define SRC_COMMON_THROTTLE_H_
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -55,12 +57,18 @@ class Throttle {
 
     struct InternalThrottle {
         Type type;
-        bool enabled;
+        // read by Add without lock while the params are updated
+        std::atomic<bool> enabled;
         std::unique_ptr<common::LeakyBucket> leakyBucket;
 
         InternalThrottle(Type type, bool enabled,
                          common::LeakyBucket* leakyBucket)
             : type(type), enabled(enabled), leakyBucket(leakyBucket) {}
+
+        InternalThrottle(InternalThrottle&& other)
+            : type(other.type),
+              enabled(other.enabled.load()),
+              leakyBucket(std::move(other.leakyBucket)) {}
     };
 
  public:
@@ -84,7 +92,8 @@ class Throttle {
     void Add(bool isRead, uint64_t length);
 
     /**
-     * @brief Update throttle params
+     * @brief Update throttle params, it can be called while other threads
+     *        are adding tokens, and the updates are serialized
      * @param params throttle params
      */
     void UpdateThrottleParams(const ReadWriteThrottleParams& params);
@@ -123,6 +132,10 @@ class Throttle {
     bool IsReadThrottle(Type type) const;
     bool IsIOPSThrottle(Type type) const;
 
+    // serialize the updates of throttle params, the leaky buckets are
+    // protected by their own locks
+    std::mutex updateMtx_;
+
     // current throttle params
     ReadWriteThrottleParams throttleParams_;
 
@@ -416,5 +416,17 @@ int Ext4FileSystemImpl::Fsync(int fd) {
     return 0;
 }
 
+int Ext4FileSystemImpl::SyncFileRange(int fd,
+                                      uint64_t offset,
+                                      uint64_t nbytes,
+                                      unsigned int flags) {
+    int rc = posixWrapper_->sync_file_range(fd, offset, nbytes, flags);
+    if (rc < 0) {
+        LOG(ERROR) << "sync_file_range failed: " << strerror(errno);
+        return -errno;
+    }
+    return 0;
+}
+
 }  // namespace fs
 }  // namespace curve
@@ -61,9 +61,13 @@ class Ext4FileSystemImpl : public LocalFileSystem {
                   int length) override;
     int Fstat(int fd, struct stat* info) override;
     int Fsync(int fd) override;
+    int SyncFileRange(int fd, uint64_t offset, uint64_t nbytes,
+                      unsigned int flags) override;
 
- private:
+ protected:
     explicit Ext4FileSystemImpl(std::shared_ptr<PosixWrapper>);
+
+ private:
     int DoRename(const string& oldPath,
                  const string& newPath,
                  unsigned int flags) override;
@@ -29,6 +29,8 @@ namespace fs {
 enum class FileSystemType {
     // SFS,
     EXT4,
+    // ext4 with asynchronous IO submitted through io_uring
+    EXT4_IO_URING,
 };
 
 struct FileSystemInfo {
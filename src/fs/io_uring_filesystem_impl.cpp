@@ -0,0 +1,435 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <glog/logging.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "src/fs/io_uring_filesystem_impl.h"
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+
+namespace curve {
+namespace fs {
+
+namespace {
+
+int IoUringSetup(unsigned entries, struct io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                 unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, nullptr, 0));
+}
+
+}  // namespace
+
+// io_uring的提交队列和完成队列，通过mmap与内核共享
+struct IoUringFileSystemImpl::Ring {
+    int fd = -1;
+    void* sqPtr = MAP_FAILED;
+    size_t sqSize = 0;
+    void* cqPtr = MAP_FAILED;
+    size_t cqSize = 0;
+    struct io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqEntries = 0;
+
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    struct io_uring_cqe* cqes = nullptr;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqPtr != MAP_FAILED && cqPtr != sqPtr) {
+            munmap(cqPtr, cqSize);
+        }
+        if (sqPtr != MAP_FAILED) {
+            munmap(sqPtr, sqSize);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+struct IoUringFileSystemImpl::AioRequest {
+    uint8_t opcode;
+    int fd;
+    char* buf;
+    uint64_t offset;
+    int length;
+    // 已经完成的数据长度，短读写时从这里继续提交
+    int done;
+    int retryTimes;
+    struct iovec iov;
+    AioCallback cb;
+};
+
+std::shared_ptr<IoUringFileSystemImpl> IoUringFileSystemImpl::self_ = nullptr;
+std::mutex IoUringFileSystemImpl::mutex_;
+
+IoUringFileSystemImpl::IoUringFileSystemImpl(
+    std::shared_ptr<PosixWrapper> posixWrapper)
+    : Ext4FileSystemImpl(posixWrapper)
+    , inflight_(0)
+    , depth_(0) {
+}
+
+IoUringFileSystemImpl::~IoUringFileSystemImpl() {
+    Fini();
+}
+
+std::shared_ptr<IoUringFileSystemImpl> IoUringFileSystemImpl::getInstance() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (self_ == nullptr) {
+        std::shared_ptr<PosixWrapper> wrapper =
+            std::make_shared<PosixWrapper>();
+        self_ = std::shared_ptr<IoUringFileSystemImpl>(
+                new(std::nothrow) IoUringFileSystemImpl(wrapper));
+        CHECK(self_ != nullptr) << "Failed to new io_uring local fs.";
+    }
+    return self_;
+}
+
+int IoUringFileSystemImpl::Init(const LocalFileSystemOption& option) {
+    int ret = Ext4FileSystemImpl::Init(option);
+    if (ret != 0) {
+        return ret;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ring_ != nullptr) {
+        return 0;
+    }
+    ret = SetupRing(option.ioUringQueueDepth);
+    if (ret < 0) {
+        LOG(WARNING) << "Setup io_uring failed, asynchronous io will be "
+                     << "executed synchronously, error: " << strerror(-ret);
+        return 0;
+    }
+    reaper_ = std::thread(&IoUringFileSystemImpl::ReapCompletions, this);
+    LOG(INFO) << "io_uring enabled, queue depth: " << depth_;
+    return 0;
+}
+
+void IoUringFileSystemImpl::Fini() {
+    if (ring_ == nullptr) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lk(inflightMutex_);
+        inflightCond_.wait(lk, [this] { return inflight_ == 0; });
+    }
+    // 提交一个空请求唤醒完成线程，使其退出
+    int ret = Enqueue(nullptr);
+    if (ret < 0) {
+        LOG(ERROR) << "Failed to stop io_uring reaper, error: "
+                   << strerror(-ret);
+    } else if (reaper_.joinable()) {
+        reaper_.join();
+    }
+    DestroyRing();
+}
+
+int IoUringFileSystemImpl::SetupRing(uint32_t depth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = IoUringSetup(depth, &params);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    std::unique_ptr<Ring> ring(new Ring());
+    ring->fd = fd;
+    ring->sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqSize = params.cq_off.cqes +
+                   params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        ring->sqSize = ring->cqSize = std::max(ring->sqSize, ring->cqSize);
+    }
+
+    ring->sqPtr = mmap(nullptr, ring->sqSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sqPtr == MAP_FAILED) {
+        return -errno;
+    }
+    if (singleMmap) {
+        ring->cqPtr = ring->sqPtr;
+    } else {
+        ring->cqPtr = mmap(nullptr, ring->cqSize, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cqPtr == MAP_FAILED) {
+            return -errno;
+        }
+    }
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = static_cast<io_uring_sqe*>(
+        mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (ring->sqes == MAP_FAILED) {
+        return -errno;
+    }
+
+    char* sq = static_cast<char*>(ring->sqPtr);
+    ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring->sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    ring->sqEntries = params.sq_entries;
+
+    char* cq = static_cast<char*>(ring->cqPtr);
+    ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring->cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // 完成队列的长度至少是提交队列的两倍，inflight不超过提交队列长度时
+    // 完成队列不会溢出，提交队列也总有空闲位置
+    depth_ = std::min(depth, ring->sqEntries);
+    ring_ = std::move(ring);
+    return 0;
+}
+
+void IoUringFileSystemImpl::DestroyRing() {
+    ring_.reset();
+}
+
+int IoUringFileSystemImpl::ReadAsync(int fd, char* buf, uint64_t offset,
+                                     int length, AioCallback cb) {
+    // 完成线程中提交的请求同步执行，避免inflight配额耗尽时死锁
+    if (ring_ == nullptr || std::this_thread::get_id() == reaper_.get_id()) {
+        return LocalFileSystem::ReadAsync(fd, buf, offset, length, cb);
+    }
+    AioRequest* req = new AioRequest();
+    req->opcode = IORING_OP_READV;
+    req->fd = fd;
+    req->buf = buf;
+    req->offset = offset;
+    req->length = length;
+    req->done = 0;
+    req->retryTimes = 0;
+    req->cb = std::move(cb);
+    return Submit(req);
+}
+
+int IoUringFileSystemImpl::WriteAsync(int fd, const char* buf,
+                                      uint64_t offset, int length,
+                                      AioCallback cb) {
+    if (ring_ == nullptr || std::this_thread::get_id() == reaper_.get_id()) {
+        return LocalFileSystem::WriteAsync(fd, buf, offset, length, cb);
+    }
+    AioRequest* req = new AioRequest();
+    req->opcode = IORING_OP_WRITEV;
+    req->fd = fd;
+    req->buf = const_cast<char*>(buf);
+    req->offset = offset;
+    req->length = length;
+    req->done = 0;
+    req->retryTimes = 0;
+    req->cb = std::move(cb);
+    return Submit(req);
+}
+
+int IoUringFileSystemImpl::SyncAsync(int fd, AioCallback cb) {
+    if (ring_ == nullptr || std::this_thread::get_id() == reaper_.get_id()) {
+        return LocalFileSystem::SyncAsync(fd, cb);
+    }
+    AioRequest* req = new AioRequest();
+    req->opcode = IORING_OP_FSYNC;
+    req->fd = fd;
+    req->buf = nullptr;
+    req->offset = 0;
+    req->length = 0;
+    req->done = 0;
+    req->retryTimes = 0;
+    req->cb = std::move(cb);
+    return Submit(req);
+}
+
+int IoUringFileSystemImpl::Submit(AioRequest* req) {
+    {
+        std::unique_lock<std::mutex> lk(inflightMutex_);
+        inflightCond_.wait(lk, [this] { return inflight_ < depth_; });
+        ++inflight_;
+    }
+    int ret = Enqueue(req);
+    if (ret < 0) {
+        delete req;
+        std::lock_guard<std::mutex> lk(inflightMutex_);
+        --inflight_;
+        inflightCond_.notify_all();
+    }
+    return ret;
+}
+
+int IoUringFileSystemImpl::Enqueue(AioRequest* req) {
+    std::lock_guard<std::mutex> lock(sqMutex_);
+    Ring* ring = ring_.get();
+    unsigned tail = *ring->sqTail;
+    unsigned index = tail & *ring->sqMask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    if (req == nullptr) {
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = 0;
+    } else {
+        sqe->opcode = req->opcode;
+        sqe->fd = req->fd;
+        sqe->user_data = reinterpret_cast<uint64_t>(req);
+        if (req->opcode == IORING_OP_FSYNC) {
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        } else {
+            req->iov.iov_base = req->buf + req->done;
+            req->iov.iov_len = req->length - req->done;
+            sqe->addr = reinterpret_cast<uint64_t>(&req->iov);
+            sqe->len = 1;
+            sqe->off = req->offset + req->done;
+        }
+    }
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    while (true) {
+        int ret = IoUringEnter(ring->fd, 1, 0, 0);
+        if (ret >= 0) {
+            return 0;
+        }
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+            std::this_thread::yield();
+            continue;
+        }
+        int err = errno;
+        LOG(ERROR) << "io_uring_enter failed, fd: "
+                   << (req == nullptr ? -1 : req->fd)
+                   << ", error: " << strerror(err);
+        // 内核只在io_uring_enter时消费提交队列，失败时可以直接回退
+        __atomic_store_n(ring->sqTail, tail, __ATOMIC_RELEASE);
+        return -err;
+    }
+}
+
+void IoUringFileSystemImpl::ReapCompletions() {
+    Ring* ring = ring_.get();
+    bool stop = false;
+    while (!stop) {
+        int ret = IoUringEnter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && errno != EINTR) {
+            LOG(ERROR) << "io_uring wait completion failed, error: "
+                       << strerror(errno);
+        }
+        unsigned head = *ring->cqHead;
+        unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cqMask];
+            uint64_t userData = cqe->user_data;
+            int res = cqe->res;
+            ++head;
+            __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+            if (userData == 0) {
+                stop = true;
+                continue;
+            }
+            OnComplete(reinterpret_cast<AioRequest*>(userData), res);
+        }
+    }
+}
+
+void IoUringFileSystemImpl::OnComplete(AioRequest* req, int res) {
+    if (res < 0) {
+        if ((res == -EINTR || res == -EAGAIN) &&
+            req->retryTimes < MAX_RETYR_TIME) {
+            ++req->retryTimes;
+            int ret = Enqueue(req);
+            if (ret < 0) {
+                Finish(req, ret);
+            }
+            return;
+        }
+        LOG(ERROR) << "io_uring request failed, fd: " << req->fd
+                   << ", opcode: " << static_cast<int>(req->opcode)
+                   << ", size: " << req->length - req->done
+                   << ", offset: " << req->offset + req->done
+                   << ", error: " << strerror(-res);
+        Finish(req, res);
+        return;
+    }
+
+    if (req->opcode == IORING_OP_FSYNC) {
+        Finish(req, 0);
+        return;
+    }
+
+    // 如果offset大于文件长度，读会返回0
+    if (res == 0) {
+        if (req->opcode == IORING_OP_READV) {
+            LOG(WARNING) << "io_uring read returns zero."
+                         << "offset: " << req->offset + req->done
+                         << ", length: " << req->length - req->done;
+            Finish(req, req->done);
+        } else {
+            LOG(ERROR) << "io_uring write returns zero, fd: " << req->fd
+                       << ", offset: " << req->offset + req->done
+                       << ", length: " << req->length - req->done;
+            Finish(req, -EIO);
+        }
+        return;
+    }
+
+    req->done += res;
+    if (req->done < req->length) {
+        int ret = Enqueue(req);
+        if (ret < 0) {
+            Finish(req, ret);
+        }
+        return;
+    }
+    Finish(req, req->length);
+}
+
+void IoUringFileSystemImpl::Finish(AioRequest* req, int ret) {
+    AioCallback cb = std::move(req->cb);
+    delete req;
+    {
+        std::lock_guard<std::mutex> lk(inflightMutex_);
+        --inflight_;
+        inflightCond_.notify_all();
+    }
+    cb(ret);
+}
+
+}  // namespace fs
+}  // namespace curve
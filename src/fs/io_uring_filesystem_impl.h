@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef SRC_FS_IO_URING_FILESYSTEM_IMPL_H_
+#define SRC_FS_IO_URING_FILESYSTEM_IMPL_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "src/fs/ext4_filesystem_impl.h"
+#include "src/fs/wrap_posix.h"
+
+namespace curve {
+namespace fs {
+
+/**
+ * 在Ext4FileSystemImpl的基础上，通过io_uring提交异步读写和sync请求
+ * 同步接口的行为与Ext4FileSystemImpl完全一致
+ * 如果内核不支持io_uring，异步接口会退化为同步执行
+ */
+class IoUringFileSystemImpl : public Ext4FileSystemImpl {
+ public:
+    ~IoUringFileSystemImpl() override;
+    static std::shared_ptr<IoUringFileSystemImpl> getInstance();
+
+    int Init(const LocalFileSystemOption& option) override;
+    int ReadAsync(int fd, char* buf, uint64_t offset, int length,
+                  AioCallback cb) override;
+    int WriteAsync(int fd, const char* buf, uint64_t offset, int length,
+                   AioCallback cb) override;
+    int SyncAsync(int fd, AioCallback cb) override;
+
+    /**
+     * 停止io_uring，等待所有已提交的请求完成后返回
+     * 之后的异步请求会同步执行
+     */
+    void Fini();
+
+    // io_uring是否可用
+    bool IoUringEnabled() const {
+        return ring_ != nullptr;
+    }
+
+ private:
+    struct Ring;
+    struct AioRequest;
+
+    explicit IoUringFileSystemImpl(std::shared_ptr<PosixWrapper>);
+
+    int SetupRing(uint32_t depth);
+    void DestroyRing();
+    // 占用一个inflight配额后提交请求，配额不足时阻塞
+    int Submit(AioRequest* req);
+    // 将请求放入提交队列并通知内核，调用方需已占用inflight配额
+    int Enqueue(AioRequest* req);
+    void ReapCompletions();
+    void OnComplete(AioRequest* req, int res);
+    void Finish(AioRequest* req, int ret);
+
+ private:
+    static std::shared_ptr<IoUringFileSystemImpl> self_;
+    static std::mutex mutex_;
+
+    std::unique_ptr<Ring> ring_;
+    // 保护提交队列
+    std::mutex sqMutex_;
+    // 已提交但未完成的请求数，不超过队列深度
+    uint32_t inflight_;
+    uint32_t depth_;
+    std::mutex inflightMutex_;
+    std::condition_variable inflightCond_;
+    std::thread reaper_;
+};
+
+}  // namespace fs
+}  // namespace curve
+
+#endif  // SRC_FS_IO_URING_FILESYSTEM_IMPL_H_
@@ -32,6 +32,7 @@
 #include <map>
 #include <string>
 #include <cstring>
+#include <functional>
 #include <mutex>  // NOLINT
 
 #include "src/fs/fs_common.h"
@@ -45,9 +46,18 @@ namespace fs {
 
 struct LocalFileSystemOption {
     bool enableRenameat2;
-    LocalFileSystemOption() : enableRenameat2(false) {}
+    // queue depth of io_uring, only used by IoUringFileSystemImpl
+    uint32_t ioUringQueueDepth;
+    LocalFileSystemOption() : enableRenameat2(false),
+                              ioUringQueueDepth(128) {}
 };
 
+/**
+ * 异步IO完成后的回调
+ * 参数的含义与对应同步接口的返回值相同
+ */
+using AioCallback = std::function<void(int)>;
+
 class LocalFileSystem {
  public:
      LocalFileSystem() {}
@@ -215,6 +225,70 @@ class LocalFileSystem {
      */
     virtual int Fsync(int fd) = 0;
 
+    /**
+     * 对文件指定区域发起回写或等待回写完成，语义同sync_file_range
+     * 不会刷新文件元数据和磁盘缓存，不能代替Sync保证数据持久化，
+     * 一般用于在Sync之前提前发起回写
+     * 默认实现不做任何操作
+     * @param fd：文件句柄id，通过Open接口获取
+     * @param offset：区域的起始偏移
+     * @param nbytes：区域的长度，为0表示直到文件末尾
+     * @param flags：SYNC_FILE_RANGE_*的组合
+     * @return 成功返回0，失败返回负值
+     */
+    virtual int SyncFileRange(int fd, uint64_t offset, uint64_t nbytes,
+                              unsigned int flags) {
+        (void)fd;
+        (void)offset;
+        (void)nbytes;
+        (void)flags;
+        return 0;
+    }
+
+    /**
+     * 异步读取文件指定区域的数据
+     * 默认实现会同步调用Read，然后在当前线程执行回调
+     * @param fd：文件句柄id，通过Open接口获取
+     * @param buf：接收读取数据的buffer，回调执行前必须保持有效
+     * @param offset：读取区域的起始偏移
+     * @param length：读取数据的长度
+     * @param cb：读取完成后的回调，参数为成功读取到的数据长度，失败为负值
+     * @return 成功提交返回0，此时回调一定会被执行；失败返回负值，回调不会被执行
+     */
+    virtual int ReadAsync(int fd, char* buf, uint64_t offset, int length,
+                          AioCallback cb) {
+        cb(Read(fd, buf, offset, length));
+        return 0;
+    }
+
+    /**
+     * 异步向文件指定区域写入数据
+     * 默认实现会同步调用Write，然后在当前线程执行回调
+     * @param fd：文件句柄id，通过Open接口获取
+     * @param buf：待写入数据的buffer，回调执行前必须保持有效
+     * @param offset：写入区域的起始偏移
+     * @param length：写入数据的长度
+     * @param cb：写入完成后的回调，参数为成功写入的数据长度，失败为负值
+     * @return 成功提交返回0，此时回调一定会被执行；失败返回负值，回调不会被执行
+     */
+    virtual int WriteAsync(int fd, const char* buf, uint64_t offset,
+                           int length, AioCallback cb) {
+        cb(Write(fd, buf, offset, length));
+        return 0;
+    }
+
+    /**
+     * 异步将文件数据刷新到磁盘，语义同Sync
+     * 默认实现会同步调用Sync，然后在当前线程执行回调
+     * @param fd：文件句柄id，通过Open接口获取
+     * @param cb：完成后的回调，参数成功为0，失败为负值
+     * @return 成功提交返回0，此时回调一定会被执行；失败返回负值，回调不会被执行
+     */
+    virtual int SyncAsync(int fd, AioCallback cb) {
+        cb(Sync(fd));
+        return 0;
+    }
+
  private:
     virtual int DoRename(const string& /* oldPath */,
                          const string& /* newPath */,
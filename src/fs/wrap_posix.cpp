@@ -100,6 +100,13 @@ int PosixWrapper::fdatasync(int fd) {
     return ::fdatasync(fd);
 }
 
+int PosixWrapper::sync_file_range(int fd,
+                                  off64_t offset,
+                                  off64_t nbytes,
+                                  unsigned int flags) {
+    return ::sync_file_range(fd, offset, nbytes, flags);
+}
+
 int PosixWrapper::fstat(int fd, struct stat *buf) {
     return ::fstat(fd, buf);
 }
@@ -64,6 +64,10 @@ class PosixWrapper {
     virtual int fstat(int fd, struct stat *buf);
     virtual int fallocate(int fd, int mode, off_t offset, off_t len);
     virtual int fsync(int fd);
+    virtual int sync_file_range(int fd,
+                                off64_t offset,
+                                off64_t nbytes,
+                                unsigned int flags);
     virtual int statfs(const char *path, struct statfs *buf);
     virtual int uname(struct utsname *buf);
 };
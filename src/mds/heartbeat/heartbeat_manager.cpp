@@ -46,7 +46,8 @@ HeartbeatManager::HeartbeatManager(HeartbeatOption option,
     std::shared_ptr<TopologyStat> topologyStat,
     std::shared_ptr<Coordinator> coordinator)
     : topology_(topology),
-      topologyStat_(topologyStat) {
+      topologyStat_(topologyStat),
+      coordinator_(coordinator) {
     healthyChecker_ =
         std::make_shared<ChunkserverHealthyChecker>(option, topology);
 
@@ -119,8 +120,9 @@ void HeartbeatManager::UpdateChunkServerDiskStatus(
     }
 }
 
-void HeartbeatManager::UpdateChunkServerStatistics(
+bool HeartbeatManager::UpdateChunkServerStatistics(
     const ChunkServerHeartbeatRequest &request) {
+    bool merged = true;
     ChunkServerStat stat;
     stat.leaderCount = request.leadercount();
     stat.copysetCount = request.copysetcount();
@@ -181,11 +183,69 @@ void HeartbeatManager::UpdateChunkServerStatistics(
             stat.copysetStats.push_back(cstat);
         }
 
+        // a delta heartbeat only carries the changed copysets, keep the
+        // statistics of the others from the last heartbeat
+        if (request.deltareport()) {
+            merged = MergeCopysetStats(request, &stat);
+        }
     } else {
         LOG(WARNING) << "hearbeat manager receive request "
                      << "do not have ChunkServerStatisticInfo";
     }
     topologyStat_->UpdateChunkServerStat(request.chunkserverid(), stat);
+    return merged;
+}
+
+bool HeartbeatManager::MergeCopysetStats(
+    const ChunkServerHeartbeatRequest &request, ChunkServerStat *stat) {
+    ChunkServerStat lastStat;
+    if (!topologyStat_->GetChunkServerStat(request.chunkserverid(),
+                                           &lastStat)) {
+        LOG(INFO) << "heartbeat manager receive delta heartbeat from "
+                  << "chunkserver " << request.chunkserverid()
+                  << ", but has no statistics of it, require full report";
+        return false;
+    }
+
+    std::set<CopySetKey> updated;
+    for (const auto &cstat : stat->copysetStats) {
+        updated.emplace(cstat.logicalPoolId, cstat.copysetId);
+    }
+    for (const auto &removed : request.removedcopysets()) {
+        updated.emplace(removed.logicalpoolid(), removed.copysetid());
+    }
+    for (const auto &cstat : lastStat.copysetStats) {
+        if (updated.count(CopySetKey(cstat.logicalPoolId,
+                                     cstat.copysetId)) == 0) {
+            stat->copysetStats.push_back(cstat);
+        }
+    }
+    return true;
+}
+
+void HeartbeatManager::AddNeedReportCopySets(
+    const ChunkServerHeartbeatRequest &request,
+    ChunkServerHeartbeatResponse *response) {
+    std::set<CopySetKey> reported;
+    for (const auto &value : request.copysetinfos()) {
+        reported.emplace(value.logicalpoolid(), value.copysetid());
+    }
+
+    // operators are dispatched on the heartbeat of the copyset leader, so
+    // the leader must report the copyset even if nothing has changed
+    for (const auto &key : coordinator_->ListOperatorCopySets()) {
+        if (reported.count(key) != 0) {
+            continue;
+        }
+        ::curve::mds::topology::CopySetInfo info;
+        if (!topology_->GetCopySet(key, &info) ||
+            info.GetLeader() != request.chunkserverid()) {
+            continue;
+        }
+        CopySetIdentity *id = response->add_needreportcopysets();
+        id->set_logicalpoolid(key.first);
+        id->set_copysetid(key.second);
+    }
 }
 
 void HeartbeatManager::ChunkServerHeartbeat(
@@ -212,12 +272,20 @@ void HeartbeatManager::ChunkServerHeartbeat(
 
     UpdateChunkServerDiskStatus(request);
 
-    UpdateChunkServerStatistics(request);
+    bool statMerged = UpdateChunkServerStatistics(request);
 
     UpdateChunkServerVersion(request);
 
-    // no copyset info in the request
-    if (request.copysetinfos_size() == 0) {
+    // handshake of delta heartbeat, the chunkserver only sends delta
+    // heartbeats after receiving this flag
+    response->set_acceptdelta(true);
+    if (request.deltareport()) {
+        if (!statMerged) {
+            response->set_needfullreport(true);
+        }
+        AddNeedReportCopySets(request, response);
+    } else if (request.copysetinfos_size() == 0) {
+        // no copyset info in the request
         response->set_statuscode(HeartbeatStatusCode::hbRequestNoCopyset);
     }
     // dealing with copysets included in the heartbeat request
@@ -45,6 +45,7 @@ using ::curve::mds::topology::PoolIdType;
 using ::curve::mds::topology::CopySetIdType;
 using ::curve::mds::topology::Topology;
 using ::curve::mds::topology::TopologyStat;
+using ::curve::mds::topology::ChunkServerStat;
 using ::curve::mds::schedule::Coordinator;
 
 using ::curve::common::Thread;
@@ -123,10 +124,38 @@ class HeartbeatManager {
      * @brief Update statistical data of chunkserver
      *
      * @param request Heartbeat request
+     *
+     * @return false if the request is a delta heartbeat and there is no
+     *         statistics to merge it with, true otherwise
      */
-    void UpdateChunkServerStatistics(
+    bool UpdateChunkServerStatistics(
         const ChunkServerHeartbeatRequest &request);
 
+    /**
+     * @brief Merge the copyset statistics of a delta heartbeat with the
+     *        statistics of the last heartbeat
+     *
+     * @param[in] request Delta heartbeat request
+     * @param[in,out] stat Statistics of the request, the copysets not
+     *                     reported and not removed are added from the
+     *                     last heartbeat
+     *
+     * @return false if there is no statistics of the last heartbeat
+     */
+    bool MergeCopysetStats(const ChunkServerHeartbeatRequest &request,
+                           ChunkServerStat *stat);
+
+    /**
+     * @brief Require the chunkserver to report the copysets it leads and
+     *        which have operators waiting for dispatch in the next delta
+     *        heartbeat
+     *
+     * @param[in] request Delta heartbeat request
+     * @param[out] response Response of heartbeat request
+     */
+    void AddNeedReportCopySets(const ChunkServerHeartbeatRequest &request,
+                               ChunkServerHeartbeatResponse *response);
+
     /**
      * @brief Update version of chunkserver
      *
@@ -366,6 +366,14 @@ std::string Coordinator::ScheduleName(SchedulerType type) {
     }
 }
 
+std::vector<CopySetKey> Coordinator::ListOperatorCopySets() {
+    std::vector<CopySetKey> copysets;
+    for (auto &op : opController_->GetOperators()) {
+        copysets.emplace_back(op.copysetID);
+    }
+    return copysets;
+}
+
 std::shared_ptr<OperatorController> Coordinator::GetOpController() {
     return opController_;
 }
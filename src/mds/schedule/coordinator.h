@@ -84,6 +84,14 @@ class Coordinator {
      */
     virtual bool ChunkserverGoingToAdd(ChunkServerIdType csId, CopySetKey key);
 
+    /**
+     * @brief list the copysets which have operators waiting for the
+     *        heartbeat of their leaders
+     *
+     * @return copysets with operators
+     */
+    virtual std::vector<CopySetKey> ListOperatorCopySets();
+
     /**
      * @brief Initialize the scheduler according to the configuration
      *
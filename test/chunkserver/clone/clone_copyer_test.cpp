@@ -24,6 +24,9 @@
 #include <gmock/gmock.h>
 #include <glog/logging.h>
 
+#include <cstring>
+#include <vector>
+
 #include "include/client/libcurve.h"
 #include "src/chunkserver/clone_copyer.h"
 #include "src/chunkserver/clone_core.h"
@@ -364,5 +367,141 @@ TEST_F(CloneCopyerTest, ExpiredTest) {
     ASSERT_EQ(0, copyer.Fini());
 }
 
+TEST_F(CloneCopyerTest, SourceCacheTest) {
+    OriginCopyer copyer;
+    CopyerOptions options;
+    options.curveConf = CURVE_CONF;
+    options.s3Conf = S3_CONF;
+    options.curveUser.owner = ROOT_OWNER;
+    options.curveUser.password = ROOT_PWD;
+    options.curveClient = nullptr;
+    options.s3Client = s3Client_;
+    options.curveFileTimeoutSec = EXPIRED_USE;
+    options.chunkSize = 16384;
+    options.sourceCacheBytes = 16384;
+    options.sourceCacheBlockSize = 4096;
+    options.sourcePrefetchBlocks = 1;
+
+    // 缓存小于一个块时初始化失败
+    options.sourceCacheBytes = 1024;
+    ASSERT_EQ(-1, copyer.Init(options));
+    options.sourceCacheBytes = 16384;
+    ASSERT_EQ(0, copyer.Init(options));
+
+    // 按偏移填充数据，先保存下载请求，之后再回调
+    std::vector<std::shared_ptr<GetObjectAsyncContext>> contexts;
+    auto saveContext =
+        [&] (const std::shared_ptr<GetObjectAsyncContext>& context) {
+            for (size_t i = 0; i < context->len; ++i) {
+                context->buf[i] = (context->offset + i) % 251;
+            }
+            contexts.push_back(context);
+        };
+    auto finishContexts = [&] (int retCode) {
+        auto pending = std::move(contexts);
+        contexts.clear();
+        for (auto& context : pending) {
+            context->retCode = retCode;
+            context->cb(s3Client_.get(), context);
+        }
+    };
+    auto checkData = [] (const char* buf, off_t offset, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            if (buf[i] != static_cast<char>((offset + i) % 251)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    char buf1[2048];
+    char buf2[2048];
+    AsyncDownloadContext context1;
+    context1.location = "test@s3";
+    context1.offset = 1024;
+    context1.size = 2048;
+    context1.buf = buf1;
+    MockDownloadClosure closure1(&context1);
+    AsyncDownloadContext context2 = context1;
+    context2.buf = buf2;
+    MockDownloadClosure closure2(&context2);
+
+    /* 用例:并发读同一个块
+     * 预期:只下载一次该块，并预取下一个块
+     */
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .Times(2)
+        .WillRepeatedly(Invoke(saveContext));
+    copyer.DownloadAsync(&closure1);
+    copyer.DownloadAsync(&closure2);
+    ASSERT_FALSE(closure1.IsRun());
+    ASSERT_FALSE(closure2.IsRun());
+    ASSERT_EQ(2, contexts.size());
+    ASSERT_EQ(0, contexts[0]->offset);
+    ASSERT_EQ(4096, contexts[0]->len);
+    ASSERT_EQ(4096, contexts[1]->offset);
+    finishContexts(0);
+    ASSERT_TRUE(closure1.IsRun());
+    ASSERT_FALSE(closure1.IsFailed());
+    ASSERT_TRUE(checkData(buf1, 1024, 2048));
+    ASSERT_TRUE(closure2.IsRun());
+    ASSERT_FALSE(closure2.IsFailed());
+    ASSERT_TRUE(checkData(buf2, 1024, 2048));
+    closure1.Reset();
+
+    /* 用例:读取跨越两个已缓存的块
+     * 预期:直接从缓存返回，只预取后面的块
+     */
+    context1.offset = 3072;
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .WillOnce(Invoke(saveContext));
+    memset(buf1, 0, sizeof(buf1));
+    copyer.DownloadAsync(&closure1);
+    ASSERT_TRUE(closure1.IsRun());
+    ASSERT_FALSE(closure1.IsFailed());
+    ASSERT_TRUE(checkData(buf1, 3072, 2048));
+    ASSERT_EQ(1, contexts.size());
+    ASSERT_EQ(8192, contexts[0]->offset);
+    finishContexts(0);
+    closure1.Reset();
+
+    /* 用例:读chunk的最后一个块
+     * 预期:不预取chunk之外的数据
+     */
+    context1.offset = 12288;
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .WillOnce(Invoke(saveContext));
+    copyer.DownloadAsync(&closure1);
+    ASSERT_EQ(1, contexts.size());
+    ASSERT_EQ(12288, contexts[0]->offset);
+    finishContexts(0);
+    ASSERT_TRUE(closure1.IsRun());
+    ASSERT_TRUE(checkData(buf1, 12288, 2048));
+    closure1.Reset();
+
+    /* 用例:下载块失败
+     * 预期:按请求的区域直接下载
+     */
+    context1.location = "test2@s3";
+    context1.offset = 0;
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .Times(3)
+        .WillRepeatedly(Invoke(saveContext));
+    copyer.DownloadAsync(&closure1);
+    finishContexts(-1);
+    ASSERT_FALSE(closure1.IsRun());
+    ASSERT_EQ(1, contexts.size());
+    ASSERT_EQ(0, contexts[0]->offset);
+    ASSERT_EQ(2048, contexts[0]->len);
+    finishContexts(0);
+    ASSERT_TRUE(closure1.IsRun());
+    ASSERT_FALSE(closure1.IsFailed());
+    closure1.Reset();
+
+    EXPECT_CALL(*s3Client_, Deinit())
+        .Times(1);
+    ASSERT_EQ(0, copyer.Fini());
+}
+
 }  // namespace chunkserver
 }  // namespace curve
@@ -24,6 +24,7 @@
 
 #include <atomic>
 #include <functional>
+#include <vector>
 
 #include "proto/chunk.pb.h"
 #include "src/common/timeutility.h"
@@ -166,3 +167,66 @@ TEST(ConcurrentApplyModule, ConcurrentTest) {
     concurrentapply.Stop();
 }
 
+
+TEST(ConcurrentApplyModule, SlowTaskNotBlockOtherQueueTest) {
+    ConcurrentApplyModule concurrentapply;
+    // key 0 and key 2 were executed by the same thread before,
+    // now they are in different queues shared by both threads
+    ConcurrentApplyOption opt{2, 10, 1, 1, 8, 0};
+    ASSERT_TRUE(concurrentapply.Init(opt));
+
+    std::atomic<bool> release(false);
+    std::atomic<bool> slowDone(false);
+    auto slowtask = [&release, &slowDone]() {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        slowDone.store(true);
+    };
+    std::atomic<bool> fastDone(false);
+    auto fasttask = [&fastDone]() {
+        fastDone.store(true);
+    };
+
+    ASSERT_TRUE(concurrentapply.Push(0, ApplyTaskType::WRITE, slowtask));
+    ASSERT_TRUE(concurrentapply.Push(2, ApplyTaskType::WRITE, fasttask));
+    uint64_t startMs = curve::common::TimeUtility::GetTimeofDayMs();
+    while (!fastDone.load() &&
+           curve::common::TimeUtility::GetTimeofDayMs() - startMs < 5000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(fastDone.load());
+    ASSERT_FALSE(slowDone.load());
+
+    release.store(true);
+    concurrentapply.Flush();
+    ASSERT_TRUE(slowDone.load());
+    concurrentapply.Stop();
+}
+
+TEST(ConcurrentApplyModule, SameKeyInOrderTest) {
+    ConcurrentApplyModule concurrentapply;
+    ConcurrentApplyOption opt{4, 2, 1, 1};
+    ASSERT_TRUE(concurrentapply.Init(opt));
+
+    const int keyNum = 16;
+    const int taskNum = 1000;
+    std::vector<std::vector<int>> results(keyNum);
+    for (int i = 0; i < taskNum; i++) {
+        for (int key = 0; key < keyNum; key++) {
+            auto task = [&results, key, i]() {
+                results[key].push_back(i);
+            };
+            ASSERT_TRUE(concurrentapply.Push(key, ApplyTaskType::WRITE, task));
+        }
+    }
+    concurrentapply.Flush();
+
+    for (int key = 0; key < keyNum; key++) {
+        ASSERT_EQ(taskNum, results[key].size());
+        for (int i = 0; i < taskNum; i++) {
+            ASSERT_EQ(i, results[key][i]);
+        }
+    }
+    concurrentapply.Stop();
+}
@@ -23,8 +23,10 @@
 #include <gtest/gtest.h>
 #include <unistd.h>
 #include <brpc/server.h>
+#include <braft/local_file_meta.pb.h>
 
 #include <memory>
+#include <map>
 #include <cstdio>
 #include <vector>
 #include <string>
@@ -108,6 +110,25 @@ class FakeSnapshotWriter : public braft::SnapshotWriter {
     }
 };
 
+// 记录add_file时传入的file meta
+class RecordSnapshotWriter : public FakeSnapshotWriter {
+ public:
+    int add_file(const std::string &filename) override {
+        files[filename] = "";
+        return 0;
+    }
+
+    int add_file(const std::string &filename,
+                 const ::google::protobuf::Message *file_meta) override {
+        const braft::LocalFileMeta *meta =
+            dynamic_cast<const braft::LocalFileMeta *>(file_meta);
+        files[filename] = meta == nullptr ? "" : meta->user_meta();
+        return 0;
+    }
+
+    std::map<std::string, std::string> files;
+};
+
 class FakeClosure : public braft::Closure {
  public:
     void Run() {
@@ -258,6 +279,56 @@ TEST_F(CopysetNodeTest, error_test) {
         copysetNode.WaitSnapshotDone();
     }
 
+    // on_snapshot_save: chunk文件的meta中记录最后一次修改的日志index
+    {
+        LogicPoolID logicPoolID = 123;
+        CopysetID copysetID = 1345;
+        Configuration conf;
+        std::vector<std::string> files;
+        files.push_back("chunk_1");
+        files.push_back("chunk_1_snap_1");
+        files.push_back("test-1.txt");
+
+        const char *json = "{\"logicPoolId\":123,\"copysetId\":1345,\"epoch\":0,\"checksum\":774340440}";  // NOLINT
+        std::string jsonStr(json);
+
+        CopysetNode copysetNode(logicPoolID, copysetID, conf);
+        ASSERT_EQ(0, copysetNode.Init(defaultOptions_));
+        FakeClosure closure;
+        RecordSnapshotWriter writer;
+        std::shared_ptr<MockLocalFileSystem>
+            mockfs = std::make_shared<MockLocalFileSystem>();
+        std::unique_ptr<ConfEpochFile>
+            epochFile(new ConfEpochFile(mockfs));;
+
+        copysetNode.SetLocalFileSystem(mockfs);
+        copysetNode.SetConfEpochFile(std::move(epochFile));
+        EXPECT_CALL(*mockfs, Open(_, _)).Times(1).WillOnce(Return(10));
+        EXPECT_CALL(*mockfs, Write(_, Matcher<const char*>(_), _, _)).Times(1)
+            .WillOnce(Return(jsonStr.size()));
+        EXPECT_CALL(*mockfs, Fsync(_)).Times(1).WillOnce(Return(0));
+        EXPECT_CALL(*mockfs, Close(_)).Times(1).WillOnce(Return(0));
+        EXPECT_CALL(*mockfs, List(_, _)).Times(1)
+            .WillOnce(DoAll(SetArgPointee<1>(files), Return(0)));
+
+        copysetNode.on_snapshot_save(&writer, &closure);
+        copysetNode.WaitSnapshotDone();
+        // 快照文件不保存到meta中，非chunk文件不记录修改index，
+        // 没有修改记录的chunk使用快照加载时的index
+        ASSERT_EQ(3, writer.files.size());
+        bool foundChunk = false;
+        for (const auto &file : writer.files) {
+            ASSERT_EQ(std::string::npos, file.first.find("_snap_"));
+            if (file.first.find("chunk_1") != std::string::npos) {
+                ASSERT_EQ("0", file.second);
+                foundChunk = true;
+            } else {
+                ASSERT_EQ("", file.second);
+            }
+        }
+        ASSERT_TRUE(foundChunk);
+    }
+
     // on_snapshot_save: success, enableOdsyncWhenOpenChunkFile_ = false
     {
         LogicPoolID logicPoolID = 123;
@@ -296,10 +367,8 @@ TEST_F(CopysetNodeTest, error_test) {
         copysetNode.on_snapshot_save(&writer, &closure);
         copysetNode.WaitSnapshotDone();
     }
-    // ShipToSync & handle sync time out
+    // ShipToSync & force sync all chunks
     {
-        CopysetNode::copysetSyncPool_ =
-            std::make_shared<common::TaskThreadPool<>>();
         LogicPoolID logicPoolID = 123;
         CopysetID copysetID = 1345;
         Configuration conf;
@@ -314,10 +383,13 @@ TEST_F(CopysetNodeTest, error_test) {
         ChunkID id1 = 100;
         ChunkID id2 = 200;
         ChunkID id3 = 100;
+        CopysetNode::groupSyncer_->Flush();
         copysetNode.ShipToSync(id1);
         copysetNode.ShipToSync(id2);
         copysetNode.ShipToSync(id3);
-        copysetNode.HandleSyncTimerOut();
+        ASSERT_EQ(2, CopysetNode::groupSyncer_->PendingCount());
+        copysetNode.ForceSyncAllChunks();
+        ASSERT_EQ(0, CopysetNode::groupSyncer_->PendingCount());
     }
 
     // on_snapshot_load: Dir not exist, File not exist, data init success
@@ -0,0 +1,156 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "src/chunkserver/datastore/block_cache.h"
+
+namespace curve {
+namespace chunkserver {
+
+namespace {
+
+const uint32_t kCacheBlockSize = 4096;
+
+CachedBlockPtr MakeBlock(char c) {
+    return std::make_shared<std::string>(kCacheBlockSize, c);
+}
+
+BlockCacheOptions MakeOptions(const std::string& prefix) {
+    BlockCacheOptions options;
+    options.capacity = 8 * kCacheBlockSize;
+    options.blockSize = kCacheBlockSize;
+    options.metricPrefix = prefix;
+    return options;
+}
+
+}  // namespace
+
+TEST(CSBlockCacheTest, FillAndGetTest) {
+    CSBlockCache cache(MakeOptions("block_cache_test_fill"));
+    uint64_t ns = cache.NewNamespace();
+    CachedBlockPtr block;
+    ASSERT_FALSE(cache.Get(ns, 1, 0, &block));
+
+    uint64_t generation = cache.BeginFill(ns, 1);
+    cache.Fill(ns, 1, generation, 0, MakeBlock('a'));
+    ASSERT_TRUE(cache.Get(ns, 1, 0, &block));
+    ASSERT_EQ(std::string(kCacheBlockSize, 'a'), *block);
+    ASSERT_FALSE(cache.Get(ns, 1, 1, &block));
+    ASSERT_FALSE(cache.Get(ns, 2, 0, &block));
+
+    // the same chunk id in another namespace does not share blocks
+    uint64_t otherNs = cache.NewNamespace();
+    ASSERT_NE(ns, otherNs);
+    ASSERT_FALSE(cache.Get(otherNs, 1, 0, &block));
+
+    // a generation of another namespace can not fill blocks
+    cache.Fill(otherNs, 1, generation, 0, MakeBlock('b'));
+    ASSERT_FALSE(cache.Get(otherNs, 1, 0, &block));
+}
+
+TEST(CSBlockCacheTest, InvalidateTest) {
+    CSBlockCache cache(MakeOptions("block_cache_test_invalidate"));
+    uint64_t ns = cache.NewNamespace();
+    CachedBlockPtr block;
+    uint64_t generation = cache.BeginFill(ns, 1);
+    for (uint64_t index = 0; index < 4; ++index) {
+        cache.Fill(ns, 1, generation, index, MakeBlock('a'));
+    }
+
+    // only the blocks overlapping with the range are invalidated
+    cache.Invalidate(ns, 1, kCacheBlockSize + 512, kCacheBlockSize);
+    ASSERT_TRUE(cache.Get(ns, 1, 0, &block));
+    ASSERT_FALSE(cache.Get(ns, 1, 1, &block));
+    ASSERT_FALSE(cache.Get(ns, 1, 2, &block));
+    ASSERT_TRUE(cache.Get(ns, 1, 3, &block));
+
+    // the blocks read before the modification can not be filled
+    cache.Fill(ns, 1, generation, 1, MakeBlock('a'));
+    ASSERT_FALSE(cache.Get(ns, 1, 1, &block));
+    generation = cache.BeginFill(ns, 1);
+    cache.Fill(ns, 1, generation, 1, MakeBlock('b'));
+    ASSERT_TRUE(cache.Get(ns, 1, 1, &block));
+    ASSERT_EQ(std::string(kCacheBlockSize, 'b'), *block);
+
+    // delete the chunk
+    cache.InvalidateChunk(ns, 1, 4 * kCacheBlockSize);
+    for (uint64_t index = 0; index < 4; ++index) {
+        ASSERT_FALSE(cache.Get(ns, 1, index, &block));
+    }
+    cache.Fill(ns, 1, generation, 0, MakeBlock('a'));
+    ASSERT_FALSE(cache.Get(ns, 1, 0, &block));
+    // the chunk created again gets a new generation
+    ASSERT_NE(generation, cache.BeginFill(ns, 1));
+}
+
+TEST(CSBlockCacheTest, DropNamespaceTest) {
+    CSBlockCache cache(MakeOptions("block_cache_test_drop"));
+    uint64_t ns = cache.NewNamespace();
+    CachedBlockPtr block;
+    uint64_t generation = cache.BeginFill(ns, 1);
+    cache.Fill(ns, 1, generation, 0, MakeBlock('a'));
+    ASSERT_TRUE(cache.Get(ns, 1, 0, &block));
+
+    cache.DropNamespace(ns);
+    ASSERT_EQ(0, cache.BeginFill(ns, 1));
+    cache.Fill(ns, 1, generation, 1, MakeBlock('a'));
+    ASSERT_FALSE(cache.Get(ns, 1, 1, &block));
+    // invalidating a dropped namespace is harmless
+    cache.Invalidate(ns, 1, 0, kCacheBlockSize);
+    cache.InvalidateChunk(ns, 1, 4 * kCacheBlockSize);
+}
+
+TEST(CSBlockCacheTest, CapacityTest) {
+    CSBlockCache cache(MakeOptions("block_cache_test_capacity"));
+    uint64_t ns = cache.NewNamespace();
+    uint64_t generation = cache.BeginFill(ns, 1);
+    CachedBlockPtr block;
+    // fill the cache and read every block more than once
+    for (uint64_t index = 0; index < 8; ++index) {
+        cache.Fill(ns, 1, generation, index, MakeBlock('a'));
+    }
+    for (int round = 0; round < 2; ++round) {
+        for (uint64_t index = 0; index < 8; ++index) {
+            ASSERT_TRUE(cache.Get(ns, 1, index, &block));
+        }
+    }
+
+    // blocks read only once do not flush the blocks read more than once
+    for (uint64_t index = 8; index < 40; ++index) {
+        cache.Fill(ns, 1, generation, index, MakeBlock('a'));
+    }
+    int reread = 0;
+    for (uint64_t index = 0; index < 8; ++index) {
+        if (cache.Get(ns, 1, index, &block)) {
+            ++reread;
+        }
+    }
+    int cached = reread;
+    for (uint64_t index = 8; index < 40; ++index) {
+        if (cache.Get(ns, 1, index, &block)) {
+            ++cached;
+        }
+    }
+    ASSERT_GE(reread, 6);
+    ASSERT_LE(cached, 8);
+}
+
+}  // namespace chunkserver
+}  // namespace curve
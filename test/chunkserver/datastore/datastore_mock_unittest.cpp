@@ -28,6 +28,7 @@
 
 #include "include/chunkserver/chunkserver_common.h"
 #include "src/common/bitmap.h"
+#include "src/common/concurrent/count_down_event.h"
 #include "src/common/crc32.h"
 #include "src/fs/local_filesystem.h"
 #include "src/chunkserver/datastore/define.h"
@@ -39,6 +40,7 @@
 using curve::fs::LocalFileSystem;
 using curve::fs::MockLocalFileSystem;
 using curve::common::Bitmap;
+using curve::common::CountDownEvent;
 
 using ::testing::_;
 using ::testing::Ge;
@@ -352,6 +354,38 @@ TEST_P(CSDataStore_test, InitializeTest3) {
         .Times(1);
 }
 
+/**
+ * InitializeTest
+ * case:多个线程并发加载chunk文件
+ * 预期结果:所有chunk和快照都被加载，返回true
+ */
+TEST_P(CSDataStore_test, InitializeParallelTest) {
+    FakeEnv();
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = chunksize_;
+    options.blockSize = blocksize_;
+    options.metaPageSize = metapagesize_;
+    options.locationLimit = kLocationLimit;
+    options.enableOdsyncWhenOpenChunkFile = true;
+    options.loadConcurrency = 4;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    EXPECT_TRUE(dataStore->Initialize());
+
+    CSChunkInfo info;
+    ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(1, &info));
+    ASSERT_EQ(1, info.snapSn);
+    ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(2, &info));
+    ASSERT_EQ(2, dataStore->GetStatus().chunkFileCount);
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
 /**
  * InitializeTest
  * case:存在chunk文件，chunk文件存在snapshot文件，
@@ -551,6 +585,8 @@ TEST_P(CSDataStore_test, InitializeErrorTest4) {
     // 每次重新初始化都会释放原先的资源，重新加载
     EXPECT_CALL(*lfs_, Close(1))
         .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Close(3))
+        .WillOnce(Return(0));
     // open success
     EXPECT_CALL(*lfs_, Open(chunk1snap1Path, _))
         .WillOnce(Return(2));
@@ -565,6 +601,8 @@ TEST_P(CSDataStore_test, InitializeErrorTest4) {
     // 每次重新初始化都会释放原先的资源，重新加载
     EXPECT_CALL(*lfs_, Close(1))
         .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Close(3))
+        .WillOnce(Return(0));
     // open success
     EXPECT_CALL(*lfs_, Open(chunk1snap1Path, _))
         .WillOnce(Return(2));
@@ -582,6 +620,8 @@ TEST_P(CSDataStore_test, InitializeErrorTest4) {
     // 每次重新初始化都会释放原先的资源，重新加载
     EXPECT_CALL(*lfs_, Close(1))
         .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Close(3))
+        .WillOnce(Return(0));
     // open success
     EXPECT_CALL(*lfs_, Open(chunk1snap1Path, _))
         .WillOnce(Return(2));
@@ -601,6 +641,8 @@ TEST_P(CSDataStore_test, InitializeErrorTest4) {
     // 每次重新初始化都会释放原先的资源，重新加载
     EXPECT_CALL(*lfs_, Close(1))
         .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Close(3))
+        .WillOnce(Return(0));
     // open success
     EXPECT_CALL(*lfs_, Open(chunk1snap1Path, _))
         .WillOnce(Return(2));
@@ -624,6 +666,8 @@ TEST_P(CSDataStore_test, InitializeErrorTest4) {
     // 每次重新初始化都会释放原先的资源，重新加载
     EXPECT_CALL(*lfs_, Close(1))
         .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Close(3))
+        .WillOnce(Return(0));
     // open success
     EXPECT_CALL(*lfs_, Open(chunk1snap1Path, _))
         .WillOnce(Return(2));
@@ -647,6 +691,8 @@ TEST_P(CSDataStore_test, InitializeErrorTest4) {
 
     EXPECT_CALL(*lfs_, Close(1))
         .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
 }
 
 /**
@@ -2634,6 +2680,235 @@ TEST_P(CSDataStore_test, ReadChunkErrorTest1) {
     delete[] buf;
 }
 
+/**
+ * ReadChunkAsyncTest
+ * case1:chunk不存在
+ * 预期结果:回调返回ChunkNotExistError错误码
+ * case2:读取区域未对齐
+ * 预期结果:回调返回InvalidArgError错误码
+ * case3:正常读取存在的chunk
+ * 预期结果:回调返回Success
+ * case4:读chunk文件时出错
+ * 预期结果:回调返回InternalError
+ */
+TEST_P(CSDataStore_test, ReadChunkAsyncTest1) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    SequenceNum sn = 2;
+    off_t offset = blocksize_;
+    size_t length = blocksize_;
+    char* buf = new char[length];
+    memset(buf, 0, length);
+    CSErrorCode result = CSErrorCode::Success;
+    int called = 0;
+    // done may run in another bthread, wait for it before checking
+    CountDownEvent event;
+    auto done = [&](CSErrorCode errorCode) {
+        result = errorCode;
+        ++called;
+        event.Signal();
+    };
+
+    // case1
+    event.Reset(1);
+    dataStore->ReadChunkAsync(4, sn, buf, offset, length, done);
+    event.Wait();
+    EXPECT_EQ(1, called);
+    EXPECT_EQ(CSErrorCode::ChunkNotExistError, result);
+
+    // case2
+    EXPECT_CALL(*lfs_, Read(_, _, _, _))
+        .Times(0);
+    event.Reset(1);
+    dataStore->ReadChunkAsync(1, sn, buf, offset + 1, length, done);
+    event.Wait();
+    EXPECT_EQ(2, called);
+    EXPECT_EQ(CSErrorCode::InvalidArgError, result);
+
+    // case3
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), offset + metapagesize_, length))
+        .WillOnce(Return(length));
+    event.Reset(1);
+    dataStore->ReadChunkAsync(1, sn, buf, offset, length, done);
+    event.Wait();
+    EXPECT_EQ(3, called);
+    EXPECT_EQ(CSErrorCode::Success, result);
+
+    // case4
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), offset + metapagesize_, length))
+        .WillOnce(Return(-UT_ERRNO));
+    event.Reset(1);
+    dataStore->ReadChunkAsync(1, sn, buf, offset, length, done);
+    event.Wait();
+    EXPECT_EQ(4, called);
+    EXPECT_EQ(CSErrorCode::InternalError, result);
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+    delete[] buf;
+}
+
+/**
+ * ReadChunkODirectTest
+ * case1:开启O_DIRECT读，buffer、offset和length均对齐
+ * 预期结果:第一次读时以O_DIRECT打开文件，之后复用该fd读取
+ * case2:buffer未对齐
+ * 预期结果:使用普通fd读取
+ * case3:O_DIRECT fd数量达到上限后读取另一个chunk
+ * 预期结果:不再以O_DIRECT打开文件，使用普通fd读取
+ */
+TEST_P(CSDataStore_test, ReadChunkODirectTest) {
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = chunksize_;
+    options.blockSize = blocksize_;
+    options.metaPageSize = metapagesize_;
+    options.locationLimit = kLocationLimit;
+    options.enableOdsyncWhenOpenChunkFile = true;
+    options.enableODirectRead = true;
+    options.maxODirectReadFds = 1;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 1;
+    SequenceNum sn = 2;
+    off_t offset = 0;
+    size_t length = kDirectIOAlignment;
+    char* buf = nullptr;
+    ASSERT_EQ(0, posix_memalign(reinterpret_cast<void**>(&buf),
+                                kDirectIOAlignment, 2 * length));
+    int directFd = 10;
+
+    // case1
+    EXPECT_CALL(*lfs_, Open(chunk1Path, O_RDONLY|O_NOATIME|O_DIRECT))
+        .WillOnce(Return(directFd));
+    EXPECT_CALL(*lfs_, Read(directFd, buf, offset + metapagesize_, length))
+        .Times(2)
+        .WillRepeatedly(Return(length));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunk(id, sn, buf, offset, length));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunk(id, sn, buf, offset, length));
+
+    // case2
+    char* unaligned = buf + 512;
+    EXPECT_CALL(*lfs_, Read(1, unaligned, offset + metapagesize_, length))
+        .WillOnce(Return(length));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunk(id, sn, unaligned, offset, length));
+
+    // case3
+    EXPECT_CALL(*lfs_, Read(3, buf, offset + metapagesize_, length))
+        .WillOnce(Return(length));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunk(2, sn, buf, offset, length));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(directFd))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+    dataStore = nullptr;
+    free(buf);
+}
+
+/**
+ * ReadChunkBlockCacheTest
+ * case1:开启块缓存，读取的区域未命中
+ * 预期结果1:读取覆盖该区域的完整块，并加入缓存
+ * case2:再次读取该块内的区域，包括异步读
+ * 预期结果2:从缓存中读取，不再读文件
+ * case3:写入该块后再读取
+ * 预期结果3:缓存失效，重新读取文件
+ */
+TEST_P(CSDataStore_test, ReadChunkBlockCacheTest) {
+    BlockCacheOptions cacheOptions;
+    cacheOptions.capacity = 16 * 4 * blocksize_;
+    cacheOptions.blockSize = 4 * blocksize_;
+    cacheOptions.metricPrefix = "datastore_test_block_cache";
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = chunksize_;
+    options.blockSize = blocksize_;
+    options.metaPageSize = metapagesize_;
+    options.locationLimit = kLocationLimit;
+    options.enableOdsyncWhenOpenChunkFile = true;
+    options.blockCache = std::make_shared<CSBlockCache>(cacheOptions);
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    // chunk2没有快照，写入时不会触发COW读
+    ChunkID id = 2;
+    SequenceNum sn = 2;
+    size_t cacheBlockSize = cacheOptions.blockSize;
+    off_t offset = blocksize_;
+    size_t length = blocksize_;
+    char* block = new char[cacheBlockSize];
+    for (size_t i = 0; i < cacheBlockSize; ++i) {
+        block[i] = i % 251;
+    }
+    char* buf = new char[cacheBlockSize];
+
+    // case1
+    EXPECT_CALL(*lfs_, Read(3, NotNull(), metapagesize_, cacheBlockSize))
+        .WillOnce(DoAll(SetArrayArgument<1>(block, block + cacheBlockSize),
+                        Return(cacheBlockSize)));
+    memset(buf, 0, cacheBlockSize);
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunk(id, sn, buf, offset, length));
+    EXPECT_EQ(0, memcmp(buf, block + offset, length));
+
+    // case2
+    memset(buf, 0, cacheBlockSize);
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunk(id, sn, buf, 0, cacheBlockSize));
+    EXPECT_EQ(0, memcmp(buf, block, cacheBlockSize));
+    memset(buf, 0, cacheBlockSize);
+    CSErrorCode result = CSErrorCode::InternalError;
+    dataStore->ReadChunkAsync(id, sn, buf, 2 * blocksize_, 2 * blocksize_,
+        [&result](CSErrorCode errorCode) { result = errorCode; });
+    EXPECT_EQ(CSErrorCode::Success, result);
+    EXPECT_EQ(0, memcmp(buf, block + 2 * blocksize_, 2 * blocksize_));
+
+    // case3
+    uint32_t cost;
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->WriteChunk(id, sn, buf, offset, length, &cost));
+    for (size_t i = 0; i < cacheBlockSize; ++i) {
+        block[i] = i % 241;
+    }
+    EXPECT_CALL(*lfs_, Read(3, NotNull(), metapagesize_, cacheBlockSize))
+        .WillOnce(DoAll(SetArrayArgument<1>(block, block + cacheBlockSize),
+                        Return(cacheBlockSize)));
+    memset(buf, 0, cacheBlockSize);
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunk(id, sn, buf, 0, cacheBlockSize));
+    EXPECT_EQ(0, memcmp(buf, block, cacheBlockSize));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+    dataStore = nullptr;
+    delete[] block;
+    delete[] buf;
+}
+
 /**
  * ReadSnapshotChunkTest
  * case:chunk不存在
@@ -4086,6 +4361,131 @@ TEST_P(CSDataStore_test, PasteChunkTest1) {
     delete[] buf;
 }
 
+/**
+ * PasteChunkBatchTest
+ * case1:连续paste的次数未达到batch
+ * 预期结果1:写入数据，只更新内存中的bitmap，不更新metapage
+ * case2:连续paste的次数达到batch
+ * 预期结果2:更新一次metapage
+ * case3:paste后所有区域都已写过
+ * 预期结果3:立即更新metapage，clone chunk转为普通chunk
+ */
+TEST_P(CSDataStore_test, PasteChunkBatchTest) {
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = chunksize_;
+    options.blockSize = blocksize_;
+    options.metaPageSize = metapagesize_;
+    options.locationLimit = kLocationLimit;
+    options.enableOdsyncWhenOpenChunkFile = true;
+    options.pasteMetaPageBatch = 3;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 3;
+    SequenceNum sn = 1;
+    SequenceNum correctedSn = 2;
+    size_t length = blocksize_;
+    char* buf = new char[chunksize_];
+    memset(buf, 0, chunksize_);
+    CSChunkInfo info;
+    // 创建 clone chunk
+    {
+        char chunk3MetaPage[metapagesize_];  // NOLINT(runtime/arrays)
+        memset(chunk3MetaPage, 0, sizeof(chunk3MetaPage));
+        shared_ptr<Bitmap> bitmap =
+            make_shared<Bitmap>(chunksize_ / blocksize_);
+        FakeEncodeChunk(chunk3MetaPage, correctedSn, sn, bitmap, location);
+        string chunk3Path = string(baseDir) + "/" +
+                            FileNameOperator::GenerateChunkFileName(id);
+        EXPECT_CALL(*lfs_, FileExists(chunk3Path))
+            .WillOnce(Return(false));
+        EXPECT_CALL(*fpool_, GetFileImpl(chunk3Path, NotNull()))
+            .WillOnce(Return(0));
+        EXPECT_CALL(*lfs_, Open(chunk3Path, _))
+            .Times(1)
+            .WillOnce(Return(4));
+        EXPECT_CALL(*lfs_, Read(4, NotNull(), 0, metapagesize_))
+            .WillOnce(DoAll(SetArrayArgument<1>(chunk3MetaPage,
+                            chunk3MetaPage + metapagesize_),
+                            Return(metapagesize_)));
+        EXPECT_EQ(CSErrorCode::Success,
+                  dataStore->CreateCloneChunk(id,
+                                              sn,
+                                              correctedSn,
+                                              chunksize_,
+                                              location));
+    }
+
+    // case1:连续paste的次数未达到batch
+    {
+        EXPECT_CALL(*lfs_, Write(4, Matcher<const char*>(NotNull()),
+                                 metapagesize_ + blocksize_, length))
+            .Times(1);
+        EXPECT_CALL(*lfs_, Write(4, Matcher<const char*>(NotNull()),
+                                 metapagesize_ + 2 * blocksize_, length))
+            .Times(1);
+        EXPECT_CALL(*lfs_,
+                    Write(4, Matcher<const char*>(NotNull()), 0, metapagesize_))
+            .Times(0);
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->PasteChunk(id, buf, blocksize_, length));
+        // 已经写过的区域不计入次数
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->PasteChunk(id, buf, blocksize_, length));
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->PasteChunk(id, buf, 2 * blocksize_, length));
+        // paste的区域可以直接读取
+        ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(id, &info));
+        ASSERT_EQ(true, info.isClone);
+        ASSERT_EQ(1, info.bitmap->NextSetBit(0));
+        ASSERT_EQ(3, info.bitmap->NextClearBit(1));
+    }
+
+    // case2:连续paste的次数达到batch
+    {
+        EXPECT_CALL(*lfs_, Write(4, Matcher<const char*>(NotNull()),
+                                 metapagesize_ + 4 * blocksize_, length))
+            .Times(1);
+        EXPECT_CALL(*lfs_,
+                    Write(4, Matcher<const char*>(NotNull()), 0, metapagesize_))
+            .Times(1);
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->PasteChunk(id, buf, 4 * blocksize_, length));
+        ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(id, &info));
+        ASSERT_EQ(true, info.isClone);
+        ASSERT_EQ(3, info.bitmap->NextClearBit(1));
+        ASSERT_EQ(4, info.bitmap->NextSetBit(3));
+    }
+
+    // case3:paste后所有区域都已写过
+    {
+        EXPECT_CALL(*lfs_, Write(4, Matcher<const char*>(NotNull()),
+                                 _, _))
+            .Times(3);
+        EXPECT_CALL(*lfs_,
+                    Write(4, Matcher<const char*>(NotNull()), 0, metapagesize_))
+            .Times(1);
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->PasteChunk(id, buf, 0, chunksize_));
+        ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(id, &info));
+        ASSERT_EQ(false, info.isClone);
+        ASSERT_EQ(nullptr, info.bitmap);
+    }
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(4))
+        .Times(1);
+    delete[] buf;
+}
+
 /*
  * PasteChunkErrorTest
  * case1:写数据时失败
@@ -4246,6 +4646,48 @@ TEST_P(CSDataStore_test, GetHashErrorTest2) {
         .Times(1);
 }
 
+/*
+ * 分段读取计算hash
+ */
+TEST_P(CSDataStore_test, GetHashTest) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 1;
+    std::string hash;
+    const size_t kReadSize = 1024 * 1024;
+    size_t length = 2 * kReadSize + 4096;
+    auto fillRead = [](int fd, char* buf, uint64_t offset, int length) {
+        (void)fd;
+        memset(buf, static_cast<char>(offset / 4096), length);
+        return length;
+    };
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), 0, kReadSize))
+        .WillOnce(Invoke(fillRead));
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), kReadSize, kReadSize))
+        .WillOnce(Invoke(fillRead));
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), 2 * kReadSize, 4096))
+        .WillOnce(Invoke(fillRead));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->GetChunkHash(id, 0, length, &hash));
+
+    std::string data(length, 0);
+    memset(&data[0], 0, kReadSize);
+    memset(&data[kReadSize], static_cast<char>(kReadSize / 4096), kReadSize);
+    memset(&data[2 * kReadSize], static_cast<char>(2 * kReadSize / 4096),
+           4096);
+    ASSERT_EQ(std::to_string(curve::common::CRC32(data.data(), length)),
+              hash);
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
 /*
  * 获取datastore状态测试
  */
@@ -4267,6 +4709,43 @@ TEST_P(CSDataStore_test, GetStatusTest) {
         .Times(1);
 }
 
+/**
+ * GetChunkMapTest
+ * case:metaCache未修改时多次获取chunk map，删除chunk后再获取
+ * 预期结果:未修改时返回同一份快照，删除chunk后返回新的快照，旧快照不受影响
+ */
+TEST_P(CSDataStore_test, GetChunkMapTest) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkMapPtr chunkMap = dataStore->GetChunkMap();
+    ASSERT_EQ(2, chunkMap->size());
+    ASSERT_EQ(1, chunkMap->count(1));
+    ASSERT_EQ(1, chunkMap->count(2));
+    ASSERT_EQ(chunkMap, dataStore->GetChunkMap());
+
+    // delete chunk2, chunk will be closed
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+    EXPECT_CALL(*fpool_, RecycleFile(chunk2Path))
+        .WillOnce(Return(0));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->DeleteChunk(2, 2));
+
+    ChunkMapPtr newMap = dataStore->GetChunkMap();
+    ASSERT_NE(chunkMap, newMap);
+    ASSERT_EQ(1, newMap->size());
+    ASSERT_EQ(1, newMap->count(1));
+    ASSERT_EQ(2, chunkMap->size());
+    chunkMap = nullptr;
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+}
+
 INSTANTIATE_TEST_CASE_P(
     CSDataStoreTest,
     CSDataStore_test,
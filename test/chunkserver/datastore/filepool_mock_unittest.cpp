@@ -28,6 +28,7 @@
 #include <memory>
 
 #include "include/chunkserver/chunkserver_common.h"
+#include "src/common/aligned_buffer_pool.h"
 #include "src/common/crc32.h"
 #include "src/common/curve_define.h"
 #include "src/chunkserver/datastore/file_pool.h"
@@ -50,6 +51,7 @@ using ::testing::SetArrayArgument;
 
 using curve::fs::MockLocalFileSystem;
 using curve::common::kFilePoolMagic;
+using curve::common::AlignedBufferPool;
 
 namespace curve {
 namespace chunkserver {
@@ -59,6 +61,10 @@ const PageSizeType PAGE_SIZE = 4096;
 const uint32_t metaFileSize = 4096;
 const uint32_t blockSize = 4096;
 const uint32_t fileSize = CHUNK_SIZE + PAGE_SIZE;
+// 格式化文件时按AlignedBufferPool的最大规格分段写入
+const uint32_t kFormatWriteNum =
+    (fileSize + AlignedBufferPool::kMaxPooledSize - 1) /
+    AlignedBufferPool::kMaxPooledSize;
 const std::string poolDir = "./chunkfilepool_dat";  // NOLINT
 const std::string poolMetaPath = "./chunkfilepool_dat.meta";  // NOLINT
 const std::string filePath1 = poolDir + "/1";  // NOLINT
@@ -745,8 +751,8 @@ TEST_F(CSChunkfilePoolMockTest, GetFileTest) {
         EXPECT_CALL(*lfs_, Fallocate(1, 0, 0, fileSize))
             .Times(retryTimes)
             .WillRepeatedly(Return(0));
-        EXPECT_CALL(*lfs_,
-                    Write(1, Matcher<const char*>(NotNull()), 0, fileSize))
+        EXPECT_CALL(*lfs_, Write(1, Matcher<const char*>(NotNull()), 0,
+                                 AlignedBufferPool::kMaxPooledSize))
             .Times(retryTimes)
             .WillRepeatedly(Return(-1));
         EXPECT_CALL(*lfs_, Close(1))
@@ -763,10 +769,9 @@ TEST_F(CSChunkfilePoolMockTest, GetFileTest) {
         EXPECT_CALL(*lfs_, Fallocate(1, 0, 0, fileSize))
             .Times(retryTimes)
             .WillRepeatedly(Return(0));
-        EXPECT_CALL(*lfs_,
-                    Write(1, Matcher<const char*>(NotNull()), 0, fileSize))
-            .Times(retryTimes)
-            .WillRepeatedly(Return(fileSize));
+        EXPECT_CALL(*lfs_, Write(1, Matcher<const char*>(NotNull()), _, _))
+            .Times(retryTimes * kFormatWriteNum)
+            .WillRepeatedly(ReturnArg<3>());
         EXPECT_CALL(*lfs_, Fsync(1))
             .Times(retryTimes)
             .WillRepeatedly(Return(-1));
@@ -784,10 +789,9 @@ TEST_F(CSChunkfilePoolMockTest, GetFileTest) {
         EXPECT_CALL(*lfs_, Fallocate(1, 0, 0, fileSize))
             .Times(retryTimes)
             .WillRepeatedly(Return(0));
-        EXPECT_CALL(*lfs_,
-                    Write(1, Matcher<const char*>(NotNull()), 0, fileSize))
-            .Times(retryTimes)
-            .WillRepeatedly(Return(fileSize));
+        EXPECT_CALL(*lfs_, Write(1, Matcher<const char*>(NotNull()), _, _))
+            .Times(retryTimes * kFormatWriteNum)
+            .WillRepeatedly(ReturnArg<3>());
         EXPECT_CALL(*lfs_, Fsync(1))
             .Times(retryTimes)
             .WillRepeatedly(Return(0));
@@ -923,6 +927,7 @@ TEST_F(CSChunkfilePoolMockTest, RecycleFileTest) {
         FakePool(&pool, options, 0);
         struct stat fileInfo;
         fileInfo.st_size = CHUNK_SIZE + PAGE_SIZE;
+        fileInfo.st_nlink = 1;
 
         EXPECT_CALL(*lfs_, Open(targetPath, _))
             .WillOnce(Return(1));
@@ -943,6 +948,7 @@ TEST_F(CSChunkfilePoolMockTest, RecycleFileTest) {
         FakePool(&pool, options, 0);
         struct stat fileInfo;
         fileInfo.st_size = CHUNK_SIZE + PAGE_SIZE;
+        fileInfo.st_nlink = 1;
 
         EXPECT_CALL(*lfs_, Open(targetPath, _))
             .WillOnce(Return(1));
@@ -956,6 +962,29 @@ TEST_F(CSChunkfilePoolMockTest, RecycleFileTest) {
         ASSERT_EQ(0, pool.RecycleFile(targetPath));
         ASSERT_EQ(1, pool.Size());
     }
+
+    // Fstat信息匹配，但文件还有其他硬链接，直接Delete
+    {
+        FilePool pool(lfs_);
+        FakePool(&pool, options, 0);
+        struct stat fileInfo;
+        fileInfo.st_size = CHUNK_SIZE + PAGE_SIZE;
+        fileInfo.st_nlink = 2;
+
+        EXPECT_CALL(*lfs_, Open(targetPath, _))
+            .WillOnce(Return(1));
+        EXPECT_CALL(*lfs_, Fstat(1, _))
+            .WillOnce(DoAll(SetArgPointee<1>(fileInfo),
+                            Return(0)));
+        EXPECT_CALL(*lfs_, Close(1))
+            .Times(1);
+        EXPECT_CALL(*lfs_, Rename(_, _, _))
+            .Times(0);
+        EXPECT_CALL(*lfs_, Delete(targetPath))
+            .WillOnce(Return(0));
+        ASSERT_EQ(0, pool.RecycleFile(targetPath));
+        ASSERT_EQ(0, pool.Size());
+    }
 }
 
 }  // namespace chunkserver
@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "src/chunkserver/datastore/free_chunk_list.h"
+
+namespace curve {
+namespace chunkserver {
+
+TEST(FreeChunkListTest, BasicTest) {
+    FreeChunkList list(4);
+    uint64_t chunkid = 0;
+    ASSERT_TRUE(list.Empty());
+    ASSERT_FALSE(list.Pop(&chunkid));
+
+    list.Push(1);
+    ASSERT_EQ(1, list.Size());
+    ASSERT_TRUE(list.Pop(&chunkid));
+    ASSERT_EQ(1, chunkid);
+    ASSERT_TRUE(list.Empty());
+
+    // files pushed in batch can be popped from any thread
+    std::vector<uint64_t> chunkids;
+    for (uint64_t i = 1; i <= 10; ++i) {
+        chunkids.push_back(i);
+    }
+    list.PushBatch(chunkids);
+    ASSERT_EQ(10, list.Size());
+    std::set<uint64_t> popped;
+    std::thread t([&] {
+        uint64_t id;
+        while (list.Pop(&id)) {
+            popped.insert(id);
+        }
+    });
+    t.join();
+    ASSERT_EQ(10, popped.size());
+    ASSERT_TRUE(list.Empty());
+
+    list.PushBatch(chunkids);
+    list.Clear();
+    ASSERT_EQ(0, list.Size());
+    ASSERT_FALSE(list.Pop(&chunkid));
+}
+
+TEST(FreeChunkListTest, ConcurrentPushPopTest) {
+    const int kThreadNum = 8;
+    const uint64_t kFilePerThread = 1000;
+    FreeChunkList list;
+    std::vector<uint64_t> initial;
+    for (uint64_t i = 1; i <= kFilePerThread; ++i) {
+        initial.push_back(i);
+    }
+    list.PushBatch(initial);
+
+    // every thread recycles new files and takes files concurrently
+    std::mutex mtx;
+    std::vector<uint64_t> popped;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreadNum; ++i) {
+        threads.emplace_back([&, i] {
+            std::vector<uint64_t> local;
+            for (uint64_t j = 0; j < kFilePerThread; ++j) {
+                list.Push(kFilePerThread * (i + 1) + j + 1);
+                uint64_t id;
+                if (list.Pop(&id)) {
+                    local.push_back(id);
+                }
+            }
+            std::lock_guard<std::mutex> lk(mtx);
+            popped.insert(popped.end(), local.begin(), local.end());
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    uint64_t id;
+    while (list.Pop(&id)) {
+        popped.push_back(id);
+    }
+    ASSERT_TRUE(list.Empty());
+    std::sort(popped.begin(), popped.end());
+    ASSERT_EQ(kFilePerThread * (kThreadNum + 1), popped.size());
+    for (uint64_t i = 0; i < popped.size(); ++i) {
+        ASSERT_EQ(i + 1, popped[i]);
+    }
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <memory>
+
+#include "src/chunkserver/datastore/group_syncer.h"
+#include "src/common/concurrent/count_down_event.h"
+#include "test/chunkserver/datastore/mock_datastore.h"
+
+using ::testing::_;
+using ::testing::InSequence;
+using ::testing::Invoke;
+using ::testing::Return;
+
+using curve::common::CountDownEvent;
+
+namespace curve {
+namespace chunkserver {
+
+class GroupSyncerTest : public testing::Test {
+ public:
+    void SetUp() {
+        dataStore1_ = std::make_shared<MockDataStore>();
+        dataStore2_ = std::make_shared<MockDataStore>();
+        GroupSyncerOptions options;
+        options.flushIntervalMs = 1000 * 1000;
+        options.syncConcurrency = 4;
+        ASSERT_EQ(0, syncer_.Init(options));
+    }
+
+    void TearDown() {
+        syncer_.Fini();
+    }
+
+ protected:
+    GroupSyncer syncer_;
+    std::shared_ptr<MockDataStore> dataStore1_;
+    std::shared_ptr<MockDataStore> dataStore2_;
+};
+
+TEST_F(GroupSyncerTest, FlushWithoutRun) {
+    syncer_.Add(dataStore1_, 1);
+    syncer_.Add(dataStore1_, 2);
+    syncer_.Add(dataStore1_, 1);
+    ASSERT_EQ(2, syncer_.PendingCount());
+
+    // 先发起所有chunk的回写，再逐个sync
+    {
+        InSequence s;
+        EXPECT_CALL(*dataStore1_, WriteBackChunk(_))
+            .Times(2)
+            .WillRepeatedly(Return(CSErrorCode::Success));
+        EXPECT_CALL(*dataStore1_, SyncChunk(_))
+            .Times(2)
+            .WillRepeatedly(Return(CSErrorCode::Success));
+    }
+    syncer_.Flush();
+    ASSERT_EQ(0, syncer_.PendingCount());
+
+    // 没有待刷盘的chunk
+    EXPECT_CALL(*dataStore1_, WriteBackChunk(_)).Times(0);
+    EXPECT_CALL(*dataStore1_, SyncChunk(_)).Times(0);
+    syncer_.Flush();
+}
+
+TEST_F(GroupSyncerTest, FlushAcrossDataStores) {
+    ASSERT_EQ(0, syncer_.Run());
+    syncer_.Add(dataStore1_, 1);
+    syncer_.Add(dataStore2_, 1);
+    syncer_.Add(dataStore2_, 2);
+    ASSERT_EQ(3, syncer_.PendingCount());
+
+    // 回写失败不影响后续的sync
+    EXPECT_CALL(*dataStore1_, WriteBackChunk(1))
+        .WillOnce(Return(CSErrorCode::InternalError));
+    EXPECT_CALL(*dataStore2_, WriteBackChunk(_))
+        .Times(2)
+        .WillRepeatedly(Return(CSErrorCode::Success));
+    EXPECT_CALL(*dataStore1_, SyncChunk(1))
+        .WillOnce(Return(CSErrorCode::Success));
+    EXPECT_CALL(*dataStore2_, SyncChunk(1))
+        .WillOnce(Return(CSErrorCode::Success));
+    EXPECT_CALL(*dataStore2_, SyncChunk(2))
+        .WillOnce(Return(CSErrorCode::Success));
+    syncer_.Flush();
+    ASSERT_EQ(0, syncer_.PendingCount());
+}
+
+TEST_F(GroupSyncerTest, FlushOneDataStore) {
+    ASSERT_EQ(0, syncer_.Run());
+    syncer_.Add(dataStore1_, 1);
+    syncer_.Add(dataStore2_, 1);
+    syncer_.Add(dataStore2_, 2);
+
+    // 只刷指定datastore的chunk
+    EXPECT_CALL(*dataStore1_, WriteBackChunk(_)).Times(0);
+    EXPECT_CALL(*dataStore1_, SyncChunk(_)).Times(0);
+    EXPECT_CALL(*dataStore2_, WriteBackChunk(_))
+        .Times(2)
+        .WillRepeatedly(Return(CSErrorCode::Success));
+    EXPECT_CALL(*dataStore2_, SyncChunk(_))
+        .Times(2)
+        .WillRepeatedly(Return(CSErrorCode::Success));
+    syncer_.Flush(dataStore2_);
+    ASSERT_EQ(1, syncer_.PendingCount());
+
+    // 没有登记chunk的datastore
+    syncer_.Flush(dataStore2_);
+    ASSERT_EQ(1, syncer_.PendingCount());
+
+    ::testing::Mock::VerifyAndClearExpectations(dataStore1_.get());
+    EXPECT_CALL(*dataStore1_, WriteBackChunk(1))
+        .WillOnce(Return(CSErrorCode::Success));
+    EXPECT_CALL(*dataStore1_, SyncChunk(1))
+        .WillOnce(Return(CSErrorCode::Success));
+    syncer_.Flush(dataStore1_);
+    ASSERT_EQ(0, syncer_.PendingCount());
+}
+
+TEST_F(GroupSyncerTest, WakeupByCond) {
+    ASSERT_EQ(0, syncer_.Run());
+    CountDownEvent synced(1);
+    EXPECT_CALL(*dataStore1_, WriteBackChunk(3))
+        .WillOnce(Return(CSErrorCode::Success));
+    EXPECT_CALL(*dataStore1_, SyncChunk(3))
+        .WillOnce(Invoke([&synced](ChunkID) {
+            synced.Signal();
+            return CSErrorCode::Success;
+        }));
+    syncer_.Add(dataStore1_, 3);
+    // 刷盘线程可能还没开始等待，重复唤醒直到完成刷盘
+    while (!synced.WaitFor(10)) {
+        syncer_.GetCond()->notify_one();
+    }
+}
+
+TEST_F(GroupSyncerTest, FlushPendingWhenFini) {
+    ASSERT_EQ(0, syncer_.Run());
+    syncer_.Add(dataStore1_, 4);
+    EXPECT_CALL(*dataStore1_, WriteBackChunk(4))
+        .WillOnce(Return(CSErrorCode::Success));
+    EXPECT_CALL(*dataStore1_, SyncChunk(4))
+        .WillOnce(Return(CSErrorCode::Success));
+    ASSERT_EQ(0, syncer_.Fini());
+    ASSERT_EQ(0, syncer_.PendingCount());
+}
+
+}  // namespace chunkserver
+}  // namespace curve
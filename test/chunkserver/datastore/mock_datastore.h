@@ -44,6 +44,15 @@ class MockDataStore : public CSDataStore {
                                         char*,
                                         off_t,
                                         size_t));
+    // 异步读转为调用ReadChunk，方便对ReadChunk设置期望
+    void ReadChunkAsync(ChunkID id,
+                        SequenceNum sn,
+                        char* buf,
+                        off_t offset,
+                        size_t length,
+                        CSAioCallback done) override {
+        done(ReadChunk(id, sn, buf, offset, length));
+    }
     MOCK_METHOD5(ReadSnapshotChunk, CSErrorCode(ChunkID,
                                                 SequenceNum,
                                                 char*,
@@ -56,6 +65,8 @@ class MockDataStore : public CSDataStore {
                                          size_t,
                                          uint32_t*,
                                          const string&));
+    MOCK_METHOD1(SyncChunk, CSErrorCode(ChunkID));
+    MOCK_METHOD1(WriteBackChunk, CSErrorCode(ChunkID));
     MOCK_METHOD5(CreateCloneChunk, CSErrorCode(ChunkID,
                                                SequenceNum,
                                                SequenceNum,
@@ -67,7 +78,7 @@ class MockDataStore : public CSDataStore {
                                          size_t));
     MOCK_METHOD2(GetChunkInfo, CSErrorCode(ChunkID, CSChunkInfo*));
     MOCK_METHOD0(GetStatus, DataStoreStatus());
-    MOCK_METHOD0(GetChunkMap, ChunkMap());
+    MOCK_METHOD0(GetChunkMap, ChunkMapPtr());
 };
 
 }  // namespace chunkserver
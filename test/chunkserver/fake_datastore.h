@@ -112,6 +112,15 @@ class FakeCSDataStore : public CSDataStore {
         return CSErrorCode::Success;
     }
 
+    void ReadChunkAsync(ChunkID id,
+                        SequenceNum sn,
+                        char *buf,
+                        off_t offset,
+                        size_t length,
+                        CSAioCallback done) override {
+        done(ReadChunk(id, sn, buf, offset, length));
+    }
+
     CSErrorCode ReadSnapshotChunk(ChunkID id,
                                   SequenceNum sn,
                                   char *buf,
@@ -0,0 +1,211 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <map>
+
+#include "src/chunkserver/heartbeat_delta_tracker.h"
+
+namespace curve {
+namespace chunkserver {
+
+using HeartbeatRequest = curve::mds::heartbeat::ChunkServerHeartbeatRequest;
+using HeartbeatResponse = curve::mds::heartbeat::ChunkServerHeartbeatResponse;
+using curve::mds::heartbeat::HeartbeatStatusCode;
+
+namespace {
+
+void AddCopyset(HeartbeatRequest *request, CopysetID copysetId,
+                uint64_t epoch) {
+    auto info = request->add_copysetinfos();
+    info->set_logicalpoolid(1);
+    info->set_copysetid(copysetId);
+    info->set_epoch(epoch);
+    info->mutable_leaderpeer()->set_address("127.0.0.1:8200:0");
+}
+
+// 构造包含copyset 1~count的心跳请求，epochs中记录的copyset使用指定的epoch
+HeartbeatRequest MakeRequest(int count,
+                             const std::map<CopysetID, uint64_t> &epochs) {
+    HeartbeatRequest request;
+    for (CopysetID id = 1; id <= static_cast<CopysetID>(count); ++id) {
+        auto iter = epochs.find(id);
+        AddCopyset(&request, id, iter == epochs.end() ? 1 : iter->second);
+    }
+    return request;
+}
+
+HeartbeatResponse MakeResponse(bool acceptDelta) {
+    HeartbeatResponse response;
+    response.set_statuscode(HeartbeatStatusCode::hbOK);
+    response.set_acceptdelta(acceptDelta);
+    return response;
+}
+
+}  // namespace
+
+TEST(HeartbeatDeltaTrackerTest, DisabledTest) {
+    HeartbeatDeltaTracker tracker;
+    HeartbeatDeltaOptions options;
+    options.enable = false;
+    tracker.Init(options);
+
+    for (int i = 0; i < 3; ++i) {
+        HeartbeatRequest request = MakeRequest(3, {});
+        ASSERT_FALSE(tracker.Filter(&request));
+        ASSERT_EQ(3, request.copysetinfos_size());
+        ASSERT_FALSE(request.has_deltareport());
+        tracker.OnResponse(MakeResponse(true));
+    }
+}
+
+TEST(HeartbeatDeltaTrackerTest, HandshakeTest) {
+    HeartbeatDeltaTracker tracker;
+    HeartbeatDeltaOptions options;
+    options.enable = true;
+    tracker.Init(options);
+
+    // mds不支持增量心跳时一直全量上报
+    for (int i = 0; i < 3; ++i) {
+        HeartbeatRequest request = MakeRequest(3, {});
+        ASSERT_FALSE(tracker.Filter(&request));
+        ASSERT_EQ(3, request.copysetinfos_size());
+        tracker.OnResponse(MakeResponse(false));
+    }
+
+    // mds支持增量心跳后，只上报有变化的copyset
+    HeartbeatRequest request = MakeRequest(3, {});
+    ASSERT_FALSE(tracker.Filter(&request));
+    tracker.OnResponse(MakeResponse(true));
+
+    request = MakeRequest(3, {});
+    ASSERT_TRUE(tracker.Filter(&request));
+    ASSERT_TRUE(request.deltareport());
+    ASSERT_EQ(0, request.copysetinfos_size());
+    ASSERT_EQ(0, request.removedcopysets_size());
+    tracker.OnResponse(MakeResponse(true));
+
+    // 回应中没有acceptDelta(例如切换到了旧版本的mds)，恢复全量上报
+    request = MakeRequest(3, {});
+    ASSERT_TRUE(tracker.Filter(&request));
+    tracker.OnResponse(HeartbeatResponse());
+    request = MakeRequest(3, {});
+    ASSERT_FALSE(tracker.Filter(&request));
+    ASSERT_EQ(3, request.copysetinfos_size());
+}
+
+TEST(HeartbeatDeltaTrackerTest, DeltaTest) {
+    HeartbeatDeltaTracker tracker;
+    HeartbeatDeltaOptions options;
+    options.enable = true;
+    options.fullReportInterval = 0;
+    tracker.Init(options);
+
+    HeartbeatRequest request = MakeRequest(3, {});
+    ASSERT_FALSE(tracker.Filter(&request));
+    tracker.OnResponse(MakeResponse(true));
+
+    // copyset 2的epoch变化，copyset 3被删除，新增copyset 4
+    request = MakeRequest(2, {{2, 2}});
+    AddCopyset(&request, 4, 1);
+    ASSERT_TRUE(tracker.Filter(&request));
+    ASSERT_EQ(2, request.copysetinfos_size());
+    ASSERT_EQ(2, request.copysetinfos(0).copysetid());
+    ASSERT_EQ(2, request.copysetinfos(0).epoch());
+    ASSERT_EQ(4, request.copysetinfos(1).copysetid());
+    ASSERT_EQ(1, request.removedcopysets_size());
+    ASSERT_EQ(1, request.removedcopysets(0).logicalpoolid());
+    ASSERT_EQ(3, request.removedcopysets(0).copysetid());
+
+    // 心跳失败，下次心跳全量上报
+    tracker.Reset();
+    request = MakeRequest(2, {{2, 2}});
+    AddCopyset(&request, 4, 1);
+    ASSERT_FALSE(tracker.Filter(&request));
+    ASSERT_EQ(3, request.copysetinfos_size());
+    tracker.OnResponse(MakeResponse(true));
+
+    // mds要求上报copyset 1
+    request = MakeRequest(2, {{2, 2}});
+    AddCopyset(&request, 4, 1);
+    ASSERT_TRUE(tracker.Filter(&request));
+    ASSERT_EQ(0, request.copysetinfos_size());
+    HeartbeatResponse response = MakeResponse(true);
+    auto id = response.add_needreportcopysets();
+    id->set_logicalpoolid(1);
+    id->set_copysetid(1);
+    tracker.OnResponse(response);
+
+    request = MakeRequest(2, {{2, 2}});
+    AddCopyset(&request, 4, 1);
+    ASSERT_TRUE(tracker.Filter(&request));
+    ASSERT_EQ(1, request.copysetinfos_size());
+    ASSERT_EQ(1, request.copysetinfos(0).copysetid());
+    tracker.OnResponse(MakeResponse(true));
+
+    request = MakeRequest(2, {{2, 2}});
+    AddCopyset(&request, 4, 1);
+    ASSERT_TRUE(tracker.Filter(&request));
+    ASSERT_EQ(0, request.copysetinfos_size());
+}
+
+TEST(HeartbeatDeltaTrackerTest, FullReportTest) {
+    HeartbeatDeltaTracker tracker;
+    HeartbeatDeltaOptions options;
+    options.enable = true;
+    options.fullReportInterval = 2;
+    tracker.Init(options);
+
+    // 每两次增量心跳后全量上报一次
+    HeartbeatRequest request = MakeRequest(3, {});
+    ASSERT_FALSE(tracker.Filter(&request));
+    tracker.OnResponse(MakeResponse(true));
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            request = MakeRequest(3, {});
+            ASSERT_TRUE(tracker.Filter(&request));
+            tracker.OnResponse(MakeResponse(true));
+        }
+        request = MakeRequest(3, {});
+        ASSERT_FALSE(tracker.Filter(&request));
+        ASSERT_EQ(3, request.copysetinfos_size());
+        tracker.OnResponse(MakeResponse(true));
+    }
+
+    // mds要求全量上报
+    request = MakeRequest(3, {});
+    ASSERT_TRUE(tracker.Filter(&request));
+    HeartbeatResponse response = MakeResponse(true);
+    response.set_needfullreport(true);
+    tracker.OnResponse(response);
+    request = MakeRequest(3, {});
+    ASSERT_FALSE(tracker.Filter(&request));
+    ASSERT_EQ(3, request.copysetinfos_size());
+    tracker.OnResponse(MakeResponse(true));
+
+    // mds处理copyset出错，下次全量上报
+    request = MakeRequest(3, {});
+    ASSERT_TRUE(tracker.Filter(&request));
+    response = MakeResponse(true);
+    response.set_statuscode(HeartbeatStatusCode::hbAnalyseCopysetError);
+    tracker.OnResponse(response);
+    request = MakeRequest(3, {});
+    ASSERT_FALSE(tracker.Filter(&request));
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,161 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "proto/chunk.pb.h"
+#include "src/chunkserver/io_tracer.h"
+
+namespace curve {
+namespace chunkserver {
+
+namespace {
+
+ChunkRequest MakeRequest(CHUNK_OP_TYPE type, ChunkID chunkId) {
+    ChunkRequest request;
+    request.set_optype(type);
+    request.set_logicpoolid(1);
+    request.set_copysetid(100001);
+    request.set_chunkid(chunkId);
+    request.set_offset(4096);
+    request.set_size(4096);
+    return request;
+}
+
+// 构造各阶段依次间隔stepUs的trace
+void FillTrace(IOTrace *trace, uint64_t stepUs) {
+    uint64_t begin = trace->timeUs[0];
+    for (int i = 1; i < kIOTraceStageNum; ++i) {
+        trace->timeUs[i] = begin + i * stepUs;
+    }
+}
+
+}  // namespace
+
+TEST(IOTracerTest, DisabledTest) {
+    IOTracer tracer;
+    ChunkRequest request = MakeRequest(CHUNK_OP_TYPE::CHUNK_OP_WRITE, 1);
+    // 未初始化时不采样
+    ASSERT_EQ(nullptr, tracer.Sample(request));
+
+    IOTracerOptions options;
+    options.sampleRate = 0;
+    ASSERT_EQ(0, tracer.Init(options, "io_tracer_test_disabled"));
+    ASSERT_EQ(nullptr, tracer.Sample(request));
+
+    std::ostringstream os;
+    tracer.DumpSlowest(os);
+    ASSERT_TRUE(os.str().empty());
+}
+
+TEST(IOTracerTest, InvalidOptionTest) {
+    IOTracer tracer;
+    IOTracerOptions options;
+    options.sampleRate = 1;
+    options.windowS = 0;
+    ASSERT_EQ(-1, tracer.Init(options, "io_tracer_test_invalid"));
+}
+
+TEST(IOTracerTest, SampleTest) {
+    IOTracer tracer;
+    IOTracerOptions options;
+    options.sampleRate = 1;
+    ASSERT_EQ(0, tracer.Init(options, "io_tracer_test_sample"));
+
+    // 只采样写请求
+    ChunkRequest read = MakeRequest(CHUNK_OP_TYPE::CHUNK_OP_READ, 1);
+    ASSERT_EQ(nullptr, tracer.Sample(read));
+
+    ChunkRequest write = MakeRequest(CHUNK_OP_TYPE::CHUNK_OP_WRITE, 2);
+    std::unique_ptr<IOTrace> trace = tracer.Sample(write);
+    ASSERT_NE(nullptr, trace);
+    ASSERT_EQ(1, trace->logicPoolId);
+    ASSERT_EQ(100001, trace->copysetId);
+    ASSERT_EQ(2, trace->chunkId);
+    ASSERT_EQ(4096, trace->offset);
+    ASSERT_EQ(4096, trace->size);
+    ASSERT_NE(0, trace->timeUs[static_cast<int>(IOTraceStage::RECEIVE)]);
+    for (int i = 1; i < kIOTraceStageNum; ++i) {
+        ASSERT_EQ(0, trace->timeUs[i]);
+    }
+    ASSERT_EQ(0, trace->TotalUs());
+}
+
+TEST(IOTracerTest, SlowestTest) {
+    IOTracer tracer;
+    IOTracerOptions options;
+    options.sampleRate = 1;
+    options.slowestNum = 2;
+    ASSERT_EQ(0, tracer.Init(options, "io_tracer_test_slowest"));
+
+    // 请求按chunk id依次变慢，只保留最慢的两个
+    for (ChunkID id = 1; id <= 4; ++id) {
+        ChunkRequest write = MakeRequest(CHUNK_OP_TYPE::CHUNK_OP_WRITE, id);
+        std::unique_ptr<IOTrace> trace = tracer.Sample(write);
+        ASSERT_NE(nullptr, trace);
+        FillTrace(trace.get(), id * 10);
+        tracer.Finish(*trace);
+    }
+    // 没有完整经过各阶段的请求不计入最慢请求
+    ChunkRequest write = MakeRequest(CHUNK_OP_TYPE::CHUNK_OP_WRITE, 5);
+    std::unique_ptr<IOTrace> trace = tracer.Sample(write);
+    ASSERT_NE(nullptr, trace);
+    trace->Mark(IOTraceStage::PROCESS);
+    tracer.Finish(*trace);
+
+    std::ostringstream os;
+    tracer.DumpSlowest(os);
+    std::string dump = os.str();
+    size_t chunk4 = dump.find("chunk 4 ");
+    size_t chunk3 = dump.find("chunk 3 ");
+    ASSERT_NE(std::string::npos, chunk4);
+    ASSERT_NE(std::string::npos, chunk3);
+    ASSERT_LT(chunk4, chunk3);
+    ASSERT_EQ(std::string::npos, dump.find("chunk 1 "));
+    ASSERT_EQ(std::string::npos, dump.find("chunk 2 "));
+    ASSERT_EQ(std::string::npos, dump.find("chunk 5 "));
+    ASSERT_NE(std::string::npos, dump.find("total 240us"));
+    ASSERT_NE(std::string::npos, dump.find("commit 40us"));
+}
+
+TEST(IOTracerTest, PartialTraceTest) {
+    IOTracer tracer;
+    IOTracerOptions options;
+    options.sampleRate = 1;
+    ASSERT_EQ(0, tracer.Init(options, "io_tracer_test_partial"));
+
+    // 中间阶段没有打点时，对应的时延输出为-
+    ChunkRequest write = MakeRequest(CHUNK_OP_TYPE::CHUNK_OP_WRITE, 1);
+    std::unique_ptr<IOTrace> trace = tracer.Sample(write);
+    ASSERT_NE(nullptr, trace);
+    uint64_t begin = trace->timeUs[0];
+    trace->timeUs[static_cast<int>(IOTraceStage::RESPONSE)] = begin + 100;
+    tracer.Finish(*trace);
+
+    std::ostringstream os;
+    tracer.DumpSlowest(os);
+    std::string dump = os.str();
+    ASSERT_NE(std::string::npos, dump.find("total 100us"));
+    ASSERT_NE(std::string::npos, dump.find("process -"));
+    ASSERT_NE(std::string::npos, dump.find("response -"));
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,301 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/chunkserver/raftlog/merged_log_storage.h"
+#include "test/fs/mock_local_filesystem.h"
+#include "test/chunkserver/datastore/mock_file_pool.h"
+#include "test/chunkserver/raftlog/common.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::fs::MockLocalFileSystem;
+using ::testing::Return;
+using ::testing::Invoke;
+using ::testing::_;
+
+const uint32_t kMergedFileSize = 64 * 1024;
+const char kMergedLogDir[] = "./raft-log-data/merged_log";
+const char kMergedLogRootDir[] = "./raft-log-data/copysets";
+
+class MergedLogStorageTest : public testing::Test {
+ protected:
+    MergedLogStorageTest() {
+        fp_option.metaPageSize = kPageSize;
+        fp_option.fileSize = kMergedFileSize;
+    }
+    void SetUp() {
+        lfs = std::make_shared<MockLocalFileSystem>();
+        file_pool = std::make_shared<MockFilePool>(lfs);
+        std::string cmd = std::string("mkdir -p ") + kMergedLogRootDir;
+        ::system(cmd.c_str());
+
+        // 模拟walFilePool，获取的文件已经写好metapage
+        auto getFile = [](const std::string& path,
+                          const char* metapage) -> int {
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0) {
+                return -1;
+            }
+            std::string data(kMergedFileSize + kPageSize, 0);
+            memcpy(&data[0], metapage, kPageSize);
+            int ret = ::pwrite(fd, data.data(), data.size(), 0) ==
+                      static_cast<ssize_t>(data.size()) ? 0 : -1;
+            ::close(fd);
+            return ret;
+        };
+        auto recycleFile = [](const std::string& path) -> int {
+            return ::unlink(path.c_str());
+        };
+        EXPECT_CALL(*file_pool, GetFilePoolOpt())
+            .WillRepeatedly(Return(fp_option));
+        EXPECT_CALL(*file_pool, GetFileImpl(_, _))
+            .WillRepeatedly(Invoke(getFile));
+        EXPECT_CALL(*file_pool, RecycleFile(_))
+            .WillRepeatedly(Invoke(recycleFile));
+    }
+    void TearDown() {
+        std::string cmd = std::string("rm -rf ") + kRaftLogDataDir;
+        ::system(cmd.c_str());
+    }
+
+    std::shared_ptr<MergedLogManager> NewManager() {
+        MergedLogOptions options;
+        options.path = kMergedLogDir;
+        options.logRootDir = kMergedLogRootDir;
+        options.walFilePool = file_pool;
+        auto manager = std::make_shared<MergedLogManager>();
+        EXPECT_EQ(0, manager->Init(options));
+        return manager;
+    }
+
+    std::shared_ptr<MergedLogStorage> NewStorage(
+        const std::shared_ptr<MergedLogManager>& manager, uint64_t groupId) {
+        std::string path = std::string(kMergedLogRootDir) + "/" +
+                           std::to_string(groupId) + "/log";
+        auto storage = std::make_shared<MergedLogStorage>(path, manager);
+        braft::ConfigurationManager configurationManager;
+        EXPECT_EQ(0, storage->init(&configurationManager));
+        return storage;
+    }
+
+    void append_entries(std::shared_ptr<MergedLogStorage> storage,
+                        int64_t start, int m, int n, int64_t term = 1) {
+        braft::IOMetric metric;
+        for (int i = 0; i < m; i++) {
+            std::vector<braft::LogEntry*> entries;
+            for (int j = 0; j < n; j++) {
+                int64_t index = start + n*i + j;
+                braft::LogEntry* entry = new braft::LogEntry();
+                entry->AddRef();
+                entry->type = braft::ENTRY_TYPE_DATA;
+                entry->id.term = term;
+                entry->id.index = index;
+
+                char data_buf[128];
+                snprintf(data_buf, sizeof(data_buf),
+                         "hello, world: %" PRId64, index);
+                entry->data.append(data_buf);
+                entries.push_back(entry);
+            }
+
+            ASSERT_EQ(n, storage->append_entries(entries, &metric));
+            for (auto entry : entries) {
+                entry->Release();
+            }
+        }
+    }
+
+    void read_entries(std::shared_ptr<MergedLogStorage> storage,
+                      int64_t start, int64_t end, int64_t term = 1) {
+        for (int64_t index = start; index < end; index++) {
+            braft::LogEntry* entry = storage->get_entry(index);
+            ASSERT_NE(nullptr, entry) << index;
+            ASSERT_EQ(entry->id.term, term);
+            ASSERT_EQ(entry->type, braft::ENTRY_TYPE_DATA);
+            ASSERT_EQ(entry->id.index, index);
+            ASSERT_EQ(term, storage->get_term(index));
+
+            char data_buf[128];
+            snprintf(data_buf, sizeof(data_buf),
+                     "hello, world: %" PRId64, index);
+            ASSERT_EQ(data_buf, entry->data.to_string());
+            entry->Release();
+        }
+    }
+
+    std::shared_ptr<MockLocalFileSystem> lfs;
+    std::shared_ptr<MockFilePool> file_pool;
+    FilePoolOptions fp_option;
+};
+
+TEST_F(MergedLogStorageTest, basic_test) {
+    auto manager = NewManager();
+    auto storage1 = NewStorage(manager, 1);
+    auto storage2 = NewStorage(manager, 2);
+    ASSERT_EQ(1, storage1->first_log_index());
+    ASSERT_EQ(0, storage1->last_log_index());
+    ASSERT_EQ(1, manager->FileCount());
+
+    // 两个复制组的日志交替写入同一个文件
+    for (int i = 0; i < 10; i++) {
+        append_entries(storage1, 10 * i + 1, 1, 10);
+        append_entries(storage2, 5 * i + 1, 1, 5);
+    }
+    ASSERT_EQ(1, manager->FileCount());
+    ASSERT_EQ(1, storage1->first_log_index());
+    ASSERT_EQ(100, storage1->last_log_index());
+    ASSERT_EQ(50, storage2->last_log_index());
+    read_entries(storage1, 1, 101);
+    read_entries(storage2, 1, 51);
+    ASSERT_EQ(nullptr, storage1->get_entry(101));
+    ASSERT_EQ(0, storage2->get_term(51));
+
+    // truncate prefix
+    ASSERT_EQ(0, storage1->truncate_prefix(51));
+    ASSERT_EQ(51, storage1->first_log_index());
+    ASSERT_EQ(nullptr, storage1->get_entry(50));
+    read_entries(storage1, 51, 101);
+
+    // truncate suffix后重新写入
+    ASSERT_EQ(0, storage2->truncate_suffix(30));
+    ASSERT_EQ(30, storage2->last_log_index());
+    append_entries(storage2, 31, 1, 10, 2);
+    read_entries(storage2, 1, 31);
+    read_entries(storage2, 31, 41, 2);
+
+    // reset
+    ASSERT_EQ(0, storage1->reset(200));
+    ASSERT_EQ(200, storage1->first_log_index());
+    ASSERT_EQ(199, storage1->last_log_index());
+    append_entries(storage1, 200, 1, 10);
+    read_entries(storage1, 200, 210);
+}
+
+TEST_F(MergedLogStorageTest, restart_test) {
+    {
+        auto manager = NewManager();
+        auto storage1 = NewStorage(manager, 1);
+        auto storage2 = NewStorage(manager, 2);
+        auto storage3 = NewStorage(manager, 3);
+        append_entries(storage1, 1, 100, 5);
+        append_entries(storage2, 1, 100, 5);
+        append_entries(storage3, 1, 10, 5);
+        ASSERT_EQ(0, storage1->truncate_prefix(101));
+        ASSERT_EQ(0, storage2->truncate_suffix(300));
+        append_entries(storage2, 301, 1, 10, 2);
+        ASSERT_EQ(0, storage3->reset(1000));
+        ASSERT_LT(1, manager->FileCount());
+    }
+
+    // 重启后从共享文件中恢复各复制组的日志
+    auto manager = NewManager();
+    auto storage1 = NewStorage(manager, 1);
+    auto storage2 = NewStorage(manager, 2);
+    auto storage3 = NewStorage(manager, 3);
+    ASSERT_EQ(101, storage1->first_log_index());
+    ASSERT_EQ(500, storage1->last_log_index());
+    read_entries(storage1, 101, 501);
+    ASSERT_EQ(1, storage2->first_log_index());
+    ASSERT_EQ(310, storage2->last_log_index());
+    read_entries(storage2, 1, 301);
+    read_entries(storage2, 301, 311, 2);
+    ASSERT_EQ(1000, storage3->first_log_index());
+    ASSERT_EQ(999, storage3->last_log_index());
+
+    // 重启后的写入在新文件中进行
+    size_t fileCount = manager->FileCount();
+    append_entries(storage3, 1000, 1, 10);
+    ASSERT_EQ(fileCount + 1, manager->FileCount());
+    read_entries(storage3, 1000, 1010);
+}
+
+TEST_F(MergedLogStorageTest, recycle_test) {
+    auto manager = NewManager();
+    auto storage1 = NewStorage(manager, 1);
+    auto storage2 = NewStorage(manager, 2);
+    for (int i = 0; i < 200; i++) {
+        append_entries(storage1, 10 * i + 1, 1, 10);
+        append_entries(storage2, 10 * i + 1, 1, 10);
+    }
+    size_t fileCount = manager->FileCount();
+    ASSERT_LE(4, fileCount);
+
+    // 只有一个复制组截断了日志，文件仍然被另一个复制组使用
+    ASSERT_EQ(0, storage1->truncate_prefix(2001));
+    ASSERT_EQ(fileCount, manager->FileCount());
+
+    // 两个复制组都截断后，按创建顺序回收不再使用的文件
+    ASSERT_EQ(0, storage2->truncate_prefix(1000));
+    size_t count = manager->FileCount();
+    ASSERT_GT(fileCount, count);
+    ASSERT_LT(1, count);
+    read_entries(storage2, 1000, 2001);
+
+    // 复制组被删除后，其日志可以被回收
+    storage2 = nullptr;
+    std::string cmd = std::string("rm -rf ") + kMergedLogRootDir + "/2";
+    ASSERT_EQ(0, ::system(cmd.c_str()));
+    manager->Recycle();
+    ASSERT_EQ(1, manager->FileCount());
+    append_entries(storage1, 2001, 1, 10);
+    read_entries(storage1, 2001, 2011);
+}
+
+TEST_F(MergedLogStorageTest, concurrent_append_test) {
+    auto manager = NewManager();
+    const int kGroupNum = 8;
+    std::vector<std::shared_ptr<MergedLogStorage>> storages;
+    for (int i = 0; i < kGroupNum; i++) {
+        storages.push_back(NewStorage(manager, i + 1));
+    }
+
+    // 多个复制组并发写入，合并后一起落盘
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kGroupNum; i++) {
+        threads.emplace_back([this, &storages, i] {
+            append_entries(storages[i], 1, 100, 3);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < kGroupNum; i++) {
+        ASSERT_EQ(300, storages[i]->last_log_index());
+        read_entries(storages[i], 1, 301);
+    }
+
+    storages.clear();
+    manager = NewManager();
+    for (int i = 0; i < kGroupNum; i++) {
+        auto storage = NewStorage(manager, i + 1);
+        ASSERT_EQ(300, storage->last_log_index());
+        read_entries(storage, 1, 301);
+    }
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -126,7 +126,8 @@ TEST_F(ScanManagerTest, ScanJobTest) {
     EXPECT_CALL(*copysetNode_, SetScan(_)).Times(2);
     EXPECT_CALL(*copysetNode_, SetLastScan(_)).Times(1);
     EXPECT_CALL(*dataStore_, GetChunkMap())
-                .Times(1).WillOnce(Return(chunkMap));
+                .Times(1)
+                .WillOnce(Return(std::make_shared<ChunkMap>(chunkMap)));
     EXPECT_CALL(*copysetNode_, ListPeers(_)).Times(1)
                 .WillOnce(SetArgPointee<0>(peers));
     EXPECT_CALL(*copysetNode_, IsLeaderTerm())
@@ -164,7 +165,7 @@ TEST_F(ScanManagerTest, CompareMapSuccessTest) {
     job->poolId = 1;
     job->id = 10000;
     job->type = ScanType::NewMap;
-    job->chunkMap = chunkMap;
+    job->chunkMap = std::make_shared<ChunkMap>(chunkMap);
     job->task.chunkId = 1;
     job->task.offset = 12582912;
     job->task.len = 4194304;
@@ -207,6 +208,62 @@ TEST_F(ScanManagerTest, CompareMapSuccessTest) {
     ASSERT_EQ(0, scanManager_->GetJobNum());
 }
 
+TEST_F(ScanManagerTest, CompareMapIgnoreBlockCrcTest) {
+    // make key
+    ScanKey key(1, 10000);
+
+    // make scan job
+    ChunkMap chunkMap;
+    chunkMap.emplace(1, csChunkFile_);
+    std::shared_ptr<ScanJob> job = std::make_shared<ScanJob>();
+    job->poolId = 1;
+    job->id = 10000;
+    job->type = ScanType::WaitMap;
+    job->chunkMap = std::make_shared<ChunkMap>(chunkMap);
+    job->task.chunkId = 1;
+    job->task.offset = 12582912;
+    job->task.len = 4194304;
+    scanManager_->SetJob(key, job);
+
+    // the leader scanmap with block crc
+    ScanMap localMap;
+    localMap.set_logicalpoolid(1);
+    localMap.set_copysetid(10000);
+    localMap.set_chunkid(1);
+    localMap.set_index(1);
+    localMap.set_crc(100);
+    localMap.set_offset(12582912);
+    localMap.set_len(4194304);
+    ScanMap *followerMap = new ScanMap(localMap);
+    localMap.set_blocksize(65536);
+    for (int i = 0; i < 64; i++) {
+        localMap.add_blockcrc(i);
+    }
+    scanManager_->SetLocalScanMap(key, localMap);
+
+    // no failed scanmap, only get copyset node when finish the job
+    copysetNode_ = std::make_shared<MockCopysetNode>();
+    EXPECT_CALL(*copysetNodeManager_, GetCopysetNode(_, _))
+                .Times(1).WillOnce(Return(copysetNode_));
+    EXPECT_CALL(*copysetNode_, GetFailedScanMap()).Times(0);
+    EXPECT_CALL(*copysetNode_, SetScan(_)).Times(1);
+    EXPECT_CALL(*copysetNode_, SetLastScan(_)).Times(1);
+
+    // the follower scanmap without block crc (old version) is also consistent
+    FollowScanMapRequest request;
+    FollowScanMapResponse response;
+    request.set_allocated_scanmap(followerMap);
+    scanManager_->DealFollowerScanMap(request, &response);
+    scanManager_->DealFollowerScanMap(request, &response);
+    ASSERT_EQ(0, job->task.waitingNum);
+    ASSERT_TRUE(job->isFinished);
+
+    // finish scan job
+    job->type = ScanType::Finish;
+    scanManager_->GenScanJobs(key);
+    ASSERT_EQ(0, scanManager_->GetJobNum());
+}
+
 TEST_F(ScanManagerTest, CompareMapFailTest) {
     // make key
     ScanKey key(1, 10000);
@@ -220,7 +277,7 @@ TEST_F(ScanManagerTest, CompareMapFailTest) {
     job->poolId = 1;
     job->id = 10000;
     job->type = ScanType::NewMap;
-    job->chunkMap = chunkMap;
+    job->chunkMap = std::make_shared<ChunkMap>(chunkMap);
     job->task.chunkId = 1;
     job->task.offset = 12582912;
     job->task.len = 4194304;
@@ -322,7 +379,7 @@ TEST_F(ScanManagerTest, MismatchedCRCTest) {
     job->poolId = 1;
     job->id = 10000;
     job->type = ScanType::NewMap;
-    job->chunkMap = chunkMap;
+    job->chunkMap = std::make_shared<ChunkMap>(chunkMap);
     job->task.chunkId = 1;
     job->task.offset = 12582912;
     job->task.len = 4194304;
@@ -433,7 +490,8 @@ TEST_F(ScanManagerTest, CancelScanJobAfterTransferLeaderTest) {
                 .Times(2).WillRepeatedly(ReturnRef(failedMap));
     EXPECT_CALL(*copysetNode_, SetScan(_)).Times(2);
     EXPECT_CALL(*dataStore_, GetChunkMap())
-                .Times(1).WillOnce(Return(chunkMap));
+                .Times(1)
+                .WillOnce(Return(std::make_shared<ChunkMap>(chunkMap)));
     EXPECT_CALL(*copysetNode_, ListPeers(_)).Times(1)
                 .WillOnce(SetArgPointee<0>(peers));
     EXPECT_CALL(*copysetNode_, IsLeaderTerm())
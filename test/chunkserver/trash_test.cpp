@@ -574,6 +574,52 @@ TEST_F(TrashTest, recycle_copyset_dir_ok) {
     ASSERT_EQ(0, trash->RecycleCopySet(dirPath));
 }
 
+TEST_F(TrashTest, recycle_raft_log_dir_not_exist) {
+    std::string logDir = "./runlog/trash_test0/wal/4294967493";
+    EXPECT_CALL(*lfs, DirExists(logDir)).WillOnce(Return(false));
+    EXPECT_CALL(*lfs, Delete(_)).Times(0);
+    ASSERT_EQ(0, trash->RecycleRaftLog(logDir));
+}
+
+TEST_F(TrashTest, recycle_raft_log_ok) {
+    std::string logDir = "./runlog/trash_test0/wal/4294967493";
+    std::string log = logDir + "/" + RAFT_LOG_DIR;
+    std::vector<std::string> dirs{RAFT_LOG_DIR};
+    std::vector<std::string> logfiles{
+        "curve_log_10086_10087", "curve_log_inprogress_10088", "log_meta"};
+    EXPECT_CALL(*lfs, DirExists(logDir)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, DirExists(log)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, DirExists(Truly([&](const std::string& path) {
+        return path.find(log + "/") == 0;
+    }))).WillRepeatedly(Return(false));
+    EXPECT_CALL(*lfs, List(logDir, _))
+        .WillOnce(DoAll(SetArgPointee<1>(dirs), Return(0)));
+    EXPECT_CALL(*lfs, List(log, _))
+        .WillOnce(DoAll(SetArgPointee<1>(logfiles), Return(0)));
+    EXPECT_CALL(*walPool, RecycleFile(log + "/curve_log_10086_10087"))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*walPool, RecycleFile(log + "/curve_log_inprogress_10088"))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs, Delete(logDir)).WillOnce(Return(0));
+    ASSERT_EQ(0, trash->RecycleRaftLog(logDir));
+    // 单独回收的wal文件不计入回收站中的chunk个数
+    ASSERT_EQ(0, trash->GetChunkNum());
+}
+
+TEST_F(TrashTest, recycle_raft_log_failed) {
+    std::string logDir = "./runlog/trash_test0/wal/4294967493";
+    std::vector<std::string> logfiles{"curve_log_10086_10087"};
+    EXPECT_CALL(*lfs, DirExists(logDir)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, DirExists(logDir + "/curve_log_10086_10087"))
+        .WillOnce(Return(false));
+    EXPECT_CALL(*lfs, List(logDir, _))
+        .WillOnce(DoAll(SetArgPointee<1>(logfiles), Return(0)));
+    EXPECT_CALL(*walPool, RecycleFile(logDir + "/curve_log_10086_10087"))
+        .WillOnce(Return(-1));
+    EXPECT_CALL(*lfs, Delete(_)).Times(0);
+    ASSERT_EQ(-1, trash->RecycleRaftLog(logDir));
+}
+
 TEST_F(TrashTest, DISABLED_test_concurrenct) {
     std::thread thread1(&TrashTest::RecycleCopyset50Times, this);
     std::thread thread2(&TrashTest::CleanFiles, this);
@@ -0,0 +1,211 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <brpc/controller.h>
+#include <butil/iobuf.h>
+
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "proto/chunk.pb.h"
+#include "src/chunkserver/op_request.h"
+#include "src/chunkserver/write_coalescer.h"
+#include "test/chunkserver/mock_copyset_node.h"
+
+namespace curve {
+namespace chunkserver {
+
+using ::testing::_;
+using ::testing::Invoke;
+
+namespace {
+
+class CountClosure : public google::protobuf::Closure {
+ public:
+    void Run() override { ++count; }
+    int count = 0;
+};
+
+struct ProposedTask {
+    ChunkRequest request;
+    std::string data;
+    braft::Closure *done;
+};
+
+}  // namespace
+
+class WriteCoalescerTest : public testing::Test {
+ protected:
+    void SetUp() {
+        node_ = std::make_shared<MockCopysetNode>();
+        EXPECT_CALL(*node_, Propose(_))
+            .WillRepeatedly(Invoke([this](const braft::Task &task) {
+                // 第一个请求propose时阻塞，让后续请求在队列中积压
+                if (first_) {
+                    first_ = false;
+                    entered_.set_value();
+                    blocker_.get_future().wait();
+                }
+                ProposedTask proposed;
+                butil::IOBuf data;
+                auto op = ChunkOpRequest::Decode(*task.data,
+                                                 &proposed.request,
+                                                 &data, 0, PeerId());
+                ASSERT_NE(nullptr, op);
+                proposed.data = data.to_string();
+                proposed.done = task.done;
+                tasks_.push_back(proposed);
+            }));
+    }
+
+    void AddWrite(uint64_t chunkId, uint64_t offset, uint32_t size,
+                  char c) {
+        auto request = std::make_shared<ChunkRequest>();
+        request->set_optype(CHUNK_OP_TYPE::CHUNK_OP_WRITE);
+        request->set_logicpoolid(1);
+        request->set_copysetid(10001);
+        request->set_chunkid(chunkId);
+        request->set_offset(offset);
+        request->set_size(size);
+        request->set_sn(1);
+        auto cntl = std::make_shared<brpc::Controller>();
+        cntl->request_attachment().append(std::string(size, c));
+        auto response = std::make_shared<ChunkResponse>();
+        auto done = std::make_shared<CountClosure>();
+        requests_.push_back(request);
+        cntls_.push_back(cntl);
+        responses_.push_back(response);
+        dones_.push_back(done);
+        ops_.push_back(std::make_shared<WriteChunkRequest>(
+            node_, cntl.get(), request.get(), response.get(), done.get()));
+    }
+
+    void SubmitAll(WriteCoalescer *coalescer) {
+        // 第一个请求负责propose，其余请求在它阻塞期间进入队列
+        std::thread drainer([&] {
+            coalescer->Submit(ops_[0], requests_[0].get(),
+                              &cntls_[0]->request_attachment());
+        });
+        entered_.get_future().wait();
+        for (size_t i = 1; i < ops_.size(); ++i) {
+            coalescer->Submit(ops_[i], requests_[i].get(),
+                              &cntls_[i]->request_attachment());
+        }
+        blocker_.set_value();
+        drainer.join();
+    }
+
+    std::shared_ptr<MockCopysetNode> node_;
+    bool first_ = true;
+    std::promise<void> entered_;
+    std::promise<void> blocker_;
+    std::vector<ProposedTask> tasks_;
+    std::vector<std::shared_ptr<ChunkRequest>> requests_;
+    std::vector<std::shared_ptr<brpc::Controller>> cntls_;
+    std::vector<std::shared_ptr<ChunkResponse>> responses_;
+    std::vector<std::shared_ptr<CountClosure>> dones_;
+    std::vector<std::shared_ptr<ChunkOpRequest>> ops_;
+};
+
+TEST_F(WriteCoalescerTest, MergeSequentialWrites) {
+    WriteCoalescerOptions options;
+    options.maxBytes = 12 * 1024;
+    WriteCoalescer coalescer(options);
+
+    AddWrite(1, 0, 4096, 'a');
+    // 下面三个顺序写合并成一个
+    AddWrite(1, 4096, 4096, 'b');
+    AddWrite(1, 8192, 4096, 'c');
+    AddWrite(1, 12288, 4096, 'd');
+    // 超过maxBytes，单独propose
+    AddWrite(1, 16384, 4096, 'e');
+    // 不连续的写和其他chunk上的写不合并
+    AddWrite(1, 32768, 4096, 'f');
+    AddWrite(2, 36864, 4096, 'g');
+    SubmitAll(&coalescer);
+
+    ASSERT_EQ(5, tasks_.size());
+    ASSERT_EQ(1, coalescer.MergedCount());
+    ASSERT_EQ(0, tasks_[0].request.offset());
+    ASSERT_EQ(4096, tasks_[1].request.offset());
+    ASSERT_EQ(12288, tasks_[1].request.size());
+    ASSERT_EQ(std::string(4096, 'b') + std::string(4096, 'c') +
+              std::string(4096, 'd'), tasks_[1].data);
+    ASSERT_EQ(16384, tasks_[2].request.offset());
+    ASSERT_EQ(32768, tasks_[3].request.offset());
+    ASSERT_EQ(2, tasks_[4].request.chunkid());
+
+    // 合并后的请求失败时，所有原始请求都返回相同的错误
+    tasks_[1].done->status().set_error(EPERM, "leader stepped down");
+    tasks_[1].done->Run();
+    for (int i = 1; i <= 3; ++i) {
+        ASSERT_EQ(1, dones_[i]->count);
+        ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_REDIRECTED,
+                  responses_[i]->status());
+    }
+    ASSERT_EQ(0, dones_[0]->count);
+    ASSERT_EQ(0, dones_[4]->count);
+
+    for (size_t i = 0; i < tasks_.size(); ++i) {
+        if (i != 1) {
+            tasks_[i].done->Run();
+        }
+    }
+    for (auto &done : dones_) {
+        ASSERT_EQ(1, done->count);
+    }
+}
+
+TEST_F(WriteCoalescerTest, KeepOrderOfOtherRequests) {
+    WriteCoalescerOptions options;
+    WriteCoalescer coalescer(options);
+
+    AddWrite(1, 0, 4096, 'a');
+    AddWrite(1, 4096, 4096, 'b');
+    AddWrite(1, 8192, 4096, 'c');
+    // 带clone信息的写不合并
+    AddWrite(1, 12288, 4096, 'd');
+    requests_[3]->set_clonefilesource("/clone");
+    requests_[3]->set_clonefileoffset(0);
+    AddWrite(1, 16384, 4096, 'e');
+    // correctedSn不同的写不合并
+    AddWrite(1, 20480, 4096, 'f');
+    requests_[5]->set_correctedsn(2);
+    SubmitAll(&coalescer);
+
+    ASSERT_EQ(5, tasks_.size());
+    ASSERT_EQ(1, coalescer.MergedCount());
+    ASSERT_EQ(4096, tasks_[1].request.offset());
+    ASSERT_EQ(8192, tasks_[1].request.size());
+    ASSERT_TRUE(tasks_[2].request.has_clonefilesource());
+    ASSERT_EQ(16384, tasks_[3].request.offset());
+    ASSERT_EQ(20480, tasks_[4].request.offset());
+    ASSERT_EQ(2, tasks_[4].request.correctedsn());
+    for (auto &task : tasks_) {
+        task.done->Run();
+    }
+    for (auto &done : dones_) {
+        ASSERT_EQ(1, done->count);
+    }
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,250 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/client/file_read_cache.h"
+
+namespace curve {
+namespace client {
+
+namespace {
+
+const uint32_t kBlockSize = 4096;
+const uint64_t kChunkSize = 16 * kBlockSize;
+
+butil::IOBuf MakeData(size_t length, char c) {
+    butil::IOBuf data;
+    data.append(std::string(length, c));
+    return data;
+}
+
+ReadCacheOption MakeOption() {
+    ReadCacheOption option;
+    option.enable = true;
+    option.blockSize = kBlockSize;
+    option.memoryCapacityMB = 1;
+    return option;
+}
+
+}  // namespace
+
+TEST(FileReadCacheTest, InitTest) {
+    ReadCacheOption option = MakeOption();
+    option.blockSize = 3000;
+    FileReadCache cache(option, kChunkSize, "file_read_cache_test_init");
+    ASSERT_FALSE(cache.Init());
+
+    option = MakeOption();
+    option.ssdCachePath = "./not_exist_read_cache_dir";
+    option.ssdCapacityMB = 1;
+    FileReadCache cache2(option, kChunkSize, "file_read_cache_test_init2");
+    ASSERT_FALSE(cache2.Init());
+}
+
+TEST(FileReadCacheTest, FillAndReadTest) {
+    FileReadCache cache(MakeOption(), kChunkSize,
+                        "file_read_cache_test_fill");
+    ASSERT_TRUE(cache.Init());
+
+    butil::IOBuf data;
+    ASSERT_FALSE(cache.Read(0, kBlockSize, &data));
+
+    // only the blocks fully covered by the data are cached
+    uint64_t ticket = cache.BeginFill();
+    cache.Fill(ticket, 512, MakeData(3 * kBlockSize, 'a'));
+    ASSERT_FALSE(cache.Read(0, kBlockSize, &data));
+    ASSERT_TRUE(cache.Read(kBlockSize, 2 * kBlockSize, &data));
+    ASSERT_EQ(std::string(2 * kBlockSize, 'a'), data.to_string());
+    ASSERT_FALSE(cache.Read(3 * kBlockSize, kBlockSize, &data));
+
+    // unaligned read in the cached blocks
+    ASSERT_TRUE(cache.Read(kBlockSize + 100, kBlockSize, &data));
+    ASSERT_EQ(kBlockSize, data.size());
+    ASSERT_FALSE(cache.Read(kBlockSize + 100, 2 * kBlockSize, &data));
+}
+
+TEST(FileReadCacheTest, InvalidateTest) {
+    FileReadCache cache(MakeOption(), kChunkSize,
+                        "file_read_cache_test_invalidate");
+    ASSERT_TRUE(cache.Init());
+
+    butil::IOBuf data;
+    uint64_t ticket = cache.BeginFill();
+    uint64_t otherTicket = cache.BeginFill();
+    cache.Fill(ticket, 0, MakeData(4 * kBlockSize, 'a'));
+    cache.Fill(ticket, kChunkSize, MakeData(kBlockSize, 'a'));
+
+    // only the blocks overlapping with the range are invalidated
+    cache.Invalidate(kBlockSize + 512, kBlockSize);
+    ASSERT_TRUE(cache.Read(0, kBlockSize, &data));
+    ASSERT_FALSE(cache.Read(kBlockSize, kBlockSize, &data));
+    ASSERT_FALSE(cache.Read(2 * kBlockSize, kBlockSize, &data));
+    ASSERT_TRUE(cache.Read(3 * kBlockSize, kBlockSize, &data));
+
+    // the data read before the modification can not fill the chunk
+    cache.Fill(otherTicket, kBlockSize, MakeData(kBlockSize, 'a'));
+    ASSERT_FALSE(cache.Read(kBlockSize, kBlockSize, &data));
+    // but other chunks are not affected
+    cache.Fill(otherTicket, kChunkSize + kBlockSize,
+               MakeData(kBlockSize, 'a'));
+    ASSERT_TRUE(cache.Read(kChunkSize, 2 * kBlockSize, &data));
+
+    ticket = cache.BeginFill();
+    cache.Fill(ticket, kBlockSize, MakeData(kBlockSize, 'b'));
+    ASSERT_TRUE(cache.Read(kBlockSize, kBlockSize, &data));
+    ASSERT_EQ(std::string(kBlockSize, 'b'), data.to_string());
+}
+
+TEST(FileReadCacheTest, WriteThroughTest) {
+    FileReadCache cache(MakeOption(), kChunkSize,
+                        "file_read_cache_test_write");
+    ASSERT_TRUE(cache.Init());
+
+    butil::IOBuf data;
+    uint64_t ticket = cache.BeginFill();
+    cache.Fill(ticket, 0, MakeData(2 * kBlockSize, 'a'));
+
+    // the written data replaces the cached blocks
+    ticket = cache.BeginFill();
+    cache.WriteThrough(ticket, 0, MakeData(kBlockSize + 512, 'b'));
+    ASSERT_TRUE(cache.Read(0, kBlockSize, &data));
+    ASSERT_EQ(std::string(kBlockSize, 'b'), data.to_string());
+    ASSERT_FALSE(cache.Read(kBlockSize, kBlockSize, &data));
+
+    // overlapping writes, the one finished later only invalidates
+    uint64_t first = cache.BeginFill();
+    uint64_t second = cache.BeginFill();
+    cache.WriteThrough(second, 0, MakeData(kBlockSize, 'c'));
+    ASSERT_TRUE(cache.Read(0, kBlockSize, &data));
+    ASSERT_EQ(std::string(kBlockSize, 'c'), data.to_string());
+    cache.WriteThrough(first, 0, MakeData(kBlockSize, 'd'));
+    ASSERT_FALSE(cache.Read(0, kBlockSize, &data));
+}
+
+TEST(FileReadCacheTest, DropTest) {
+    FileReadCache cache(MakeOption(), kChunkSize, "file_read_cache_test_drop");
+    ASSERT_TRUE(cache.Init());
+
+    butil::IOBuf data;
+    uint64_t ticket = cache.BeginFill();
+    uint64_t otherTicket = cache.BeginFill();
+    cache.Fill(ticket, 0, MakeData(kBlockSize, 'a'));
+    ASSERT_TRUE(cache.Read(0, kBlockSize, &data));
+
+    cache.Drop();
+    ASSERT_FALSE(cache.Read(0, kBlockSize, &data));
+    cache.Fill(otherTicket, kBlockSize, MakeData(kBlockSize, 'a'));
+    ASSERT_FALSE(cache.Read(kBlockSize, kBlockSize, &data));
+    cache.WriteThrough(otherTicket, 0, MakeData(kBlockSize, 'a'));
+    ASSERT_FALSE(cache.Read(0, kBlockSize, &data));
+
+    ticket = cache.BeginFill();
+    cache.Fill(ticket, 0, MakeData(kBlockSize, 'b'));
+    ASSERT_TRUE(cache.Read(0, kBlockSize, &data));
+    ASSERT_EQ(std::string(kBlockSize, 'b'), data.to_string());
+}
+
+TEST(FileReadCacheTest, PrefetchTest) {
+    // 4 blocks in memory
+    ReadCacheOption option = MakeOption();
+    option.blockSize = 256 * 1024;
+    const uint64_t blockSize = option.blockSize;
+    FileReadCache cache(option, 64 * blockSize,
+                        "file_read_cache_test_prefetch");
+    ASSERT_TRUE(cache.Init());
+
+    butil::IOBuf data;
+    uint64_t ticket = cache.BeginFill();
+    cache.Fill(ticket, 0, MakeData(2 * blockSize, 'a'), true);
+    ticket = cache.BeginFill();
+    cache.Fill(ticket, 2 * blockSize, MakeData(blockSize, 'b'));
+
+    // a prefetched block is only promoted by the second read of the user
+    ASSERT_TRUE(cache.Read(0, blockSize, &data));
+    ASSERT_TRUE(cache.Read(blockSize, blockSize, &data));
+    ASSERT_TRUE(cache.Read(blockSize, blockSize, &data));
+    ASSERT_TRUE(cache.Read(2 * blockSize, blockSize, &data));
+
+    // a scan only evicts the blocks read once
+    for (uint64_t index = 10; index < 20; ++index) {
+        ticket = cache.BeginFill();
+        cache.Fill(ticket, index * blockSize, MakeData(blockSize, 'c'));
+    }
+    ASSERT_FALSE(cache.Read(0, blockSize, &data));
+    ASSERT_TRUE(cache.Read(blockSize, blockSize, &data));
+    ASSERT_EQ(std::string(blockSize, 'a'), data.to_string());
+    ASSERT_TRUE(cache.Read(2 * blockSize, blockSize, &data));
+    ASSERT_EQ(std::string(blockSize, 'b'), data.to_string());
+}
+
+TEST(FileReadCacheTest, SsdTierTest) {
+    // 4 blocks in memory and 16 blocks on ssd
+    ReadCacheOption option = MakeOption();
+    option.blockSize = 256 * 1024;
+    option.ssdCachePath = ".";
+    option.ssdCapacityMB = 4;
+    const uint64_t blockSize = option.blockSize;
+    FileReadCache cache(option, 64 * blockSize, "file_read_cache_test_ssd");
+    ASSERT_TRUE(cache.Init());
+
+    butil::IOBuf data;
+    for (uint64_t index = 0; index < 12; ++index) {
+        uint64_t ticket = cache.BeginFill();
+        cache.Fill(ticket, index * blockSize,
+                   MakeData(blockSize, 'a' + index));
+    }
+
+    // the blocks evicted from memory are read from ssd
+    for (uint64_t index = 0; index < 12; ++index) {
+        ASSERT_TRUE(cache.Read(index * blockSize, blockSize, &data));
+        ASSERT_EQ(std::string(blockSize, 'a' + index), data.to_string());
+    }
+    ASSERT_TRUE(cache.Read(0, 12 * blockSize, &data));
+
+    // invalidated blocks are removed from both tiers
+    cache.Invalidate(0, 12 * blockSize);
+    for (uint64_t index = 0; index < 12; ++index) {
+        ASSERT_FALSE(cache.Read(index * blockSize, blockSize, &data));
+    }
+
+    // the slots are reused after the cache is dropped
+    for (int round = 0; round < 2; ++round) {
+        for (uint64_t index = 0; index < 20; ++index) {
+            uint64_t ticket = cache.BeginFill();
+            cache.Fill(ticket, index * blockSize,
+                       MakeData(blockSize, 'a' + index));
+        }
+        int cached = 0;
+        for (uint64_t index = 0; index < 20; ++index) {
+            if (cache.Read(index * blockSize, blockSize, &data)) {
+                ASSERT_EQ(std::string(blockSize, 'a' + index),
+                          data.to_string());
+                ++cached;
+            }
+        }
+        ASSERT_GE(cached, 16);
+        cache.Drop();
+        for (uint64_t index = 0; index < 20; ++index) {
+            ASSERT_FALSE(cache.Read(index * blockSize, blockSize, &data));
+        }
+    }
+}
+
+}  // namespace client
+}  // namespace curve
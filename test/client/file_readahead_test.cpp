@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "src/client/file_readahead.h"
+
+namespace curve {
+namespace client {
+
+namespace {
+
+const uint32_t kBlockSize = 4096;
+const uint64_t kIOSize = 16 * 1024;
+const uint64_t kFileLength = 1024 * 1024 * 1024;
+const uint64_t kWindow = 64 * 1024;
+const uint64_t kMaxWindow = 1024 * 1024;
+
+ReadaheadOption MakeOption() {
+    ReadaheadOption option;
+    option.enable = true;
+    option.triggerCount = 3;
+    option.minWindowKB = 64;
+    option.maxWindowKB = 1024;
+    option.maxStreams = 2;
+    return option;
+}
+
+}  // namespace
+
+TEST(FileReadaheadTest, RandomReadTest) {
+    FileReadahead readahead(MakeOption(), kBlockSize,
+                            "file_readahead_test_random");
+
+    ReadaheadRange range;
+    for (uint64_t i = 0; i < 10; ++i) {
+        uint64_t offset = (i * 7 % 10) * 1024 * 1024;
+        ASSERT_FALSE(readahead.OnRead(offset, kIOSize, kFileLength, &range));
+    }
+}
+
+TEST(FileReadaheadTest, SequentialReadTest) {
+    FileReadahead readahead(MakeOption(), kBlockSize,
+                            "file_readahead_test_sequential");
+
+    // prefetch after 3 sequential reads
+    ReadaheadRange range;
+    ASSERT_FALSE(readahead.OnRead(0, kIOSize, kFileLength, &range));
+    ASSERT_FALSE(readahead.OnRead(kIOSize, kIOSize, kFileLength, &range));
+    ASSERT_TRUE(readahead.OnRead(2 * kIOSize, kIOSize, kFileLength, &range));
+    ASSERT_EQ(3 * kIOSize, range.offset);
+    ASSERT_EQ(kWindow, range.length);
+
+    // only one prefetch of a stream is in flight, and the reader catching up
+    // with it doubles the window
+    ReadaheadRange next;
+    ASSERT_FALSE(readahead.OnRead(3 * kIOSize, kIOSize, kFileLength, &next));
+    readahead.OnPrefetchDone(range, true, 0);
+
+    ASSERT_TRUE(readahead.OnRead(4 * kIOSize, kIOSize, kFileLength, &next));
+    ASSERT_EQ(range.offset + range.length, next.offset);
+    ASSERT_EQ(5 * kIOSize + 2 * kWindow, next.offset + next.length);
+    readahead.OnPrefetchDone(next, true, 0);
+
+    // enough data is prefetched ahead of the reader
+    ASSERT_FALSE(readahead.OnRead(5 * kIOSize, kIOSize, kFileLength, &range));
+
+    // reordered reads of the stream are still sequential
+    ASSERT_FALSE(readahead.OnRead(7 * kIOSize, kIOSize, kFileLength, &range));
+    ASSERT_FALSE(readahead.OnRead(6 * kIOSize, kIOSize, kFileLength, &range));
+    ASSERT_FALSE(readahead.OnRead(8 * kIOSize, kIOSize, kFileLength, &range));
+    ASSERT_TRUE(readahead.OnRead(9 * kIOSize, kIOSize, kFileLength, &range));
+    ASSERT_EQ(next.offset + next.length, range.offset);
+}
+
+TEST(FileReadaheadTest, FileEndTest) {
+    FileReadahead readahead(MakeOption(), kBlockSize,
+                            "file_readahead_test_end");
+    const uint64_t fileLength = 4 * kIOSize + kBlockSize;
+
+    ReadaheadRange range;
+    ASSERT_FALSE(readahead.OnRead(0, kIOSize, fileLength, &range));
+    ASSERT_FALSE(readahead.OnRead(kIOSize, kIOSize, fileLength, &range));
+    ASSERT_TRUE(readahead.OnRead(2 * kIOSize, kIOSize, fileLength, &range));
+    ASSERT_EQ(3 * kIOSize, range.offset);
+    ASSERT_EQ(fileLength, range.offset + range.length);
+    readahead.OnPrefetchDone(range, true, 0);
+
+    ASSERT_FALSE(readahead.OnRead(3 * kIOSize, kIOSize, fileLength, &range));
+    ASSERT_FALSE(readahead.OnRead(4 * kIOSize, kBlockSize, fileLength,
+                                  &range));
+}
+
+TEST(FileReadaheadTest, LatencyTest) {
+    FileReadahead readahead(MakeOption(), kBlockSize,
+                            "file_readahead_test_latency");
+
+    // the window grows with the latency of prefetches, at most doubled at
+    // once and limited by the max window
+    ReadaheadRange range;
+    uint64_t offset = 0;
+    uint64_t window = 0;
+    for (int i = 0; i < 40; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (readahead.OnRead(offset, kIOSize, kFileLength, &range)) {
+            uint64_t current = range.offset + range.length - offset - kIOSize;
+            if (window != 0) {
+                ASSERT_LE(current, 2 * window);
+            }
+            ASSERT_LE(current, kMaxWindow);
+            window = current;
+            readahead.OnPrefetchDone(range, true, 1000 * 1000);
+        }
+        offset += kIOSize;
+    }
+    ASSERT_EQ(kMaxWindow, window);
+}
+
+TEST(FileReadaheadTest, StreamTest) {
+    FileReadahead readahead(MakeOption(), kBlockSize,
+                            "file_readahead_test_stream");
+
+    // two interleaved streams are both detected
+    ReadaheadRange range;
+    const uint64_t base = 512 * 1024 * 1024ull;
+    for (uint64_t i = 0; i < 2; ++i) {
+        ASSERT_FALSE(readahead.OnRead(i * kIOSize, kIOSize, kFileLength,
+                                      &range));
+        ASSERT_FALSE(readahead.OnRead(base + i * kIOSize, kIOSize,
+                                      kFileLength, &range));
+    }
+    ReadaheadRange first;
+    ASSERT_TRUE(readahead.OnRead(2 * kIOSize, kIOSize, kFileLength, &first));
+    ASSERT_EQ(3 * kIOSize, first.offset);
+    ReadaheadRange second;
+    ASSERT_TRUE(readahead.OnRead(base + 2 * kIOSize, kIOSize, kFileLength,
+                                 &second));
+    ASSERT_EQ(base + 3 * kIOSize, second.offset);
+
+    // a third stream replaces the least recently used one, and the
+    // prefetch of the replaced stream is ignored
+    ASSERT_FALSE(readahead.OnRead(base / 2, kIOSize, kFileLength, &range));
+    readahead.OnPrefetchDone(first, true, 0);
+    readahead.OnPrefetchDone(second, true, 0);
+    ASSERT_FALSE(readahead.OnRead(3 * kIOSize, kIOSize, kFileLength, &range));
+    ASSERT_FALSE(readahead.OnRead(base + 3 * kIOSize, kIOSize, kFileLength,
+                                  &range));
+
+    // all the streams are forgotten after reset
+    readahead.Reset();
+    ASSERT_FALSE(readahead.OnRead(base + 4 * kIOSize, kIOSize, kFileLength,
+                                  &range));
+    ASSERT_FALSE(readahead.OnRead(base + 5 * kIOSize, kIOSize, kFileLength,
+                                  &range));
+    ASSERT_TRUE(readahead.OnRead(base + 6 * kIOSize, kIOSize, kFileLength,
+                                 &range));
+    ASSERT_EQ(base + 7 * kIOSize, range.offset);
+}
+
+TEST(FileReadaheadTest, PrefetchFailTest) {
+    FileReadahead readahead(MakeOption(), kBlockSize,
+                            "file_readahead_test_fail");
+
+    ReadaheadRange range;
+    ASSERT_FALSE(readahead.OnRead(0, kIOSize, kFileLength, &range));
+    ASSERT_FALSE(readahead.OnRead(kIOSize, kIOSize, kFileLength, &range));
+    ASSERT_TRUE(readahead.OnRead(2 * kIOSize, kIOSize, kFileLength, &range));
+    readahead.OnPrefetchDone(range, false, 0);
+
+    // the part of the failed range not read yet is prefetched again
+    ReadaheadRange retry;
+    ASSERT_TRUE(readahead.OnRead(3 * kIOSize, kIOSize, kFileLength, &retry));
+    ASSERT_EQ(4 * kIOSize, retry.offset);
+    ASSERT_EQ(4 * kIOSize + kWindow, retry.offset + retry.length);
+}
+
+}  // namespace client
+}  // namespace curve
@@ -571,6 +571,143 @@ TEST_F(IOTrackerSplitorTest, ManagerAsyncStartWrite) {
     ASSERT_EQ('c', writebuffer[aioctx->length - 1]);
 }
 
+TEST_F(IOTrackerSplitorTest, ManagerAsyncSubmitVectored) {
+    MockRequestScheduler* mockschuler = new MockRequestScheduler;
+    mockschuler->DelegateToFake();
+
+    auto ioctxmana = fileinstance_->GetIOManager4File();
+    ioctxmana->SetRequestScheduler(mockschuler);
+
+    const size_t length = 4 * 1024 * 1024 + 8 * 1024;
+    std::unique_ptr<char[]> data(new char[length]);
+    // the buffers do not line up with the chunk boundaries
+    struct iovec iov[3];
+    iov[0].iov_base = data.get();
+    iov[0].iov_len = 6 * 1024;
+    iov[1].iov_base = data.get() + 6 * 1024;
+    iov[1].iov_len = chunk_size;
+    iov[2].iov_base = data.get() + 6 * 1024 + chunk_size;
+    iov[2].iov_len = length - 6 * 1024 - chunk_size;
+
+    CurveAioContext readctx;
+    readctx.offset = 4 * 1024 * 1024 - 4 * 1024;
+    readctx.length = length;
+    readctx.ret = LIBCURVE_ERROR::OK;
+    readctx.cb = readcallback;
+    readctx.buf = nullptr;
+    readctx.op = LIBCURVE_OP::LIBCURVE_OP_READ;
+
+    // the length of the buffers does not match
+    CurveAioRequest request{&readctx, iov, 2};
+    ASSERT_EQ(-LIBCURVE_ERROR::PARAM_ERROR,
+              fileinstance_->AioSubmit(&request, 1));
+
+    ioreadflag = false;
+    request.iovcnt = 3;
+    ASSERT_EQ(LIBCURVE_ERROR::OK, fileinstance_->AioSubmit(&request, 1));
+    {
+        std::unique_lock<std::mutex> lk(readmtx);
+        readcv.wait(lk, []()->bool{return ioreadflag;});
+    }
+    ASSERT_EQ(static_cast<int>(length), readctx.ret);
+    ASSERT_EQ('a', data[0]);
+    ASSERT_EQ('a', data[4 * 1024 - 1]);
+    ASSERT_EQ('b', data[4 * 1024]);
+    ASSERT_EQ('e', data[4 * 1024 + chunk_size - 1]);
+    ASSERT_EQ('f', data[4 * 1024 + chunk_size]);
+    ASSERT_EQ('f', data[length - 1]);
+
+    memset(data.get(), 'a', 4 * 1024);
+    memset(data.get() + 4 * 1024, 'b', chunk_size);
+    memset(data.get() + 4 * 1024 + chunk_size, 'c', 4 * 1024);
+
+    CurveAioContext writectx;
+    writectx.offset = 4 * 1024 * 1024 - 4 * 1024;
+    writectx.length = length;
+    writectx.ret = LIBCURVE_ERROR::OK;
+    writectx.cb = writecallback;
+    writectx.buf = nullptr;
+    writectx.op = LIBCURVE_OP::LIBCURVE_OP_WRITE;
+
+    writeData.clear();
+    iowriteflag = false;
+    request = CurveAioRequest{&writectx, iov, 3};
+    ASSERT_EQ(LIBCURVE_ERROR::OK, fileinstance_->AioSubmit(&request, 1));
+    {
+        std::unique_lock<std::mutex> lk(writemtx);
+        writecv.wait(lk, []()->bool{return iowriteflag;});
+    }
+    ASSERT_EQ(static_cast<int>(length), writectx.ret);
+
+    std::string written = writeData.to_string();
+    ASSERT_EQ(length, written.size());
+    ASSERT_EQ('a', written[0]);
+    ASSERT_EQ('a', written[4 * 1024 - 1]);
+    ASSERT_EQ('b', written[4 * 1024]);
+    ASSERT_EQ('b', written[4 * 1024 + chunk_size - 1]);
+    ASSERT_EQ('c', written[4 * 1024 + chunk_size]);
+    ASSERT_EQ('c', written[length - 1]);
+}
+
+TEST_F(IOTrackerSplitorTest, ManagerAsyncSubmitBatch) {
+    MockRequestScheduler* mockschuler = new MockRequestScheduler;
+    mockschuler->DelegateToFake();
+
+    auto ioctxmana = fileinstance_->GetIOManager4File();
+    ioctxmana->SetRequestScheduler(mockschuler);
+
+    const size_t length = 8 * 1024;
+    std::unique_ptr<char[]> readbuf(new char[length]);
+    std::unique_ptr<char[]> writebuf(new char[length]);
+    memset(writebuf.get(), 'c', length);
+
+    CurveAioContext readctx;
+    readctx.offset = 4 * 1024 * 1024 - 4 * 1024;
+    readctx.length = length;
+    readctx.ret = LIBCURVE_ERROR::OK;
+    readctx.cb = readcallback;
+    readctx.buf = readbuf.get();
+    readctx.op = LIBCURVE_OP::LIBCURVE_OP_READ;
+
+    CurveAioContext writectx;
+    writectx.offset = 8 * 1024 * 1024;
+    writectx.length = length;
+    writectx.ret = LIBCURVE_ERROR::OK;
+    writectx.cb = writecallback;
+    writectx.buf = writebuf.get();
+    writectx.op = LIBCURVE_OP::LIBCURVE_OP_WRITE;
+
+    // nothing is submitted if any of the requests is invalid
+    CurveAioContext badctx = writectx;
+    badctx.offset = 1;
+    CurveAioRequest requests[3] = {{&readctx, nullptr, 0},
+                                   {&writectx, nullptr, 0},
+                                   {&badctx, nullptr, 0}};
+    ASSERT_EQ(-LIBCURVE_ERROR::NOT_ALIGNED,
+              fileinstance_->AioSubmit(requests, 3));
+
+    writeData.clear();
+    ioreadflag = false;
+    iowriteflag = false;
+    ASSERT_EQ(LIBCURVE_ERROR::OK, fileinstance_->AioSubmit(requests, 2));
+    {
+        std::unique_lock<std::mutex> lk(readmtx);
+        readcv.wait(lk, []()->bool{return ioreadflag;});
+    }
+    {
+        std::unique_lock<std::mutex> lk(writemtx);
+        writecv.wait(lk, []()->bool{return iowriteflag;});
+    }
+
+    ASSERT_EQ(static_cast<int>(length), readctx.ret);
+    ASSERT_EQ('a', readbuf[0]);
+    ASSERT_EQ('a', readbuf[4 * 1024 - 1]);
+    ASSERT_EQ('b', readbuf[4 * 1024]);
+    ASSERT_EQ('b', readbuf[length - 1]);
+    ASSERT_EQ(static_cast<int>(length), writectx.ret);
+    ASSERT_EQ(std::string(length, 'c'), writeData.to_string());
+}
+
 /*
 TEST_F(IOTrackerSplitorTest, ManagerAsyncStartWriteReadGetSegmentFail) {
     MockRequestScheduler* mockschuler = new MockRequestScheduler;
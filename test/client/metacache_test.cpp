@@ -26,6 +26,7 @@
 #include <gtest/gtest.h>
 
 #include <tuple>
+#include <utility>
 #include <vector>
 
 namespace curve {
@@ -109,6 +110,37 @@ TEST_F(MetaCacheTest, TestCleanChunksInSegment) {
     }
 }
 
+TEST_F(MetaCacheTest, TestUpdateChunkInfosByIndex) {
+    std::vector<std::pair<ChunkIndex, ChunkIDInfo>> chunkInfos;
+    for (ChunkIndex i = 0; i < 4; ++i) {
+        chunkInfos.emplace_back(i, ChunkIDInfo(i + 1, 1, 1));
+    }
+    metaCache_.UpdateChunkInfoByIndex(chunkInfos);
+
+    ChunkIDInfo info;
+    for (ChunkIndex i = 0; i < 4; ++i) {
+        ASSERT_EQ(MetaCacheErrorType::OK,
+                  metaCache_.GetChunkInfoByIndex(i, &info));
+        ASSERT_EQ(i + 1, info.cid_);
+    }
+    ASSERT_EQ(MetaCacheErrorType::CHUNKINFO_NOT_FOUND,
+              metaCache_.GetChunkInfoByIndex(4, &info));
+
+    // existing entries are overwritten
+    chunkInfos.clear();
+    chunkInfos.emplace_back(1, ChunkIDInfo(10, 1, 1));
+    metaCache_.UpdateChunkInfoByIndex(chunkInfos);
+    ASSERT_EQ(MetaCacheErrorType::OK,
+              metaCache_.GetChunkInfoByIndex(1, &info));
+    ASSERT_EQ(10, info.cid_);
+
+    // an empty batch changes nothing
+    metaCache_.UpdateChunkInfoByIndex({});
+    ASSERT_EQ(MetaCacheErrorType::OK,
+              metaCache_.GetChunkInfoByIndex(1, &info));
+    ASSERT_EQ(10, info.cid_);
+}
+
 TEST(MetaCacheCommonTest, TestAddCopysetsInfo) {
     MetaCache metaCache;
 
@@ -161,5 +193,72 @@ TEST(MetaCacheCommonTest, TestAddCopysetsInfo) {
     }
 }
 
+TEST(MetaCacheCommonTest, TestUpdateLeaderAndUnstable) {
+    MetaCache metaCache;
+
+    std::vector<CopysetPeerInfo<ChunkServerID>> peers;
+    PeerAddr addr;
+    ASSERT_EQ(0, addr.Parse("127.0.0.1:8200:0"));
+    peers.emplace_back(1, addr, addr);
+    ASSERT_EQ(0, addr.Parse("127.0.0.1:8201:0"));
+    peers.emplace_back(2, addr, addr);
+    ASSERT_EQ(0, addr.Parse("127.0.0.1:8202:0"));
+    peers.emplace_back(3, addr, addr);
+
+    std::vector<CopysetInfo<ChunkServerID>> copysets;
+    for (int i = 1; i <= 2; ++i) {
+        CopysetInfo<ChunkServerID> info;
+        info.lpid_ = 1;
+        info.cpid_ = i;
+        info.leaderindex_ = 0;
+        info.csinfos_ = peers;
+        copysets.emplace_back(info);
+    }
+    metaCache.AddCopysetsInfo(1, std::move(copysets));
+
+    ChunkServerID leaderId = 0;
+    butil::EndPoint leaderAddr;
+    ASSERT_EQ(0, metaCache.GetLeader(1, 1, &leaderId, &leaderAddr));
+    ASSERT_EQ(1, leaderId);
+    ASSERT_EQ(8200, leaderAddr.port);
+
+    // leader changes are visible to the following lookups
+    ASSERT_EQ(0, metaCache.UpdateLeader(1, 1, peers[1].externalAddr.addr_));
+    ASSERT_EQ(0, metaCache.GetLeader(1, 1, &leaderId, &leaderAddr));
+    ASSERT_EQ(2, leaderId);
+    ASSERT_EQ(8201, leaderAddr.port);
+    ASSERT_EQ(1, metaCache.GetCopysetinfo(1, 1).GetCurrentLeaderIndex());
+
+    // leader not in the copyset and copyset not exists
+    ASSERT_EQ(0, addr.Parse("127.0.0.1:8203:0"));
+    ASSERT_EQ(-1, metaCache.UpdateLeader(1, 1, addr.addr_));
+    ASSERT_EQ(-1, metaCache.UpdateLeader(1, 3, addr.addr_));
+    ASSERT_EQ(0, metaCache.GetLeader(1, 1, &leaderId, &leaderAddr));
+    ASSERT_EQ(2, leaderId);
+    ASSERT_EQ(-1, metaCache.GetLeader(1, 3, &leaderId, &leaderAddr));
+
+    // only the copysets whose leader is on the chunkserver are marked
+    metaCache.AddCopysetIDInfo(2, CopysetIDInfo(1, 1));
+    metaCache.AddCopysetIDInfo(2, CopysetIDInfo(1, 2));
+    metaCache.SetChunkserverUnstable(2);
+    ASSERT_TRUE(metaCache.IsLeaderMayChange(1, 1));
+    ASSERT_FALSE(metaCache.IsLeaderMayChange(1, 2));
+    ASSERT_FALSE(metaCache.IsLeaderMayChange(1, 3));
+}
+
+TEST(MetaCacheCommonTest, TestGetFileSegment) {
+    MetaCache metaCache;
+    FInfo fileInfo;
+    fileInfo.segmentsize = 1 * GiB;
+    fileInfo.chunksize = 16 * MiB;
+    metaCache.UpdateFileInfo(fileInfo);
+
+    FileSegment* segment = metaCache.GetFileSegment(1);
+    ASSERT_NE(nullptr, segment);
+    ASSERT_EQ(segment, metaCache.GetFileSegment(1));
+    ASSERT_NE(segment, metaCache.GetFileSegment(2));
+    ASSERT_EQ(segment, metaCache.GetFileSegment(1));
+}
+
 }  // namespace client
 }  // namespace curve
@@ -23,6 +23,8 @@
 #include <brpc/server.h>
 #include <gtest/gtest.h>
 
+#include <set>
+
 #include "src/client/client_common.h"
 #include "src/client/request_sender.h"
 #include "src/common/concurrent/count_down_event.h"
@@ -206,5 +208,45 @@ TEST_F(RequestSenderTest, TestReadChunkSourceInfo) {
     }
 }
 
+TEST_F(RequestSenderTest, TestMultipleConnections) {
+    butil::EndPoint serverEndpoint;
+    butil::str2endpoint(serverAddr_.c_str(), &serverEndpoint);
+
+    auto sendWrites = [&](uint32_t connectionNum, int count) {
+        ioSenderOption_.chunkserverConnectionNum = connectionNum;
+        RequestSender requestSender(0, serverEndpoint);
+        EXPECT_EQ(0, requestSender.Init(ioSenderOption_));
+
+        // 记录rpc在server端看到的client端口，不同的连接端口不同
+        std::set<int> ports;
+        EXPECT_CALL(mockChunkService_, WriteChunk(_, _, _, _))
+            .Times(count)
+            .WillRepeatedly(Invoke(
+                [&ports](::google::protobuf::RpcController* controller,
+                         const ::curve::chunkserver::ChunkRequest* request,
+                         ::curve::chunkserver::ChunkResponse* response,
+                         google::protobuf::Closure* done) {
+                    brpc::ClosureGuard doneGuard(done);
+                    ports.insert(static_cast<brpc::Controller*>(controller)
+                                     ->remote_side().port);
+                }));
+
+        for (int i = 0; i < count; ++i) {
+            CountDownEvent event(1);
+            FakeChunkClosure closure(&event);
+            requestSender.WriteChunk(ChunkIDInfo(), 1, 1, 0, {}, 0, 0,
+                                     RequestSourceInfo(), &closure);
+            event.Wait();
+        }
+        EXPECT_TRUE(requestSender.IsSocketHealth());
+        return static_cast<int>(ports.size());
+    };
+
+    // 只有一个连接时，所有rpc都使用同一个连接
+    ASSERT_EQ(1, sendWrites(1, 8));
+    // 连接上都没有inflight rpc时，轮流使用每个连接
+    ASSERT_EQ(4, sendWrites(4, 8));
+}
+
 }  // namespace client
 }  // namespace curve
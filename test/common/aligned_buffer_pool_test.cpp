@@ -0,0 +1,160 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include "src/common/aligned_buffer_pool.h"
+
+namespace curve {
+namespace common {
+
+TEST(AlignedBufferPoolTest, AllocAndFree) {
+    AlignedBufferPool& pool = AlignedBufferPool::GetInstance();
+    pool.Clear();
+    ASSERT_EQ(0, pool.CachedBytes());
+
+    // 分配的buffer按kAlignment对齐，并且可以写满申请的大小
+    char* buf = pool.Alloc(100);
+    ASSERT_NE(nullptr, buf);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(buf) %
+                 AlignedBufferPool::kAlignment);
+    memset(buf, 'a', 100);
+    pool.Free(buf, 100);
+    ASSERT_EQ(AlignedBufferPool::kAlignment, pool.CachedBytes());
+
+    // 同一规格的buffer会被复用
+    char* buf2 = pool.Alloc(AlignedBufferPool::kAlignment);
+    ASSERT_EQ(buf, buf2);
+    ASSERT_EQ(0, pool.CachedBytes());
+
+    // 不同规格的buffer互不影响
+    size_t size = 3 * AlignedBufferPool::kAlignment;
+    char* buf3 = pool.Alloc(size);
+    ASSERT_NE(nullptr, buf3);
+    memset(buf3, 'b', size);
+    pool.Free(buf3, size);
+    ASSERT_EQ(4 * AlignedBufferPool::kAlignment, pool.CachedBytes());
+    pool.Free(buf2, AlignedBufferPool::kAlignment);
+    ASSERT_EQ(5 * AlignedBufferPool::kAlignment, pool.CachedBytes());
+
+    // 超过最大规格的buffer不缓存
+    size = 2 * AlignedBufferPool::kMaxPooledSize;
+    char* large = pool.Alloc(size);
+    ASSERT_NE(nullptr, large);
+    memset(large, 'c', size);
+    pool.Free(large, size);
+    ASSERT_EQ(5 * AlignedBufferPool::kAlignment, pool.CachedBytes());
+
+    pool.Clear();
+    ASSERT_EQ(0, pool.CachedBytes());
+}
+
+TEST(AlignedBufferPoolTest, DeleterAndCacheLimit) {
+    AlignedBufferPool& pool = AlignedBufferPool::GetInstance();
+    pool.Clear();
+
+    // 通过deleter释放的buffer归还到对应规格
+    size_t size = 8192;
+    char* buf = pool.Alloc(size);
+    AlignedBufferPool::Deleter deleter = pool.GetDeleter(size);
+    deleter(buf);
+    ASSERT_EQ(size, pool.CachedBytes());
+    ASSERT_EQ(buf, pool.Alloc(size - 1));
+
+    // 大buffer的deleter直接释放
+    size_t largeSize = AlignedBufferPool::kMaxPooledSize + 1;
+    char* large = pool.Alloc(largeSize);
+    pool.GetDeleter(largeSize)(large);
+    ASSERT_EQ(0, pool.CachedBytes());
+
+    // 超过缓存上限后不再缓存
+    pool.SetMaxCachedBytes(size);
+    char* buf2 = pool.Alloc(size);
+    pool.Free(buf, size);
+    pool.Free(buf2, size);
+    ASSERT_EQ(size, pool.CachedBytes());
+
+    pool.SetMaxCachedBytes(256 * 1024 * 1024);
+    pool.Clear();
+}
+
+TEST(AlignedBufferPoolTest, HitAndMissCount) {
+    AlignedBufferPool& pool = AlignedBufferPool::GetInstance();
+    pool.Clear();
+    uint64_t hit = pool.HitCount();
+    uint64_t miss = pool.MissCount();
+
+    size_t size = 8192;
+    char* buf = pool.Alloc(size);
+    ASSERT_EQ(miss + 1, pool.MissCount());
+    pool.Free(buf, size);
+    ASSERT_EQ(buf, pool.Alloc(size));
+    ASSERT_EQ(hit + 1, pool.HitCount());
+    pool.Free(buf, size);
+
+    // 超过最大规格的buffer每次都重新分配
+    size_t largeSize = AlignedBufferPool::kMaxPooledSize + 1;
+    char* large = pool.Alloc(largeSize);
+    pool.Free(large, largeSize);
+    ASSERT_EQ(miss + 2, pool.MissCount());
+    ASSERT_EQ(hit + 1, pool.HitCount());
+    pool.Clear();
+}
+
+TEST(AlignedBufferPoolTest, ThreadCache) {
+    AlignedBufferPool& pool = AlignedBufferPool::GetInstance();
+    pool.Clear();
+
+    // 线程退出时缓存的buffer归还到全局空闲链表，其他线程可以复用
+    size_t size = 4096;
+    char* buf = nullptr;
+    std::thread t([&pool, &buf, size] {
+        buf = pool.Alloc(size);
+        pool.Free(buf, size);
+    });
+    t.join();
+    ASSERT_EQ(size, pool.CachedBytes());
+    uint64_t hit = pool.HitCount();
+    ASSERT_EQ(buf, pool.Alloc(size));
+    ASSERT_EQ(hit + 1, pool.HitCount());
+    ASSERT_EQ(0, pool.CachedBytes());
+
+    // 线程缓存满了之后释放到全局空闲链表，其他线程可以立即复用
+    char* buf2 = pool.Alloc(size);
+    char* buf3 = pool.Alloc(AlignedBufferPool::kMaxPooledSize);
+    pool.Free(buf3, AlignedBufferPool::kMaxPooledSize);
+    pool.Free(buf, size);
+    pool.Free(buf2, size);
+    ASSERT_EQ(AlignedBufferPool::kMaxPooledSize + 2 * size,
+              pool.CachedBytes());
+    char* other = nullptr;
+    std::thread t2([&pool, &other, size] {
+        other = pool.Alloc(size);
+        pool.Free(other, size);
+    });
+    t2.join();
+    ASSERT_TRUE(other == buf || other == buf2);
+
+    pool.Clear();
+    ASSERT_EQ(0, pool.CachedBytes());
+}
+
+}  // namespace common
+}  // namespace curve
@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/common/background_io_scheduler.h"
+#include "src/common/timeutility.h"
+
+namespace curve {
+namespace common {
+
+namespace {
+
+BackgroundIOSchedulerOptions DefaultOptions() {
+    BackgroundIOSchedulerOptions options;
+    options.bpsLimit = 100 * 1024 * 1024;
+    options.iopsLimit = 1000;
+    options.latencyThresholdUs = 1000;
+    options.minRatioPercent = 10;
+    // 测试中手动调用Adjust
+    options.adjustIntervalMs = 3600 * 1000;
+    return options;
+}
+
+}  // namespace
+
+TEST(BackgroundIOSchedulerTest, InvalidOptions) {
+    BackgroundIOScheduler scheduler;
+    BackgroundIOSchedulerOptions options = DefaultOptions();
+    options.adjustIntervalMs = 0;
+    ASSERT_EQ(-1, scheduler.Init(options));
+
+    options = DefaultOptions();
+    options.minRatioPercent = 0;
+    ASSERT_EQ(-1, scheduler.Init(options));
+
+    options.minRatioPercent = 101;
+    ASSERT_EQ(-1, scheduler.Init(options));
+}
+
+TEST(BackgroundIOSchedulerTest, ShareByWeight) {
+    BackgroundIOScheduler scheduler;
+    ASSERT_EQ(0, scheduler.Init(DefaultOptions()));
+
+    // 没有活跃的类别时，每个类别按加入后的份额限制
+    ASSERT_EQ(1000 * 2 / 2, scheduler.IopsLimit(BackgroundIOType::CLONE));
+    ASSERT_EQ(1000, scheduler.IopsLimit(BackgroundIOType::SCAN));
+
+    // 只有scan活跃时，scan独占所有配额
+    scheduler.Acquire(BackgroundIOType::SCAN, 4096);
+    scheduler.Adjust();
+    ASSERT_EQ(1000, scheduler.IopsLimit(BackgroundIOType::SCAN));
+    ASSERT_EQ(100 * 1024 * 1024, scheduler.BpsLimit(BackgroundIOType::SCAN));
+    ASSERT_EQ(1000 * 2 / 3, scheduler.IopsLimit(BackgroundIOType::CLONE));
+
+    // scan和clone都活跃时按1:2分配
+    scheduler.Acquire(BackgroundIOType::SCAN, 4096);
+    scheduler.Acquire(BackgroundIOType::CLONE, 4096);
+    scheduler.Adjust();
+    ASSERT_EQ(1000 / 3, scheduler.IopsLimit(BackgroundIOType::SCAN));
+    ASSERT_EQ(1000 * 2 / 3, scheduler.IopsLimit(BackgroundIOType::CLONE));
+    ASSERT_EQ(1000 / 4, scheduler.IopsLimit(BackgroundIOType::TRASH));
+
+    // 不再有IO后，下个周期重新分配
+    scheduler.Adjust();
+    ASSERT_EQ(1000, scheduler.IopsLimit(BackgroundIOType::SCAN));
+    scheduler.Stop();
+}
+
+TEST(BackgroundIOSchedulerTest, BackoffByForegroundLatency) {
+    BackgroundIOScheduler scheduler;
+    ASSERT_EQ(0, scheduler.Init(DefaultOptions()));
+    ASSERT_EQ(100, scheduler.RatioPercent());
+
+    // 前台时延超过阈值，配额减半直到最小值
+    scheduler.OnForegroundIO(500);
+    scheduler.OnForegroundIO(2500);
+    scheduler.Adjust();
+    ASSERT_EQ(50, scheduler.RatioPercent());
+    ASSERT_EQ(500, scheduler.IopsLimit(BackgroundIOType::SCAN));
+    for (int i = 0; i < 5; ++i) {
+        scheduler.OnForegroundIO(2000);
+        scheduler.Adjust();
+    }
+    ASSERT_EQ(10, scheduler.RatioPercent());
+    ASSERT_EQ(100, scheduler.IopsLimit(BackgroundIOType::SCAN));
+
+    // 时延恢复后逐步增加配额
+    scheduler.OnForegroundIO(100);
+    scheduler.Adjust();
+    ASSERT_EQ(20, scheduler.RatioPercent());
+    for (int i = 0; i < 10; ++i) {
+        scheduler.Adjust();
+    }
+    ASSERT_EQ(100, scheduler.RatioPercent());
+    scheduler.Stop();
+}
+
+TEST(BackgroundIOSchedulerTest, ThrottleAndUnlimited) {
+    BackgroundIOScheduler scheduler;
+    // 未初始化时不限制
+    uint64_t start = TimeUtility::GetTimeofDayMs();
+    for (int i = 0; i < 100; ++i) {
+        scheduler.Acquire(BackgroundIOType::FORMAT, 1024 * 1024);
+    }
+    ASSERT_LT(TimeUtility::GetTimeofDayMs() - start, 500);
+
+    BackgroundIOSchedulerOptions options = DefaultOptions();
+    options.bpsLimit = 0;
+    options.iopsLimit = 20;
+    ASSERT_EQ(0, scheduler.Init(options));
+    ASSERT_EQ(0, scheduler.BpsLimit(BackgroundIOType::FORMAT));
+    ASSERT_EQ(20 * 2 / 2, scheduler.IopsLimit(BackgroundIOType::FORMAT));
+
+    // iops限制为20时，除去桶的初始容量，60次IO至少需要2s
+    start = TimeUtility::GetTimeofDayMs();
+    for (int i = 0; i < 60; ++i) {
+        scheduler.Acquire(BackgroundIOType::FORMAT, 0);
+    }
+    ASSERT_GE(TimeUtility::GetTimeofDayMs() - start, 1500);
+    scheduler.Stop();
+
+    // 停止后不再限制
+    start = TimeUtility::GetTimeofDayMs();
+    for (int i = 0; i < 100; ++i) {
+        scheduler.Acquire(BackgroundIOType::FORMAT, 0);
+    }
+    ASSERT_LT(TimeUtility::GetTimeofDayMs() - start, 500);
+}
+
+}  // namespace common
+}  // namespace curve
@@ -22,6 +22,9 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
+#include <vector>
+
 #include "src/common/bitmap.h"
 
 namespace curve {
@@ -415,5 +418,69 @@ TEST(BitmapTEST, divide_test) {
     }
 }
 
+TEST(BitmapTEST, range_test) {
+    // 位数不是8的倍数，覆盖不完整的字节
+    const uint32_t bits = 1021;
+    Bitmap bitmap(bits);
+    std::vector<bool> expected(bits, false);
+    std::mt19937 rng(1234);
+
+    auto nextBit = [&](uint32_t start, uint32_t end, bool set) {
+        for (uint32_t i = start; i <= end && i < bits; ++i) {
+            if (expected[i] == set) {
+                return i;
+            }
+        }
+        return Bitmap::NO_POS;
+    };
+
+    for (int round = 0; round < 2000; ++round) {
+        uint32_t start = rng() % bits;
+        uint32_t end = start + rng() % (round % 2 ? 16 : 300);
+        bool set = rng() % 2;
+        if (set) {
+            bitmap.Set(start, end);
+        } else {
+            bitmap.Clear(start, end);
+        }
+        for (uint32_t i = start; i <= end && i < bits; ++i) {
+            expected[i] = set;
+        }
+
+        uint32_t queryStart = rng() % bits;
+        uint32_t queryEnd = queryStart + rng() % 400;
+        ASSERT_EQ(nextBit(queryStart, queryEnd, true),
+                  bitmap.NextSetBit(queryStart, queryEnd));
+        ASSERT_EQ(nextBit(queryStart, queryEnd, false),
+                  bitmap.NextClearBit(queryStart, queryEnd));
+        ASSERT_EQ(nextBit(queryStart, bits - 1, true),
+                  bitmap.NextSetBit(queryStart));
+        ASSERT_EQ(nextBit(queryStart, bits - 1, false),
+                  bitmap.NextClearBit(queryStart));
+    }
+    for (uint32_t i = 0; i < bits; ++i) {
+        ASSERT_EQ(expected[i], bitmap.Test(i));
+    }
+
+    // 长的全0和全1区域
+    bitmap.Clear();
+    bitmap.Set(1000);
+    ASSERT_EQ(1000, bitmap.NextSetBit(0));
+    ASSERT_EQ(Bitmap::NO_POS, bitmap.NextSetBit(0, 999));
+    ASSERT_EQ(Bitmap::NO_POS, bitmap.NextSetBit(1001));
+    bitmap.Set();
+    bitmap.Clear(bits - 1);
+    ASSERT_EQ(bits - 1, bitmap.NextClearBit(0));
+    ASSERT_EQ(Bitmap::NO_POS, bitmap.NextClearBit(0, bits - 2));
+
+    // 超出范围的操作被忽略
+    bitmap.Clear();
+    bitmap.Set(bits - 2, bits + 100);
+    ASSERT_EQ(bits - 2, bitmap.NextSetBit(0));
+    bitmap.Set(bits + 1, bits + 100);
+    bitmap.Set(10, 5);
+    ASSERT_EQ(bits - 2, bitmap.NextSetBit(0));
+}
+
 }  // namespace common
 }  // namespace curve
@@ -22,6 +22,8 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+
 #include "src/common/crc32.h"
 
 namespace curve {
@@ -92,5 +94,23 @@ TEST(Crc32TEST, Extend) {
             CRC32(CRC32("hello ", 6), "world", 5));
 }
 
+TEST(Crc32TEST, Combine) {
+  ASSERT_EQ(CRC32("hello world", 11),
+            CRC32Combine(CRC32("hello ", 6), CRC32("world", 5), 5));
+  ASSERT_EQ(CRC32("hello", 5), CRC32Combine(CRC32("hello", 5), 0, 0));
+
+  std::string data(1024 * 1024 + 17, 0);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(i * 31 + 7);
+  }
+  for (size_t len1 : {0, 1, 4096, 65536, 1024 * 1024}) {
+    size_t len2 = data.size() - len1;
+    uint32_t crc1 = CRC32(data.data(), len1);
+    uint32_t crc2 = CRC32(data.data() + len1, len2);
+    ASSERT_EQ(CRC32(data.data(), data.size()),
+              CRC32Combine(crc1, crc2, len2));
+  }
+}
+
 }  // namespace common
 }  // namespace curve
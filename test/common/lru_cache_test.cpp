@@ -212,6 +212,33 @@ TEST(CaCheTest, TestCacheGetLastKVWithFunction) {
     ASSERT_EQ(false, ok);
 }
 
+TEST(ARCCaCheTest, TestEvictTouchedKey) {
+    // 4 keys resident
+    ARCCache<int, int> cache(8);
+    for (int i = 0; i < 4; ++i) {
+        cache.Put(i, i);
+    }
+    // move all the keys to T2, then touch them in T2
+    int v;
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(cache.Get(i, &v));
+            ASSERT_EQ(i, v);
+        }
+    }
+
+    // T1 is empty, the LRU key of T2 is evicted
+    int eliminated = -1;
+    cache.Put(4, 4, &eliminated);
+    ASSERT_EQ(0, eliminated);
+    ASSERT_FALSE(cache.Get(0, &v));
+    for (int i = 1; i < 5; ++i) {
+        ASSERT_TRUE(cache.Get(i, &v));
+        ASSERT_EQ(i, v);
+    }
+    ASSERT_EQ(4, cache.Size());
+}
+
 TEST(SglCaCheTest, TestGetBefore) {
     auto cache = std::make_shared<SglLRUCache<int>>(
         std::make_shared<CacheMetrics>("LruCache"));
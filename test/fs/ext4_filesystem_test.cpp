@@ -543,6 +543,18 @@ TEST_F(Ext4LocalFileSystemTest, FsyncTest) {
     ASSERT_EQ(lfs->Fsync(666), -errno);
 }
 
+// test SyncFileRange
+TEST_F(Ext4LocalFileSystemTest, SyncFileRangeTest) {
+    // success
+    EXPECT_CALL(*wrapper, sync_file_range(666, 0, 0, SYNC_FILE_RANGE_WRITE))
+        .WillOnce(Return(0));
+    ASSERT_EQ(lfs->SyncFileRange(666, 0, 0, SYNC_FILE_RANGE_WRITE), 0);
+    // sync_file_range failed
+    EXPECT_CALL(*wrapper, sync_file_range(_, _, _, _))
+        .WillOnce(Return(-1));
+    ASSERT_EQ(lfs->SyncFileRange(666, 0, 0, SYNC_FILE_RANGE_WRITE), -errno);
+}
+
 TEST_F(Ext4LocalFileSystemTest, ReadRealTest) {
     std::shared_ptr<PosixWrapper> pw = std::make_shared<PosixWrapper>();
     lfs->SetPosixWrapper(pw);
@@ -0,0 +1,138 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "src/fs/io_uring_filesystem_impl.h"
+
+namespace curve {
+namespace fs {
+
+namespace {
+
+const char kTestFile[] = "./io_uring_filesystem_test.data";
+
+// 等待异步请求完成，返回回调的参数
+class AioWaiter {
+ public:
+    AioCallback Callback() {
+        return [this](int ret) {
+            std::lock_guard<std::mutex> lk(mtx_);
+            ret_ = ret;
+            done_ = true;
+            cond_.notify_one();
+        };
+    }
+
+    int Wait() {
+        std::unique_lock<std::mutex> lk(mtx_);
+        cond_.wait(lk, [this] { return done_; });
+        done_ = false;
+        return ret_;
+    }
+
+ private:
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    bool done_ = false;
+    int ret_ = 0;
+};
+
+}  // namespace
+
+class IoUringFileSystemTest : public testing::Test {
+ public:
+    void SetUp() {
+        lfs_ = IoUringFileSystemImpl::getInstance();
+        LocalFileSystemOption option;
+        option.ioUringQueueDepth = 4;
+        ASSERT_EQ(0, lfs_->Init(option));
+        fd_ = lfs_->Open(kTestFile, O_RDWR | O_CREAT);
+        ASSERT_GE(fd_, 0);
+    }
+
+    void TearDown() {
+        lfs_->Close(fd_);
+        lfs_->Delete(kTestFile);
+    }
+
+ protected:
+    std::shared_ptr<IoUringFileSystemImpl> lfs_;
+    int fd_;
+};
+
+TEST_F(IoUringFileSystemTest, ReadWriteSyncTest) {
+    const int length = 8192;
+    std::string data(length, 'a');
+    AioWaiter waiter;
+
+    ASSERT_EQ(0, lfs_->WriteAsync(fd_, data.c_str(), 4096, length,
+                                  waiter.Callback()));
+    ASSERT_EQ(length, waiter.Wait());
+    ASSERT_EQ(0, lfs_->SyncAsync(fd_, waiter.Callback()));
+    ASSERT_EQ(0, waiter.Wait());
+
+    char buf[length];
+    memset(buf, 0, length);
+    ASSERT_EQ(0, lfs_->ReadAsync(fd_, buf, 4096, length, waiter.Callback()));
+    ASSERT_EQ(length, waiter.Wait());
+    ASSERT_EQ(0, memcmp(buf, data.c_str(), length));
+
+    // 超过文件末尾只返回实际读到的长度
+    ASSERT_EQ(0, lfs_->ReadAsync(fd_, buf, 8192, length, waiter.Callback()));
+    ASSERT_EQ(4096, waiter.Wait());
+    ASSERT_EQ(0, lfs_->ReadAsync(fd_, buf, 16384, length, waiter.Callback()));
+    ASSERT_EQ(0, waiter.Wait());
+
+    // 非法的fd通过回调返回错误
+    ASSERT_EQ(0, lfs_->ReadAsync(-1, buf, 0, length, waiter.Callback()));
+    ASSERT_EQ(-EBADF, waiter.Wait());
+}
+
+TEST_F(IoUringFileSystemTest, ConcurrentRequestTest) {
+    // 请求数超过队列深度时，提交会等待已有请求完成
+    const int count = 64;
+    const int length = 4096;
+    std::string data(length, 'b');
+    std::mutex mtx;
+    std::condition_variable cond;
+    int finished = 0;
+    int failed = 0;
+    for (int i = 0; i < count; ++i) {
+        ASSERT_EQ(0, lfs_->WriteAsync(fd_, data.c_str(), i * length, length,
+            [&](int ret) {
+                std::lock_guard<std::mutex> lk(mtx);
+                if (ret != length) {
+                    ++failed;
+                }
+                ++finished;
+                cond.notify_one();
+            }));
+    }
+    std::unique_lock<std::mutex> lk(mtx);
+    cond.wait(lk, [&] { return finished == count; });
+    ASSERT_EQ(0, failed);
+}
+
+}  // namespace fs
+}  // namespace curve
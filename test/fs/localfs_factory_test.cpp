@@ -40,6 +40,14 @@ TEST_F(LocalFSFactoryTest, CreateTest) {
         LocalFsFactory::CreateFs(FileSystemType::EXT4, "");
     // singleton
     ASSERT_EQ(lfs1.get(), lfs2.get());
+
+    std::shared_ptr<LocalFileSystem> lfs3 =
+        LocalFsFactory::CreateFs(FileSystemType::EXT4_IO_URING, "");
+    ASSERT_NE(lfs3, nullptr);
+    ASSERT_NE(lfs1.get(), lfs3.get());
+    std::shared_ptr<LocalFileSystem> lfs4 =
+        LocalFsFactory::CreateFs(FileSystemType::EXT4_IO_URING, "");
+    ASSERT_EQ(lfs3.get(), lfs4.get());
 }
 
 }  // namespace fs
@@ -730,5 +730,87 @@ TEST_F(RaftSnapshotTest, AddPeerWhenDoingCurveSnapshotWithMultiCopyset) {
                        length, ch-1, loop);
 }
 
+/**
+ * 验证并发下载多个chunk文件的install snapshot
+ * 1. 配置install snapshot同时下载4个文件，每次rpc读取64KB
+ * 2. 创建3个副本的复制组，写入多个chunk
+ * 3. shutdown 非 leader，再次写入多个chunk，并等待打两次快照
+ * 4. 重启shutdown的peer，使其通过install snapshot恢复
+ * 5. transfer leader 到重启的peer上，read 之前写入的数据验证
+ */
+TEST_F(RaftSnapshotTest, InstallSnapshotWithConcurrentFileCopy) {
+    LogicPoolID logicPoolId = 2;
+    CopysetID copysetId = 100001;
+    uint64_t chunkId = 1;
+    const int chunkNum = 8;
+    int length = kOpRequestAlignSize;
+    char ch = 'a';
+    int loop = 25;
+
+    CSTConfigGenerator* cgs[] = {&cg1_, &cg2_, &cg3_};
+    for (auto cg : cgs) {
+        cg->SetKV("chunkserver.snapshot_copy_concurrency", "4");
+        cg->SetKV("chunkserver.snapshot_copy_block_size", "65536");
+        ASSERT_TRUE(cg->Generate());
+    }
+
+    std::vector<Peer> peers;
+    peers.push_back(peer1_);
+    peers.push_back(peer2_);
+    peers.push_back(peer3_);
+
+    PeerCluster cluster("ThreeNode-cluster",
+                        logicPoolId,
+                        copysetId,
+                        peers,
+                        params_,
+                        paramsIndexs_);
+    ASSERT_EQ(0, cluster.StartFakeTopoloyService(kFakeMdsAddr));
+    ASSERT_EQ(0, cluster.StartPeer(peer1_, PeerCluster::PeerToId(peer1_)));
+    ASSERT_EQ(0, cluster.StartPeer(peer2_, PeerCluster::PeerToId(peer2_)));
+    ASSERT_EQ(0, cluster.StartPeer(peer3_, PeerCluster::PeerToId(peer3_)));
+
+    Peer leaderPeer;
+    ASSERT_EQ(0, cluster.WaitLeader(&leaderPeer));
+
+    for (int i = 0; i < chunkNum; ++i) {
+        WriteThenReadVerify(leaderPeer, logicPoolId, copysetId, chunkId + i,
+                            length, ch, loop);
+    }
+    ::sleep(2);
+
+    // shutdown 某个follower
+    Peer shutdownPeer;
+    if (leaderPeer.address() == peer1_.address()) {
+        shutdownPeer = peer2_;
+    } else {
+        shutdownPeer = peer1_;
+    }
+    ASSERT_EQ(0, cluster.ShutdownPeer(shutdownPeer));
+
+    ::sleep(1.5*snapshotIntervalS_);
+    for (int i = 0; i < chunkNum; ++i) {
+        WriteThenReadVerify(leaderPeer, logicPoolId, copysetId,
+                            chunkId + chunkNum + i, length, ch + 1, loop);
+    }
+    ::sleep(1.5*snapshotIntervalS_);
+
+    // restart, 需要从 install snapshot 恢复
+    ASSERT_EQ(0, cluster.StartPeer(shutdownPeer,
+                                   PeerCluster::PeerToId(shutdownPeer)));
+    ASSERT_EQ(0, cluster.WaitLeader(&leaderPeer));
+
+    // Wait shutdown peer recovery, and then transfer leader to it
+    ::sleep(3);
+    TransferLeaderAssertSuccess(&cluster, shutdownPeer, defaultCliOpt_);
+    leaderPeer = shutdownPeer;
+    for (int i = 0; i < chunkNum; ++i) {
+        ReadVerify(leaderPeer, logicPoolId, copysetId, chunkId + i,
+                   length, ch, loop);
+        ReadVerify(leaderPeer, logicPoolId, copysetId, chunkId + chunkNum + i,
+                   length, ch + 1, loop);
+    }
+}
+
 }  // namespace chunkserver
 }  // namespace curve
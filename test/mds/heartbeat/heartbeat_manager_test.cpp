@@ -34,9 +34,12 @@
 using ::testing::Return;
 using ::testing::SetArgPointee;
 using ::testing::DoAll;
+using ::testing::SaveArg;
 using ::testing::_;
 using ::curve::mds::topology::MockTopology;
 using ::curve::mds::topology::MockTopologyStat;
+using ::curve::mds::topology::ChunkServerStat;
+using ::curve::mds::topology::CopysetStat;
 
 namespace curve {
 namespace mds {
@@ -934,6 +937,78 @@ TEST_F(TestHeartbeatManager, test_patrol_copySetInfo_return_order) {
     ASSERT_EQ(TRANSFER_LEADER, response.needupdatecopysets(0).type());
     ASSERT_EQ(3, response.needupdatecopysets(0).peers_size());
 }
+
+TEST_F(TestHeartbeatManager, test_chunkServer_delta_heartbeat) {
+    ::curve::mds::topology::ChunkServer chunkServer1(
+        1, "hello", "", 1, "192.168.10.1", 9000, "",
+        ::curve::mds::topology::ChunkServerStatus::READWRITE);
+
+    // 增量心跳中没有变化的copyset, copyset(1,3)已经被删除
+    auto request = GetChunkServerHeartbeatRequestForTest();
+    request.clear_copysetinfos();
+    request.set_deltareport(true);
+    auto removed = request.add_removedcopysets();
+    removed->set_logicalpoolid(1);
+    removed->set_copysetid(3);
+
+    {
+        // 1. mds没有该chunkserver的统计信息，要求全量上报
+        ChunkServerHeartbeatResponse response;
+        EXPECT_CALL(*topology_, GetChunkServer(1, _))
+            .WillOnce(DoAll(SetArgPointee<1>(chunkServer1), Return(true)));
+        EXPECT_CALL(*topologyStat_, GetChunkServerStat(1, _))
+            .WillOnce(Return(false));
+        EXPECT_CALL(*topologyStat_, UpdateChunkServerStat(1, _)).Times(1);
+        EXPECT_CALL(*coordinator_, ListOperatorCopySets())
+            .WillOnce(Return(std::vector<CopySetKey>{}));
+        heartbeatManager_->ChunkServerHeartbeat(request, &response);
+        ASSERT_EQ(HeartbeatStatusCode::hbOK, response.statuscode());
+        ASSERT_TRUE(response.acceptdelta());
+        ASSERT_TRUE(response.needfullreport());
+        ASSERT_EQ(0, response.needreportcopysets_size());
+    }
+
+    {
+        // 2. 合并上次心跳的统计信息，要求上报有operator的leader copyset
+        ChunkServerHeartbeatResponse response;
+        ChunkServerStat lastStat;
+        CopysetStat cstat;
+        cstat.logicalPoolId = 1;
+        cstat.copysetId = 2;
+        cstat.writeIOPS = 10;
+        lastStat.copysetStats.push_back(cstat);
+        cstat.copysetId = 3;
+        lastStat.copysetStats.push_back(cstat);
+        ChunkServerStat stat;
+        EXPECT_CALL(*topology_, GetChunkServer(1, _))
+            .WillOnce(DoAll(SetArgPointee<1>(chunkServer1), Return(true)));
+        EXPECT_CALL(*topologyStat_, GetChunkServerStat(1, _))
+            .WillOnce(DoAll(SetArgPointee<1>(lastStat), Return(true)));
+        EXPECT_CALL(*topologyStat_, UpdateChunkServerStat(1, _))
+            .WillOnce(SaveArg<1>(&stat));
+        EXPECT_CALL(*coordinator_, ListOperatorCopySets())
+            .WillOnce(Return(std::vector<CopySetKey>{
+                CopySetKey{1, 4}, CopySetKey{1, 5}}));
+        ::curve::mds::topology::CopySetInfo leaderCopyset(1, 4);
+        leaderCopyset.SetLeader(1);
+        ::curve::mds::topology::CopySetInfo followerCopyset(1, 5);
+        followerCopyset.SetLeader(2);
+        EXPECT_CALL(*topology_, GetCopySet(CopySetKey{1, 4}, _))
+            .WillOnce(DoAll(SetArgPointee<1>(leaderCopyset), Return(true)));
+        EXPECT_CALL(*topology_, GetCopySet(CopySetKey{1, 5}, _))
+            .WillOnce(DoAll(SetArgPointee<1>(followerCopyset), Return(true)));
+        heartbeatManager_->ChunkServerHeartbeat(request, &response);
+        ASSERT_EQ(HeartbeatStatusCode::hbOK, response.statuscode());
+        ASSERT_TRUE(response.acceptdelta());
+        ASSERT_FALSE(response.needfullreport());
+        ASSERT_EQ(1, response.needreportcopysets_size());
+        ASSERT_EQ(1, response.needreportcopysets(0).logicalpoolid());
+        ASSERT_EQ(4, response.needreportcopysets(0).copysetid());
+        ASSERT_EQ(1, stat.copysetStats.size());
+        ASSERT_EQ(2, stat.copysetStats[0].copysetId);
+        ASSERT_EQ(10, stat.copysetStats[0].writeIOPS);
+    }
+}
 }  // namespace heartbeat
 }  // namespace mds
 }  // namespace curve
@@ -21,6 +21,7 @@
  */
 
 #include <glog/logging.h>
+#include <algorithm>
 #include "src/mds/schedule/coordinator.h"
 #include "src/mds/common/mds_define.h"
 #include "test/mds/schedule/mock_topoAdapter.h"
@@ -428,6 +429,36 @@ TEST(CoordinatorTest, test_ChunkserverGoingToAdd) {
     }
 }
 
+TEST(CoordinatorTest, test_ListOperatorCopySets) {
+    auto topo = std::make_shared<MockTopology>();
+    auto topoAdapter = std::make_shared<MockTopoAdapter>();
+    auto coordinator = std::make_shared<Coordinator>(topoAdapter);
+    ScheduleOption scheduleOption;
+    scheduleOption.operatorConcurrent = 4;
+    coordinator->InitScheduler(
+        scheduleOption, std::make_shared<ScheduleMetrics>(topo));
+
+    // 1. 没有operator
+    ASSERT_TRUE(coordinator->ListOperatorCopySets().empty());
+
+    // 2. 返回所有有operator的copyset
+    Operator transferLeader(1, CopySetKey{1, 1},
+                            OperatorPriority::NormalPriority,
+                            steady_clock::now(),
+                            std::make_shared<TransferLeader>(2, 1));
+    ASSERT_TRUE(coordinator->GetOpController()->AddOperator(transferLeader));
+    Operator addPeer(1, CopySetKey{1, 2},
+                     OperatorPriority::NormalPriority,
+                     steady_clock::now(),
+                     std::make_shared<AddPeer>(1));
+    ASSERT_TRUE(coordinator->GetOpController()->AddOperator(addPeer));
+    auto copysets = coordinator->ListOperatorCopySets();
+    std::sort(copysets.begin(), copysets.end());
+    ASSERT_EQ(2, copysets.size());
+    ASSERT_EQ(CopySetKey(1, 1), copysets[0]);
+    ASSERT_EQ(CopySetKey(1, 2), copysets[1]);
+}
+
 TEST(CoordinatorTest, test_SchedulerSwitch) {
     auto topo = std::make_shared<MockTopology>();
     auto metric = std::make_shared<ScheduleMetrics>(topo);